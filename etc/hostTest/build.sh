@@ -0,0 +1,61 @@
+#!/bin/sh
+# @file build.sh
+# @author Daniel Starke
+# @copyright Copyright 2026 Daniel Starke
+# @date 2026-10-17
+# @version 2026-10-17
+#
+# Running from within the library root directory.
+# Builds the core library against the simulated STM32 HAL in etc/hostTest/src/mock
+# and runs all unit tests from etc/hostTest/src/test_*.cpp.
+# The following environment variables are used:
+# CXX      - host C++ compiler (default: g++)
+# CXXFLAGS - additional compiler flags
+#
+# Tests in etc/hostTest/src/test_*_sr.cpp are built against the SR/DR UART register model
+# (MOCK_UART_SR) of the STM32F1/F2/F4/L1 series.
+# Optionally, set BENCH=1 to also build and run the benchmarks in etc/hostTest/src/bench_*.cpp.
+
+Error() {
+	echo "Error: $@"
+	exit 1
+}
+
+[ -d "src/scdinternal" ] || Error "Needs to be run from within the library root directory."
+
+CXX="${CXX:-g++}"
+OUT="etc/hostTest/bin"
+FLAGS="-std=gnu++14 -O2 -g -Wall -Wextra -Wformat -pedantic -Wshadow -Wconversion -Wparentheses -Wunused -Wno-missing-field-initializers -DNO_GPL -DVENDOR_WINUSB -Ietc/hostTest/src/mock -Ietc/hostTest/src -Isrc ${CXXFLAGS}"
+LIBS="-lpthread"
+CORE="src/Print.cpp src/Stream.cpp src/WString.cpp src/WMath.cpp src/HardwareSerial.cpp src/PluggableUSB.cpp src/USBCore.cpp src/CDC.cpp src/HID.cpp src/Vendor.cpp etc/hostTest/src/mock/arduino.cpp etc/hostTest/src/mock/stm32mock.cpp"
+
+mkdir -p "${OUT}" || Error "Failed to create output directory \"${OUT}\"."
+
+# Build core library objects once for each UART register model.
+OBJS=""
+OBJS_SR=""
+for SRC in ${CORE}
+do
+	OBJ="${OUT}/$(basename "${SRC}" .cpp).o"
+	${CXX} ${FLAGS} -c "${SRC}" -o "${OBJ}" || Error "Failed to compile ${SRC}."
+	OBJS="${OBJS} ${OBJ}"
+	OBJ="${OUT}/$(basename "${SRC}" .cpp)_sr.o"
+	${CXX} ${FLAGS} -DMOCK_UART_SR -c "${SRC}" -o "${OBJ}" || Error "Failed to compile ${SRC} with MOCK_UART_SR."
+	OBJS_SR="${OBJS_SR} ${OBJ}"
+done
+
+# Build and run unit tests and, optionally, benchmarks.
+PATTERN="etc/hostTest/src/test_*.cpp"
+[ "x1" = "x${BENCH}" ] && PATTERN="${PATTERN} etc/hostTest/src/bench_*.cpp"
+for SRC in ${PATTERN}
+do
+	[ -f "${SRC}" ] || continue
+	BIN="${OUT}/$(basename "${SRC}" .cpp)"
+	case "${SRC}" in
+	*_sr.cpp) ${CXX} ${FLAGS} -DMOCK_UART_SR "${SRC}" ${OBJS_SR} ${LIBS} -o "${BIN}" || Error "Failed to build ${SRC}.";;
+	*)        ${CXX} ${FLAGS} "${SRC}" ${OBJS} ${LIBS} -o "${BIN}" || Error "Failed to build ${SRC}.";;
+	esac
+	"${BIN}" || Error "Failed to run ${BIN}."
+done
+
+exit 0
@@ -0,0 +1,231 @@
+/**
+ * @file bench_fifo.cpp
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ *
+ * Benchmarks for scdinternal/fifo.h.
+ * The results are given in bytes per time stamp counter tick (see `testCycles()`).
+ */
+#include "hosttest.h"
+#include "stm32mock.h"
+#include "scdinternal/fifo.h"
+
+
+namespace {
+enum {
+	ROUNDS = 200000,
+	READ_BYTES = 1 << 26
+};
+
+
+/**
+ * Prints a single benchmark result.
+ *
+ * @param[in] name - benchmark name
+ * @param[in] chunk - bytes per operation
+ * @param[in] bytes - total number of bytes processed
+ * @param[in] ticks - total number of ticks needed
+ */
+void printResult(const char * name, const uint32_t chunk, const uint64_t bytes, const uint64_t ticks) {
+	printf("%-36s %4u byte: %8.3f bytes/tick\n", name, unsigned(chunk), double(bytes) / double(ticks));
+}
+
+
+/** Reads from the FIFO one byte at a time like `_FifoClass::read()` did before. */
+struct ReadPerByte {
+	template <typename Fifo>
+	static uint32_t read(Fifo & fifo, uint8_t * buf, const uint32_t len) {
+		uint32_t res = 0;
+		for (int val; res < len && (val = fifo.pop()) >= 0; buf++, res++) {
+			*buf = uint8_t(val);
+		}
+		return res;
+	}
+};
+
+
+/** Reads from the FIFO via `_FifoClass::read()`. */
+struct ReadBulk {
+	template <typename Fifo>
+	static uint32_t read(Fifo & fifo, uint8_t * buf, const uint32_t len) {
+		return fifo.read(buf, len);
+	}
+};
+
+
+/** Processes the FIFO data in place via `_FifoClass::peek(span)` and `_FifoClass::consume()`. */
+struct ReadSpan {
+	template <typename Fifo>
+	static uint32_t read(Fifo & fifo, uint8_t * /* buf */, const uint32_t len) {
+		_FifoSpan span[2];
+		const uint32_t available = fifo.peek(span);
+		const uint32_t res = (available < len) ? available : len;
+		testKeep(span);
+		fifo.consume(res);
+		return res;
+	}
+};
+
+
+/**
+ * Measures reads of the given chunk size. The FIFO is refilled outside of the measured
+ * section. Head and tail are rotated to include wrap-arounds.
+ *
+ * @tparam Fifo - FIFO type to benchmark
+ * @tparam Reader - read strategy
+ * @param[in] name - benchmark name
+ * @param[in] chunk - number of bytes per read
+ */
+template <typename Fifo, typename Reader>
+void benchRead(const char * name, const uint32_t chunk) {
+	static Fifo fifo;
+	static uint8_t buf[Fifo::Size];
+	memset(buf, 0x55, sizeof(buf));
+	fifo.clear();
+	uint64_t ticks = 0, bytes = 0;
+	while (bytes < READ_BYTES) {
+		/* fill to capacity */
+		fifo.write(buf, fifo.availableForWrite());
+		const uint32_t fill = fifo.availableForRead();
+		const uint32_t count = fill / chunk;
+		const uint64_t start = testCycles();
+		for (uint32_t i = 0; i < count; i++) {
+			testKeep(Reader::read(fifo, buf, chunk));
+		}
+		ticks += testCycles() - start;
+		bytes += uint64_t(count) * chunk;
+		/* rotate start position */
+		fifo.skip(fifo.availableForRead());
+		fifo.dummyWrite(7);
+		fifo.skip(7);
+	}
+	printResult(name, chunk, bytes, ticks);
+}
+
+
+/**
+ * Measures single byte push and pop.
+ *
+ * @tparam Fifo - FIFO type to benchmark
+ * @param[in] name - benchmark name
+ */
+template <typename Fifo>
+void benchBytePushPop(const char * name) {
+	static Fifo fifo;
+	fifo.clear();
+	const uint64_t start = testCycles();
+	for (uint32_t i = 0; i < ROUNDS; i++) {
+		fifo.push(uint8_t(i));
+		testKeep(fifo.pop());
+	}
+	const uint64_t end = testCycles();
+	printResult(name, 1, uint64_t(ROUNDS) * 2, end - start);
+}
+
+
+/**
+ * Measures the generic circular buffer macros with single byte push and pop.
+ *
+ * @tparam BUF_SIZE - buffer size
+ * @param[in] name - benchmark name
+ */
+template <uint32_t BUF_SIZE>
+void benchFifoMacros(const char * name) {
+	static uint8_t buf[BUF_SIZE];
+	static volatile uint8_t head;
+	static uint8_t tail;
+	#define HANDLE buf, BUF_SIZE, head, tail
+	_FIFOX_INIT(HANDLE);
+	const uint64_t start = testCycles();
+	for (uint32_t i = 0; i < ROUNDS; i++) {
+		_FIFOX_PUSH(HANDLE, uint8_t(i));
+		testKeep(_FIFOX_POP(HANDLE));
+	}
+	const uint64_t end = testCycles();
+	#undef HANDLE
+	printResult(name, 1, uint64_t(ROUNDS) * 2, end - start);
+}
+
+
+/**
+ * Measures the block FIFO as used by the USB transmission path.
+ */
+void benchBlockFifo() {
+	typedef _BlockFifoClass<256, 64> Fifo;
+	static Fifo fifo;
+	uint8_t buf[64];
+	memset(buf, 0x55, sizeof(buf));
+	fifo.clear();
+	const uint64_t start = testCycles();
+	for (uint32_t i = 0; i < ROUNDS; i++) {
+		fifo.write(buf, sizeof(buf));
+		fifo.commitBlock();
+		uint32_t blockSize;
+		testKeep(fifo.peek(blockSize));
+		testKeep(blockSize);
+		fifo.pop();
+	}
+	const uint64_t end = testCycles();
+	printResult("_BlockFifoClass<256,64>::write/pop", uint32_t(sizeof(buf)), uint64_t(ROUNDS) * sizeof(buf), end - start);
+}
+
+
+/**
+ * Measures bulk write and read of the block FIFO with and without per byte pushes.
+ *
+ * @param[in] name - benchmark name
+ * @param[in] perByte - set to true to write via `push()` like `write()` did before
+ */
+void benchBlockFifoBulk(const char * name, const bool perByte) {
+	typedef _BlockFifoClass<1024, 64> Fifo;
+	static Fifo fifo;
+	static uint8_t buf[Fifo::TotalSize];
+	enum { ROUNDS_BULK = ROUNDS / 64 };
+	memset(buf, 0x55, sizeof(buf));
+	fifo.clear();
+	uint64_t bytes = 0;
+	const uint64_t start = testCycles();
+	for (uint32_t i = 0; i < ROUNDS_BULK; i++) {
+		const uint32_t len = fifo.availableForWrite();
+		uint32_t written = 0;
+		if ( perByte ) {
+			for (; written < len && fifo.push(buf[written]); written++);
+		} else {
+			written = fifo.write(buf, len);
+		}
+		fifo.commitBlock();
+		testKeep(fifo.availableForRead());
+		bytes += fifo.read(buf, sizeof(buf));
+		testKeep(written);
+	}
+	const uint64_t end = testCycles();
+	printResult(name, Fifo::TotalSize, bytes, end - start);
+}
+} /* anonymous namespace */
+
+
+int main() {
+	typedef _FifoClass<1024> Fifo;
+	static const uint32_t chunks[] = {1, 16, 64, 512};
+	/* modulo vs. mask vs. free-running counters */
+	benchFifoMacros<60>("_FIFOX_PUSH/_FIFOX_POP size 60");
+	benchFifoMacros<64>("_FIFOX_PUSH/_FIFOX_POP size 64");
+	benchBytePushPop< _FifoClass<1000> >("_FifoClass<1000>::push/pop");
+	benchBytePushPop<Fifo>("_FifoClass<1024>::push/pop");
+	benchBytePushPop< _FifoClass<1024, true> >("_FifoClass<1024,true>::push/pop");
+	benchRead<_FifoClass<1000>, ReadBulk>("_FifoClass<1000>::read", 16);
+	benchRead<Fifo, ReadBulk>("_FifoClass<1024>::read", 16);
+	benchRead<_FifoClass<1024, true>, ReadBulk>("_FifoClass<1024,true>::read", 16);
+	/* read strategies */
+	for (size_t i = 0; i < (sizeof(chunks) / sizeof(*chunks)); i++) {
+		benchRead<Fifo, ReadPerByte>("_FifoClass<1024>::read (per byte)", chunks[i]);
+		benchRead<Fifo, ReadBulk>("_FifoClass<1024>::read", chunks[i]);
+		benchRead<Fifo, ReadSpan>("_FifoClass<1024>::peek(span)/consume", chunks[i]);
+	}
+	benchBlockFifo();
+	benchBlockFifoBulk("_BlockFifoClass<1024,64>::push/read", true);
+	benchBlockFifoBulk("_BlockFifoClass<1024,64>::write/read", false);
+	return EXIT_SUCCESS;
+}
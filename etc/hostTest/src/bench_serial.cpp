@@ -0,0 +1,131 @@
+/**
+ * @file bench_serial.cpp
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ *
+ * Benchmarks for the HardwareSerial interrupt handlers.
+ * The cycles spent within the UART interrupt handler are measured via `DWT->CYCCNT` which
+ * follows the time stamp counter of the host (see `testCycles()`). The same measurement is
+ * done on the target by examples/NUCLEO-L432KC/SerialIrq.
+ */
+#include "hosttest.h"
+#include "Arduino.h"
+
+
+extern "C" void STM32CubeDuinoIrqHandlerForUSART1(void);
+
+
+HardwareSerial Serial1(USART1, USART1_IRQn, PA_10, PA_9, 7, 7);
+
+
+namespace {
+enum {
+	ROUNDS = 200000,
+	BURST = 32
+};
+
+
+/** Cycles needed to read the cycle counter twice. */
+uint32_t overhead = 0;
+
+
+/**
+ * Prints a single benchmark result.
+ *
+ * @param[in] name - benchmark name
+ * @param[in] bytes - number of bytes processed
+ * @param[in] cycles - number of cycles spent in the interrupt handler
+ */
+void printResult(const char * name, const uint64_t bytes, const uint64_t cycles) {
+	printf("%-36s %8.1f cycles/byte\n", name, double(cycles) / double(bytes));
+}
+
+
+/**
+ * Determines the overhead of the measurement itself.
+ */
+void calibrate() {
+	uint64_t cycles = 0;
+	for (uint32_t i = 0; i < ROUNDS; i++) {
+		const uint32_t start = DWT->CYCCNT;
+		cycles += DWT->CYCCNT - start;
+	}
+	overhead = uint32_t(cycles / ROUNDS);
+}
+
+
+/**
+ * Calls the UART interrupt handler and returns the number of cycles spent in it.
+ *
+ * @return cycles
+ */
+uint32_t measureIrq() {
+	const uint32_t start = DWT->CYCCNT;
+	STM32CubeDuinoIrqHandlerForUSART1();
+	const uint32_t cycles = DWT->CYCCNT - start;
+	return (cycles > overhead) ? (cycles - overhead) : 0;
+}
+
+
+/**
+ * Measures the interrupt handler for the reception of single bytes. The interrupts are
+ * disabled to call the handler directly once a byte was received.
+ *
+ * @param[in] name - benchmark name
+ * @param[in] fastIrq - true to use the register level interrupt handler
+ */
+void benchRx(const char * name, const bool fastIrq) {
+	Serial1.end();
+	Serial1.setFastIrq(fastIrq);
+	Serial1.begin(115200);
+	uint64_t cycles = 0;
+	__disable_irq();
+	for (uint32_t i = 0; i < ROUNDS; i++) {
+		const uint8_t val = uint8_t(i);
+		mockUartReceive(USART1, &val, 1);
+		cycles += measureIrq();
+		testKeep(Serial1.read());
+	}
+	__enable_irq();
+	printResult(name, ROUNDS, cycles);
+}
+
+
+/**
+ * Measures the interrupt handler for the transmission of bursts of bytes. The handler is called
+ * each time the UART shifted out a byte, including the final transmission complete interrupt.
+ *
+ * @param[in] name - benchmark name
+ * @param[in] fastIrq - true to use the register level interrupt handler
+ */
+void benchTx(const char * name, const bool fastIrq) {
+	uint8_t buf[BURST];
+	memset(buf, 0x55, sizeof(buf));
+	Serial1.end();
+	Serial1.setFastIrq(fastIrq);
+	Serial1.begin(115200);
+	uint64_t cycles = 0;
+	__disable_irq();
+	for (uint32_t i = 0; i < (ROUNDS / BURST); i++) {
+		Serial1.write(buf, sizeof(buf));
+		cycles += measureIrq();
+		while (mockUartTransmit(USART1, 1) > 0) cycles += measureIrq();
+		mockUartFetch(USART1, buf, sizeof(buf));
+	}
+	__enable_irq();
+	printResult(name, (ROUNDS / BURST) * BURST, cycles);
+}
+} /* anonymous namespace */
+
+
+int main() {
+	calibrate();
+	benchRx("HAL_UART_IRQHandler RX", false);
+	benchRx("HardwareSerial::fastIrqHandler RX", true);
+	benchTx("HAL_UART_IRQHandler TX", false);
+	benchTx("HardwareSerial::fastIrqHandler TX", true);
+	Serial1.end();
+	return EXIT_SUCCESS;
+}
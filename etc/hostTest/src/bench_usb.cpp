@@ -0,0 +1,104 @@
+/**
+ * @file bench_usb.cpp
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ *
+ * Benchmarks for the USB CDC upload path using the simulated USB FS device.
+ * The results are given in bytes per time stamp counter tick (see `testCycles()`). The time
+ * includes the simulated host which is the same for all variants.
+ */
+#include "hosttest.h"
+#include "Arduino.h"
+
+
+namespace {
+enum {
+	EP_OUT = 2,
+	UPLOAD_BYTES = 1 << 22
+};
+
+
+/** Data sent by the simulated host on the CDC OUT endpoint. */
+struct HostOutBuffer {
+	uint8_t packet[USB_EP_SIZE];
+	size_t size;
+	size_t pos;
+} hostOutData;
+
+
+/**
+ * Sends the next OUT packet to the CDC OUT endpoint like a host would. Also used as idle hook
+ * while the device waits for data.
+ */
+void pushHostOut(void * /* user */) {
+	if (hostOutData.pos >= hostOutData.size) return;
+	const size_t remaining = hostOutData.size - hostOutData.pos;
+	const size_t packetLen = (remaining > USB_EP_SIZE) ? USB_EP_SIZE : remaining;
+	const int sent = mockUsbHostOut(EP_OUT, hostOutData.packet, packetLen);
+	if (sent > 0) hostOutData.pos += size_t(sent);
+}
+
+
+/**
+ * Prints a single benchmark result.
+ *
+ * @param[in] name - benchmark name
+ * @param[in] chunk - bytes per read
+ * @param[in] bytes - total number of bytes processed
+ * @param[in] ticks - total number of ticks needed
+ */
+void printResult(const char * name, const uint32_t chunk, const uint64_t bytes, const uint64_t ticks) {
+	printf("%-36s %4u byte: %8.3f bytes/tick\n", name, unsigned(chunk), double(bytes) / double(ticks));
+}
+
+
+/**
+ * Measures the upload with reads of the given chunk size. Chunks of at least `USB_EP_SIZE` bytes
+ * are received directly into the passed buffer. A chunk size of 1 uses `read()`.
+ *
+ * @param[in] name - benchmark name
+ * @param[in] chunk - number of bytes per read
+ */
+void benchUpload(const char * name, const uint32_t chunk) {
+	static uint8_t buf[4096];
+	hostOutData.size = UPLOAD_BYTES;
+	hostOutData.pos = 0;
+	mockSetIdleHook(pushHostOut, NULL);
+	size_t received = 0;
+	const uint64_t start = testCycles();
+	while (received < UPLOAD_BYTES) {
+		int len;
+		if (chunk == 1) {
+			const int val = SerialUSB.read();
+			len = (val >= 0) ? 1 : 0;
+			testKeep(val);
+		} else {
+			len = SerialUSB.read(buf, chunk);
+		}
+		if (len > 0) {
+			received += size_t(len);
+		} else {
+			pushHostOut(NULL);
+		}
+	}
+	const uint64_t ticks = testCycles() - start;
+	mockSetIdleHook(NULL, NULL);
+	testKeep(buf);
+	printResult(name, chunk, received, ticks);
+}
+} /* anonymous namespace */
+
+
+int main() {
+	USBDevice.init();
+	TEST_ASSERT(USBDevice.attach());
+	SerialUSB.begin(115200);
+	TEST_ASSERT(mockUsbEnumerate() == 0);
+	TEST_ASSERT(mockUsbControl(0x21, CDC_SET_CONTROL_LINE_STATE, 0x0003 /* DTR | RTS */, 0, 0, NULL) == 0);
+	benchUpload("Serial_::read()", 1);
+	benchUpload("Serial_::read(buffer, size) FIFO", USB_EP_SIZE - 1);
+	benchUpload("Serial_::read(buffer, size) direct", 4096);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file hosttest.h
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ *
+ * Minimal helpers for host based unit tests and benchmarks.
+ */
+#ifndef __HOSTTEST_H__
+#define __HOSTTEST_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+
+/** Aborts the test with an error message if the given expression evaluates to false. */
+#define TEST_ASSERT(exp) \
+	do { \
+		if ( ! (exp) ) { \
+			fprintf(stderr, "%s:%i: failed assertion: %s\n", __FILE__, int(__LINE__), #exp); \
+			exit(EXIT_FAILURE); \
+		} \
+	} while ( false )
+
+
+/** Runs the given test function and reports its name. */
+#define TEST_RUN(fn) \
+	do { \
+		printf("%s\n", #fn); \
+		fflush(stdout); \
+		fn(); \
+	} while ( false )
+
+
+/**
+ * Returns a monotonic time stamp counter. This is the CPU cycle counter on x86
+ * and the nanosecond counter on all other hosts.
+ *
+ * @return time stamp
+ */
+static inline uint64_t testCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t(ts.tv_sec) * 1000000000U) + uint64_t(ts.tv_nsec);
+#endif
+}
+
+
+/** Prevents the compiler from optimizing out the given value. */
+template <typename T>
+static inline void testKeep(const T & val) {
+	__asm__ __volatile__("" : : "g"(&val) : "memory");
+}
+
+
+#endif /* __HOSTTEST_H__ */
@@ -0,0 +1,41 @@
+/**
+ * @file arduino.cpp
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ *
+ * Replaces the MCU specific parts of Arduino.cpp for the host build.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "Arduino.h"
+
+
+extern "C" {
+void yield(void) {
+	mockIdle();
+}
+
+
+void serialEventRun(void) {}
+
+
+uint32_t micros(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return uint32_t((uint64_t(ts.tv_sec) * 1000000U) + (uint64_t(ts.tv_nsec) / 1000U));
+}
+
+
+void pinModeEx(const uint32_t pin, const uint32_t /* mode */, const uint32_t /* altFn */) {
+	if (pin == uint32_t(NC)) systemErrorHandler();
+}
+} /* extern "C" */
+
+
+void systemErrorHandler() {
+	fprintf(stderr, "Error: systemErrorHandler() was called.\n");
+	abort();
+}
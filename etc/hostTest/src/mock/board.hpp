@@ -0,0 +1,42 @@
+/**
+ * @file board.hpp
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ *
+ * Host test board using the simulated STM32 HAL.
+ */
+#ifndef __BOARD_HPP__
+#define __BOARD_HPP__
+
+#include <stdint.h>
+#include "stm32mock.h"
+
+
+#define USB_VID 0x0483
+#define USB_PID 0x5740
+#define USB_TX_TRANSACTIONAL
+#define USB_DBL_BUF
+#define USB_TX_SIZE (USB_EP_SIZE * 8)
+
+#define USB_IRQ_PRIO 0
+#define USB_IRQ_SUBPRIO 0
+
+#define UART_IRQ_PRIO 1
+#define UART_IRQ_SUBPRIO 0
+
+#define EXTI_IRQ_PRIO 3
+#define EXTI_IRQ_SUBPRIO 0
+
+#define TIMER_IRQ_PRIO 4
+#define TIMER_IRQ_SUBPRIO 0
+
+#define I2C_IRQ_PRIO 5
+#define I2C_IRQ_SUBPRIO 0
+
+#define SYSTICK_IRQ_PRIO 15
+#define SYSTICK_IRQ_SUBPRIO 0
+
+
+#endif /* __BOARD_HPP__ */
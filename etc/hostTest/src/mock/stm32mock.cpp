@@ -0,0 +1,1413 @@
+/**
+ * @file stm32mock.cpp
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ *
+ * Simulation of the STM32 HAL functions declared in stm32mock.h.
+ * Interrupts are delivered synchronously in the context of the function which raised them
+ * if they are enabled in the NVIC, not masked by PRIMASK and have a higher priority than
+ * the currently active interrupt. Otherwise, they remain pending until these conditions
+ * are met.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <string>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "stm32mock.h"
+
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE MAP_FIXED
+#endif
+
+
+/* UART status and data register access of the selected register model */
+#ifdef MOCK_UART_SR
+#define MOCK_UART_STATUS(x) ((x)->SR)
+#define MOCK_UART_RDR(x)    ((x)->DR)
+#define MOCK_UART_TDR(x)    ((x)->DR)
+#define MOCK_UART_RX(x)     ((x)->DR.rx)
+#define MOCK_UART_TX(x)     ((x)->DR.tx)
+#else /* not MOCK_UART_SR */
+#define MOCK_UART_STATUS(x) ((x)->ISR)
+#define MOCK_UART_RDR(x)    ((x)->RDR)
+#define MOCK_UART_TDR(x)    ((x)->TDR)
+#define MOCK_UART_RX(x)     ((x)->RDR.value)
+#define MOCK_UART_TX(x)     ((x)->TDR.value)
+#endif /* not MOCK_UART_SR */
+
+
+/* weak references to the IRQ handlers provided by STM32CubeDuino */
+extern "C" {
+void STM32CubeDuinoIrqHandlerForUSART1(void) __attribute__((weak));
+void STM32CubeDuinoIrqHandlerForUSART2(void) __attribute__((weak));
+void STM32CubeDuinoIrqHandlerForDMA1_CH6(void) __attribute__((weak));
+void STM32CubeDuinoIrqHandlerForDMA1_CH7(void) __attribute__((weak));
+void STM32CubeDuinoIrqHandlerForUSB(void) __attribute__((weak));
+} /* extern "C" */
+
+
+SCB_Type mockScb;
+SysTick_Type mockSysTick;
+DWT_Type mockDwt;
+uint32_t SystemCoreClock = 80000000;
+
+
+namespace {
+enum {
+	UART_INSTANCES = 2,
+	DMA_CHANNELS = 7,
+	DMA1_CHANNEL1_IRQN = 11,
+	USB_EVENT_COUNT = 64,
+	USB_EP_COUNT = 8
+};
+
+
+/** NVIC state. */
+struct MockNvic {
+	bool enabled[MOCK_IRQn_COUNT];
+	bool pending[MOCK_IRQn_COUNT];
+	uint32_t priority[MOCK_IRQn_COUNT];
+	uint32_t count[MOCK_IRQn_COUNT];
+	MockIrqHandler handler[MOCK_IRQn_COUNT];
+};
+
+
+/** UART simulation state. */
+struct MockUart {
+	USART_TypeDef * instance;
+	IRQn_Type irq;
+	UART_HandleTypeDef * handle;
+	std::string wire; /**< data sent out on the TX line */
+	bool ctsDeasserted; /**< remote side is not ready to receive */
+};
+
+
+/** DMA channel simulation state. */
+struct MockDmaChannel {
+	uint8_t * mem; /**< memory address (CMAR cannot hold host pointers) */
+	uint32_t length; /**< programmed number of data items */
+};
+
+
+/** USB PCD event types. */
+enum MockUsbEventType {
+	USB_EVENT_RESET,
+	USB_EVENT_SETUP,
+	USB_EVENT_DATA_OUT,
+	USB_EVENT_DATA_IN,
+	USB_EVENT_SOF
+};
+
+
+/** USB PCD event. */
+struct MockUsbEvent {
+	MockUsbEventType type;
+	uint8_t ep;
+};
+
+
+MockNvic nvic;
+uint32_t primask = 0;
+MockIdleHook idleHook = NULL;
+void * idleHookUser = NULL;
+uint32_t tickOffset = 0;
+MockUart uart[UART_INSTANCES];
+MockDmaChannel dmaChannel[DMA_CHANNELS];
+PCD_HandleTypeDef * pcd = NULL;
+MockUsbEvent usbEvents[USB_EVENT_COUNT];
+size_t usbEventHead = 0;
+size_t usbEventTail = 0;
+bool usbStalled = false;
+uint32_t usbTransfers[2 * USB_EP_COUNT];
+
+
+/**
+ * Maps the peripheral address space to the original STM32 addresses before any
+ * global constructor is executed. This keeps `XXX_BASE` constant expressions
+ * usable in `switch` statements.
+ */
+__attribute__((constructor(101))) void mockMapPeripherals() {
+	static const struct { uintptr_t base; size_t size; } regions[] = {
+		{PERIPH_BASE, 0x20000},
+		{AHB1PERIPH_BASE, 0x1000},
+		{AHB2PERIPH_BASE, 0x1000}
+	};
+	for (size_t i = 0; i < (sizeof(regions) / sizeof(*regions)); i++) {
+		void * ptr = mmap(reinterpret_cast<void *>(regions[i].base), regions[i].size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+		if (ptr != reinterpret_cast<void *>(regions[i].base)) {
+			fprintf(stderr, "Error: Failed to map peripheral memory at 0x%08lX.\n", static_cast<unsigned long>(regions[i].base));
+			abort();
+		}
+	}
+	uart[0].instance = USART1;
+	uart[0].irq = USART1_IRQn;
+	uart[1].instance = USART2;
+	uart[1].irq = USART2_IRQn;
+	mockReset();
+}
+
+
+/**
+ * Returns the monotonic host time in milliseconds.
+ *
+ * @return milliseconds
+ */
+uint32_t hostMillis() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return uint32_t((uint64_t(ts.tv_sec) * 1000U) + (uint64_t(ts.tv_nsec) / 1000000U));
+}
+
+
+/**
+ * Returns the host time stamp counter. This is the same as `testCycles()`.
+ *
+ * @return time stamp
+ */
+uint64_t hostCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t(ts.tv_sec) * 1000000000U) + uint64_t(ts.tv_nsec);
+#endif
+}
+
+
+/**
+ * Returns the priority of the currently active interrupt.
+ *
+ * @return priority or UINT32_MAX in thread mode
+ */
+uint32_t activePriority() {
+	const uint32_t active = SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk;
+	if (active < 16) return UINT32_MAX;
+	return nvic.priority[active - 16];
+}
+
+
+/**
+ * Returns whether a UART with the given interrupt has an enabled interrupt source with its
+ * flag set. These keep the interrupt line asserted like on the target.
+ *
+ * @param[in] IRQn - interrupt number
+ * @return true if an interrupt is requested, else false
+ */
+bool uartIrqRequested(const int IRQn) {
+	for (size_t i = 0; i < UART_INSTANCES; i++) {
+		if (uart[i].irq != IRQn || uart[i].instance == NULL) continue;
+		const uint32_t isr = MOCK_UART_STATUS(uart[i].instance);
+		const uint32_t cr1 = uart[i].instance->CR1;
+		if ((isr & UART_FLAG_RXNE) != 0 && (cr1 & USART_CR1_RXNEIE) != 0) return true;
+		if ((isr & UART_FLAG_TXE) != 0 && (cr1 & USART_CR1_TXEIE) != 0) return true;
+		if ((isr & UART_FLAG_TC) != 0 && (cr1 & USART_CR1_TCIE) != 0) return true;
+		if ((isr & UART_FLAG_PE) != 0 && (cr1 & USART_CR1_PEIE) != 0) return true;
+#ifdef USART_CR1_CMIE
+		if ((isr & USART_ISR_CMF) != 0 && (cr1 & USART_CR1_CMIE) != 0) return true;
+#endif /* USART_CR1_CMIE */
+		if ((isr & (UART_FLAG_FE | UART_FLAG_NE | UART_FLAG_ORE)) != 0 && (uart[i].instance->CR3 & USART_CR3_EIE) != 0) return true;
+	}
+	return false;
+}
+
+
+/**
+ * Delivers all pending interrupts which are allowed to preempt the current context.
+ */
+void dispatchIrqs() {
+	for (;;) {
+		if (primask != 0) return;
+		const uint32_t current = activePriority();
+		int next = -1;
+		for (int i = 0; i < MOCK_IRQn_COUNT; i++) {
+			if ( ! (nvic.pending[i] && nvic.enabled[i]) ) continue;
+			if (nvic.priority[i] >= current) continue;
+			if (next < 0 || nvic.priority[i] < nvic.priority[next]) next = i;
+		}
+		if (next < 0) return;
+		nvic.pending[next] = false;
+		nvic.count[next]++;
+		const uint32_t savedIcsr = SCB->ICSR;
+		SCB->ICSR = (savedIcsr & ~SCB_ICSR_VECTACTIVE_Msk) | uint32_t(next + 16);
+		if (nvic.handler[next] != NULL) nvic.handler[next]();
+		SCB->ICSR = savedIcsr;
+		/* interrupt requests of the UARTs are level triggered */
+		if ( uartIrqRequested(next) ) nvic.pending[next] = true;
+	}
+}
+
+
+/**
+ * Returns the UART simulation state of the given instance.
+ *
+ * @param[in] instance - UART instance
+ * @return simulation state or NULL
+ */
+MockUart * getUart(const USART_TypeDef * instance) {
+	for (size_t i = 0; i < UART_INSTANCES; i++) {
+		if (uart[i].instance == instance) return uart + i;
+	}
+	return NULL;
+}
+
+
+/**
+ * Returns the zero based channel index of the given DMA1 channel.
+ *
+ * @param[in] instance - DMA channel instance
+ * @return channel index
+ */
+uint32_t getDmaIndex(const DMA_Channel_TypeDef * instance) {
+	return uint32_t((reinterpret_cast<uintptr_t>(instance) - (DMA1_BASE + 0x08)) / 0x14);
+}
+
+
+/**
+ * Programs and enables the given DMA channel.
+ *
+ * @param[in,out] hdma - DMA handle
+ * @param[in,out] mem - memory address
+ * @param[in] length - number of data items
+ */
+void dmaStart(DMA_HandleTypeDef * hdma, uint8_t * mem, const uint32_t length) {
+	const uint32_t idx = getDmaIndex(hdma->Instance);
+	dmaChannel[idx].mem = mem;
+	dmaChannel[idx].length = length;
+	DMA1->ISR &= ~((DMA_ISR_GIF1 | DMA_ISR_TCIF1 | DMA_ISR_HTIF1 | DMA_ISR_TEIF1) << (4 * idx));
+	hdma->Instance->CNDTR = length;
+	hdma->Instance->CCR |= DMA_CCR_EN | DMA_CCR_TCIE | DMA_CCR_HTIE | DMA_CCR_TEIE;
+	hdma->State = HAL_DMA_STATE_BUSY;
+}
+
+
+/**
+ * Advances the given DMA channel by one transferred data item and raises the half and
+ * full transfer interrupts if needed.
+ *
+ * @param[in,out] instance - DMA channel instance
+ */
+void dmaAdvance(DMA_Channel_TypeDef * instance) {
+	const uint32_t idx = getDmaIndex(instance);
+	MockDmaChannel & ch = dmaChannel[idx];
+	instance->CNDTR--;
+	uint32_t flags = 0;
+	if ((ch.length - instance->CNDTR) == (ch.length / 2)) flags |= DMA_ISR_HTIF1;
+	if (instance->CNDTR == 0) {
+		flags |= DMA_ISR_TCIF1;
+		if ((instance->CCR & DMA_CCR_CIRC) != 0) {
+			instance->CNDTR = ch.length;
+		} else {
+			instance->CCR &= ~DMA_CCR_EN;
+		}
+	}
+	if (flags != 0) {
+		DMA1->ISR |= (flags | DMA_ISR_GIF1) << (4 * idx);
+		mockRaiseIrq(IRQn_Type(DMA1_CHANNEL1_IRQN + idx));
+	}
+}
+
+
+/**
+ * Returns the memory address of the next data item of the given DMA channel.
+ *
+ * @param[in] instance - DMA channel instance
+ * @return memory address or NULL if the channel is disabled
+ */
+uint8_t * dmaCurrent(const DMA_Channel_TypeDef * instance) {
+	if ((instance->CCR & DMA_CCR_EN) == 0 || instance->CNDTR == 0) return NULL;
+	const MockDmaChannel & ch = dmaChannel[getDmaIndex(instance)];
+	return ch.mem + (ch.length - instance->CNDTR);
+}
+
+
+/**
+ * Performs a single peripheral to memory transfer on the given DMA channel.
+ *
+ * @param[in,out] instance - DMA channel instance
+ * @param[in] val - transferred value
+ * @return true if the channel was enabled, else false
+ */
+bool dmaPeriphToMemory(DMA_Channel_TypeDef * instance, const uint8_t val) {
+	uint8_t * ptr = dmaCurrent(instance);
+	if (ptr == NULL) return false;
+	*ptr = val;
+	dmaAdvance(instance);
+	return true;
+}
+
+
+/**
+ * Serves the DMA transmission request of the given UART if the transmit data register is empty.
+ *
+ * @param[in,out] obj - UART simulation state
+ */
+void uartDmaTxRequest(MockUart * obj) {
+	USART_TypeDef * regs = obj->instance;
+	if ((regs->CR3 & USART_CR3_DMAT) == 0 || (MOCK_UART_STATUS(regs) & UART_FLAG_TXE) == 0) return;
+	if (obj->handle == NULL || obj->handle->hdmatx == NULL) return;
+	const uint8_t * ptr = dmaCurrent(obj->handle->hdmatx->Instance);
+	if (ptr == NULL) return;
+	MOCK_UART_TDR(regs) = *ptr;
+	MOCK_UART_STATUS(regs) &= ~(UART_FLAG_TXE | UART_FLAG_TC);
+	dmaAdvance(obj->handle->hdmatx->Instance);
+}
+
+
+/**
+ * Serves the DMA reception request of the given UART if the receive data register is not empty.
+ *
+ * @param[in,out] obj - UART simulation state
+ */
+void uartDmaRxRequest(MockUart * obj) {
+	USART_TypeDef * regs = obj->instance;
+	if ((regs->CR3 & USART_CR3_DMAR) == 0 || (MOCK_UART_STATUS(regs) & UART_FLAG_RXNE) == 0) return;
+	if (obj->handle == NULL || obj->handle->hdmarx == NULL) return;
+	MOCK_UART_STATUS(regs) &= ~UART_FLAG_RXNE;
+	if ( ! dmaPeriphToMemory(obj->handle->hdmarx->Instance, uint8_t(MOCK_UART_RDR(regs))) ) MOCK_UART_STATUS(regs) |= UART_FLAG_RXNE;
+}
+
+
+/**
+ * Stops the DMA based reception of the given UART.
+ *
+ * @param[in,out] huart - UART handle
+ */
+void uartEndDmaRx(UART_HandleTypeDef * huart) {
+	huart->Instance->CR1 &= ~(USART_CR1_PEIE | USART_CR1_IDLEIE);
+	huart->Instance->CR3 &= ~(USART_CR3_EIE | USART_CR3_DMAR);
+	huart->RxState = HAL_UART_STATE_READY;
+	if (huart->hdmarx != NULL) HAL_DMA_Abort(huart->hdmarx);
+}
+
+
+/**
+ * DMA transmission complete callback of the UART. The UART transmission complete interrupt
+ * signals the end of the transmission.
+ *
+ * @param[in,out] hdma - DMA handle
+ */
+void uartDmaTxCplt(DMA_HandleTypeDef * hdma) {
+	UART_HandleTypeDef * huart = static_cast<UART_HandleTypeDef *>(hdma->Parent);
+	if ((hdma->Instance->CCR & DMA_CCR_CIRC) != 0) return;
+	huart->TxXferCount = 0;
+	huart->Instance->CR3 &= ~USART_CR3_DMAT;
+	huart->Instance->CR1 |= USART_CR1_TCIE;
+	MockUart * obj = getUart(huart->Instance);
+	if (obj != NULL && (MOCK_UART_STATUS(huart->Instance) & UART_FLAG_TC) != 0) mockRaiseIrq(obj->irq);
+}
+
+
+/**
+ * DMA reception complete callback of the UART.
+ *
+ * @param[in,out] hdma - DMA handle
+ */
+void uartDmaRxCplt(DMA_HandleTypeDef * hdma) {
+	UART_HandleTypeDef * huart = static_cast<UART_HandleTypeDef *>(hdma->Parent);
+	if ((hdma->Instance->CCR & DMA_CCR_CIRC) == 0) {
+		huart->RxXferCount = 0;
+		huart->Instance->CR1 &= ~(USART_CR1_PEIE | USART_CR1_IDLEIE);
+		huart->Instance->CR3 &= ~(USART_CR3_EIE | USART_CR3_DMAR);
+		huart->RxState = HAL_UART_STATE_READY;
+	}
+	if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE) {
+		HAL_UARTEx_RxEventCallback(huart, huart->RxXferSize);
+	} else {
+		HAL_UART_RxCpltCallback(huart);
+	}
+}
+
+
+/**
+ * DMA reception half complete callback of the UART.
+ *
+ * @param[in,out] hdma - DMA handle
+ */
+void uartDmaRxHalfCplt(DMA_HandleTypeDef * hdma) {
+	UART_HandleTypeDef * huart = static_cast<UART_HandleTypeDef *>(hdma->Parent);
+	if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE) {
+		HAL_UARTEx_RxEventCallback(huart, uint16_t(huart->RxXferSize / 2));
+	}
+}
+
+
+/**
+ * Queues a USB event and raises the USB interrupt.
+ *
+ * @param[in] type - event type
+ * @param[in] ep - associated endpoint number
+ */
+void usbQueueEvent(const MockUsbEventType type, const uint8_t ep) {
+	const size_t next = (usbEventHead + 1) % USB_EVENT_COUNT;
+	if (next == usbEventTail) {
+		fprintf(stderr, "Error: USB event queue overflow.\n");
+		abort();
+	}
+	usbEvents[usbEventHead].type = type;
+	usbEvents[usbEventHead].ep = ep;
+	usbEventHead = next;
+	mockRaiseIrq(USB_IRQn);
+}
+} /* anonymous namespace */
+
+
+MockCycleCounter::operator uint32_t() const volatile {
+	return uint32_t(hostCycles()) - this->offset;
+}
+
+
+void MockCycleCounter::operator= (const uint32_t val) volatile {
+	this->offset = uint32_t(hostCycles()) - val;
+}
+
+
+#ifdef MOCK_UART_SR
+MockUartDr::operator uint16_t() const volatile {
+	USART_TypeDef * regs = reinterpret_cast<USART_TypeDef *>(reinterpret_cast<uintptr_t>(this) - offsetof(USART_TypeDef, DR));
+	regs->SR &= ~(USART_SR_RXNE | USART_SR_IDLE | USART_SR_PE | USART_SR_FE | USART_SR_NE | USART_SR_ORE);
+	return this->rx;
+}
+
+
+void MockUartDr::operator= (const uint16_t val) volatile {
+	USART_TypeDef * regs = reinterpret_cast<USART_TypeDef *>(reinterpret_cast<uintptr_t>(this) - offsetof(USART_TypeDef, DR));
+	regs->SR &= ~(USART_SR_TXE | USART_SR_TC);
+	this->tx = val;
+}
+#else /* not MOCK_UART_SR */
+MockUartRdr::operator uint16_t() const volatile {
+	USART_TypeDef * regs = reinterpret_cast<USART_TypeDef *>(reinterpret_cast<uintptr_t>(this) - offsetof(USART_TypeDef, RDR));
+	MOCK_UART_STATUS(regs) &= ~UART_FLAG_RXNE;
+	return this->value;
+}
+
+
+void MockUartTdr::operator= (const uint16_t val) volatile {
+	USART_TypeDef * regs = reinterpret_cast<USART_TypeDef *>(reinterpret_cast<uintptr_t>(this) - offsetof(USART_TypeDef, TDR));
+	MOCK_UART_STATUS(regs) &= ~(UART_FLAG_TXE | UART_FLAG_TC);
+	this->value = val;
+}
+#endif /* not MOCK_UART_SR */
+
+
+extern "C" {
+/* core */
+void mockIdle(void) {
+	mockSysTick.VAL = 0;
+	if (idleHook != NULL) {
+		idleHook(idleHookUser);
+	} else {
+		/* default: drain one pending byte of each UART */
+		for (size_t i = 0; i < UART_INSTANCES; i++) {
+			if (uart[i].handle != NULL) mockUartTransmit(uart[i].instance, 1);
+		}
+	}
+	if (pcd != NULL) pcd->Instance->FNR = uint16_t(HAL_GetTick() & USB_FNR_FN);
+	dispatchIrqs();
+}
+
+
+uint32_t mockGetPrimask(void) {
+	return primask;
+}
+
+
+void mockSetPrimask(const uint32_t val) {
+	primask = val & 1;
+	dispatchIrqs();
+}
+
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t /* SubPriority */) {
+	if (IRQn < 0) return;
+	nvic.priority[IRQn] = PreemptPriority;
+	dispatchIrqs();
+}
+
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn) {
+	if (IRQn < 0) return;
+	nvic.enabled[IRQn] = true;
+	/* interrupt requests of the UARTs are level triggered */
+	if ( uartIrqRequested(IRQn) ) nvic.pending[IRQn] = true;
+	dispatchIrqs();
+}
+
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn) {
+	if (IRQn < 0) return;
+	nvic.enabled[IRQn] = false;
+}
+
+
+void HAL_NVIC_SetPendingIRQ(IRQn_Type IRQn) {
+	mockRaiseIrq(IRQn);
+}
+
+
+void HAL_NVIC_ClearPendingIRQ(IRQn_Type IRQn) {
+	if (IRQn < 0) return;
+	nvic.pending[IRQn] = false;
+}
+
+
+uint32_t NVIC_GetPriority(IRQn_Type IRQn) {
+	if (IRQn < 0) return 0;
+	return nvic.priority[IRQn];
+}
+
+
+uint32_t HAL_GetTick(void) {
+	return hostMillis() - tickOffset;
+}
+
+
+void HAL_Delay(uint32_t Delay) {
+	const uint32_t start = HAL_GetTick();
+	while ((HAL_GetTick() - start) < Delay) mockIdle();
+}
+
+
+/* UART */
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef * huart) {
+	MockUart * obj = getUart(huart->Instance);
+	if (obj == NULL || ! IS_UART_MODE(huart->Init.Mode)) return HAL_ERROR;
+	obj->handle = huart;
+	obj->wire.clear();
+	USART_TypeDef * regs = huart->Instance;
+	regs->CR1 = USART_CR1_UE | USART_CR1_TE | USART_CR1_RE;
+	regs->CR2 = 0;
+	regs->CR3 = huart->Init.HwFlowCtl & (USART_CR3_RTSE | USART_CR3_CTSE);
+	MOCK_UART_STATUS(regs) = UART_FLAG_TXE | UART_FLAG_TC;
+	huart->ErrorCode = HAL_UART_ERROR_NONE;
+	huart->gState = HAL_UART_STATE_READY;
+	huart->RxState = HAL_UART_STATE_READY;
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_UART_DeInit(UART_HandleTypeDef * huart) {
+	MockUart * obj = getUart(huart->Instance);
+	if (obj == NULL) return HAL_ERROR;
+	obj->handle = NULL;
+	huart->Instance->CR1 = 0;
+	huart->Instance->CR3 = 0;
+	huart->gState = HAL_UART_STATE_RESET;
+	huart->RxState = HAL_UART_STATE_RESET;
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef * huart, const uint8_t * pData, uint16_t Size) {
+	if (huart->gState != HAL_UART_STATE_READY) return HAL_BUSY;
+	if (pData == NULL || Size == 0) return HAL_ERROR;
+	huart->pTxBuffPtr = pData;
+	huart->TxXferSize = Size;
+	huart->TxXferCount = Size;
+	huart->gState = HAL_UART_STATE_BUSY_TX;
+	huart->Instance->CR1 |= USART_CR1_TXEIE;
+	MockUart * obj = getUart(huart->Instance);
+	if (obj != NULL && (MOCK_UART_STATUS(huart->Instance) & UART_FLAG_TXE) != 0) mockRaiseIrq(obj->irq);
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef * huart, const uint8_t * pData, uint16_t Size) {
+	if (huart->gState != HAL_UART_STATE_READY) return HAL_BUSY;
+	if (pData == NULL || Size == 0 || huart->hdmatx == NULL) return HAL_ERROR;
+	huart->pTxBuffPtr = pData;
+	huart->TxXferSize = Size;
+	huart->TxXferCount = Size;
+	huart->gState = HAL_UART_STATE_BUSY_TX;
+	huart->hdmatx->XferCpltCallback = uartDmaTxCplt;
+	huart->hdmatx->XferHalfCpltCallback = NULL;
+	dmaStart(huart->hdmatx, const_cast<uint8_t *>(pData), Size);
+	huart->Instance->CR3 |= USART_CR3_DMAT;
+	MockUart * obj = getUart(huart->Instance);
+	if (obj != NULL) uartDmaTxRequest(obj);
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef * huart, uint8_t * pData, uint16_t Size) {
+	if (huart->RxState != HAL_UART_STATE_READY) return HAL_BUSY;
+	if (pData == NULL || Size == 0) return HAL_ERROR;
+	huart->pRxBuffPtr = pData;
+	huart->RxXferSize = Size;
+	huart->RxXferCount = Size;
+	huart->ErrorCode = HAL_UART_ERROR_NONE;
+	huart->RxState = HAL_UART_STATE_BUSY_RX;
+	huart->Instance->CR1 |= USART_CR1_RXNEIE | USART_CR1_PEIE;
+	huart->Instance->CR3 |= USART_CR3_EIE;
+	MockUart * obj = getUart(huart->Instance);
+	if (obj != NULL && (MOCK_UART_STATUS(huart->Instance) & (UART_FLAG_RXNE | UART_FLAG_ORE)) != 0) mockRaiseIrq(obj->irq);
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef * huart, uint8_t * pData, uint16_t Size) {
+	if (huart->RxState != HAL_UART_STATE_READY) return HAL_BUSY;
+	if (pData == NULL || Size == 0 || huart->hdmarx == NULL) return HAL_ERROR;
+	huart->ReceptionType = HAL_UART_RECEPTION_TOIDLE;
+	huart->pRxBuffPtr = pData;
+	huart->RxXferSize = Size;
+	huart->RxXferCount = Size;
+	huart->ErrorCode = HAL_UART_ERROR_NONE;
+	huart->RxState = HAL_UART_STATE_BUSY_RX;
+	huart->hdmarx->XferCpltCallback = uartDmaRxCplt;
+	huart->hdmarx->XferHalfCpltCallback = uartDmaRxHalfCplt;
+	dmaStart(huart->hdmarx, pData, Size);
+	__HAL_UART_CLEAR_IDLEFLAG(huart);
+	huart->Instance->CR1 |= USART_CR1_PEIE | USART_CR1_IDLEIE;
+	huart->Instance->CR3 |= USART_CR3_EIE | USART_CR3_DMAR;
+	MockUart * obj = getUart(huart->Instance);
+	if (obj != NULL) uartDmaRxRequest(obj); /* byte held back in the receive data register */
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef * huart) {
+	huart->Instance->CR1 &= ~(USART_CR1_RXNEIE | USART_CR1_PEIE | USART_CR1_IDLEIE);
+	huart->Instance->CR3 &= ~(USART_CR3_EIE | USART_CR3_DMAR);
+	if (huart->hdmarx != NULL) HAL_DMA_Abort(huart->hdmarx);
+	huart->RxXferCount = 0;
+	huart->RxState = HAL_UART_STATE_READY;
+	huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+	return HAL_OK;
+}
+
+
+HAL_UART_StateTypeDef HAL_UART_GetState(const UART_HandleTypeDef * huart) {
+	return huart->gState | huart->RxState;
+}
+
+
+void HAL_UART_IRQHandler(UART_HandleTypeDef * huart) {
+	USART_TypeDef * regs = huart->Instance;
+	const uint32_t isr = MOCK_UART_STATUS(regs);
+	const uint32_t cr1 = regs->CR1;
+	const uint32_t errors = isr & (UART_FLAG_PE | UART_FLAG_FE | UART_FLAG_NE | UART_FLAG_ORE);
+	if (errors != 0 && ((cr1 & USART_CR1_RXNEIE) != 0 || (regs->CR3 & USART_CR3_EIE) != 0)) {
+		if ((errors & UART_FLAG_PE) != 0) huart->ErrorCode |= HAL_UART_ERROR_PE;
+		if ((errors & UART_FLAG_FE) != 0) huart->ErrorCode |= HAL_UART_ERROR_FE;
+		if ((errors & UART_FLAG_NE) != 0) huart->ErrorCode |= HAL_UART_ERROR_NE;
+		if ((errors & UART_FLAG_ORE) != 0) huart->ErrorCode |= HAL_UART_ERROR_ORE;
+		/* all errors are handled as blocking errors which abort the ongoing reception */
+		regs->CR1 &= ~(USART_CR1_RXNEIE | USART_CR1_PEIE);
+		regs->CR3 &= ~USART_CR3_EIE;
+		if ((regs->CR3 & USART_CR3_DMAR) != 0) uartEndDmaRx(huart);
+		huart->RxState = HAL_UART_STATE_READY;
+		huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+		HAL_UART_ErrorCallback(huart);
+		return;
+	}
+	if ((isr & UART_FLAG_RXNE) != 0 && (cr1 & USART_CR1_RXNEIE) != 0) {
+		const uint8_t data = uint8_t(MOCK_UART_RDR(regs));
+		MOCK_UART_STATUS(regs) &= ~UART_FLAG_RXNE;
+		*(huart->pRxBuffPtr) = data;
+		huart->pRxBuffPtr++;
+		huart->RxXferCount--;
+		if (huart->RxXferCount == 0) {
+			regs->CR1 &= ~(USART_CR1_RXNEIE | USART_CR1_PEIE);
+			regs->CR3 &= ~USART_CR3_EIE;
+			huart->RxState = HAL_UART_STATE_READY;
+			HAL_UART_RxCpltCallback(huart);
+		}
+	}
+	if ((MOCK_UART_STATUS(regs) & UART_FLAG_IDLE) != 0 && (regs->CR1 & USART_CR1_IDLEIE) != 0 && huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE) {
+		__HAL_UART_CLEAR_IDLEFLAG(huart);
+		if ((regs->CR3 & USART_CR3_DMAR) != 0 && huart->hdmarx != NULL) {
+			/* no event if the DMA completed the buffer in the same moment (already reported via TC) */
+			const uint16_t remaining = uint16_t(__HAL_DMA_GET_COUNTER(huart->hdmarx));
+			if (remaining > 0 && remaining < huart->RxXferSize) {
+				if ((huart->hdmarx->Instance->CCR & DMA_CCR_CIRC) == 0) {
+					uartEndDmaRx(huart);
+					huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+				}
+				huart->RxXferCount = remaining;
+				HAL_UARTEx_RxEventCallback(huart, uint16_t(huart->RxXferSize - remaining));
+			}
+		}
+	}
+	if ((MOCK_UART_STATUS(regs) & UART_FLAG_TXE) != 0 && (regs->CR1 & USART_CR1_TXEIE) != 0) {
+		if (huart->TxXferCount == 0) {
+			regs->CR1 &= ~USART_CR1_TXEIE;
+			regs->CR1 |= USART_CR1_TCIE;
+		} else {
+			MOCK_UART_TDR(regs) = *(huart->pTxBuffPtr);
+			MOCK_UART_STATUS(regs) &= ~(UART_FLAG_TXE | UART_FLAG_TC);
+			huart->pTxBuffPtr++;
+			huart->TxXferCount--;
+		}
+	}
+	if ((MOCK_UART_STATUS(regs) & UART_FLAG_TC) != 0 && (regs->CR1 & USART_CR1_TCIE) != 0) {
+		regs->CR1 &= ~USART_CR1_TCIE;
+		huart->gState = HAL_UART_STATE_READY;
+		HAL_UART_TxCpltCallback(huart);
+	}
+}
+
+
+__attribute__((weak)) void HAL_UART_TxCpltCallback(UART_HandleTypeDef * /* huart */) {}
+__attribute__((weak)) void HAL_UART_RxCpltCallback(UART_HandleTypeDef * /* huart */) {}
+__attribute__((weak)) void HAL_UART_ErrorCallback(UART_HandleTypeDef * /* huart */) {}
+__attribute__((weak)) void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef * /* huart */, uint16_t /* Size */) {}
+
+
+/* DMA */
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef * hdma) {
+	if (hdma == NULL || hdma->Instance == NULL || getDmaIndex(hdma->Instance) >= DMA_CHANNELS) return HAL_ERROR;
+	if ( ! IS_DMA_MODE(hdma->Init.Mode) ) return HAL_ERROR;
+	hdma->Instance->CCR = hdma->Init.Direction | hdma->Init.PeriphInc | hdma->Init.MemInc | hdma->Init.PeriphDataAlignment
+		| hdma->Init.MemDataAlignment | hdma->Init.Mode | hdma->Init.Priority;
+	hdma->Instance->CNDTR = 0;
+	hdma->ErrorCode = 0;
+	hdma->State = HAL_DMA_STATE_READY;
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef * hdma) {
+	if (hdma == NULL || hdma->Instance == NULL) return HAL_ERROR;
+	const uint32_t idx = getDmaIndex(hdma->Instance);
+	hdma->Instance->CCR = 0;
+	hdma->Instance->CNDTR = 0;
+	DMA1->ISR &= ~((DMA_ISR_GIF1 | DMA_ISR_TCIF1 | DMA_ISR_HTIF1 | DMA_ISR_TEIF1) << (4 * idx));
+	hdma->XferCpltCallback = NULL;
+	hdma->XferHalfCpltCallback = NULL;
+	hdma->XferErrorCallback = NULL;
+	hdma->XferAbortCallback = NULL;
+	hdma->State = HAL_DMA_STATE_RESET;
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef * hdma) {
+	const uint32_t idx = getDmaIndex(hdma->Instance);
+	hdma->Instance->CCR &= ~(DMA_CCR_EN | DMA_CCR_TCIE | DMA_CCR_HTIE | DMA_CCR_TEIE);
+	DMA1->ISR &= ~((DMA_ISR_GIF1 | DMA_ISR_TCIF1 | DMA_ISR_HTIF1 | DMA_ISR_TEIF1) << (4 * idx));
+	hdma->State = HAL_DMA_STATE_READY;
+	return HAL_OK;
+}
+
+
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef * hdma) {
+	const uint32_t shift = 4 * getDmaIndex(hdma->Instance);
+	const uint32_t isr = DMA1->ISR >> shift;
+	const uint32_t ccr = hdma->Instance->CCR;
+	if ((isr & DMA_ISR_HTIF1) != 0 && (ccr & DMA_CCR_HTIE) != 0) {
+		DMA1->ISR &= ~(DMA_ISR_HTIF1 << shift);
+		if ((ccr & DMA_CCR_CIRC) == 0) hdma->Instance->CCR &= ~DMA_CCR_HTIE;
+		if (hdma->XferHalfCpltCallback != NULL) hdma->XferHalfCpltCallback(hdma);
+	}
+	if ((isr & DMA_ISR_TCIF1) != 0 && (ccr & DMA_CCR_TCIE) != 0) {
+		DMA1->ISR &= ~(DMA_ISR_TCIF1 << shift);
+		if ((ccr & DMA_CCR_CIRC) == 0) {
+			hdma->Instance->CCR &= ~(DMA_CCR_TCIE | DMA_CCR_HTIE | DMA_CCR_TEIE);
+			hdma->State = HAL_DMA_STATE_READY;
+		}
+		if (hdma->XferCpltCallback != NULL) hdma->XferCpltCallback(hdma);
+	}
+	if ((DMA1->ISR >> shift & (DMA_ISR_TCIF1 | DMA_ISR_HTIF1 | DMA_ISR_TEIF1)) == 0) DMA1->ISR &= ~(DMA_ISR_GIF1 << shift);
+}
+
+
+/* USB PCD */
+HAL_StatusTypeDef HAL_PCD_Init(PCD_HandleTypeDef * hpcd) {
+	if (hpcd == NULL || hpcd->Instance != USB) return HAL_ERROR;
+	pcd = hpcd;
+	memset(hpcd->IN_ep, 0, sizeof(hpcd->IN_ep));
+	memset(hpcd->OUT_ep, 0, sizeof(hpcd->OUT_ep));
+	for (uint8_t i = 0; i < USB_EP_COUNT; i++) {
+		hpcd->IN_ep[i].num = i;
+		hpcd->IN_ep[i].is_in = 1;
+		hpcd->OUT_ep[i].num = i;
+	}
+	hpcd->USB_Address = 0;
+	usbEventHead = 0;
+	usbEventTail = 0;
+	hpcd->State = HAL_PCD_STATE_READY;
+	HAL_PCD_MspInit(hpcd);
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_PCD_DeInit(PCD_HandleTypeDef * hpcd) {
+	HAL_PCD_Stop(hpcd);
+	HAL_PCD_MspDeInit(hpcd);
+	hpcd->State = HAL_PCD_STATE_RESET;
+	pcd = NULL;
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_PCD_Start(PCD_HandleTypeDef * hpcd) {
+	hpcd->Instance->CNTR = 1;
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_PCD_Stop(PCD_HandleTypeDef * hpcd) {
+	hpcd->Instance->CNTR = 0;
+	for (uint8_t i = 0; i < USB_EP_COUNT; i++) {
+		hpcd->IN_ep[i].is_armed = 0;
+		hpcd->OUT_ep[i].is_armed = 0;
+	}
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_PCD_SetAddress(PCD_HandleTypeDef * hpcd, uint8_t address) {
+	hpcd->USB_Address = address;
+	hpcd->Instance->DADDR = uint16_t(address | 0x80);
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_PCD_EP_Open(PCD_HandleTypeDef * hpcd, uint8_t ep_addr, uint16_t ep_mps, uint8_t ep_type) {
+	PCD_EPTypeDef * ep = ((ep_addr & 0x80) != 0) ? hpcd->IN_ep + (ep_addr & 0x7) : hpcd->OUT_ep + (ep_addr & 0x7);
+	ep->maxpacket = ep_mps;
+	ep->type = ep_type;
+	ep->is_open = 1;
+	ep->is_armed = 0;
+	ep->is_stall = 0;
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_PCD_EP_Close(PCD_HandleTypeDef * hpcd, uint8_t ep_addr) {
+	PCD_EPTypeDef * ep = ((ep_addr & 0x80) != 0) ? hpcd->IN_ep + (ep_addr & 0x7) : hpcd->OUT_ep + (ep_addr & 0x7);
+	ep->is_open = 0;
+	ep->is_armed = 0;
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_PCD_EP_Receive(PCD_HandleTypeDef * hpcd, uint8_t ep_addr, uint8_t * pBuf, uint32_t len) {
+	PCD_EPTypeDef * ep = hpcd->OUT_ep + (ep_addr & 0x7);
+	ep->xfer_buff = pBuf;
+	ep->xfer_len = len;
+	ep->xfer_count = 0;
+	ep->is_armed = 1;
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_PCD_EP_Transmit(PCD_HandleTypeDef * hpcd, uint8_t ep_addr, uint8_t * pBuf, uint32_t len) {
+	PCD_EPTypeDef * ep = hpcd->IN_ep + (ep_addr & 0x7);
+	ep->xfer_buff = pBuf;
+	ep->xfer_len = len;
+	ep->xfer_count = 0;
+	ep->is_armed = 1;
+	return HAL_OK;
+}
+
+
+uint32_t HAL_PCD_EP_GetRxCount(PCD_HandleTypeDef const * hpcd, uint8_t ep_addr) {
+	return hpcd->OUT_ep[ep_addr & 0x7].xfer_count;
+}
+
+
+HAL_StatusTypeDef HAL_PCD_EP_SetStall(PCD_HandleTypeDef * hpcd, uint8_t ep_addr) {
+	PCD_EPTypeDef * ep = ((ep_addr & 0x80) != 0) ? hpcd->IN_ep + (ep_addr & 0x7) : hpcd->OUT_ep + (ep_addr & 0x7);
+	ep->is_stall = 1;
+	if ((ep_addr & 0x7) == 0) usbStalled = true;
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_PCD_EP_ClrStall(PCD_HandleTypeDef * hpcd, uint8_t ep_addr) {
+	PCD_EPTypeDef * ep = ((ep_addr & 0x80) != 0) ? hpcd->IN_ep + (ep_addr & 0x7) : hpcd->OUT_ep + (ep_addr & 0x7);
+	ep->is_stall = 0;
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_PCD_EP_Flush(PCD_HandleTypeDef * /* hpcd */, uint8_t /* ep_addr */) {
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_PCD_ActivateRemoteWakeup(PCD_HandleTypeDef * /* hpcd */) {
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_PCD_DeActivateRemoteWakeup(PCD_HandleTypeDef * /* hpcd */) {
+	return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_PCDEx_PMAConfig(PCD_HandleTypeDef * hpcd, uint16_t ep_addr, uint16_t ep_kind, uint32_t pmaadress) {
+	PCD_EPTypeDef * ep = ((ep_addr & 0x80) != 0) ? hpcd->IN_ep + (ep_addr & 0x7) : hpcd->OUT_ep + (ep_addr & 0x7);
+	if (ep_kind == PCD_SNG_BUF) {
+		ep->doublebuffer = 0;
+		ep->pmaadress = uint16_t(pmaadress);
+	} else {
+		ep->doublebuffer = 1;
+		ep->pmaaddr0 = uint16_t(pmaadress & 0xFFFF);
+		ep->pmaaddr1 = uint16_t((pmaadress >> 16) & 0xFFFF);
+	}
+	return HAL_OK;
+}
+
+
+void HAL_PCD_IRQHandler(PCD_HandleTypeDef * hpcd) {
+	while (usbEventTail != usbEventHead) {
+		const MockUsbEvent event = usbEvents[usbEventTail];
+		usbEventTail = (usbEventTail + 1) % USB_EVENT_COUNT;
+		switch (event.type) {
+		case USB_EVENT_RESET:
+			HAL_PCD_ResetCallback(hpcd);
+			break;
+		case USB_EVENT_SETUP:
+			HAL_PCD_SetupStageCallback(hpcd);
+			break;
+		case USB_EVENT_DATA_OUT:
+			HAL_PCD_DataOutStageCallback(hpcd, event.ep);
+			break;
+		case USB_EVENT_DATA_IN:
+			HAL_PCD_DataInStageCallback(hpcd, event.ep);
+			break;
+		case USB_EVENT_SOF:
+			HAL_PCD_SOFCallback(hpcd);
+			break;
+		}
+	}
+}
+
+
+__attribute__((weak)) void HAL_PCD_MspInit(PCD_HandleTypeDef * /* hpcd */) {}
+__attribute__((weak)) void HAL_PCD_MspDeInit(PCD_HandleTypeDef * /* hpcd */) {}
+__attribute__((weak)) void HAL_PCD_SetupStageCallback(PCD_HandleTypeDef * /* hpcd */) {}
+__attribute__((weak)) void HAL_PCD_DataOutStageCallback(PCD_HandleTypeDef * /* hpcd */, uint8_t /* epnum */) {}
+__attribute__((weak)) void HAL_PCD_DataInStageCallback(PCD_HandleTypeDef * /* hpcd */, uint8_t /* epnum */) {}
+__attribute__((weak)) void HAL_PCD_SOFCallback(PCD_HandleTypeDef * /* hpcd */) {}
+__attribute__((weak)) void HAL_PCD_ResetCallback(PCD_HandleTypeDef * /* hpcd */) {}
+__attribute__((weak)) void HAL_PCD_SuspendCallback(PCD_HandleTypeDef * /* hpcd */) {}
+__attribute__((weak)) void HAL_PCD_ResumeCallback(PCD_HandleTypeDef * /* hpcd */) {}
+
+
+/* simulation control */
+/**
+ * Resets the simulated core state (NVIC, PRIMASK, tick and idle hook).
+ */
+void mockReset(void) {
+	memset(&nvic, 0, sizeof(nvic));
+	nvic.handler[USART1_IRQn] = STM32CubeDuinoIrqHandlerForUSART1;
+	nvic.handler[USART2_IRQn] = STM32CubeDuinoIrqHandlerForUSART2;
+	nvic.handler[DMA1_Channel6_IRQn] = STM32CubeDuinoIrqHandlerForDMA1_CH6;
+	nvic.handler[DMA1_Channel7_IRQn] = STM32CubeDuinoIrqHandlerForDMA1_CH7;
+	nvic.handler[USB_IRQn] = STM32CubeDuinoIrqHandlerForUSB;
+	primask = 0;
+	idleHook = NULL;
+	idleHookUser = NULL;
+	tickOffset = hostMillis();
+	memset(&mockScb, 0, sizeof(mockScb));
+	memset(&mockSysTick, 0, sizeof(mockSysTick));
+	mockSysTick.LOAD = (SystemCoreClock / 1000) - 1;
+	memset(usbTransfers, 0, sizeof(usbTransfers));
+}
+
+
+/**
+ * Sets the handler for the given interrupt.
+ *
+ * @param[in] IRQn - interrupt number
+ * @param[in] handler - new handler
+ */
+void mockSetIrqHandler(IRQn_Type IRQn, MockIrqHandler handler) {
+	if (IRQn < 0) return;
+	nvic.handler[IRQn] = handler;
+}
+
+
+/**
+ * Marks the given interrupt as pending and delivers it if possible.
+ *
+ * @param[in] IRQn - interrupt number
+ */
+void mockRaiseIrq(IRQn_Type IRQn) {
+	if (IRQn < 0) return;
+	nvic.pending[IRQn] = true;
+	dispatchIrqs();
+}
+
+
+/**
+ * Sets the function which is called on each `__WFI()` to simulate external events.
+ *
+ * @param[in] hook - idle hook or NULL for the default behavior
+ * @param[in] user - user pointer passed to the hook
+ */
+void mockSetIdleHook(MockIdleHook hook, void * user) {
+	idleHook = hook;
+	idleHookUser = user;
+}
+
+
+/**
+ * Returns the number of times the given interrupt was executed since the last reset.
+ *
+ * @param[in] IRQn - interrupt number
+ * @return execution count
+ */
+uint32_t mockIrqCount(IRQn_Type IRQn) {
+	if (IRQn < 0) return 0;
+	return nvic.count[IRQn];
+}
+
+
+/**
+ * Simulates data reception on the RX line of the given UART. The receive interrupt is raised
+ * for each byte. Overrun errors are set if the previous byte was not read in time.
+ * The received bytes are directly transferred to memory if DMA reception is enabled.
+ * The character match flag is set for bytes which equal the ADD field of CR2.
+ * The line becomes idle after the last byte. The remote side stops sending once RTS is
+ * deasserted by the hardware flow control.
+ *
+ * @param[in] instance - UART instance
+ * @param[in] data - received data
+ * @param[in] len - number of bytes received
+ * @return number of bytes sent by the remote side
+ */
+size_t mockUartReceive(USART_TypeDef * instance, const uint8_t * data, size_t len) {
+	MockUart * obj = getUart(instance);
+	if (obj == NULL || (instance->CR1 & USART_CR1_RE) == 0) return 0;
+	size_t res = 0;
+	for (; res < len; res++) {
+		/* the remote side stops sending while RTS is deasserted */
+		if ( ! mockUartRts(instance) ) break;
+#ifdef USART_CR1_CMIE
+		/* character match */
+		if (data[res] == uint8_t(instance->CR2 >> USART_CR2_ADD_Pos)) MOCK_UART_STATUS(instance) |= USART_ISR_CMF;
+#endif /* USART_CR1_CMIE */
+		if ((instance->CR3 & USART_CR3_DMAR) != 0 && obj->handle != NULL && obj->handle->hdmarx != NULL) {
+			if ( dmaPeriphToMemory(obj->handle->hdmarx->Instance, data[res]) ) {
+#ifdef USART_CR1_CMIE
+				if ((MOCK_UART_STATUS(instance) & USART_ISR_CMF) != 0 && (instance->CR1 & USART_CR1_CMIE) != 0) mockRaiseIrq(obj->irq);
+#endif /* USART_CR1_CMIE */
+				continue;
+			}
+		}
+		if ((MOCK_UART_STATUS(instance) & UART_FLAG_RXNE) != 0) {
+			MOCK_UART_STATUS(instance) |= UART_FLAG_ORE;
+		} else {
+			MOCK_UART_RX(instance) = data[res];
+			MOCK_UART_STATUS(instance) |= UART_FLAG_RXNE;
+		}
+		mockRaiseIrq(obj->irq);
+	}
+	if (res > 0) {
+		MOCK_UART_STATUS(instance) |= UART_FLAG_IDLE;
+		if ((instance->CR1 & USART_CR1_IDLEIE) != 0) mockRaiseIrq(obj->irq);
+	}
+	return res;
+}
+
+
+/**
+ * Simulates the transmission of up to the given number of bytes on the TX line of the given UART.
+ *
+ * @param[in] instance - UART instance
+ * @param[in] maxBytes - maximum number of bytes to shift out
+ * @return number of bytes sent
+ */
+size_t mockUartTransmit(USART_TypeDef * instance, size_t maxBytes) {
+	MockUart * obj = getUart(instance);
+	if (obj == NULL) return 0;
+	size_t res = 0;
+	for (; res < maxBytes; res++) {
+		if ((MOCK_UART_STATUS(instance) & UART_FLAG_TXE) != 0) break; /* transmit data register empty */
+		if ((instance->CR3 & USART_CR3_CTSE) != 0 && obj->ctsDeasserted) break; /* remote side is not ready */
+		obj->wire.push_back(char(MOCK_UART_TX(instance)));
+		MOCK_UART_STATUS(instance) |= UART_FLAG_TXE | UART_FLAG_TC;
+		uartDmaTxRequest(obj);
+		if ((instance->CR1 & (USART_CR1_TXEIE | USART_CR1_TCIE)) != 0) mockRaiseIrq(obj->irq);
+	}
+	return res;
+}
+
+
+/**
+ * Retrieves the data sent on the TX line of the given UART.
+ *
+ * @param[out] buf - output buffer
+ * @param[in] maxLen - output buffer size
+ * @return number of bytes copied
+ */
+size_t mockUartFetch(USART_TypeDef * instance, uint8_t * buf, size_t maxLen) {
+	MockUart * obj = getUart(instance);
+	if (obj == NULL) return 0;
+	const size_t len = (obj->wire.size() < maxLen) ? obj->wire.size() : maxLen;
+	memcpy(buf, obj->wire.data(), len);
+	obj->wire.erase(0, len);
+	return len;
+}
+
+
+/**
+ * Returns the number of bytes sent on the TX line of the given UART which were not fetched, yet.
+ *
+ * @param[in] instance - UART instance
+ * @return number of bytes
+ */
+size_t mockUartPending(USART_TypeDef * instance) {
+	MockUart * obj = getUart(instance);
+	if (obj == NULL) return 0;
+	return obj->wire.size();
+}
+
+
+/**
+ * Simulates a reception error on the given UART.
+ *
+ * @param[in] instance - UART instance
+ * @param[in] flags - error flags (UART_FLAG_PE, UART_FLAG_FE, UART_FLAG_NE and/or UART_FLAG_ORE)
+ */
+void mockUartError(USART_TypeDef * instance, uint32_t flags) {
+	MockUart * obj = getUart(instance);
+	if (obj == NULL) return;
+	MOCK_UART_STATUS(instance) |= flags & (UART_FLAG_PE | UART_FLAG_FE | UART_FLAG_NE | UART_FLAG_ORE);
+	mockRaiseIrq(obj->irq);
+}
+
+
+/**
+ * Returns the state of the RTS output of the given UART. RTS is always asserted without
+ * hardware flow control. Otherwise, it is deasserted while the receive data register is full.
+ *
+ * @param[in] instance - UART instance
+ * @return true if asserted (ready to receive), else false
+ */
+bool mockUartRts(USART_TypeDef * instance) {
+	if ((instance->CR3 & USART_CR3_RTSE) == 0) return true;
+	return (MOCK_UART_STATUS(instance) & UART_FLAG_RXNE) == 0;
+}
+
+
+/**
+ * Returns the state of the driver enable output of the given UART. DE is asserted from the
+ * write to the transmit data register until the transmission is complete if the driver enable
+ * mode is active.
+ *
+ * @param[in] instance - UART instance
+ * @return true if asserted (transceiver drives the bus), else false
+ */
+bool mockUartDe(USART_TypeDef * instance) {
+#ifdef USART_CR3_DEM
+	if ((instance->CR3 & USART_CR3_DEM) == 0) return false;
+	return (MOCK_UART_STATUS(instance) & UART_FLAG_TC) == 0;
+#else /* not USART_CR3_DEM */
+	(void)instance;
+	return false;
+#endif /* not USART_CR3_DEM */
+}
+
+
+/**
+ * Sets the state of the CTS input of the given UART. The transmission pauses while CTS is
+ * deasserted and hardware flow control is enabled.
+ *
+ * @param[in] instance - UART instance
+ * @param[in] asserted - true if the remote side is ready to receive, else false
+ */
+void mockUartSetCts(USART_TypeDef * instance, bool asserted) {
+	MockUart * obj = getUart(instance);
+	if (obj == NULL) return;
+	obj->ctsDeasserted = ! asserted;
+}
+
+
+/**
+ * Simulates a USB bus reset by the host.
+ */
+void mockUsbHostReset(void) {
+	if (pcd == NULL) return;
+	usbStalled = false;
+	usbQueueEvent(USB_EVENT_RESET, 0);
+}
+
+
+/**
+ * Sends a setup packet to the device control endpoint.
+ *
+ * @param[in] setup - 8 byte setup packet
+ * @return 0 on success, else -1
+ */
+int mockUsbHostSetup(const uint8_t * setup) {
+	if (pcd == NULL) return -1;
+	memcpy(pcd->Setup, setup, 8);
+	pcd->OUT_ep[0].xfer_count = 8;
+	usbQueueEvent(USB_EVENT_SETUP, 0);
+	return 0;
+}
+
+
+/**
+ * Sends a single OUT packet from the host to the device.
+ *
+ * @param[in] ep - endpoint number
+ * @param[in] data - packet data
+ * @param[in] len - packet size (at most the endpoint size)
+ * @return number of bytes accepted or -1 if the endpoint replied with NAK or STALL
+ */
+int mockUsbHostOut(uint8_t ep, const uint8_t * data, size_t len) {
+	if (pcd == NULL) return -1;
+	PCD_EPTypeDef & obj = pcd->OUT_ep[ep & 0x7];
+	if (obj.is_stall || ! obj.is_armed) return -1;
+	if (len > obj.maxpacket) len = obj.maxpacket;
+	const uint32_t space = obj.xfer_len - obj.xfer_count;
+	if (len > space) len = space; /* babble; truncated */
+	if (len > 0) memcpy(obj.xfer_buff + obj.xfer_count, data, len);
+	obj.xfer_count += uint32_t(len);
+	if (len < obj.maxpacket || obj.xfer_count >= obj.xfer_len) {
+		obj.is_armed = 0;
+		usbTransfers[ep & 0x7]++;
+		usbQueueEvent(USB_EVENT_DATA_OUT, uint8_t(ep & 0x7));
+	}
+	return int(len);
+}
+
+
+/**
+ * Requests a single IN packet from the device.
+ *
+ * @param[in] ep - endpoint number
+ * @param[out] buf - packet data
+ * @param[in] maxLen - buffer size (at least the endpoint size)
+ * @return packet size or -1 if the endpoint replied with NAK or STALL
+ */
+int mockUsbHostIn(uint8_t ep, uint8_t * buf, size_t maxLen) {
+	if (pcd == NULL) return -1;
+	PCD_EPTypeDef & obj = pcd->IN_ep[ep & 0x7];
+	if (obj.is_stall || ! obj.is_armed) return -1;
+	uint32_t len = obj.xfer_len - obj.xfer_count;
+	if (len > obj.maxpacket) len = obj.maxpacket;
+	if (len > maxLen) len = uint32_t(maxLen);
+	if (len > 0) memcpy(buf, obj.xfer_buff + obj.xfer_count, len);
+	obj.xfer_count += len;
+	if (obj.xfer_count >= obj.xfer_len) {
+		obj.is_armed = 0;
+		usbTransfers[USB_EP_COUNT + (ep & 0x7)]++;
+		usbQueueEvent(USB_EVENT_DATA_IN, uint8_t(0x80 | (ep & 0x7)));
+	}
+	return int(len);
+}
+
+
+/**
+ * Performs a complete control transfer on the default control endpoint.
+ *
+ * @param[in] bmRequestType - request type
+ * @param[in] bRequest - request
+ * @param[in] wValue - value
+ * @param[in] wIndex - index
+ * @param[in] wLength - data stage length
+ * @param[in,out] data - data stage buffer
+ * @return number of bytes transferred within the data stage or -1 on error
+ */
+int mockUsbControl(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, uint16_t wLength, uint8_t * data) {
+	enum { MAX_RETRIES = 1000 };
+	const uint8_t setup[8] = {
+		bmRequestType, bRequest,
+		uint8_t(wValue & 0xFF), uint8_t(wValue >> 8),
+		uint8_t(wIndex & 0xFF), uint8_t(wIndex >> 8),
+		uint8_t(wLength & 0xFF), uint8_t(wLength >> 8)
+	};
+	usbStalled = false;
+	if (mockUsbHostSetup(setup) != 0 || usbStalled) return -1;
+	int res = 0;
+	uint8_t packet[64];
+	if ((bmRequestType & 0x80) != 0) {
+		/* data stage IN */
+		for (int retry = 0; retry < MAX_RETRIES && res < int(wLength); ) {
+			const int len = mockUsbHostIn(0, packet, sizeof(packet));
+			if (usbStalled) return -1;
+			if (len < 0) {
+				retry++;
+				mockIdle();
+				continue;
+			}
+			const int copyLen = ((res + len) > int(wLength)) ? int(wLength) - res : len;
+			if (copyLen > 0) memcpy(data + res, packet, size_t(copyLen));
+			res += len;
+			if (len < int(pcd->IN_ep[0].maxpacket)) break; /* short packet */
+		}
+		if (res > int(wLength)) res = int(wLength);
+		/* status stage OUT */
+		for (int retry = 0; mockUsbHostOut(0, NULL, 0) < 0; retry++) {
+			if (retry >= MAX_RETRIES || usbStalled) return -1;
+			mockIdle();
+		}
+	} else {
+		/* data stage OUT */
+		for (int retry = 0; res < int(wLength); ) {
+			const size_t len = ((wLength - res) > 64) ? 64 : size_t(wLength - res);
+			const int sent = mockUsbHostOut(0, data + res, len);
+			if (usbStalled) return -1;
+			if (sent < 0) {
+				if (++retry >= MAX_RETRIES) return -1;
+				mockIdle();
+				continue;
+			}
+			res += sent;
+		}
+		/* status stage IN */
+		for (int retry = 0; mockUsbHostIn(0, packet, sizeof(packet)) < 0; retry++) {
+			if (retry >= MAX_RETRIES || usbStalled) return -1;
+			mockIdle();
+		}
+	}
+	return usbStalled ? -1 : res;
+}
+
+
+/**
+ * Resets the bus and enumerates the device with the first configuration.
+ *
+ * @return 0 on success, else -1
+ */
+int mockUsbEnumerate(void) {
+	uint8_t desc[256];
+	mockUsbHostReset();
+	if (mockUsbControl(0x00, 0x05 /* SET_ADDRESS */, 1, 0, 0, NULL) < 0) return -1;
+	if (mockUsbControl(0x80, 0x06 /* GET_DESCRIPTOR */, 0x0100, 0, 18, desc) != 18) return -1;
+	if (mockUsbControl(0x80, 0x06 /* GET_DESCRIPTOR */, 0x0200, 0, 9, desc) != 9) return -1;
+	const uint16_t total = uint16_t(desc[2] | (desc[3] << 8));
+	if (total > sizeof(desc)) return -1;
+	if (mockUsbControl(0x80, 0x06 /* GET_DESCRIPTOR */, 0x0200, 0, total, desc) != int(total)) return -1;
+	if (mockUsbControl(0x00, 0x09 /* SET_CONFIGURATION */, desc[5], 0, 0, NULL) < 0) return -1;
+	return 0;
+}
+
+
+/**
+ * Simulates the start of a new frame. The event is only delivered if start of frame
+ * interrupts were enabled via `Sof_enable`.
+ */
+void mockUsbHostSof(void) {
+	if (pcd == NULL || pcd->Init.Sof_enable == 0) return;
+	usbQueueEvent(USB_EVENT_SOF, 0);
+}
+
+
+/**
+ * Returns the number of completed transfers on the given endpoint since the last reset.
+ *
+ * @param[in] ep - endpoint address (bit 7 set for IN endpoints)
+ * @return transfer count
+ */
+uint32_t mockUsbTransferCount(uint8_t ep) {
+	return usbTransfers[(((ep & 0x80) != 0) ? USB_EP_COUNT : 0) + (ep & 0x7)];
+}
+} /* extern "C" */
@@ -0,0 +1,744 @@
+/**
+ * @file stm32mock.h
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ *
+ * Minimal STM32 Cube HAL/LL replacement to build the STM32CubeDuino core on the host.
+ * The register layout follows that of the STM32L4 series. Peripheral registers are
+ * mapped to their original addresses to keep the `switch` statements on `XXX_BASE`
+ * working. Interrupts are simulated and delivered in the context of the simulation
+ * functions (`mockXxx()`) or within `__WFI()` and `__enable_irq()`.
+ *
+ * Reading RDR and writing TDR of the UART clear the status flags like on the target.
+ * Defining MOCK_UART_SR selects the SR/DR register model of the STM32F1/F2/F4/L1 series
+ * for the UART instead. Reading DR clears IDLE and the error flags then.
+ * The UART interrupt requests are level triggered.
+ *
+ * Only the peripherals exercised on the hot paths are simulated: core (NVIC/SCB/SysTick),
+ * GPIO, DMA (channel based), UART and USB FS device (PCD). All other HAL modules are left out which disables
+ * the corresponding STM32CubeDuino functions via their detection macros.
+ */
+#ifndef __STM32MOCK_H__
+#define __STM32MOCK_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* generic HAL definitions */
+typedef enum {
+	HAL_OK = 0x00,
+	HAL_ERROR = 0x01,
+	HAL_BUSY = 0x02,
+	HAL_TIMEOUT = 0x03
+} HAL_StatusTypeDef;
+
+typedef enum {
+	HAL_UNLOCKED = 0x00,
+	HAL_LOCKED = 0x01
+} HAL_LockTypeDef;
+
+#define DISABLE 0
+#define ENABLE 1
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+#define TICK_INT_PRIORITY 15U
+#define __IO volatile
+#define SET_BIT(reg, bit)   ((reg) |= (bit))
+#define CLEAR_BIT(reg, bit) ((reg) &= ~(bit))
+#define MODIFY_REG(reg, clearMask, setMask) ((reg) = (((reg) & ~(clearMask)) | (setMask)))
+
+
+/* interrupt numbers (subset of STM32L4) */
+typedef enum {
+	NonMaskableInt_IRQn = -14,
+	SysTick_IRQn = -1,
+	DMA1_Channel6_IRQn = 16,
+	DMA1_Channel7_IRQn = 17,
+	USART1_IRQn = 37,
+	USART2_IRQn = 38,
+	USB_IRQn = 67,
+	MOCK_IRQn_COUNT = 96
+} IRQn_Type;
+
+
+/* core peripherals */
+typedef struct {
+	volatile uint32_t CPUID;
+	volatile uint32_t ICSR;
+	volatile uint32_t VTOR;
+	volatile uint32_t AIRCR;
+} SCB_Type;
+
+typedef struct {
+	volatile uint32_t CTRL;
+	volatile uint32_t LOAD;
+	volatile uint32_t VAL;
+	volatile uint32_t CALIB;
+} SysTick_Type;
+
+/** Cycle counter register which follows the host time stamp counter. */
+struct MockCycleCounter {
+	uint32_t offset;
+	operator uint32_t() const volatile;
+	void operator= (const uint32_t val) volatile;
+};
+
+typedef struct {
+	volatile uint32_t CTRL;
+	volatile MockCycleCounter CYCCNT;
+} DWT_Type;
+
+#define SCB_ICSR_VECTACTIVE_Pos 0U
+#define SCB_ICSR_VECTACTIVE_Msk (0x1FFU << SCB_ICSR_VECTACTIVE_Pos)
+
+extern SCB_Type mockScb;
+extern SysTick_Type mockSysTick;
+extern DWT_Type mockDwt;
+#define SCB (&mockScb)
+#define SysTick (&mockSysTick)
+#define DWT (&mockDwt)
+
+extern uint32_t SystemCoreClock;
+
+
+/* simulated CMSIS intrinsics */
+void mockIdle(void);
+uint32_t mockGetPrimask(void);
+void mockSetPrimask(const uint32_t val);
+
+static inline void __WFI(void) { mockIdle(); }
+static inline void __WFE(void) { mockIdle(); }
+static inline void __DMB(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+static inline void __DSB(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+static inline void __ISB(void) { __atomic_signal_fence(__ATOMIC_SEQ_CST); }
+static inline void __NOP(void) {}
+static inline uint32_t __get_PRIMASK(void) { return mockGetPrimask(); }
+static inline void __set_PRIMASK(const uint32_t val) { mockSetPrimask(val); }
+static inline void __disable_irq(void) { mockSetPrimask(1); }
+static inline void __enable_irq(void) { mockSetPrimask(0); }
+
+
+/* NVIC */
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_SetPendingIRQ(IRQn_Type IRQn);
+void HAL_NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+uint32_t NVIC_GetPriority(IRQn_Type IRQn);
+#define NVIC_EnableIRQ HAL_NVIC_EnableIRQ
+#define NVIC_DisableIRQ HAL_NVIC_DisableIRQ
+#define NVIC_SetPendingIRQ HAL_NVIC_SetPendingIRQ
+#define NVIC_ClearPendingIRQ HAL_NVIC_ClearPendingIRQ
+
+
+/* system */
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+
+
+/* memory map */
+#define PERIPH_BASE       0x40000000UL
+#define APB1PERIPH_BASE   PERIPH_BASE
+#define APB2PERIPH_BASE   (PERIPH_BASE + 0x00010000UL)
+#define AHB1PERIPH_BASE   (PERIPH_BASE + 0x00020000UL)
+#define AHB2PERIPH_BASE   (PERIPH_BASE + 0x08000000UL)
+#define USART2_BASE       (APB1PERIPH_BASE + 0x4400UL)
+#define USB_BASE          (APB1PERIPH_BASE + 0x6800UL)
+#define USB_PMAADDR       (APB1PERIPH_BASE + 0x6C00UL)
+#define USART1_BASE       (APB2PERIPH_BASE + 0x3800UL)
+#define DMA1_BASE         (AHB1PERIPH_BASE + 0x0000UL)
+#define DMA1_Channel6_BASE (DMA1_BASE + 0x006CUL)
+#define DMA1_Channel7_BASE (DMA1_BASE + 0x0080UL)
+#define GPIOA_BASE        (AHB2PERIPH_BASE + 0x0000UL)
+#define GPIOB_BASE        (AHB2PERIPH_BASE + 0x0400UL)
+
+
+/* GPIO */
+typedef struct {
+	volatile uint32_t MODER;
+	volatile uint32_t OTYPER;
+	volatile uint32_t OSPEEDR;
+	volatile uint32_t PUPDR;
+	volatile uint32_t IDR;
+	volatile uint32_t ODR;
+	volatile uint32_t BSRR;
+	volatile uint32_t LCKR;
+	volatile uint32_t AFR[2];
+	volatile uint32_t BRR;
+	volatile uint32_t ASCR;
+} GPIO_TypeDef;
+
+#define GPIOA ((GPIO_TypeDef *)GPIOA_BASE)
+#define GPIOB ((GPIO_TypeDef *)GPIOB_BASE)
+
+#define LL_GPIO_PIN_0  0x00000001U
+#define LL_GPIO_PIN_1  0x00000002U
+#define LL_GPIO_PIN_2  0x00000004U
+#define LL_GPIO_PIN_3  0x00000008U
+#define LL_GPIO_PIN_4  0x00000010U
+#define LL_GPIO_PIN_5  0x00000020U
+#define LL_GPIO_PIN_6  0x00000040U
+#define LL_GPIO_PIN_7  0x00000080U
+#define LL_GPIO_PIN_8  0x00000100U
+#define LL_GPIO_PIN_9  0x00000200U
+#define LL_GPIO_PIN_10 0x00000400U
+#define LL_GPIO_PIN_11 0x00000800U
+#define LL_GPIO_PIN_12 0x00001000U
+#define LL_GPIO_PIN_13 0x00002000U
+#define LL_GPIO_PIN_14 0x00004000U
+#define LL_GPIO_PIN_15 0x00008000U
+
+static inline uint32_t LL_GPIO_IsInputPinSet(GPIO_TypeDef * GPIOx, uint32_t PinMask) {
+	return ((GPIOx->IDR & PinMask) == PinMask) ? 1U : 0U;
+}
+static inline void LL_GPIO_SetOutputPin(GPIO_TypeDef * GPIOx, uint32_t PinMask) {
+	GPIOx->ODR |= PinMask;
+}
+static inline void LL_GPIO_ResetOutputPin(GPIO_TypeDef * GPIOx, uint32_t PinMask) {
+	GPIOx->ODR &= ~PinMask;
+}
+static inline void LL_GPIO_TogglePin(GPIO_TypeDef * GPIOx, uint32_t PinMask) {
+	GPIOx->ODR ^= PinMask;
+}
+
+#define __HAL_RCC_GPIOA_CLK_ENABLE() do { } while ( 0 )
+#define __HAL_RCC_GPIOB_CLK_ENABLE() do { } while ( 0 )
+
+
+/* DMA */
+typedef struct {
+	volatile uint32_t ISR;
+	volatile uint32_t IFCR;
+} DMA_TypeDef;
+
+typedef struct {
+	volatile uint32_t CCR;
+	volatile uint32_t CNDTR;
+	volatile uint32_t CPAR;
+	volatile uint32_t CMAR;
+} DMA_Channel_TypeDef;
+
+#define DMA1 ((DMA_TypeDef *)DMA1_BASE)
+#define DMA1_Channel6 ((DMA_Channel_TypeDef *)DMA1_Channel6_BASE)
+#define DMA1_Channel7 ((DMA_Channel_TypeDef *)DMA1_Channel7_BASE)
+
+#define DMA_CCR_EN    (1U << 0)
+#define DMA_CCR_TCIE  (1U << 1)
+#define DMA_CCR_HTIE  (1U << 2)
+#define DMA_CCR_TEIE  (1U << 3)
+#define DMA_CCR_DIR   (1U << 4)
+#define DMA_CCR_CIRC  (1U << 5)
+#define DMA_CCR_MINC  (1U << 7)
+
+/* flags per channel n (0 based) at bit position 4 * n */
+#define DMA_ISR_GIF1  (1U << 0)
+#define DMA_ISR_TCIF1 (1U << 1)
+#define DMA_ISR_HTIF1 (1U << 2)
+#define DMA_ISR_TEIF1 (1U << 3)
+
+#define DMA_REQUEST_0 0U
+#define DMA_REQUEST_1 1U
+#define DMA_REQUEST_2 2U
+#define DMA_REQUEST_3 3U
+#define DMA_REQUEST_4 4U
+#define DMA_REQUEST_5 5U
+#define DMA_REQUEST_6 6U
+#define DMA_REQUEST_7 7U
+#define DMA_PERIPH_TO_MEMORY 0x00000000U
+#define DMA_MEMORY_TO_PERIPH DMA_CCR_DIR
+#define DMA_PINC_ENABLE 0x00000040U
+#define DMA_PINC_DISABLE 0x00000000U
+#define DMA_MINC_ENABLE DMA_CCR_MINC
+#define DMA_MINC_DISABLE 0x00000000U
+#define DMA_PDATAALIGN_BYTE 0x00000000U
+#define DMA_MDATAALIGN_BYTE 0x00000000U
+#define DMA_NORMAL 0x00000000U
+#define DMA_CIRCULAR DMA_CCR_CIRC
+#define DMA_PRIORITY_LOW 0x00000000U
+#define DMA_PRIORITY_MEDIUM 0x00001000U
+#define DMA_PRIORITY_HIGH 0x00002000U
+#define DMA_PRIORITY_VERY_HIGH 0x00003000U
+
+#define IS_DMA_MODE(MODE) (((MODE) == DMA_NORMAL) || ((MODE) == DMA_CIRCULAR))
+
+typedef enum {
+	HAL_DMA_STATE_RESET = 0x00U,
+	HAL_DMA_STATE_READY = 0x01U,
+	HAL_DMA_STATE_BUSY = 0x02U,
+	HAL_DMA_STATE_TIMEOUT = 0x03U
+} HAL_DMA_StateTypeDef;
+
+typedef struct {
+	uint32_t Request;
+	uint32_t Direction;
+	uint32_t PeriphInc;
+	uint32_t MemInc;
+	uint32_t PeriphDataAlignment;
+	uint32_t MemDataAlignment;
+	uint32_t Mode;
+	uint32_t Priority;
+} DMA_InitTypeDef;
+
+typedef struct __DMA_HandleTypeDef {
+	DMA_Channel_TypeDef * Instance;
+	DMA_InitTypeDef Init;
+	HAL_LockTypeDef Lock;
+	volatile HAL_DMA_StateTypeDef State;
+	void * Parent;
+	void (* XferCpltCallback)(struct __DMA_HandleTypeDef * hdma);
+	void (* XferHalfCpltCallback)(struct __DMA_HandleTypeDef * hdma);
+	void (* XferErrorCallback)(struct __DMA_HandleTypeDef * hdma);
+	void (* XferAbortCallback)(struct __DMA_HandleTypeDef * hdma);
+	volatile uint32_t ErrorCode;
+} DMA_HandleTypeDef;
+
+#define __HAL_LINKDMA(h, field, dma) do { (h)->field = &(dma); (dma).Parent = (h); } while ( 0 )
+#define __HAL_DMA_GET_COUNTER(h) ((h)->Instance->CNDTR)
+#define __HAL_RCC_DMA1_CLK_ENABLE() do { } while ( 0 )
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef * hdma);
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef * hdma);
+HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef * hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength);
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef * hdma);
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef * hdma);
+
+
+/* UART */
+#ifdef MOCK_UART_SR
+/**
+ * UART data register of the SR/DR register model. Reading it clears RXNE, IDLE and the error
+ * flags like the status register read followed by the data register read on the target.
+ * Writing it clears TXE and TC like on the target.
+ */
+struct MockUartDr {
+	uint16_t rx;
+	uint16_t tx;
+	operator uint16_t() const volatile;
+	void operator= (const uint16_t val) volatile;
+};
+
+typedef struct {
+	volatile uint32_t SR;
+	volatile MockUartDr DR;
+	volatile uint32_t BRR;
+	volatile uint32_t CR1;
+	volatile uint32_t CR2;
+	volatile uint32_t CR3;
+	volatile uint32_t GTPR;
+} USART_TypeDef;
+#else /* not MOCK_UART_SR */
+/** UART receive data register. Reading it clears RXNE like on the target. */
+struct MockUartRdr {
+	uint16_t value;
+	operator uint16_t() const volatile;
+	void operator= (const uint16_t val) volatile { this->value = val; }
+};
+
+/** UART transmit data register. Writing it clears TXE and TC like on the target. */
+struct MockUartTdr {
+	uint16_t value;
+	operator uint16_t() const volatile { return this->value; }
+	void operator= (const uint16_t val) volatile;
+};
+
+typedef struct {
+	volatile uint32_t CR1;
+	volatile uint32_t CR2;
+	volatile uint32_t CR3;
+	volatile uint32_t BRR;
+	volatile uint16_t GTPR;
+	uint16_t RESERVED2;
+	volatile uint32_t RTOR;
+	volatile uint16_t RQR;
+	uint16_t RESERVED3;
+	volatile uint32_t ISR;
+	volatile uint32_t ICR;
+	volatile MockUartRdr RDR;
+	uint16_t RESERVED4;
+	volatile MockUartTdr TDR;
+	uint16_t RESERVED5;
+} USART_TypeDef;
+#endif /* not MOCK_UART_SR */
+
+#define USART1 ((USART_TypeDef *)USART1_BASE)
+#define USART2 ((USART_TypeDef *)USART2_BASE)
+
+#define USART_CR1_UE     (1U << 0)
+#define USART_CR1_RE     (1U << 2)
+#define USART_CR1_TE     (1U << 3)
+#define USART_CR1_IDLEIE (1U << 4)
+#define USART_CR1_RXNEIE (1U << 5)
+#define USART_CR1_TCIE   (1U << 6)
+#define USART_CR1_TXEIE  (1U << 7)
+#define USART_CR1_PEIE   (1U << 8)
+#define USART_CR3_EIE    (1U << 0)
+#define USART_CR3_DMAR   (1U << 6)
+#define USART_CR3_DMAT   (1U << 7)
+#define USART_CR3_RTSE   (1U << 8)
+#define USART_CR3_CTSE   (1U << 9)
+#ifdef MOCK_UART_SR
+/* no character match and no driver enable output like on the STM32F1/F2/F4/L1 series */
+#define USART_SR_PE      (1U << 0)
+#define USART_SR_FE      (1U << 1)
+#define USART_SR_NE      (1U << 2)
+#define USART_SR_ORE     (1U << 3)
+#define USART_SR_IDLE    (1U << 4)
+#define USART_SR_RXNE    (1U << 5)
+#define USART_SR_TC      (1U << 6)
+#define USART_SR_TXE     (1U << 7)
+#else /* not MOCK_UART_SR */
+#define USART_CR1_CMIE   (1U << 14)
+#define USART_CR1_DEDT_Pos 16U
+#define USART_CR1_DEDT   (0x1FU << USART_CR1_DEDT_Pos)
+#define USART_CR1_DEAT_Pos 21U
+#define USART_CR1_DEAT   (0x1FU << USART_CR1_DEAT_Pos)
+#define USART_CR2_ADD_Pos 24U
+#define USART_CR2_ADD    (0xFFU << USART_CR2_ADD_Pos)
+#define USART_CR3_DEM    (1U << 14)
+#define USART_CR3_DEP    (1U << 15)
+
+#define USART_ISR_PE     (1U << 0)
+#define USART_ISR_FE     (1U << 1)
+#define USART_ISR_NE     (1U << 2)
+#define USART_ISR_ORE    (1U << 3)
+#define USART_ISR_IDLE   (1U << 4)
+#define USART_ISR_RXNE   (1U << 5)
+#define USART_ISR_TC     (1U << 6)
+#define USART_ISR_TXE    (1U << 7)
+#define USART_ISR_CMF    (1U << 17)
+
+#define USART_ICR_PECF   (1U << 0)
+#define USART_ICR_FECF   (1U << 1)
+#define USART_ICR_NCF    (1U << 2)
+#define USART_ICR_ORECF  (1U << 3)
+#define USART_ICR_IDLECF (1U << 4)
+#define USART_ICR_TCCF   (1U << 6)
+#endif /* not MOCK_UART_SR */
+
+#define UART_WORDLENGTH_7B 0x10000000U
+#define UART_WORDLENGTH_8B 0x00000000U
+#define UART_WORDLENGTH_9B 0x00001000U
+#define UART_STOPBITS_1 0x00000000U
+#define UART_STOPBITS_2 0x00002000U
+#define UART_PARITY_NONE 0x00000000U
+#define UART_PARITY_EVEN 0x00000400U
+#define UART_PARITY_ODD 0x00000600U
+#define UART_MODE_RX 0x00000004U
+#define UART_MODE_TX 0x00000008U
+#define UART_MODE_TX_RX 0x0000000CU
+#define UART_HWCONTROL_NONE 0x00000000U
+#define UART_HWCONTROL_RTS 0x00000100U
+#define UART_HWCONTROL_CTS 0x00000200U
+#define UART_HWCONTROL_RTS_CTS 0x00000300U
+#define UART_OVERSAMPLING_16 0x00000000U
+#define UART_OVERSAMPLING_8 0x00008000U
+#define UART_ONE_BIT_SAMPLE_DISABLE 0x00000000U
+#define UART_ADVFEATURE_NO_INIT 0x00000000U
+
+#define HAL_UART_STATE_RESET 0x00000000U
+#define HAL_UART_STATE_READY 0x00000020U
+#define HAL_UART_STATE_BUSY 0x00000024U
+#define HAL_UART_STATE_BUSY_TX 0x00000021U
+#define HAL_UART_STATE_BUSY_RX 0x00000022U
+#define HAL_UART_STATE_BUSY_TX_RX 0x00000023U
+#define HAL_UART_STATE_ERROR 0x000000E0U
+typedef uint32_t HAL_UART_StateTypeDef;
+
+#define HAL_UART_RECEPTION_STANDARD 0x00000000U
+#define HAL_UART_RECEPTION_TOIDLE 0x00000001U
+typedef uint32_t HAL_UART_RxTypeTypeDef;
+
+#define HAL_UART_ERROR_NONE 0x00000000U
+#define HAL_UART_ERROR_PE 0x00000001U
+#define HAL_UART_ERROR_NE 0x00000002U
+#define HAL_UART_ERROR_FE 0x00000004U
+#define HAL_UART_ERROR_ORE 0x00000008U
+
+#define IS_UART_MODE(MODE) ((((MODE) & (~((uint32_t)(UART_MODE_TX_RX)))) == 0x00U) && ((MODE) != 0x00U))
+
+typedef struct {
+	uint32_t BaudRate;
+	uint32_t WordLength;
+	uint32_t StopBits;
+	uint32_t Parity;
+	uint32_t Mode;
+	uint32_t HwFlowCtl;
+	uint32_t OverSampling;
+	uint32_t OneBitSampling;
+} UART_InitTypeDef;
+
+typedef struct {
+	uint32_t AdvFeatureInit;
+	uint32_t TxPinLevelInvert;
+	uint32_t RxPinLevelInvert;
+	uint32_t DataInvert;
+	uint32_t Swap;
+	uint32_t OverrunDisable;
+	uint32_t DMADisableonRxError;
+	uint32_t AutoBaudRateEnable;
+	uint32_t AutoBaudRateMode;
+	uint32_t MSBFirst;
+} UART_AdvFeatureInitTypeDef;
+
+typedef struct __UART_HandleTypeDef {
+	USART_TypeDef * Instance;
+	UART_InitTypeDef Init;
+	UART_AdvFeatureInitTypeDef AdvancedInit;
+	const uint8_t * pTxBuffPtr;
+	uint16_t TxXferSize;
+	volatile uint16_t TxXferCount;
+	uint8_t * pRxBuffPtr;
+	uint16_t RxXferSize;
+	volatile uint16_t RxXferCount;
+	uint16_t Mask;
+	volatile HAL_UART_RxTypeTypeDef ReceptionType;
+	DMA_HandleTypeDef * hdmatx;
+	DMA_HandleTypeDef * hdmarx;
+	HAL_LockTypeDef Lock;
+	volatile HAL_UART_StateTypeDef gState;
+	volatile HAL_UART_StateTypeDef RxState;
+	volatile uint32_t ErrorCode;
+} UART_HandleTypeDef;
+
+#ifdef MOCK_UART_SR
+#define UART_FLAG_PE   USART_SR_PE
+#define UART_FLAG_FE   USART_SR_FE
+#define UART_FLAG_NE   USART_SR_NE
+#define UART_FLAG_ORE  USART_SR_ORE
+#define UART_FLAG_IDLE USART_SR_IDLE
+#define UART_FLAG_RXNE USART_SR_RXNE
+#define UART_FLAG_TC   USART_SR_TC
+#define UART_FLAG_TXE  USART_SR_TXE
+#else /* not MOCK_UART_SR */
+#define UART_FLAG_PE   USART_ISR_PE
+#define UART_FLAG_FE   USART_ISR_FE
+#define UART_FLAG_NE   USART_ISR_NE
+#define UART_FLAG_ORE  USART_ISR_ORE
+#define UART_FLAG_IDLE USART_ISR_IDLE
+#define UART_FLAG_RXNE USART_ISR_RXNE
+#define UART_FLAG_TC   USART_ISR_TC
+#define UART_FLAG_TXE  USART_ISR_TXE
+#define UART_FLAG_CMF  USART_ISR_CMF
+#define UART_CLEAR_PEF  USART_ISR_PE
+#define UART_CLEAR_FEF  USART_ISR_FE
+#define UART_CLEAR_NEF  USART_ISR_NE
+#define UART_CLEAR_OREF USART_ISR_ORE
+#define UART_CLEAR_CMF  USART_ISR_CMF
+#endif /* not MOCK_UART_SR */
+
+#define __HAL_UART_ENABLE(h)  ((h)->Instance->CR1 |= USART_CR1_UE)
+#define __HAL_UART_DISABLE(h) ((h)->Instance->CR1 &= ~USART_CR1_UE)
+#ifdef MOCK_UART_SR
+/* same as in the STM32F1 HAL: status register read followed by a data register read */
+#define __HAL_UART_CLEAR_FLAG(h, f)  ((h)->Instance->SR = ~(f))
+#define __HAL_UART_CLEAR_PEFLAG(h)   do { volatile uint32_t tmpreg = (h)->Instance->SR; tmpreg = (h)->Instance->DR; (void)tmpreg; } while ( 0 )
+#define __HAL_UART_CLEAR_FEFLAG(h)   __HAL_UART_CLEAR_PEFLAG(h)
+#define __HAL_UART_CLEAR_NEFLAG(h)   __HAL_UART_CLEAR_PEFLAG(h)
+#define __HAL_UART_CLEAR_OREFLAG(h)  __HAL_UART_CLEAR_PEFLAG(h)
+#define __HAL_UART_CLEAR_IDLEFLAG(h) __HAL_UART_CLEAR_PEFLAG(h)
+#else /* not MOCK_UART_SR */
+#define __HAL_UART_CLEAR_FLAG(h, f)  ((h)->Instance->ISR &= ~(f))
+#define __HAL_UART_CLEAR_PEFLAG(h)   __HAL_UART_CLEAR_FLAG((h), USART_ISR_PE)
+#define __HAL_UART_CLEAR_FEFLAG(h)   __HAL_UART_CLEAR_FLAG((h), USART_ISR_FE)
+#define __HAL_UART_CLEAR_NEFLAG(h)   __HAL_UART_CLEAR_FLAG((h), USART_ISR_NE)
+#define __HAL_UART_CLEAR_OREFLAG(h)  __HAL_UART_CLEAR_FLAG((h), USART_ISR_ORE)
+#define __HAL_UART_CLEAR_IDLEFLAG(h) __HAL_UART_CLEAR_FLAG((h), USART_ISR_IDLE)
+#endif /* not MOCK_UART_SR */
+
+#define __HAL_RCC_USART1_FORCE_RESET() do { } while ( 0 )
+#define __HAL_RCC_USART1_RELEASE_RESET() do { } while ( 0 )
+#define __HAL_RCC_USART1_CLK_ENABLE() do { } while ( 0 )
+#define __HAL_RCC_USART1_CLK_DISABLE() do { } while ( 0 )
+#define __HAL_RCC_USART2_FORCE_RESET() do { } while ( 0 )
+#define __HAL_RCC_USART2_RELEASE_RESET() do { } while ( 0 )
+#define __HAL_RCC_USART2_CLK_ENABLE() do { } while ( 0 )
+#define __HAL_RCC_USART2_CLK_DISABLE() do { } while ( 0 )
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef * huart);
+HAL_StatusTypeDef HAL_UART_DeInit(UART_HandleTypeDef * huart);
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef * huart, const uint8_t * pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef * huart, const uint8_t * pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef * huart, uint8_t * pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef * huart, uint8_t * pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef * huart);
+HAL_UART_StateTypeDef HAL_UART_GetState(const UART_HandleTypeDef * huart);
+void HAL_UART_IRQHandler(UART_HandleTypeDef * huart);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef * huart);
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef * huart);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef * huart);
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef * huart, uint16_t Size);
+
+
+/* USB FS device */
+typedef struct {
+	volatile uint16_t EP0R;
+	volatile uint16_t RESERVED0;
+	volatile uint16_t EP1R;
+	volatile uint16_t RESERVED1;
+	volatile uint16_t EP2R;
+	volatile uint16_t RESERVED2;
+	volatile uint16_t EP3R;
+	volatile uint16_t RESERVED3;
+	volatile uint16_t EP4R;
+	volatile uint16_t RESERVED4;
+	volatile uint16_t EP5R;
+	volatile uint16_t RESERVED5;
+	volatile uint16_t EP6R;
+	volatile uint16_t RESERVED6;
+	volatile uint16_t EP7R;
+	volatile uint16_t RESERVED7[17];
+	volatile uint16_t CNTR;
+	volatile uint16_t RESERVED8;
+	volatile uint16_t ISTR;
+	volatile uint16_t RESERVED9;
+	volatile uint16_t FNR;
+	volatile uint16_t RESERVEDA;
+	volatile uint16_t DADDR;
+	volatile uint16_t RESERVEDB;
+	volatile uint16_t BTABLE;
+	volatile uint16_t RESERVEDC;
+} USB_TypeDef;
+typedef USB_TypeDef PCD_TypeDef;
+
+#define USB ((USB_TypeDef *)USB_BASE)
+#define USB_FNR_FN 0x07FFU
+#define USB_PMASIZE 0x400U
+
+#define PCD_PHY_EMBEDDED 2U
+#define PCD_SPEED_FULL 2U
+#define PCD_SNG_BUF 0U
+#define PCD_DBL_BUF 1U
+#define PCD_ENDP0 0U
+#define PCD_ENDP1 1U
+#define PCD_ENDP2 2U
+#define PCD_ENDP3 3U
+#define PCD_ENDP4 4U
+#define PCD_ENDP5 5U
+#define PCD_ENDP6 6U
+#define PCD_ENDP7 7U
+#define EP_TYPE_CTRL 0U
+#define EP_TYPE_ISOC 1U
+#define EP_TYPE_BULK 2U
+#define EP_TYPE_INTR 3U
+#define PCD_EP_TYPE_CTRL EP_TYPE_CTRL
+#define PCD_EP_TYPE_ISOC EP_TYPE_ISOC
+#define PCD_EP_TYPE_BULK EP_TYPE_BULK
+#define PCD_EP_TYPE_INTR EP_TYPE_INTR
+
+typedef struct {
+	uint32_t dev_endpoints;
+	uint32_t speed;
+	uint32_t ep0_mps;
+	uint32_t phy_itface;
+	uint32_t Sof_enable;
+	uint32_t low_power_enable;
+	uint32_t lpm_enable;
+	uint32_t battery_charging_enable;
+} PCD_InitTypeDef;
+
+typedef struct {
+	uint8_t num;
+	uint8_t is_in;
+	uint8_t is_stall;
+	uint8_t type;
+	uint16_t pmaadress;
+	uint16_t pmaaddr0;
+	uint16_t pmaaddr1;
+	uint8_t doublebuffer;
+	uint32_t maxpacket;
+	uint8_t * xfer_buff;
+	uint32_t xfer_len;
+	uint32_t xfer_count;
+	uint8_t is_open; /**< mock specific */
+	uint8_t is_armed; /**< mock specific */
+} PCD_EPTypeDef;
+
+typedef enum {
+	HAL_PCD_STATE_RESET = 0x00,
+	HAL_PCD_STATE_READY = 0x01,
+	HAL_PCD_STATE_ERROR = 0x02,
+	HAL_PCD_STATE_BUSY = 0x03
+} PCD_StateTypeDef;
+
+typedef struct {
+	PCD_TypeDef * Instance;
+	PCD_InitTypeDef Init;
+	volatile uint8_t USB_Address;
+	PCD_EPTypeDef IN_ep[8];
+	PCD_EPTypeDef OUT_ep[8];
+	HAL_LockTypeDef Lock;
+	volatile PCD_StateTypeDef State;
+	uint32_t Setup[12];
+	void * pData;
+} PCD_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_PCD_Init(PCD_HandleTypeDef * hpcd);
+HAL_StatusTypeDef HAL_PCD_DeInit(PCD_HandleTypeDef * hpcd);
+HAL_StatusTypeDef HAL_PCD_Start(PCD_HandleTypeDef * hpcd);
+HAL_StatusTypeDef HAL_PCD_Stop(PCD_HandleTypeDef * hpcd);
+HAL_StatusTypeDef HAL_PCD_SetAddress(PCD_HandleTypeDef * hpcd, uint8_t address);
+HAL_StatusTypeDef HAL_PCD_EP_Open(PCD_HandleTypeDef * hpcd, uint8_t ep_addr, uint16_t ep_mps, uint8_t ep_type);
+HAL_StatusTypeDef HAL_PCD_EP_Close(PCD_HandleTypeDef * hpcd, uint8_t ep_addr);
+HAL_StatusTypeDef HAL_PCD_EP_Receive(PCD_HandleTypeDef * hpcd, uint8_t ep_addr, uint8_t * pBuf, uint32_t len);
+HAL_StatusTypeDef HAL_PCD_EP_Transmit(PCD_HandleTypeDef * hpcd, uint8_t ep_addr, uint8_t * pBuf, uint32_t len);
+uint32_t HAL_PCD_EP_GetRxCount(PCD_HandleTypeDef const * hpcd, uint8_t ep_addr);
+HAL_StatusTypeDef HAL_PCD_EP_SetStall(PCD_HandleTypeDef * hpcd, uint8_t ep_addr);
+HAL_StatusTypeDef HAL_PCD_EP_ClrStall(PCD_HandleTypeDef * hpcd, uint8_t ep_addr);
+HAL_StatusTypeDef HAL_PCD_EP_Flush(PCD_HandleTypeDef * hpcd, uint8_t ep_addr);
+HAL_StatusTypeDef HAL_PCD_ActivateRemoteWakeup(PCD_HandleTypeDef * hpcd);
+HAL_StatusTypeDef HAL_PCD_DeActivateRemoteWakeup(PCD_HandleTypeDef * hpcd);
+HAL_StatusTypeDef HAL_PCDEx_PMAConfig(PCD_HandleTypeDef * hpcd, uint16_t ep_addr, uint16_t ep_kind, uint32_t pmaadress);
+void HAL_PCD_IRQHandler(PCD_HandleTypeDef * hpcd);
+void HAL_PCD_MspInit(PCD_HandleTypeDef * hpcd);
+void HAL_PCD_MspDeInit(PCD_HandleTypeDef * hpcd);
+void HAL_PCD_SetupStageCallback(PCD_HandleTypeDef * hpcd);
+void HAL_PCD_DataOutStageCallback(PCD_HandleTypeDef * hpcd, uint8_t epnum);
+void HAL_PCD_DataInStageCallback(PCD_HandleTypeDef * hpcd, uint8_t epnum);
+void HAL_PCD_SOFCallback(PCD_HandleTypeDef * hpcd);
+void HAL_PCD_ResetCallback(PCD_HandleTypeDef * hpcd);
+void HAL_PCD_SuspendCallback(PCD_HandleTypeDef * hpcd);
+void HAL_PCD_ResumeCallback(PCD_HandleTypeDef * hpcd);
+
+
+/* simulation control (not part of the STM32 HAL API) */
+typedef void (* MockIrqHandler)(void);
+typedef void (* MockIdleHook)(void * user);
+
+void mockReset(void);
+void mockSetIrqHandler(IRQn_Type IRQn, MockIrqHandler handler);
+void mockRaiseIrq(IRQn_Type IRQn);
+void mockSetIdleHook(MockIdleHook hook, void * user);
+uint32_t mockIrqCount(IRQn_Type IRQn);
+
+size_t mockUartReceive(USART_TypeDef * instance, const uint8_t * data, size_t len);
+size_t mockUartTransmit(USART_TypeDef * instance, size_t maxBytes);
+size_t mockUartFetch(USART_TypeDef * instance, uint8_t * buf, size_t maxLen);
+size_t mockUartPending(USART_TypeDef * instance);
+void mockUartError(USART_TypeDef * instance, uint32_t flags);
+bool mockUartRts(USART_TypeDef * instance);
+bool mockUartDe(USART_TypeDef * instance);
+void mockUartSetCts(USART_TypeDef * instance, bool asserted);
+
+void mockUsbHostReset(void);
+int mockUsbHostSetup(const uint8_t * setup);
+int mockUsbHostOut(uint8_t ep, const uint8_t * data, size_t len);
+int mockUsbHostIn(uint8_t ep, uint8_t * buf, size_t maxLen);
+int mockUsbControl(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wIndex, uint16_t wLength, uint8_t * data);
+int mockUsbEnumerate(void);
+void mockUsbHostSof(void);
+uint32_t mockUsbTransferCount(uint8_t ep);
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+
+#endif /* __STM32MOCK_H__ */
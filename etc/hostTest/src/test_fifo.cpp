@@ -0,0 +1,829 @@
+/**
+ * @file test_fifo.cpp
+ * @author Daniel Starke
+ * @copyright Copyright 2020-2026 Daniel Starke
+ * @date 2020-05-14
+ * @version 2026-10-17
+ *
+ * Unit tests for scdinternal/fifo.h.
+ */
+#include <thread>
+#include "hosttest.h"
+#include "stm32mock.h"
+#include "scdinternal/fifo.h"
+
+
+namespace {
+/** Random test operations. */
+enum State { ADD, COM, DEL, CLR, STATES };
+
+
+/**
+ * Tests the generic circular buffer macros against a reference size counter.
+ */
+void testFifoMacros() {
+	enum { BUF_SIZE = 8 };
+	size_t head, tail;
+	char buf[BUF_SIZE];
+	#define HANDLE buf, BUF_SIZE, head, tail
+	size_t size = 0;
+	_FIFOX_INIT(HANDLE);
+	TEST_ASSERT(_FIFOX_EMPTY(HANDLE));
+	TEST_ASSERT(_FIFOX_SIZE(HANDLE) == 0);
+	TEST_ASSERT(_FIFOX_AVAILABLE(HANDLE) == (BUF_SIZE - 1));
+	TEST_ASSERT(_FIFOX_CAPACITY(HANDLE) == (BUF_SIZE - 1));
+	TEST_ASSERT(_FIFOX_BSIZE(HANDLE) == 0);
+	for (size_t i = 0; i < 1000000; i++) {
+		switch (State(rand() % 3)) {
+		case ADD:
+			if ((size + 1) < BUF_SIZE) {
+				_FIFOX_PUSH(HANDLE, char(head));
+				size++;
+			}
+			break;
+		case COM:
+			if (size > 0) {
+				const char expVal = char(tail);
+				const char peekVal = char(_FIFOX_PEEK(HANDLE));
+				const char popVal = char(_FIFOX_POP(HANDLE));
+				TEST_ASSERT(peekVal == popVal);
+				TEST_ASSERT(expVal == popVal);
+				size--;
+			} else {
+				TEST_ASSERT(_FIFOX_PEEK(HANDLE) == -1);
+				TEST_ASSERT(_FIFOX_POP(HANDLE) == -1);
+			}
+			break;
+		default:
+			_FIFOX_CLEAR(HANDLE);
+			size = 0;
+			break;
+		}
+		TEST_ASSERT(_FIFOX_SIZE(HANDLE) == size);
+		TEST_ASSERT(_FIFOX_AVAILABLE(HANDLE) == size_t(BUF_SIZE - size - 1));
+		TEST_ASSERT(_FIFOX_INDEX(HANDLE, size) == head);
+		TEST_ASSERT(_FIFOX_BSIZE(HANDLE) <= _FIFOX_SIZE(HANDLE));
+		const size_t blockEnd = _FIFOX_INDEX(HANDLE, _FIFOX_BSIZE(HANDLE));
+		TEST_ASSERT(blockEnd == 0 || blockEnd == head);
+		if (size == 0) {
+			TEST_ASSERT(_FIFOX_EMPTY(HANDLE));
+			TEST_ASSERT(_FIFOX_SIZE(HANDLE) == 0);
+			TEST_ASSERT(_FIFOX_AVAILABLE(HANDLE) == (BUF_SIZE - 1));
+		} else {
+			TEST_ASSERT( ! _FIFOX_EMPTY(HANDLE) );
+		}
+		if ((size + 1) >= BUF_SIZE) {
+			TEST_ASSERT(_FIFOX_FULL(HANDLE));
+			TEST_ASSERT(_FIFOX_SIZE(HANDLE) == (BUF_SIZE - 1));
+			TEST_ASSERT(_FIFOX_AVAILABLE(HANDLE) == 0);
+		} else {
+			TEST_ASSERT( ! _FIFOX_FULL(HANDLE) );
+		}
+	}
+	#undef HANDLE
+}
+
+
+/**
+ * Tests the block write and read functions of the given FIFO type against a
+ * reference sequence counter.
+ *
+ * @tparam Fifo - FIFO type to test
+ * @param[in,out] fifo - FIFO instance
+ */
+template <typename Fifo>
+void testByteFifo(Fifo & fifo) {
+	uint8_t in[64], out[64];
+	uint8_t nextIn = 0, nextOut = 0;
+	uint32_t size = 0;
+	const uint32_t capacity = fifo.availableForWrite();
+	TEST_ASSERT(fifo.empty());
+	for (size_t i = 0; i < 200000; i++) {
+		const uint32_t len = uint32_t(rand() % int(sizeof(in) + 1));
+		switch (State(rand() % 4)) {
+		case ADD:
+			{
+				for (uint32_t n = 0; n < len; n++) in[n] = uint8_t(nextIn + n);
+				const uint32_t written = fifo.write(in, len);
+				const uint32_t expected = ((capacity - size) < len) ? (capacity - size) : len;
+				TEST_ASSERT(written == expected);
+				nextIn = uint8_t(nextIn + written);
+				size += written;
+			}
+			break;
+		case COM:
+			if (size > 0) {
+				TEST_ASSERT(fifo.peek() == nextOut);
+				TEST_ASSERT(fifo.pop() == nextOut);
+				nextOut++;
+				size--;
+			} else {
+				TEST_ASSERT(fifo.peek() == -1);
+				TEST_ASSERT(fifo.pop() == -1);
+			}
+			break;
+		case DEL:
+			{
+				const uint32_t copied = fifo.read(out, len);
+				const uint32_t expected = (size < len) ? size : len;
+				TEST_ASSERT(copied == expected);
+				for (uint32_t n = 0; n < copied; n++) TEST_ASSERT(out[n] == uint8_t(nextOut + n));
+				nextOut = uint8_t(nextOut + copied);
+				size -= copied;
+			}
+			break;
+		default:
+			if ((rand() % 16) == 0) {
+				fifo.clear();
+				nextOut = nextIn;
+				size = 0;
+			}
+			break;
+		}
+		TEST_ASSERT(fifo.availableForRead() == size);
+		TEST_ASSERT(fifo.availableForWrite() == (capacity - size));
+		TEST_ASSERT(fifo.availableForBlockRead() <= size);
+		TEST_ASSERT(fifo.empty() == (size == 0));
+		TEST_ASSERT(fifo.full() == (size == capacity));
+	}
+}
+
+
+/**
+ * Tests _FifoClass.
+ */
+void testFifoClass() {
+	_FifoClass<8> fifo8;
+	testByteFifo(fifo8);
+	_FifoClass<100> fifo100;
+	testByteFifo(fifo100);
+	_FifoClass<300> fifo300;
+	testByteFifo(fifo300);
+	_FifoClass<256> fifo256;
+	testByteFifo(fifo256);
+}
+
+
+/**
+ * Tests _FifoClass with free-running counters.
+ */
+void testFifoClassFreeRunning() {
+	_FifoClass<8, true> fifo8;
+	TEST_ASSERT(fifo8.availableForWrite() == 8);
+	for (uint32_t i = 0; i < 8; i++) TEST_ASSERT(fifo8.push(uint8_t(i)));
+	TEST_ASSERT( ! fifo8.push(8) );
+	TEST_ASSERT(fifo8.full());
+	fifo8.clear();
+	testByteFifo(fifo8);
+	_FifoClass<128, true> fifo128; /* counters wrap at 256 */
+	testByteFifo(fifo128);
+	_FifoClass<256, true> fifo256;
+	testByteFifo(fifo256);
+}
+
+
+/**
+ * Tests the zero-copy read functions of the given FIFO type.
+ *
+ * @tparam Fifo - FIFO type to test
+ * @param[in,out] fifo - FIFO instance
+ */
+template <typename Fifo>
+void testByteFifoSpans(Fifo & fifo) {
+	uint8_t in[64];
+	uint8_t nextIn = 0, nextOut = 0;
+	uint32_t size = 0;
+	for (size_t i = 0; i < 200000; i++) {
+		const uint32_t len = uint32_t(rand() % int(sizeof(in) + 1));
+		if ((rand() % 2) == 0) {
+			for (uint32_t n = 0; n < len; n++) in[n] = uint8_t(nextIn + n);
+			const uint32_t written = fifo.write(in, len);
+			nextIn = uint8_t(nextIn + written);
+			size += written;
+		} else {
+			_FifoSpan span[2];
+			TEST_ASSERT(fifo.peek(span) == size);
+			TEST_ASSERT((span[0].len + span[1].len) == size);
+			TEST_ASSERT(span[0].ptr == (fifo.buffer + fifo.index(0)));
+			TEST_ASSERT(span[1].len == 0 || span[1].ptr == fifo.buffer);
+			const uint32_t consumed = (size < len) ? size : len;
+			for (uint32_t n = 0; n < consumed; n++) {
+				const uint8_t val = (n < span[0].len) ? span[0].ptr[n] : span[1].ptr[n - span[0].len];
+				TEST_ASSERT(val == uint8_t(nextOut + n));
+			}
+			fifo.consume(consumed);
+			nextOut = uint8_t(nextOut + consumed);
+			size -= consumed;
+		}
+		TEST_ASSERT(fifo.availableForRead() == size);
+	}
+}
+
+
+/**
+ * Tests the in-place write functions of the given FIFO type.
+ *
+ * @tparam Fifo - FIFO type to test
+ * @param[in,out] fifo - FIFO instance
+ */
+template <typename Fifo>
+void testByteFifoReserve(Fifo & fifo) {
+	uint8_t out[64];
+	uint8_t nextIn = 0, nextOut = 0;
+	uint32_t size = 0;
+	const uint32_t capacity = fifo.availableForWrite();
+	for (size_t i = 0; i < 200000; i++) {
+		const uint32_t len = uint32_t(rand() % int(sizeof(out) + 1));
+		if ((rand() % 2) == 0) {
+			uint32_t reserved;
+			uint8_t * ptr = fifo.reserve(len, reserved);
+			TEST_ASSERT(reserved <= len && reserved <= (capacity - size));
+			TEST_ASSERT((ptr == NULL) == (reserved == 0));
+			if (len > 0 && size < capacity) TEST_ASSERT(reserved > 0);
+			/* commit only a part of the reserved region */
+			const uint32_t committed = (reserved > 0) ? uint32_t(rand() % int(reserved + 1)) : 0;
+			for (uint32_t n = 0; n < committed; n++) ptr[n] = uint8_t(nextIn + n);
+			fifo.commit(committed);
+			nextIn = uint8_t(nextIn + committed);
+			size += committed;
+		} else {
+			const uint32_t copied = fifo.read(out, len);
+			TEST_ASSERT(copied == ((size < len) ? size : len));
+			for (uint32_t n = 0; n < copied; n++) TEST_ASSERT(out[n] == uint8_t(nextOut + n));
+			nextOut = uint8_t(nextOut + copied);
+			size -= copied;
+		}
+		TEST_ASSERT(fifo.availableForRead() == size);
+	}
+}
+
+
+/**
+ * Tests the in-place write functions of _FifoClass.
+ */
+void testFifoClassReserve() {
+	_FifoClass<100> fifo100;
+	testByteFifoReserve(fifo100);
+	_FifoClass<64, true> fifo64;
+	testByteFifoReserve(fifo64);
+}
+
+
+/**
+ * Tests the zero-copy read functions of _FifoClass.
+ */
+void testFifoClassSpans() {
+	_FifoClass<100> fifo100;
+	testByteFifoSpans(fifo100);
+	_FifoClass<64, true> fifo64;
+	testByteFifoSpans(fifo64);
+}
+
+
+/** Sample element for the typed FIFO tests. */
+struct Sample {
+	uint32_t timestamp;
+	int16_t value;
+};
+
+
+/**
+ * Tests the given typed FIFO against a reference sequence counter.
+ *
+ * @tparam Fifo - FIFO type to test
+ * @tparam Make - function to create an element from a sequence number
+ * @tparam Equal - function to compare two elements
+ * @param[in,out] fifo - FIFO instance
+ * @param[in] make - creates an element from a sequence number
+ * @param[in] equal - compares two elements
+ */
+template <typename Fifo, typename Make, typename Equal>
+void testTypedFifo(Fifo & fifo, Make make, Equal equal) {
+	typedef typename Fifo::ValueType T;
+	T in[16], out[16];
+	uint32_t nextIn = 0, nextOut = 0, size = 0;
+	const uint32_t capacity = Fifo::Capacity;
+	TEST_ASSERT(fifo.empty());
+	TEST_ASSERT(fifo.availableForWrite() == capacity);
+	for (size_t i = 0; i < 200000; i++) {
+		const uint32_t len = uint32_t(rand() % int(16 + 1));
+		switch (State(rand() % STATES)) {
+		case ADD:
+			if ((rand() % 2) == 0) {
+				for (uint32_t n = 0; n < len; n++) in[n] = make(nextIn + n);
+				const uint32_t written = fifo.write(in, len);
+				TEST_ASSERT(written == (((capacity - size) < len) ? (capacity - size) : len));
+				nextIn += written;
+				size += written;
+			} else {
+				const bool res = fifo.push(make(nextIn));
+				TEST_ASSERT(res == (size < capacity));
+				if ( res ) {
+					nextIn++;
+					size++;
+				}
+			}
+			break;
+		case COM:
+			{
+				T val;
+				TEST_ASSERT(fifo.peek(val) == (size > 0));
+				if (size > 0) TEST_ASSERT(equal(val, make(nextOut)));
+				TEST_ASSERT(fifo.pop(val) == (size > 0));
+				if (size > 0) {
+					TEST_ASSERT(equal(val, make(nextOut)));
+					nextOut++;
+					size--;
+				}
+			}
+			break;
+		case DEL:
+			if ((rand() % 2) == 0) {
+				const uint32_t copied = fifo.read(out, len);
+				TEST_ASSERT(copied == ((size < len) ? size : len));
+				for (uint32_t n = 0; n < copied; n++) TEST_ASSERT(equal(out[n], make(nextOut + n)));
+				nextOut += copied;
+				size -= copied;
+			} else {
+				typename Fifo::Span span[2];
+				TEST_ASSERT(fifo.peek(span) == size);
+				TEST_ASSERT((span[0].len + span[1].len) == size);
+				const uint32_t consumed = (size < len) ? size : len;
+				for (uint32_t n = 0; n < consumed; n++) {
+					const T & val = (n < span[0].len) ? span[0].ptr[n] : span[1].ptr[n - span[0].len];
+					TEST_ASSERT(equal(val, make(nextOut + n)));
+				}
+				fifo.consume(consumed);
+				nextOut += consumed;
+				size -= consumed;
+			}
+			break;
+		default:
+			if ((rand() % 16) == 0) {
+				fifo.clear();
+				nextOut = nextIn;
+				size = 0;
+			}
+			break;
+		}
+		TEST_ASSERT(fifo.availableForRead() == size);
+		TEST_ASSERT(fifo.availableForWrite() == (capacity - size));
+		TEST_ASSERT(fifo.empty() == (size == 0));
+		TEST_ASSERT(fifo.full() == (size == capacity));
+	}
+}
+
+
+/**
+ * Tests _TypedFifo with integer and structure elements.
+ */
+void testTypedFifoClass() {
+	const auto makeInt = [](const uint32_t n) { return uint16_t(n * 7); };
+	const auto equalInt = [](const uint16_t a, const uint16_t b) { return a == b; };
+	const auto makeSample = [](const uint32_t n) { return Sample{n, int16_t(n ^ 0x5A5A)}; };
+	const auto equalSample = [](const Sample & a, const Sample & b) {
+		return a.timestamp == b.timestamp && a.value == b.value;
+	};
+	_TypedFifo<uint16_t, 8> fifo8;
+	testTypedFifo(fifo8, makeInt, equalInt);
+	_TypedFifo<uint16_t, 100> fifo100;
+	testTypedFifo(fifo100, makeInt, equalInt);
+	_TypedFifo<Sample, 32> fifoSample;
+	TEST_ASSERT((reinterpret_cast<uintptr_t>(fifoSample.buffer) % alignof(Sample)) == 0);
+	testTypedFifo(fifoSample, makeSample, equalSample);
+}
+
+
+/**
+ * Tests the given overwriting ring buffer against a reference model.
+ *
+ * @tparam Fifo - ring buffer type to test
+ * @param[in,out] fifo - ring buffer instance
+ */
+template <typename Fifo>
+void testOverwriteFifo(Fifo & fifo) {
+	typedef typename Fifo::ValueType T;
+	const uint32_t capacity = Fifo::Capacity;
+	T in[40], out[40];
+	uint32_t written = 0, readPos = 0, overruns = 0;
+	for (size_t i = 0; i < 200000; i++) {
+		const uint32_t len = uint32_t(rand() % int(sizeof(in) / sizeof(*in) + 1));
+		switch (State(rand() % STATES)) {
+		case ADD:
+			for (uint32_t n = 0; n < len; n++) in[n] = T(written + n);
+			fifo.write(in, len);
+			written += len;
+			break;
+		case COM:
+			{
+				T val;
+				if ((written - readPos) > capacity) {
+					overruns += written - capacity - readPos;
+					readPos = written - capacity;
+				}
+				TEST_ASSERT(fifo.pop(val) == (written != readPos));
+				if (written != readPos) {
+					TEST_ASSERT(val == T(readPos));
+					readPos++;
+				}
+			}
+			break;
+		case DEL:
+			if ((rand() % 2) == 0) {
+				if ((written - readPos) > capacity) {
+					overruns += written - capacity - readPos;
+					readPos = written - capacity;
+				}
+				const uint32_t copied = fifo.read(out, len);
+				TEST_ASSERT(copied == (((written - readPos) < len) ? (written - readPos) : len));
+				for (uint32_t n = 0; n < copied; n++) TEST_ASSERT(out[n] == T(readPos + n));
+				readPos += copied;
+			} else {
+				const uint32_t available = (written < capacity) ? written : capacity;
+				const uint32_t copied = fifo.readLatest(out, len);
+				TEST_ASSERT(copied == ((available < len) ? available : len));
+				for (uint32_t n = 0; n < copied; n++) TEST_ASSERT(out[n] == T(written - copied + n));
+			}
+			break;
+		default:
+			if ((rand() % 16) == 0) {
+				fifo.clear();
+				readPos = written;
+			}
+			break;
+		}
+		TEST_ASSERT(fifo.overruns == overruns);
+		TEST_ASSERT(fifo.empty() == (written == readPos));
+	}
+}
+
+
+/**
+ * Tests _OverwriteFifo with a concurrent producer thread. The consumer checks that
+ * the received sequence is increasing and that every gap is counted as overrun.
+ */
+void testOverwriteFifoThreads() {
+	enum { ELEMENTS = 2000000 };
+	static _OverwriteFifo<uint32_t, 64> fifo;
+	volatile bool done = false;
+	std::thread producer([&done]() {
+		for (uint32_t n = 1; n <= ELEMENTS; n++) fifo.push(n);
+		done = true;
+	});
+	uint32_t last = 0, received = 0;
+	uint32_t out[16];
+	/* continue until the producer is done and all remaining elements were read */
+	for (bool finished = false; ! (finished && fifo.empty()); ) {
+		finished = done;
+		const uint32_t overruns = fifo.overruns;
+		uint32_t copied;
+		switch (rand() % 3) {
+		case 0:
+			copied = fifo.pop(out[0]) ? 1 : 0;
+			break;
+		case 1:
+			copied = fifo.read(out, 16);
+			break;
+		default:
+			/* snapshot needs to be contiguous and does not remove anything */
+			copied = fifo.readLatest(out, 16);
+			for (uint32_t n = 1; n < copied; n++) TEST_ASSERT(out[n] == (out[n - 1] + 1));
+			continue;
+		}
+		if (copied == 0) continue;
+		TEST_ASSERT((out[0] - last - 1) == (fifo.overruns - overruns));
+		for (uint32_t n = 1; n < copied; n++) TEST_ASSERT(out[n] == (out[n - 1] + 1));
+		last = out[copied - 1];
+		received += copied;
+	}
+	producer.join();
+	TEST_ASSERT(last == ELEMENTS);
+	TEST_ASSERT((received + fifo.overruns) == ELEMENTS);
+}
+
+
+/**
+ * Tests _OverwriteFifo and _OverwriteByteFifo.
+ */
+void testOverwriteFifoClass() {
+	_OverwriteFifo<uint32_t, 16> fifo16;
+	testOverwriteFifo(fifo16);
+	_OverwriteByteFifo<64> fifo64;
+	testOverwriteFifo(fifo64);
+}
+
+
+/**
+ * Tests _DynFifoClass.
+ */
+void testDynFifoClass() {
+	_DynFifoClass<8> fifo8;
+	testByteFifo(fifo8);
+	_DynFifoClass<100> fifo100;
+	testByteFifo(fifo100);
+}
+
+
+/**
+ * Tests _BlockFifoClass against a reference state.
+ */
+void testBlockFifoClass() {
+	enum {
+		TOTAL_SIZE = 8,
+		BLOCK_SIZE = 4,
+		BLOCK_COUNT = TOTAL_SIZE / BLOCK_SIZE
+	};
+	typedef _BlockFifoClass<TOTAL_SIZE, BLOCK_SIZE> Fifo;
+	Fifo fifo;
+	size_t size = 0, blockSize = 0, blocks = 0;
+	TEST_ASSERT(fifo.empty());
+	TEST_ASSERT(fifo.availableForRead() == 0);
+	TEST_ASSERT((fifo.availableForWrite() + 1) == TOTAL_SIZE);
+	TEST_ASSERT(size_t(fifo.TotalSize) == size_t(TOTAL_SIZE));
+	TEST_ASSERT(size_t(fifo.BlockSize) == size_t(BLOCK_SIZE));
+	TEST_ASSERT(size_t(fifo.Count) == size_t(BLOCK_COUNT));
+	for (size_t i = 0; i < 1000000; i++) {
+		switch (State(rand() % STATES)) {
+		case ADD:
+			if ((size + 1) < TOTAL_SIZE) {
+				const bool expRes = (blocks + 1) < BLOCK_COUNT || (blockSize + 1) < BLOCK_SIZE;
+				const bool res = fifo.push(uint8_t(blockSize));
+				TEST_ASSERT(res == expRes);
+				if ( res ) {
+					size++;
+					blockSize++;
+					if (blockSize >= BLOCK_SIZE) {
+						blockSize = 0;
+						blocks++;
+					}
+				}
+			}
+			break;
+		case COM:
+			{
+				const bool expRes = (blocks + 1) < BLOCK_COUNT && blockSize > 0;
+				const bool res = fifo.commitBlock();
+				TEST_ASSERT(res == expRes);
+				if ( res ) {
+					blockSize = 0;
+					blocks++;
+				}
+			}
+			break;
+		case DEL:
+			{
+				uint32_t aBlockSize = 0;
+				const uint8_t * blockPtr = fifo.peek(aBlockSize);
+				if (blocks > 0) {
+					TEST_ASSERT(blockPtr != NULL);
+					TEST_ASSERT(aBlockSize > 0);
+					TEST_ASSERT(aBlockSize == fifo.size[fifo.tail]);
+					for (uint32_t k = 0; k < aBlockSize; k++) {
+						TEST_ASSERT(k == blockPtr[k]);
+					}
+					fifo.pop();
+					size = size_t(size - aBlockSize);
+					blocks--;
+				} else {
+					TEST_ASSERT(blockPtr == NULL);
+					TEST_ASSERT(aBlockSize == 0);
+				}
+			}
+			break;
+		case CLR:
+			fifo.clear();
+			size = 0;
+			blockSize = 0;
+			blocks = 0;
+			break;
+		case STATES:
+			break;
+		}
+		if (size == 0) {
+			TEST_ASSERT(fifo.empty());
+			TEST_ASSERT(fifo.totallyEmpty());
+			TEST_ASSERT( ! fifo.full() );
+			TEST_ASSERT(fifo.availableForRead() == 0);
+			TEST_ASSERT((fifo.availableForWrite() + 1) == TOTAL_SIZE);
+		} else if ((size + 1) == TOTAL_SIZE) {
+			TEST_ASSERT( ! fifo.empty() );
+			TEST_ASSERT( ! fifo.totallyEmpty() );
+			TEST_ASSERT(fifo.full());
+			TEST_ASSERT((fifo.availableForRead() + blockSize + 1) == TOTAL_SIZE);
+			TEST_ASSERT(fifo.availableForWrite() == 0);
+		} else {
+			if (blocks < 1) {
+				TEST_ASSERT(fifo.empty());
+			} else {
+				TEST_ASSERT( ! fifo.empty() );
+			}
+			TEST_ASSERT( ! fifo.totallyEmpty() );
+			if ((blocks + 1) == BLOCK_COUNT) {
+				TEST_ASSERT(fifo.full());
+			} else {
+				TEST_ASSERT( ! fifo.full() );
+			}
+			TEST_ASSERT(fifo.availableForRead() == (size - blockSize));
+			TEST_ASSERT(fifo.availableForWrite() == (((BLOCK_COUNT - blocks) * BLOCK_SIZE) - blockSize - 1));
+		}
+	}
+}
+
+
+/**
+ * Tests the bulk write and read functions of _BlockFifoClass against a reference
+ * sequence counter.
+ */
+void testBlockFifoClassBulk() {
+	enum {
+		TOTAL_SIZE = 32,
+		BLOCK_SIZE = 8
+	};
+	typedef _BlockFifoClass<TOTAL_SIZE, BLOCK_SIZE> Fifo;
+	Fifo fifo;
+	uint8_t in[TOTAL_SIZE + BLOCK_SIZE], out[TOTAL_SIZE + BLOCK_SIZE];
+	uint8_t nextIn = 0, nextOut = 0;
+	uint32_t size = 0; /* including uncommitted data */
+	for (size_t i = 0; i < 200000; i++) {
+		const uint32_t len = uint32_t(rand() % int(sizeof(in) + 1));
+		switch (State(rand() % STATES)) {
+		case ADD:
+			{
+				const uint32_t available = fifo.availableForWrite();
+				for (uint32_t n = 0; n < len; n++) in[n] = uint8_t(nextIn + n);
+				uint32_t written = 0;
+				if ((rand() % 2) == 0) {
+					written = fifo.write(in, len);
+					TEST_ASSERT(written == ((available < len) ? available : len));
+				} else {
+					/* in-place write; limited to the current block */
+					uint8_t * ptr = fifo.reserve(len, written);
+					TEST_ASSERT(written <= len && written <= available);
+					TEST_ASSERT((ptr == NULL) == (written == 0));
+					if (written > 0) {
+						memcpy(ptr, in, written);
+						fifo.commit(written);
+					}
+				}
+				nextIn = uint8_t(nextIn + written);
+				size += written;
+			}
+			break;
+		case COM:
+			fifo.commitBlock();
+			break;
+		case DEL:
+			{
+				const uint32_t committed = fifo.availableForRead();
+				const uint32_t copied = fifo.read(out, len);
+				TEST_ASSERT(copied <= len && copied <= committed);
+				for (uint32_t n = 0; n < copied; n++) TEST_ASSERT(out[n] == uint8_t(nextOut + n));
+				nextOut = uint8_t(nextOut + copied);
+				size -= copied;
+				/* the next block does not fit into the remaining buffer */
+				uint32_t blockSize;
+				if (fifo.peek(blockSize) != NULL) TEST_ASSERT((copied + blockSize) > len);
+			}
+			break;
+		default:
+			if ((rand() % 16) == 0) {
+				fifo.clear();
+				nextOut = nextIn;
+				size = 0;
+			}
+			break;
+		}
+		uint32_t committed = 0;
+		for (uint32_t n = fifo.tail; n != fifo.head; n = (n + 1) % Fifo::Count) committed += fifo.size[n];
+		TEST_ASSERT(fifo.availableForRead() == committed);
+		TEST_ASSERT((committed + fifo.size[fifo.head]) == size);
+		TEST_ASSERT(fifo.empty() == (committed == 0));
+	}
+}
+
+
+/**
+ * Tests _MpscFifoClass from a single thread against a reference sequence counter.
+ */
+void testMpscFifoClass() {
+	_MpscFifoClass<64> fifo;
+	uint8_t in[16], out[16];
+	uint8_t nextIn = 0, nextOut = 0;
+	uint32_t size = 0;
+	TEST_ASSERT(fifo.empty());
+	TEST_ASSERT(fifo.availableForWrite() == 64);
+	for (size_t i = 0; i < 200000; i++) {
+		const uint32_t len = uint32_t(rand() % int(sizeof(in) + 1));
+		switch (State(rand() % 3)) {
+		case ADD:
+			{
+				for (uint32_t n = 0; n < len; n++) in[n] = uint8_t(nextIn + n);
+				const uint32_t written = fifo.write(in, len);
+				TEST_ASSERT(written == ((len > 0 && (size + len) <= 64) ? len : 0)); /* all or nothing */
+				nextIn = uint8_t(nextIn + written);
+				size += written;
+			}
+			break;
+		case COM:
+			if (size > 0) {
+				TEST_ASSERT(fifo.peek() == nextOut);
+				TEST_ASSERT(fifo.pop() == nextOut);
+				nextOut++;
+				size--;
+			} else {
+				TEST_ASSERT(fifo.peek() == -1);
+				TEST_ASSERT(fifo.pop() == -1);
+			}
+			break;
+		default:
+			{
+				const uint32_t copied = fifo.read(out, len);
+				TEST_ASSERT(copied == ((size < len) ? size : len));
+				for (uint32_t n = 0; n < copied; n++) TEST_ASSERT(out[n] == uint8_t(nextOut + n));
+				nextOut = uint8_t(nextOut + copied);
+				size -= copied;
+			}
+			break;
+		}
+		TEST_ASSERT(fifo.availableForRead() == size);
+		TEST_ASSERT(fifo.availableForWrite() == (64 - size));
+		TEST_ASSERT(fifo.empty() == (size == 0));
+	}
+}
+
+
+/**
+ * Stress tests _MpscFifoClass with multiple concurrent producer threads. Each
+ * producer writes records made up of its identifier and a sequence counter.
+ * Single byte records encode the identifier in bits 5 and 6 and have bit 7 cleared.
+ */
+void testMpscFifoClassThreads() {
+	enum {
+		PRODUCERS = 4,
+		RECORDS = 200000
+	};
+	static _MpscFifoClass<128> fifo;
+	std::thread producer[PRODUCERS];
+	for (uint8_t id = 0; id < PRODUCERS; id++) {
+		producer[id] = std::thread([id]() {
+			for (uint32_t n = 0; n < RECORDS; n++) {
+				if ((n & 1) == 0) {
+					const uint8_t record[3] = {uint8_t(0x80 | id), uint8_t(n), uint8_t(n >> 8)};
+					while (fifo.write(record, sizeof(record)) == 0) std::this_thread::yield();
+				} else {
+					while ( ! fifo.push(uint8_t((id << 5) | (n & 0x1F))) ) std::this_thread::yield();
+				}
+			}
+		});
+	}
+	/* consume on this thread */
+	uint32_t next[PRODUCERS] = {0};
+	const auto popWait = []() -> uint8_t {
+		int val;
+		while ((val = fifo.pop()) < 0) std::this_thread::yield();
+		return uint8_t(val);
+	};
+	for (uint32_t total = 0; total < (PRODUCERS * RECORDS); total++) {
+		const uint8_t first = popWait();
+		uint8_t id;
+		if ((first & 0x80) != 0) {
+			/* three byte record */
+			id = uint8_t(first & 0x03);
+			TEST_ASSERT((next[id] & 1) == 0);
+			const uint8_t lo = popWait();
+			const uint8_t hi = popWait();
+			TEST_ASSERT(uint32_t(lo | (hi << 8)) == (next[id] & 0xFFFF));
+		} else {
+			/* single byte record */
+			id = uint8_t(first >> 5);
+			TEST_ASSERT((next[id] & 1) == 1);
+			TEST_ASSERT((first & 0x1F) == (next[id] & 0x1F));
+		}
+		next[id]++;
+	}
+	for (uint8_t id = 0; id < PRODUCERS; id++) {
+		producer[id].join();
+		TEST_ASSERT(next[id] == RECORDS);
+	}
+	TEST_ASSERT(fifo.empty());
+}
+} /* anonymous namespace */
+
+
+int main() {
+	srand(1);
+	TEST_RUN(testFifoMacros);
+	TEST_RUN(testFifoClass);
+	TEST_RUN(testFifoClassFreeRunning);
+	TEST_RUN(testFifoClassSpans);
+	TEST_RUN(testFifoClassReserve);
+	TEST_RUN(testTypedFifoClass);
+	TEST_RUN(testOverwriteFifoClass);
+	TEST_RUN(testOverwriteFifoThreads);
+	TEST_RUN(testDynFifoClass);
+	TEST_RUN(testBlockFifoClass);
+	TEST_RUN(testBlockFifoClassBulk);
+	TEST_RUN(testMpscFifoClass);
+	TEST_RUN(testMpscFifoClassThreads);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,242 @@
+/**
+ * @file test_hid.cpp
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ *
+ * Unit tests for the USB HID class using the simulated USB FS device.
+ */
+#include "hosttest.h"
+#include "Arduino.h"
+#include "HID.h"
+
+
+extern PCD_HandleTypeDef hPcdUsb[1];
+
+
+namespace {
+/** Keyboard and generic report descriptors plugged during static initialization. */
+struct HidSetup {
+	HIDSubDescriptor keyboard;
+	HIDSubDescriptor generic;
+
+	HidSetup():
+		keyboard(HID_KEYBOARD_REPORT_DESCRIPTOR, HID_KEYBOARD_REPORT_DESCRIPTOR_SIZE),
+		generic(HID_GENERIC_REPORT_DESCRIPTOR, HID_GENERIC_REPORT_DESCRIPTOR_SIZE)
+	{
+		HID().AppendDescriptor(&this->keyboard);
+		HID().AppendDescriptor(&this->generic);
+	}
+} hidSetup;
+
+
+/** HID interface number and IN endpoint number as found in the configuration descriptor. */
+uint8_t hidInterface = 0xFF;
+uint8_t hidEp = 0xFF;
+
+
+/** Last output report passed to the callback. */
+struct OutReport {
+	uint8_t id;
+	uint8_t data[HID_REPORT_SIZE];
+	size_t size;
+	size_t count;
+} outReport;
+
+
+/**
+ * Records the received output report.
+ *
+ * @param[in] id - report ID
+ * @param[in] data - report data
+ * @param[in] len - report data length
+ */
+void onOutReport(const uint8_t id, const uint8_t * data, const size_t len) {
+	outReport.id = id;
+	memcpy(outReport.data, data, len);
+	outReport.size = len;
+	outReport.count++;
+}
+
+
+/** Reports received by the simulated host. */
+struct HostReports {
+	uint8_t data[32][HID_REPORT_SIZE];
+	size_t size[32];
+	size_t count;
+	size_t frames;
+} hostReports;
+
+
+/**
+ * Simulates a single frame: start of frame followed by the host polling the HID endpoint.
+ */
+void hostFrame() {
+	mockUsbHostSof();
+	hostReports.frames++;
+	uint8_t packet[HID_REPORT_SIZE];
+	const int len = mockUsbHostIn(hidEp, packet, sizeof(packet));
+	if (len < 0) return;
+	TEST_ASSERT(hostReports.count < 32);
+	memcpy(hostReports.data[hostReports.count], packet, size_t(len));
+	hostReports.size[hostReports.count] = size_t(len);
+	hostReports.count++;
+}
+
+
+/**
+ * Idle hook which simulates the frames while the device waits.
+ */
+void hostFrameHook(void * /* user */) {
+	hostFrame();
+}
+
+
+void testEnumerate() {
+	uint8_t desc[256];
+	TEST_ASSERT(mockUsbEnumerate() == 0);
+	TEST_ASSERT(USBDevice.configured());
+	TEST_ASSERT(hPcdUsb[0].Init.Sof_enable == ENABLE);
+	TEST_ASSERT(mockUsbControl(0x80, GET_DESCRIPTOR, 0x0200, 0, 9, desc) == 9);
+	const int total = int(desc[2] | (desc[3] << 8));
+	TEST_ASSERT(mockUsbControl(0x80, GET_DESCRIPTOR, 0x0200, 0, uint16_t(total), desc) == total);
+	/* find the HID interface with its HID and endpoint descriptor */
+	bool hidDescFound = false;
+	for (int i = 0; i < total; i += desc[i]) {
+		TEST_ASSERT(desc[i] > 0);
+		if (desc[i + 1] == USB_INTERFACE_DESCRIPTOR_TYPE && desc[i + 5] == USB_DEVICE_CLASS_HUMAN_INTERFACE) {
+			hidInterface = desc[i + 2];
+			TEST_ASSERT(desc[i + 4] == 1); /* one endpoint */
+		} else if (hidInterface != 0xFF && hidEp == 0xFF && desc[i + 1] == HID_HID_DESCRIPTOR_TYPE) {
+			TEST_ASSERT(desc[i + 6] == HID_REPORT_DESCRIPTOR_TYPE);
+			TEST_ASSERT((desc[i + 7] | (desc[i + 8] << 8)) == (HID_KEYBOARD_REPORT_DESCRIPTOR_SIZE + HID_GENERIC_REPORT_DESCRIPTOR_SIZE));
+			hidDescFound = true;
+		} else if (hidDescFound && hidEp == 0xFF && desc[i + 1] == USB_ENDPOINT_DESCRIPTOR_TYPE) {
+			TEST_ASSERT((desc[i + 2] & 0x80) != 0);
+			TEST_ASSERT(desc[i + 3] == USB_ENDPOINT_TYPE_INTERRUPT);
+			TEST_ASSERT((desc[i + 4] | (desc[i + 5] << 8)) == HID_REPORT_SIZE);
+			TEST_ASSERT(desc[i + 6] == HID_INTERVAL);
+			hidEp = uint8_t(desc[i + 2] & 0x7F);
+		}
+	}
+	TEST_ASSERT(hidInterface != 0xFF);
+	TEST_ASSERT(hidEp != 0xFF);
+}
+
+
+void testReportDescriptor() {
+	uint8_t desc[256];
+	const int total = int(HID_KEYBOARD_REPORT_DESCRIPTOR_SIZE + HID_GENERIC_REPORT_DESCRIPTOR_SIZE);
+	TEST_ASSERT(mockUsbControl(0x81, GET_DESCRIPTOR, HID_REPORT_DESCRIPTOR_TYPE << 8, hidInterface, uint16_t(total), desc) == total);
+	TEST_ASSERT(memcmp(desc, HID_KEYBOARD_REPORT_DESCRIPTOR, HID_KEYBOARD_REPORT_DESCRIPTOR_SIZE) == 0);
+	TEST_ASSERT(memcmp(desc + HID_KEYBOARD_REPORT_DESCRIPTOR_SIZE, HID_GENERIC_REPORT_DESCRIPTOR, HID_GENERIC_REPORT_DESCRIPTOR_SIZE) == 0);
+}
+
+
+void testIdleProtocol() {
+	uint8_t val = 0xFF;
+	TEST_ASSERT(mockUsbControl(0x21, HID_SET_IDLE, 0x0000, hidInterface, 0, NULL) == 0);
+	TEST_ASSERT(mockUsbControl(0xA1, HID_GET_IDLE, 0x0000, hidInterface, 1, &val) == 1);
+	TEST_ASSERT(val == 0);
+	TEST_ASSERT(mockUsbControl(0xA1, HID_GET_PROTOCOL, 0x0000, hidInterface, 1, &val) == 1);
+	TEST_ASSERT(val == HID_REPORT_PROTOCOL);
+	TEST_ASSERT(mockUsbControl(0x21, HID_SET_PROTOCOL, HID_BOOT_PROTOCOL, hidInterface, 0, NULL) == 0);
+	TEST_ASSERT(HID().getProtocol() == HID_BOOT_PROTOCOL);
+	TEST_ASSERT(mockUsbControl(0x21, HID_SET_PROTOCOL, HID_REPORT_PROTOCOL, hidInterface, 0, NULL) == 0);
+	/* unsupported requests are stalled */
+	TEST_ASSERT(mockUsbControl(0xA1, HID_GET_REPORT, 0x0100, hidInterface, 8, &val) < 0);
+}
+
+
+void testReportQueue() {
+	memset(&hostReports, 0, sizeof(hostReports));
+	/* reports are sent on the next frame */
+	HIDKeyboardReport key;
+	memset(&key, 0, sizeof(key));
+	key.keys[0] = 0x04; /* a */
+	TEST_ASSERT(HID().availableForWrite() == HID_REPORT_QUEUE);
+	TEST_ASSERT(HID().SendReport(HID_REPORT_ID_KEYBOARD, &key, sizeof(key)) == int(sizeof(key) + 1));
+	TEST_ASSERT(mockUsbHostIn(hidEp, hostReports.data[0], HID_REPORT_SIZE) < 0);
+	hostFrame();
+	TEST_ASSERT(hostReports.count == 1);
+	TEST_ASSERT(hostReports.size[0] == (sizeof(key) + 1));
+	TEST_ASSERT(hostReports.data[0][0] == HID_REPORT_ID_KEYBOARD);
+	TEST_ASSERT(memcmp(hostReports.data[0] + 1, &key, sizeof(key)) == 0);
+	hostFrame();
+	TEST_ASSERT(hostReports.count == 1);
+	TEST_ASSERT(HID().availableForWrite() == HID_REPORT_QUEUE);
+	/* reports submitted with disabled interrupts (e.g. from an interrupt) do not wait */
+	memset(&hostReports, 0, sizeof(hostReports));
+	uint8_t generic[HID_GENERIC_REPORT_SIZE];
+	__disable_irq();
+	for (uint8_t i = 0; i < HID_REPORT_QUEUE; i++) {
+		memset(generic, i, sizeof(generic));
+		TEST_ASSERT(HID().SendReport(HID_REPORT_ID_GENERIC, generic, sizeof(generic)) == HID_REPORT_SIZE);
+	}
+	TEST_ASSERT(HID().availableForWrite() == 0);
+	TEST_ASSERT(HID().SendReport(HID_REPORT_ID_GENERIC, generic, sizeof(generic)) < 0);
+	TEST_ASSERT(HID().SendReport(HID_REPORT_ID_GENERIC, generic, sizeof(generic) + 1) < 0);
+	__enable_irq();
+	/* one report per frame */
+	for (uint8_t i = 0; i < HID_REPORT_QUEUE; i++) {
+		hostFrame();
+		TEST_ASSERT(hostReports.count == size_t(i + 1));
+		TEST_ASSERT(hostReports.size[i] == HID_REPORT_SIZE);
+		TEST_ASSERT(hostReports.data[i][0] == HID_REPORT_ID_GENERIC);
+		TEST_ASSERT(hostReports.data[i][1] == i && hostReports.data[i][HID_REPORT_SIZE - 1] == i);
+	}
+	/* no zero-length packet follows a report of endpoint size */
+	hostFrame();
+	TEST_ASSERT(hostReports.count == HID_REPORT_QUEUE);
+}
+
+
+void testReportQueueWait() {
+	enum { REPORTS = HID_REPORT_QUEUE * 3 };
+	memset(&hostReports, 0, sizeof(hostReports));
+	mockSetIdleHook(hostFrameHook, NULL);
+	HIDKeyboardReport key;
+	memset(&key, 0, sizeof(key));
+	for (uint8_t i = 0; i < REPORTS; i++) {
+		key.keys[0] = uint8_t(0x04 + i);
+		TEST_ASSERT(HID().SendReport(HID_REPORT_ID_KEYBOARD, &key, sizeof(key)) == int(sizeof(key) + 1));
+	}
+	while (hostReports.count < REPORTS && hostReports.frames < 1000) hostFrame();
+	mockSetIdleHook(NULL, NULL);
+	TEST_ASSERT(hostReports.count == REPORTS);
+	for (uint8_t i = 0; i < REPORTS; i++) {
+		TEST_ASSERT(hostReports.data[i][3] == uint8_t(0x04 + i));
+	}
+}
+
+
+void testOutReport() {
+	memset(&outReport, 0, sizeof(outReport));
+	HID().setOutReportCallback(onOutReport);
+	/* keyboard LEDs with report ID */
+	uint8_t leds[2] = {HID_REPORT_ID_KEYBOARD, 0x02 /* caps lock */};
+	TEST_ASSERT(mockUsbControl(0x21, HID_SET_REPORT, (HID_REPORT_TYPE_OUTPUT << 8) | HID_REPORT_ID_KEYBOARD, hidInterface, sizeof(leds), leds) == int(sizeof(leds)));
+	TEST_ASSERT(outReport.count == 1);
+	TEST_ASSERT(outReport.id == HID_REPORT_ID_KEYBOARD);
+	TEST_ASSERT(outReport.size == 1);
+	TEST_ASSERT(outReport.data[0] == 0x02);
+	/* feature reports are not passed to the callback */
+	TEST_ASSERT(mockUsbControl(0x21, HID_SET_REPORT, (HID_REPORT_TYPE_FEATURE << 8) | HID_REPORT_ID_KEYBOARD, hidInterface, sizeof(leds), leds) == int(sizeof(leds)));
+	TEST_ASSERT(outReport.count == 1);
+	HID().setOutReportCallback(NULL);
+}
+} /* anonymous namespace */
+
+
+int main() {
+	USBDevice.init();
+	TEST_ASSERT(USBDevice.attach());
+	TEST_RUN(testEnumerate);
+	TEST_RUN(testReportDescriptor);
+	TEST_RUN(testIdleProtocol);
+	TEST_RUN(testReportQueue);
+	TEST_RUN(testReportQueueWait);
+	TEST_RUN(testOutReport);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,695 @@
+/**
+ * @file test_serial.cpp
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ *
+ * Unit tests for HardwareSerial using the simulated UART.
+ */
+#include "hosttest.h"
+#include "Arduino.h"
+
+
+/* user provided buffers with a size which is not a power of two */
+uint8_t serial2Rx[100];
+uint8_t serial2Tx[48];
+
+
+HardwareSerial Serial1(USART1, USART1_IRQn, PA_10, PA_9, 7, 7);
+HardwareSerial Serial2(USART2, USART2_IRQn, PA_3, PA_2, 7, 7, serial2Rx, sizeof(serial2Rx), serial2Tx, sizeof(serial2Tx)); /* DMA based reception and transmission */
+
+
+extern "C" {
+/** IRQ handler for the DMA channel which serves the USART2 RX line. */
+void STM32CubeDuinoIrqHandlerForDMA1_CH6(void) {
+	Serial2.rxDmaIrqHandler();
+}
+
+
+/** IRQ handler for the DMA channel which serves the USART2 TX line. */
+void STM32CubeDuinoIrqHandlerForDMA1_CH7(void) {
+	Serial2.txDmaIrqHandler();
+}
+} /* extern "C" */
+
+
+namespace {
+/**
+ * Shifts out all data from the TX queue of the simulated UART.
+ * `flush()` cannot be used here as it busy waits for the interrupt handler.
+ *
+ * @param[in] instance - UART instance
+ */
+void drainTx(USART_TypeDef * instance) {
+	while (mockUartTransmit(instance, 1) > 0);
+}
+
+
+/**
+ * Fetches all data sent on the TX line.
+ *
+ * @param[out] buf - output buffer
+ * @param[in] maxLen - output buffer size
+ * @param[in] instance - UART instance
+ * @return number of bytes fetched
+ */
+size_t fetchTx(uint8_t * buf, const size_t maxLen, USART_TypeDef * instance = USART1) {
+	drainTx(instance);
+	return mockUartFetch(instance, buf, maxLen);
+}
+
+
+/**
+ * Tests the reception of single bytes.
+ */
+void testReceive() {
+	static const uint8_t data[] = "Hello World";
+	const size_t len = sizeof(data) - 1;
+	TEST_ASSERT(Serial1.available() == 0);
+	TEST_ASSERT(Serial1.read() == -1);
+	TEST_ASSERT(mockUartReceive(USART1, data, len) == len);
+	TEST_ASSERT(Serial1.available() == int(len));
+	TEST_ASSERT(Serial1.peek() == 'H');
+	for (size_t i = 0; i < len; i++) {
+		TEST_ASSERT(Serial1.read() == int(data[i]));
+	}
+	TEST_ASSERT(Serial1.available() == 0);
+	TEST_ASSERT(Serial1.peek() == -1);
+}
+
+
+/**
+ * Tests that the receive buffer drops data once full without corrupting previous data.
+ */
+void testReceiveOverflow() {
+	uint8_t data[SERIAL_RX_BUFFER_SIZE * 2];
+	for (size_t i = 0; i < sizeof(data); i++) data[i] = uint8_t(i);
+	mockUartReceive(USART1, data, sizeof(data));
+	TEST_ASSERT(Serial1.available() == (SERIAL_RX_BUFFER_SIZE - 1));
+	for (int i = 0; i < (SERIAL_RX_BUFFER_SIZE - 1); i++) {
+		TEST_ASSERT(Serial1.read() == i);
+	}
+	TEST_ASSERT(Serial1.available() == 0);
+	/* reception continues */
+	mockUartReceive(USART1, data, 1);
+	TEST_ASSERT(Serial1.read() == 0);
+}
+
+
+/**
+ * Tests the block wise reception via `read(buffer, size)`, `readBytes()` and
+ * `readBytesUntil()` including buffer wrap-arounds.
+ */
+void testReceiveBulk() {
+	uint8_t data[SERIAL_RX_BUFFER_SIZE - 1];
+	uint8_t buf[SERIAL_RX_BUFFER_SIZE];
+	for (size_t i = 0; i < sizeof(data); i++) data[i] = uint8_t(i * 7);
+	TEST_ASSERT(Serial1.read(buf, sizeof(buf)) == 0);
+	for (size_t round = 0; round < 3; round++) {
+		TEST_ASSERT(mockUartReceive(USART1, data, sizeof(data)) == sizeof(data));
+		TEST_ASSERT(Serial1.read(buf, 5) == 5);
+		TEST_ASSERT(Serial1.read(buf + 5, sizeof(buf) - 5) == (sizeof(data) - 5));
+		TEST_ASSERT(memcmp(buf, data, sizeof(data)) == 0);
+		TEST_ASSERT(Serial1.available() == 0);
+	}
+	/* readBytes() returns early on timeout */
+	Serial1.setTimeout(10);
+	TEST_ASSERT(mockUartReceive(USART1, data, 9) == 9);
+	TEST_ASSERT(Serial1.readBytes(buf, sizeof(buf)) == 9);
+	TEST_ASSERT(memcmp(buf, data, 9) == 0);
+	/* readBytesUntil() leaves the data after the terminator */
+	static const uint8_t line[] = "abc\ndef";
+	TEST_ASSERT(mockUartReceive(USART1, line, sizeof(line) - 1) == (sizeof(line) - 1));
+	TEST_ASSERT(Serial1.readBytesUntil('\n', buf, sizeof(buf)) == 3);
+	TEST_ASSERT(memcmp(buf, "abc", 3) == 0);
+	TEST_ASSERT(Serial1.readBytesUntil('\n', buf, sizeof(buf)) == 3);
+	TEST_ASSERT(memcmp(buf, "def", 3) == 0);
+	Serial1.setTimeout(1000);
+}
+
+
+/**
+ * Stream with the bulk read signature used by Arduino `Client` implementations.
+ * Compiles only if `Stream::read(uint8_t *, size_t)` has the same return type.
+ */
+class BlockStream : public Stream {
+public:
+	const uint8_t * data;
+	size_t size;
+	size_t blockReads;
+
+	BlockStream(const uint8_t * d, const size_t s) : data(d), size(s), blockReads(0) {}
+	int available(void) { return int(this->size); }
+	int read(void) {
+		if (this->size < 1) return -1;
+		this->size--;
+		return *(this->data)++;
+	}
+	int read(uint8_t * buffer, size_t len) {
+		this->blockReads++;
+		if (len > this->size) len = this->size;
+		memcpy(buffer, this->data, len);
+		this->data += len;
+		this->size -= len;
+		return int(len);
+	}
+	int peek(void) { return (this->size > 0) ? *(this->data) : -1; }
+	size_t write(uint8_t) { return 0; }
+};
+
+
+/**
+ * Tests that `readBytes()` is routed through an overridden `read(buffer, size)`.
+ */
+void testReceiveBulkOverride() {
+	static const uint8_t data[] = "0123456789";
+	uint8_t buf[sizeof(data)];
+	BlockStream stream(data, sizeof(data) - 1);
+	stream.setTimeout(0);
+	TEST_ASSERT(stream.readBytes(buf, sizeof(buf)) == (sizeof(data) - 1));
+	TEST_ASSERT(memcmp(buf, data, sizeof(data) - 1) == 0);
+	TEST_ASSERT(stream.blockReads > 0);
+}
+
+
+/**
+ * Tests the DMA based reception. A burst of data needs a single interrupt only.
+ */
+void testReceiveDma() {
+	static const uint8_t data[] = "Hello World";
+	const size_t len = sizeof(data) - 1;
+	TEST_ASSERT(Serial2.available() == 0);
+	TEST_ASSERT(Serial2.read() == -1);
+	const uint32_t uartIrqs = mockIrqCount(USART2_IRQn);
+	const uint32_t dmaIrqs = mockIrqCount(DMA1_Channel6_IRQn);
+	TEST_ASSERT(mockUartReceive(USART2, data, len) == len);
+	TEST_ASSERT(mockIrqCount(USART2_IRQn) == (uartIrqs + 1)); /* idle line */
+	TEST_ASSERT(mockIrqCount(DMA1_Channel6_IRQn) == dmaIrqs);
+	TEST_ASSERT(Serial2.available() == int(len));
+	TEST_ASSERT(Serial2.peek() == 'H');
+	for (size_t i = 0; i < len; i++) {
+		TEST_ASSERT(Serial2.read() == int(data[i]));
+	}
+	TEST_ASSERT(Serial2.available() == 0);
+	TEST_ASSERT(Serial2.peek() == -1);
+}
+
+
+/**
+ * Tests the DMA based reception across half and full buffer boundaries.
+ */
+void testReceiveDmaWrap() {
+	enum { ROUNDS = 20 };
+	uint8_t data[23];
+	size_t bytes = 0;
+	const uint32_t irqs = mockIrqCount(USART2_IRQn) + mockIrqCount(DMA1_Channel6_IRQn);
+	for (int round = 0; round < ROUNDS; round++) {
+		for (size_t i = 0; i < sizeof(data); i++) data[i] = uint8_t(bytes + i);
+		TEST_ASSERT(mockUartReceive(USART2, data, sizeof(data)) == sizeof(data));
+		TEST_ASSERT(Serial2.available() == int(sizeof(data)));
+		for (size_t i = 0; i < sizeof(data); i++) {
+			TEST_ASSERT(Serial2.read() == int(data[i]));
+		}
+		bytes += sizeof(data);
+	}
+	/* one interrupt per burst (idle line) and per half buffer */
+	const uint32_t maxIrqs = uint32_t(ROUNDS + ((2 * bytes) / sizeof(serial2Rx)));
+	TEST_ASSERT((mockIrqCount(USART2_IRQn) + mockIrqCount(DMA1_Channel6_IRQn) - irqs) <= maxIrqs);
+	TEST_ASSERT(Serial2.available() == 0);
+}
+
+
+/**
+ * Tests that the DMA based reception resumes at the right position after a reception error.
+ */
+void testReceiveDmaError() {
+	uint8_t data[40];
+	for (size_t i = 0; i < sizeof(data); i++) data[i] = uint8_t(i * 3);
+	TEST_ASSERT(mockUartReceive(USART2, data, 5) == 5);
+	mockUartError(USART2, USART_ISR_FE);
+	TEST_ASSERT(Serial2.available() == 5);
+	for (size_t i = 0; i < 5; i++) TEST_ASSERT(Serial2.read() == int(data[i]));
+	/* reception continues up to the buffer end and from there on in circular mode again */
+	for (int round = 0; round < 4; round++) {
+		TEST_ASSERT(mockUartReceive(USART2, data, sizeof(data)) == sizeof(data));
+		TEST_ASSERT(Serial2.available() == int(sizeof(data)));
+		for (size_t i = 0; i < sizeof(data); i++) {
+			TEST_ASSERT(Serial2.read() == int(data[i]));
+		}
+	}
+	TEST_ASSERT(Serial2.available() == 0);
+}
+
+
+/**
+ * Tests the transmission via Print functions.
+ */
+void testTransmit() {
+	uint8_t buf[256];
+	TEST_ASSERT(Serial1.print("Hello ") == 6);
+	TEST_ASSERT(Serial1.println(1234) == 6);
+	const size_t len = fetchTx(buf, sizeof(buf));
+	TEST_ASSERT(len == 12);
+	TEST_ASSERT(memcmp(buf, "Hello 1234\r\n", len) == 0);
+	TEST_ASSERT(Serial1.availableForWrite() == (SERIAL_TX_BUFFER_SIZE - 1));
+}
+
+
+/**
+ * Tests the transmission of more data than fits into the TX buffer.
+ * The blocking write relies on `__WFI()` which shifts out data in the simulation.
+ */
+void testTransmitBlocking() {
+	uint8_t data[SERIAL_TX_BUFFER_SIZE * 5];
+	uint8_t buf[sizeof(data) + 1];
+	for (size_t i = 0; i < sizeof(data); i++) data[i] = uint8_t(i * 7);
+	TEST_ASSERT(Serial1.write(data, sizeof(data)) == sizeof(data));
+	const size_t len = fetchTx(buf, sizeof(buf));
+	TEST_ASSERT(len == sizeof(data));
+	TEST_ASSERT(memcmp(buf, data, len) == 0);
+}
+
+
+/**
+ * Tests the DMA based transmission. Each block needs only a few interrupts.
+ */
+void testTransmitDma() {
+	uint8_t data[sizeof(serial2Tx) * 5];
+	uint8_t buf[sizeof(data) + 1];
+	for (size_t i = 0; i < sizeof(data); i++) data[i] = uint8_t(i * 11);
+	TEST_ASSERT(Serial2.print("Hello DMA") == 9);
+	size_t len = fetchTx(buf, sizeof(buf), USART2);
+	TEST_ASSERT(len == 9);
+	TEST_ASSERT(memcmp(buf, "Hello DMA", len) == 0);
+	const uint32_t irqs = mockIrqCount(USART2_IRQn) + mockIrqCount(DMA1_Channel7_IRQn);
+	TEST_ASSERT(Serial2.write(data, sizeof(data)) == sizeof(data));
+	len = fetchTx(buf, sizeof(buf), USART2);
+	TEST_ASSERT(len == sizeof(data));
+	TEST_ASSERT(memcmp(buf, data, len) == 0);
+	TEST_ASSERT((mockIrqCount(USART2_IRQn) + mockIrqCount(DMA1_Channel7_IRQn) - irqs) <= (sizeof(data) / 4));
+	TEST_ASSERT(Serial2.availableForWrite() == int(sizeof(serial2Tx) - 1));
+}
+
+
+/**
+ * Tests the non-blocking transmission from an interrupt context with higher priority.
+ */
+void testTransmitFromIrq() {
+	static size_t written;
+	written = 0;
+	mockSetIrqHandler(IRQn_Type(0), [] () {
+		for (size_t i = 0; i < SERIAL_TX_BUFFER_SIZE * 2; i++) written += Serial1.write(uint8_t(i));
+	});
+	HAL_NVIC_SetPriority(IRQn_Type(0), 0, 0);
+	HAL_NVIC_EnableIRQ(IRQn_Type(0));
+	mockRaiseIrq(IRQn_Type(0));
+	HAL_NVIC_DisableIRQ(IRQn_Type(0));
+	/* UART interrupt is blocked: buffer capacity and the byte in the data register are the limit */
+	TEST_ASSERT(written > 0);
+	TEST_ASSERT(written < (SERIAL_TX_BUFFER_SIZE * 2));
+	uint8_t buf[SERIAL_TX_BUFFER_SIZE * 2];
+	const size_t len = fetchTx(buf, sizeof(buf));
+	TEST_ASSERT(len == written);
+	for (size_t i = 0; i < len; i++) TEST_ASSERT(buf[i] == uint8_t(i));
+	/* the same applies for block writes */
+	mockSetIrqHandler(IRQn_Type(0), [] () {
+		uint8_t data[SERIAL_TX_BUFFER_SIZE * 2];
+		for (size_t i = 0; i < sizeof(data); i++) data[i] = uint8_t(i);
+		written = Serial1.write(data, sizeof(data));
+	});
+	HAL_NVIC_EnableIRQ(IRQn_Type(0));
+	mockRaiseIrq(IRQn_Type(0));
+	HAL_NVIC_DisableIRQ(IRQn_Type(0));
+	TEST_ASSERT(written > 0);
+	TEST_ASSERT(written < (SERIAL_TX_BUFFER_SIZE * 2));
+	TEST_ASSERT(fetchTx(buf, sizeof(buf)) == written);
+	for (size_t i = 0; i < written; i++) TEST_ASSERT(buf[i] == uint8_t(i));
+}
+
+
+/**
+ * Tests the change of the buffer sizes at runtime.
+ */
+void testBufferSize() {
+	uint8_t data[300];
+	uint8_t buf[sizeof(data) + 1];
+	for (size_t i = 0; i < sizeof(data); i++) data[i] = uint8_t(i * 13);
+	/* not possible while running */
+	TEST_ASSERT(Serial1.setRxBufferSize(sizeof(data) + 1) == 0);
+	Serial1.end();
+	TEST_ASSERT(Serial1.setRxBufferSize(1) == 0);
+	TEST_ASSERT(Serial1.setRxBufferSize(sizeof(data) + 1) == (sizeof(data) + 1));
+	TEST_ASSERT(Serial1.setTxBufferSize(30) == 30);
+	Serial1.begin(115200);
+	TEST_ASSERT(Serial1.availableForWrite() == 29);
+	TEST_ASSERT(mockUartReceive(USART1, data, sizeof(data)) == sizeof(data));
+	TEST_ASSERT(Serial1.available() == int(sizeof(data)));
+	TEST_ASSERT(Serial1.read(buf, sizeof(buf)) == sizeof(data));
+	TEST_ASSERT(memcmp(buf, data, sizeof(data)) == 0);
+	TEST_ASSERT(Serial1.write(data, sizeof(data)) == sizeof(data));
+	TEST_ASSERT(fetchTx(buf, sizeof(buf)) == sizeof(data));
+	TEST_ASSERT(memcmp(buf, data, sizeof(data)) == 0);
+	/* restore defaults */
+	Serial1.end();
+	TEST_ASSERT(Serial1.setRxBufferSize(SERIAL_RX_BUFFER_SIZE) == SERIAL_RX_BUFFER_SIZE);
+	TEST_ASSERT(Serial1.setTxBufferSize(SERIAL_TX_BUFFER_SIZE) == SERIAL_TX_BUFFER_SIZE);
+	Serial1.begin(115200);
+}
+
+
+/**
+ * Receives a large block of data in small chunks while RTS is enabled. The remote side stops
+ * sending while RTS is deasserted.
+ *
+ * @param[in,out] serial - serial instance
+ * @param[in] instance - associated UART instance
+ */
+void receiveWithRts(HardwareSerial & serial, USART_TypeDef * instance) {
+	uint8_t data[1000];
+	uint8_t buf[sizeof(data)];
+	for (size_t i = 0; i < sizeof(data); i++) data[i] = uint8_t((i * 7) + 1);
+	size_t sent = mockUartReceive(instance, data, sizeof(data));
+	TEST_ASSERT(sent < sizeof(data));
+	TEST_ASSERT( ! mockUartRts(instance) );
+	size_t received = 0;
+	for (int i = 0; i < 10000 && received < sizeof(data); i++) {
+		received += size_t(serial.read(buf + received, min(sizeof(data) - received, size_t(7))));
+		if (sent < sizeof(data)) sent += mockUartReceive(instance, data + sent, sizeof(data) - sent);
+	}
+	TEST_ASSERT(received == sizeof(data));
+	TEST_ASSERT(memcmp(buf, data, sizeof(data)) == 0);
+	TEST_ASSERT(mockUartRts(instance));
+	TEST_ASSERT(serial.available() == 0);
+}
+
+
+/**
+ * Tests the hardware flow control with interrupt and DMA based reception.
+ */
+void testFlowControl() {
+	uint8_t buf[16];
+	Serial1.end();
+	Serial1.setFlowControl(PA_12, PA_11, 7, 7);
+	Serial1.begin(115200);
+	receiveWithRts(Serial1, USART1);
+	/* transmission pauses while CTS is deasserted */
+	mockUartSetCts(USART1, false);
+	TEST_ASSERT(Serial1.write(reinterpret_cast<const uint8_t *>("CTS"), 3) == 3);
+	TEST_ASSERT(mockUartTransmit(USART1, 3) == 0);
+	mockUartSetCts(USART1, true);
+	TEST_ASSERT(fetchTx(buf, sizeof(buf)) == 3);
+	TEST_ASSERT(memcmp(buf, "CTS", 3) == 0);
+	Serial1.end();
+	Serial1.setFlowControl(NC, NC);
+	Serial1.begin(115200);
+	/* DMA based reception */
+	Serial2.end();
+	Serial2.setFlowControl(PA_1, PA_0, 7, 7);
+	Serial2.begin(115200);
+	receiveWithRts(Serial2, USART2);
+	Serial2.end();
+	Serial2.setFlowControl(NC, NC);
+	Serial2.begin(115200);
+}
+
+
+/**
+ * Tests the RS-485 driver enable output.
+ */
+void testDriverEnable() {
+	uint8_t buf[8];
+	Serial1.end();
+	Serial1.setDriverEnable(PA_12, 8, 16, 7);
+	Serial1.begin(115200);
+	TEST_ASSERT((USART1->CR3 & (USART_CR3_DEM | USART_CR3_DEP | USART_CR3_RTSE)) == USART_CR3_DEM);
+	TEST_ASSERT(((USART1->CR1 & USART_CR1_DEAT) >> USART_CR1_DEAT_Pos) == 8);
+	TEST_ASSERT(((USART1->CR1 & USART_CR1_DEDT) >> USART_CR1_DEDT_Pos) == 16);
+	TEST_ASSERT((USART1->CR1 & USART_CR1_UE) != 0);
+	/* DE is asserted until the last byte was sent */
+	TEST_ASSERT( ! mockUartDe(USART1) );
+	TEST_ASSERT(Serial1.write(reinterpret_cast<const uint8_t *>("RS485"), 5) == 5);
+	TEST_ASSERT( mockUartDe(USART1) );
+	TEST_ASSERT(mockUartTransmit(USART1, 4) == 4);
+	TEST_ASSERT( mockUartDe(USART1) );
+	TEST_ASSERT(mockUartTransmit(USART1, 1) == 1);
+	TEST_ASSERT( ! mockUartDe(USART1) );
+	TEST_ASSERT(mockUartFetch(USART1, buf, sizeof(buf)) == 5);
+	TEST_ASSERT(memcmp(buf, "RS485", 5) == 0);
+	Serial1.end();
+	Serial1.setDriverEnable(NC);
+	Serial1.begin(115200);
+	TEST_ASSERT((USART1->CR3 & USART_CR3_DEM) == 0);
+}
+
+
+/**
+ * Tests the register level interrupt handler for reception, transmission, reception errors
+ * and hardware flow control.
+ */
+void testFastIrq() {
+	uint8_t data[SERIAL_TX_BUFFER_SIZE * 5];
+	uint8_t buf[sizeof(data) + 1];
+	for (size_t i = 0; i < sizeof(data); i++) data[i] = uint8_t(i * 7);
+	Serial1.end();
+	Serial1.setFastIrq(true);
+	Serial1.begin(115200);
+	/* reception drops data once the buffer is full */
+	TEST_ASSERT(mockUartReceive(USART1, data, SERIAL_RX_BUFFER_SIZE * 2) == (SERIAL_RX_BUFFER_SIZE * 2));
+	TEST_ASSERT(Serial1.available() == (SERIAL_RX_BUFFER_SIZE - 1));
+	TEST_ASSERT(Serial1.read(buf, sizeof(buf)) == (SERIAL_RX_BUFFER_SIZE - 1));
+	TEST_ASSERT(memcmp(buf, data, SERIAL_RX_BUFFER_SIZE - 1) == 0);
+	/* corrupted bytes are dropped, reception continues */
+	TEST_ASSERT(mockUartReceive(USART1, data, 1) == 1);
+	__disable_irq();
+	TEST_ASSERT(mockUartReceive(USART1, data + 1, 1) == 1);
+	mockUartError(USART1, USART_ISR_FE);
+	__enable_irq();
+	TEST_ASSERT(mockUartReceive(USART1, data + 2, 1) == 1);
+	TEST_ASSERT(Serial1.read() == int(data[0]));
+	TEST_ASSERT(Serial1.read() == int(data[2]));
+	TEST_ASSERT(Serial1.available() == 0);
+	TEST_ASSERT((USART1->ISR & (USART_ISR_FE | USART_ISR_RXNE)) == 0);
+	/* transmission */
+	TEST_ASSERT(Serial1.print("Hello ") == 6);
+	TEST_ASSERT(Serial1.println(1234) == 6);
+	TEST_ASSERT(fetchTx(buf, sizeof(buf)) == 12);
+	TEST_ASSERT(memcmp(buf, "Hello 1234\r\n", 12) == 0);
+	TEST_ASSERT(Serial1.write(data, sizeof(data)) == sizeof(data));
+	TEST_ASSERT(fetchTx(buf, sizeof(buf)) == sizeof(data));
+	TEST_ASSERT(memcmp(buf, data, sizeof(data)) == 0);
+	TEST_ASSERT((USART1->CR1 & (USART_CR1_TXEIE | USART_CR1_TCIE)) == 0);
+	Serial1.flush(); /* returns as all data was shifted out */
+	/* the parity bit is removed */
+	Serial1.end();
+	Serial1.begin(115200, SERIAL_7E1);
+	TEST_ASSERT(mockUartReceive(USART1, reinterpret_cast<const uint8_t *>("\xC1"), 1) == 1);
+	TEST_ASSERT(Serial1.read() == 0x41);
+	/* hardware flow control */
+	Serial1.end();
+	Serial1.setFlowControl(PA_12, PA_11, 7, 7);
+	Serial1.begin(115200);
+	receiveWithRts(Serial1, USART1);
+	mockUartSetCts(USART1, false);
+	TEST_ASSERT(Serial1.write(reinterpret_cast<const uint8_t *>("CTS"), 3) == 3);
+	TEST_ASSERT(mockUartTransmit(USART1, 3) == 0);
+	mockUartSetCts(USART1, true);
+	TEST_ASSERT(fetchTx(buf, sizeof(buf)) == 3);
+	TEST_ASSERT(memcmp(buf, "CTS", 3) == 0);
+	Serial1.end();
+	Serial1.setFlowControl(NC, NC);
+	Serial1.setFastIrq(false);
+	Serial1.begin(115200);
+}
+
+
+/**
+ * Checks the error counters of the given statistics.
+ *
+ * @param[in] stats - statistics to check
+ * @param[in] parity - expected number of parity errors
+ * @param[in] framing - expected number of framing errors
+ * @param[in] noise - expected number of noise errors
+ * @param[in] overrun - expected number of overrun errors
+ */
+void checkErrors(const HardwareSerial::Stats & stats, const uint32_t parity, const uint32_t framing, const uint32_t noise, const uint32_t overrun) {
+	TEST_ASSERT(stats.parityErrors == parity);
+	TEST_ASSERT(stats.framingErrors == framing);
+	TEST_ASSERT(stats.noiseErrors == noise);
+	TEST_ASSERT(stats.overrunErrors == overrun);
+}
+
+
+/**
+ * Tests the reception and transmission statistics with the STM32 HAL API and the register
+ * level interrupt handler as well as with DMA.
+ */
+void testStats() {
+	uint8_t data[SERIAL_RX_BUFFER_SIZE * 2];
+	uint8_t buf[sizeof(data) + 1];
+	for (size_t i = 0; i < sizeof(data); i++) data[i] = uint8_t(i * 5);
+	for (int fastIrq = 0; fastIrq < 2; fastIrq++) {
+		Serial1.end();
+		Serial1.setFastIrq(fastIrq != 0);
+		Serial1.begin(115200);
+		HardwareSerial::Stats stats = Serial1.getStats();
+		TEST_ASSERT(stats.rxBytes == 0 && stats.txBytes == 0 && stats.rxHighWater == 0 && stats.txHighWater == 0);
+		/* reception with buffer overflow */
+		TEST_ASSERT(mockUartReceive(USART1, data, 10) == 10);
+		TEST_ASSERT(Serial1.read(buf, sizeof(buf)) == 10);
+		TEST_ASSERT(mockUartReceive(USART1, data, sizeof(data)) == sizeof(data));
+		TEST_ASSERT(Serial1.read(buf, sizeof(buf)) == (SERIAL_RX_BUFFER_SIZE - 1));
+		stats = Serial1.getStats();
+		TEST_ASSERT(stats.rxBytes == (10 + SERIAL_RX_BUFFER_SIZE - 1));
+		TEST_ASSERT(stats.rxDropped == (SERIAL_RX_BUFFER_SIZE + 1));
+		TEST_ASSERT(stats.rxHighWater == (SERIAL_RX_BUFFER_SIZE - 1));
+		checkErrors(stats, 0, 0, 0, 0);
+		/* reception errors */
+		mockUartError(USART1, USART_ISR_PE | USART_ISR_ORE);
+		mockUartError(USART1, USART_ISR_FE);
+		mockUartError(USART1, USART_ISR_NE);
+		checkErrors(Serial1.getStats(), 1, 1, 1, 1);
+		/* transmission */
+		TEST_ASSERT(Serial1.write(data, 20) == 20);
+		TEST_ASSERT(fetchTx(buf, sizeof(buf)) == 20);
+		stats = Serial1.getStats();
+		TEST_ASSERT(stats.txBytes == 20);
+		TEST_ASSERT(stats.txHighWater > 0 && stats.txHighWater <= 20);
+		Serial1.resetStats();
+		stats = Serial1.getStats();
+		TEST_ASSERT(stats.rxBytes == 0 && stats.rxDropped == 0 && stats.txBytes == 0 && stats.rxHighWater == 0);
+		checkErrors(stats, 0, 0, 0, 0);
+	}
+	Serial1.end();
+	Serial1.setFastIrq(false);
+	Serial1.begin(115200);
+	/* DMA based reception and transmission */
+	Serial2.resetStats();
+	TEST_ASSERT(mockUartReceive(USART2, data, 30) == 30);
+	TEST_ASSERT(Serial2.read(buf, sizeof(buf)) == 30);
+	mockUartError(USART2, USART_ISR_ORE);
+	TEST_ASSERT(Serial2.print("Hello DMA") == 9);
+	TEST_ASSERT(fetchTx(buf, sizeof(buf), USART2) == 9);
+	HardwareSerial::Stats stats = Serial2.getStats();
+	TEST_ASSERT(stats.rxBytes == 30);
+	TEST_ASSERT(stats.rxDropped == 0);
+	TEST_ASSERT(stats.rxHighWater == 30);
+	TEST_ASSERT(stats.txBytes == 9);
+	checkErrors(stats, 0, 0, 0, 1);
+}
+
+
+/** Lengths of the frames reported via `onFrame()`. */
+size_t frames[4];
+size_t frameCount = 0;
+
+
+/**
+ * Records the length of the received frame.
+ *
+ * @param[in] length - frame length in bytes
+ */
+void frameCallback(const size_t length) {
+	if (frameCount < 4) frames[frameCount] = length;
+	frameCount++;
+}
+
+
+/**
+ * Receives the given data and checks the reported frames.
+ *
+ * @param[in] serial - serial interface
+ * @param[in] instance - UART instance
+ * @param[in] withDelimiter - true if the frames end with a new-line
+ */
+void checkFrames(HardwareSerial & serial, USART_TypeDef * instance, const bool withDelimiter) {
+	static const uint8_t data[] = "ab\ncde\nfg";
+	uint8_t buf[32];
+	frameCount = 0;
+	TEST_ASSERT(mockUartReceive(instance, data, 9) == 9);
+	if ( withDelimiter ) {
+		TEST_ASSERT(frameCount == 3);
+		TEST_ASSERT(frames[0] == 3 && frames[1] == 4 && frames[2] == 2);
+	} else {
+		TEST_ASSERT(frameCount == 1);
+		TEST_ASSERT(frames[0] == 9);
+	}
+	TEST_ASSERT(serial.read(buf, sizeof(buf)) == 9);
+	TEST_ASSERT(memcmp(buf, data, 9) == 0);
+}
+
+
+/**
+ * Tests the frame callback on idle line and frame delimiter.
+ */
+void testFrames() {
+	static const uint8_t data[] = "xyz";
+	uint8_t buf[8];
+	for (int fastIrq = 0; fastIrq < 2; fastIrq++) {
+		Serial1.end();
+		Serial1.setFastIrq(fastIrq != 0);
+		Serial1.onFrame(frameCallback);
+		Serial1.begin(115200);
+		checkFrames(Serial1, USART1, false);
+		Serial1.end();
+		Serial1.setFrameDelimiter('\n');
+		Serial1.begin(115200);
+		checkFrames(Serial1, USART1, true);
+		/* disable at runtime */
+		Serial1.onFrame(NULL);
+		TEST_ASSERT((USART1->CR1 & USART_CR1_IDLEIE) == 0);
+		frameCount = 0;
+		TEST_ASSERT(mockUartReceive(USART1, data, 3) == 3);
+		TEST_ASSERT(frameCount == 0);
+		TEST_ASSERT(Serial1.read(buf, sizeof(buf)) == 3);
+		Serial1.end();
+		Serial1.setFrameDelimiter(-1);
+	}
+	Serial1.setFastIrq(false);
+	Serial1.begin(115200);
+	/* DMA based reception; the delimiter is detected via character match */
+	Serial2.onFrame(frameCallback);
+	checkFrames(Serial2, USART2, false);
+	Serial2.end();
+	Serial2.setFrameDelimiter('\n');
+	Serial2.begin(115200);
+	checkFrames(Serial2, USART2, true);
+	Serial2.onFrame(NULL);
+	TEST_ASSERT((USART2->CR1 & USART_CR1_CMIE) == 0);
+	frameCount = 0;
+	TEST_ASSERT(mockUartReceive(USART2, data, 3) == 3);
+	TEST_ASSERT(frameCount == 0);
+	TEST_ASSERT(Serial2.read(buf, sizeof(buf)) == 3);
+	Serial2.end();
+	Serial2.setFrameDelimiter(-1);
+	Serial2.begin(115200);
+}
+} /* anonymous namespace */
+
+
+int main() {
+	Serial1.begin(115200);
+	Serial2.setRxDma(DMA1_Channel6, DMA_REQUEST_2, DMA1_Channel6_IRQn);
+	Serial2.setTxDma(DMA1_Channel7, DMA_REQUEST_2, DMA1_Channel7_IRQn);
+	Serial2.begin(115200);
+	TEST_RUN(testReceive);
+	TEST_RUN(testReceiveOverflow);
+	TEST_RUN(testReceiveBulk);
+	TEST_RUN(testReceiveBulkOverride);
+	TEST_RUN(testReceiveDma);
+	TEST_RUN(testReceiveDmaWrap);
+	TEST_RUN(testReceiveDmaError);
+	TEST_RUN(testTransmit);
+	TEST_RUN(testTransmitBlocking);
+	TEST_RUN(testTransmitDma);
+	TEST_RUN(testTransmitFromIrq);
+	TEST_RUN(testBufferSize);
+	TEST_RUN(testFlowControl);
+	TEST_RUN(testDriverEnable);
+	TEST_RUN(testFastIrq);
+	TEST_RUN(testStats);
+	TEST_RUN(testFrames);
+	Serial2.end();
+	Serial1.end();
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file test_serial_sr.cpp
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ *
+ * Unit tests for HardwareSerial using the simulated UART with the SR/DR register model of the
+ * STM32F1/F2/F4/L1 series. Reading the data register clears the idle line flag there.
+ */
+#include "hosttest.h"
+#include "Arduino.h"
+
+
+HardwareSerial Serial1(USART1, USART1_IRQn, PA_10, PA_9, 7, 7);
+
+
+namespace {
+/** Number of frames and bytes reported via `onFrame()`. */
+size_t frameCount = 0;
+size_t frameBytes = 0;
+
+
+/**
+ * Records the length of the received frame.
+ *
+ * @param[in] length - frame length in bytes
+ */
+void frameCallback(const size_t length) {
+	frameCount++;
+	frameBytes += length;
+}
+
+
+/**
+ * Tests the frame callback on consecutive idle lines with the STM32 HAL API and the register
+ * level interrupt handler.
+ */
+void testFrames() {
+	static const uint8_t data[] = "abcde";
+	uint8_t buf[8];
+	for (int fastIrq = 0; fastIrq < 2; fastIrq++) {
+		Serial1.end();
+		Serial1.setFastIrq(fastIrq != 0);
+		Serial1.onFrame(frameCallback);
+		Serial1.begin(115200);
+		frameCount = 0;
+		frameBytes = 0;
+		TEST_ASSERT(mockUartReceive(USART1, data, 3) == 3);
+		TEST_ASSERT(frameCount == 1 && frameBytes == 3);
+		/* the idle line interrupt does not fire again without new data */
+		mockRaiseIrq(USART1_IRQn);
+		TEST_ASSERT(frameCount == 1);
+		TEST_ASSERT(mockUartReceive(USART1, data + 3, 2) == 2);
+		TEST_ASSERT(frameCount == 2 && frameBytes == 5);
+		TEST_ASSERT(Serial1.read(buf, sizeof(buf)) == 5);
+		TEST_ASSERT(memcmp(buf, data, 5) == 0);
+		Serial1.onFrame(NULL);
+		Serial1.end();
+	}
+	Serial1.setFastIrq(false);
+	Serial1.begin(115200);
+}
+
+
+/**
+ * Tests the frame callback with hardware flow control. The UART keeps the next byte in the data
+ * register while the reception is paused. The idle line which follows must not drop it.
+ */
+void testFramesWithRts() {
+	uint8_t data[1000];
+	uint8_t buf[sizeof(data)];
+	for (size_t i = 0; i < sizeof(data); i++) data[i] = uint8_t((i * 7) + 1);
+	for (int fastIrq = 0; fastIrq < 2; fastIrq++) {
+		Serial1.end();
+		Serial1.setFastIrq(fastIrq != 0);
+		Serial1.setFlowControl(PA_12, PA_11, 7, 7);
+		Serial1.onFrame(frameCallback);
+		Serial1.begin(115200);
+		frameCount = 0;
+		frameBytes = 0;
+		size_t sent = mockUartReceive(USART1, data, sizeof(data));
+		TEST_ASSERT(sent < sizeof(data));
+		TEST_ASSERT( ! mockUartRts(USART1) );
+		TEST_ASSERT(frameCount > 0);
+		size_t received = 0;
+		for (int i = 0; i < 10000 && received < sizeof(data); i++) {
+			received += size_t(Serial1.read(buf + received, min(sizeof(data) - received, size_t(7))));
+			if (sent < sizeof(data)) sent += mockUartReceive(USART1, data + sent, sizeof(data) - sent);
+		}
+		TEST_ASSERT(received == sizeof(data));
+		TEST_ASSERT(memcmp(buf, data, sizeof(data)) == 0);
+		TEST_ASSERT(mockUartRts(USART1));
+		TEST_ASSERT(Serial1.available() == 0);
+		TEST_ASSERT(Serial1.getStats().rxDropped == 0);
+		/* the byte kept while paused is reported with the following frame */
+		TEST_ASSERT(frameBytes == sizeof(data));
+		Serial1.onFrame(NULL);
+		Serial1.end();
+		Serial1.setFlowControl(NC, NC);
+	}
+	Serial1.setFastIrq(false);
+	Serial1.begin(115200);
+}
+} /* anonymous namespace */
+
+
+int main() {
+	Serial1.begin(115200);
+	TEST_RUN(testFrames);
+	TEST_RUN(testFramesWithRts);
+	Serial1.end();
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,361 @@
+/**
+ * @file test_usb.cpp
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ *
+ * Unit tests for USBCore and the USB CDC class using the simulated USB FS device.
+ */
+#include "hosttest.h"
+#include "Arduino.h"
+
+
+extern PCD_HandleTypeDef hPcdUsb[1];
+
+
+namespace {
+enum {
+	EP_ACM = 1,
+	EP_OUT = 2,
+	EP_IN = 3
+};
+
+
+/** Data received by the simulated host on the CDC IN endpoint. */
+struct HostInBuffer {
+	uint8_t data[8192];
+	size_t size;
+	size_t packets;
+} hostIn;
+
+
+/**
+ * Idle hook which polls the CDC IN endpoint like a host would.
+ */
+void pollHostIn(void * /* user */) {
+	uint8_t packet[USB_EP_SIZE];
+	const int len = mockUsbHostIn(EP_IN, packet, sizeof(packet));
+	if (len < 0) return;
+	hostIn.packets++;
+	TEST_ASSERT((hostIn.size + size_t(len)) <= sizeof(hostIn.data));
+	memcpy(hostIn.data + hostIn.size, packet, size_t(len));
+	hostIn.size += size_t(len);
+}
+
+
+/** Data sent by the simulated host on the CDC OUT endpoint while the device waits. */
+struct HostOutBuffer {
+	const uint8_t * data;
+	size_t size;
+	size_t pos;
+} hostOutData;
+
+
+/**
+ * Idle hook which sends one OUT packet per call to the CDC OUT endpoint like a host would.
+ */
+void pushHostOut(void * /* user */) {
+	if (hostOutData.pos >= hostOutData.size) return;
+	const size_t remaining = hostOutData.size - hostOutData.pos;
+	const size_t packetLen = (remaining > USB_EP_SIZE) ? USB_EP_SIZE : remaining;
+	const int sent = mockUsbHostOut(EP_OUT, hostOutData.data + hostOutData.pos, packetLen);
+	if (sent > 0) hostOutData.pos += size_t(sent);
+}
+
+
+/**
+ * Sends the given data as a sequence of OUT packets to the CDC OUT endpoint.
+ *
+ * @param[in] data - data to send
+ * @param[in] len - number of bytes to send
+ * @return number of bytes accepted by the device
+ */
+size_t hostOut(const uint8_t * data, const size_t len) {
+	size_t res = 0;
+	while (res < len) {
+		const size_t packetLen = ((len - res) > USB_EP_SIZE) ? USB_EP_SIZE : (len - res);
+		const int sent = mockUsbHostOut(EP_OUT, data + res, packetLen);
+		if (sent < 0) break; /* NAK */
+		res += size_t(sent);
+	}
+	return res;
+}
+
+
+/**
+ * Tests the device enumeration and the CDC line state handling.
+ */
+void testEnumerate() {
+	TEST_ASSERT(mockUsbEnumerate() == 0);
+	TEST_ASSERT(USBDevice.configured());
+	TEST_ASSERT( ! SerialUSB.dtr() );
+	uint8_t lineCoding[7] = {0x00, 0xC2, 0x01, 0x00, 0, 0, 8}; /* 115200 8N1 */
+	TEST_ASSERT(mockUsbControl(0x21, CDC_SET_LINE_CODING, 0, 0, sizeof(lineCoding), lineCoding) == int(sizeof(lineCoding)));
+	TEST_ASSERT(SerialUSB.baud() == 115200);
+	TEST_ASSERT(mockUsbControl(0x21, CDC_SET_CONTROL_LINE_STATE, 0x0003 /* DTR | RTS */, 0, 0, NULL) == 0);
+	TEST_ASSERT(SerialUSB.dtr());
+	TEST_ASSERT(SerialUSB.rts());
+	TEST_ASSERT(bool(SerialUSB));
+}
+
+
+/**
+ * Tests that the CDC bulk endpoints are double-buffered and that no endpoint buffers overlap
+ * within the PMA.
+ */
+void testPmaLayout() {
+	TEST_ASSERT(hPcdUsb->OUT_ep[EP_OUT].doublebuffer == 1);
+	TEST_ASSERT(hPcdUsb->IN_ep[EP_IN].doublebuffer == 1);
+	TEST_ASSERT(hPcdUsb->IN_ep[EP_ACM].doublebuffer == 0);
+	uint16_t start[USB_ENDPOINTS * 4];
+	size_t count = 0;
+	for (size_t i = 0; i < USB_ENDPOINTS; i++) {
+		const PCD_EPTypeDef * eps[2] = {hPcdUsb->OUT_ep + i, hPcdUsb->IN_ep + i};
+		for (const PCD_EPTypeDef * ep : eps) {
+			if ( ! ep->is_open ) continue;
+			if ( ep->doublebuffer ) {
+				start[count++] = ep->pmaaddr0;
+				start[count++] = ep->pmaaddr1;
+			} else {
+				start[count++] = ep->pmaadress;
+			}
+		}
+	}
+	TEST_ASSERT(count == 7); /* control OUT/IN, ACM IN, 2 * bulk OUT, 2 * bulk IN */
+	for (size_t i = 0; i < count; i++) {
+		TEST_ASSERT(start[i] >= (16 * USB_ENDPOINTS));
+		TEST_ASSERT(size_t(start[i] + USB_EP_SIZE) <= size_t(USB_PMASIZE));
+		for (size_t j = i + 1; j < count; j++) {
+			TEST_ASSERT((start[i] + USB_EP_SIZE) <= start[j] || (start[j] + USB_EP_SIZE) <= start[i]);
+		}
+	}
+}
+
+
+/**
+ * Tests the data reception from the host.
+ */
+void testReceive() {
+	uint8_t data[USB_EP_SIZE / 2];
+	for (size_t i = 0; i < sizeof(data); i++) data[i] = uint8_t(i * 3);
+	TEST_ASSERT(SerialUSB.available() == 0);
+	TEST_ASSERT(SerialUSB.read() == -1);
+	/* zero-length packets carry no data */
+	TEST_ASSERT(mockUsbHostOut(EP_OUT, data, 0) == 0);
+	TEST_ASSERT(SerialUSB.available() == 0);
+	TEST_ASSERT(SerialUSB.read() == -1);
+	/* two short packets */
+	TEST_ASSERT(hostOut(data, 7) == 7);
+	TEST_ASSERT(hostOut(data + 7, sizeof(data) - 7) == (sizeof(data) - 7));
+	TEST_ASSERT(SerialUSB.available() == int(sizeof(data)));
+	TEST_ASSERT(SerialUSB.peek() == int(data[0]));
+	for (size_t i = 0; i < sizeof(data); i++) {
+		TEST_ASSERT(SerialUSB.read() == int(data[i]));
+	}
+	TEST_ASSERT(SerialUSB.available() == 0);
+}
+
+
+/**
+ * Tests that the device stops accepting OUT packets once the receive buffer is full and
+ * resumes after the application consumed the data.
+ */
+void testReceiveFlowControl() {
+	uint8_t data[USB_EP_SIZE * 8];
+	for (size_t i = 0; i < sizeof(data); i++) data[i] = uint8_t(i);
+	const size_t accepted = hostOut(data, sizeof(data));
+	TEST_ASSERT(accepted >= USB_EP_SIZE);
+	TEST_ASSERT(accepted < sizeof(data));
+	TEST_ASSERT(SerialUSB.available() > 0 && SerialUSB.available() <= int(accepted)); /* pending packet data is not reported */
+	for (size_t i = 0; i < accepted; i++) {
+		TEST_ASSERT(SerialUSB.read() == int(data[i]));
+	}
+	TEST_ASSERT(SerialUSB.read() == -1);
+	/* device accepts new data again */
+	TEST_ASSERT(hostOut(data, USB_EP_SIZE) == USB_EP_SIZE);
+	for (size_t i = 0; i < USB_EP_SIZE; i++) TEST_ASSERT(SerialUSB.read() == int(data[i]));
+	/* all data arrives if the application reads in between */
+	size_t sent = 0, received = 0;
+	while (received < sizeof(data)) {
+		if (sent < sizeof(data)) sent += hostOut(data + sent, sizeof(data) - sent);
+		const int c = SerialUSB.read();
+		if (c < 0) continue;
+		TEST_ASSERT(c == int(data[received]));
+		received++;
+	}
+}
+
+
+/**
+ * Tests the block wise reception from the FIFO and the pending packet including the
+ * peeked byte.
+ */
+void testReceiveBulk() {
+	uint8_t data[USB_EP_SIZE * 8];
+	uint8_t buf[USB_EP_SIZE * 8];
+	for (size_t i = 0; i < sizeof(data); i++) data[i] = uint8_t(i * 11);
+	TEST_ASSERT(SerialUSB.read(buf, sizeof(buf)) == 0);
+	/* fill FIFO and pending packet */
+	const size_t accepted = hostOut(data, sizeof(data));
+	TEST_ASSERT(accepted > USB_EP_SIZE);
+	TEST_ASSERT(SerialUSB.peek() == int(data[0]));
+	TEST_ASSERT(SerialUSB.read(buf, 3) == 3);
+	TEST_ASSERT(SerialUSB.read(buf + 3, sizeof(buf) - 3) == int(accepted - 3));
+	TEST_ASSERT(memcmp(buf, data, accepted) == 0);
+	TEST_ASSERT(SerialUSB.read(buf, sizeof(buf)) == 0);
+	/* readBytes() picks up data sent while reading */
+	SerialUSB.setTimeout(10);
+	TEST_ASSERT(hostOut(data, USB_EP_SIZE + 5) == (USB_EP_SIZE + 5));
+	TEST_ASSERT(SerialUSB.readBytes(buf, sizeof(buf)) == (USB_EP_SIZE + 5));
+	TEST_ASSERT(memcmp(buf, data, USB_EP_SIZE + 5) == 0);
+	SerialUSB.setTimeout(1000);
+}
+
+
+/**
+ * Tests the reception directly into the application buffer without FIFO.
+ */
+void testReceiveDirect() {
+	uint8_t data[USB_EP_SIZE * 6 + 5];
+	uint8_t buf[USB_EP_SIZE * 8];
+	for (size_t i = 0; i < sizeof(data); i++) data[i] = uint8_t(i * 7 + 1);
+	TEST_ASSERT(SerialUSB.available() == 0);
+	/* single transfer terminated by a short packet */
+	uint32_t transfers = mockUsbTransferCount(EP_OUT);
+	hostOutData.data = data;
+	hostOutData.size = sizeof(data);
+	hostOutData.pos = 0;
+	mockSetIdleHook(pushHostOut, NULL);
+	TEST_ASSERT(SerialUSB.read(buf, sizeof(buf)) == sizeof(data));
+	TEST_ASSERT(memcmp(buf, data, sizeof(data)) == 0);
+	TEST_ASSERT(mockUsbTransferCount(EP_OUT) == (transfers + 1));
+	/* transfer is aborted if the host stops sending */
+	memset(buf, 0, sizeof(buf));
+	hostOutData.size = USB_EP_SIZE * 2;
+	hostOutData.pos = 0;
+	TEST_ASSERT(SerialUSB.read(buf, sizeof(buf)) == (USB_EP_SIZE * 2));
+	TEST_ASSERT(memcmp(buf, data, USB_EP_SIZE * 2) == 0);
+	TEST_ASSERT(SerialUSB.read(buf, sizeof(buf)) == 0);
+	mockSetIdleHook(NULL, NULL);
+	/* buffered reception continues afterwards */
+	transfers = mockUsbTransferCount(EP_OUT);
+	TEST_ASSERT(hostOut(data, 5) == 5);
+	TEST_ASSERT(mockUsbTransferCount(EP_OUT) == (transfers + 1));
+	TEST_ASSERT(SerialUSB.available() == 5);
+	TEST_ASSERT(SerialUSB.read(buf, sizeof(buf)) == 5);
+	TEST_ASSERT(memcmp(buf, data, 5) == 0);
+	/* small reads still use the FIFO */
+	TEST_ASSERT(SerialUSB.read(buf, USB_EP_SIZE - 1) == 0);
+	TEST_ASSERT(hostOut(data, USB_EP_SIZE) == USB_EP_SIZE);
+	TEST_ASSERT(SerialUSB.read(buf, USB_EP_SIZE - 1) == (USB_EP_SIZE - 1));
+	TEST_ASSERT(SerialUSB.read() == int(data[USB_EP_SIZE - 1]));
+}
+
+
+/**
+ * Tests the data transmission to the host.
+ */
+void testTransmit() {
+	uint8_t data[USB_EP_SIZE * 16 + 5];
+	for (size_t i = 0; i < sizeof(data); i++) data[i] = uint8_t(i * 5);
+	hostIn.size = 0;
+	hostIn.packets = 0;
+	mockSetIdleHook(pollHostIn, NULL);
+	TEST_ASSERT(SerialUSB.print("Hello USB") == 9);
+	SerialUSB.flush();
+	while (hostIn.size < 9) mockIdle();
+	TEST_ASSERT(memcmp(hostIn.data, "Hello USB", 9) == 0);
+	hostIn.size = 0;
+	TEST_ASSERT(SerialUSB.write(data, sizeof(data)) == sizeof(data));
+	SerialUSB.flush();
+	for (int i = 0; i < 1000 && hostIn.size < sizeof(data); i++) mockIdle();
+	TEST_ASSERT(hostIn.size == sizeof(data));
+	TEST_ASSERT(memcmp(hostIn.data, data, sizeof(data)) == 0);
+	mockSetIdleHook(NULL, NULL);
+}
+
+
+/**
+ * Tests the data transmission to the host by writing in place via `reserve()` and `commit()`.
+ */
+void testTransmitReserve() {
+	uint8_t data[USB_EP_SIZE * 16 + 5];
+	for (size_t i = 0; i < sizeof(data); i++) data[i] = uint8_t(i * 13 + 3);
+	hostIn.size = 0;
+	hostIn.packets = 0;
+	mockSetIdleHook(pollHostIn, NULL);
+	/* a discarded reservation sends nothing */
+	size_t len;
+	uint8_t * ptr = SerialUSB.reserve(4, len);
+	TEST_ASSERT(ptr != NULL && len == 4);
+	memcpy(ptr, "drop", 4);
+	TEST_ASSERT(SerialUSB.commit(0) == 0);
+	/* the reservation is limited to one packet */
+	ptr = SerialUSB.reserve(sizeof(data), len);
+	TEST_ASSERT(ptr != NULL && len > 0 && len <= USB_EP_SIZE);
+	TEST_ASSERT(SerialUSB.commit(0) == 0);
+	/* stream data in place */
+	for (size_t sent = 0; sent < sizeof(data); ) {
+		ptr = SerialUSB.reserve(sizeof(data) - sent, len);
+		TEST_ASSERT(ptr != NULL);
+		TEST_ASSERT(len > 0 && len <= (sizeof(data) - sent));
+		memcpy(ptr, data + sent, len);
+		TEST_ASSERT(SerialUSB.commit(len) == len);
+		sent += len;
+	}
+	SerialUSB.flush();
+	for (int i = 0; i < 1000 && hostIn.size < sizeof(data); i++) mockIdle();
+	TEST_ASSERT(hostIn.size == sizeof(data));
+	TEST_ASSERT(memcmp(hostIn.data, data, sizeof(data)) == 0);
+	mockSetIdleHook(NULL, NULL);
+}
+
+
+/**
+ * Tests that contiguous blocks of the transmission queue are sent with a single transfer.
+ * Mock board uses USB_TX_SIZE = 8 * USB_EP_SIZE.
+ */
+void testTransmitMultiBlock() {
+	uint8_t data[USB_EP_SIZE * 11];
+	for (size_t i = 0; i < sizeof(data); i++) data[i] = uint8_t(i * 3 + 7);
+	SerialUSB.flush();
+	USBDevice.initEP(EP_IN, EP_TYPE_BULK_IN); /* start with the first block */
+	hostIn.size = 0;
+	hostIn.packets = 0;
+	/* 7 full blocks are queued before the host polls */
+	uint32_t transfers = mockUsbTransferCount(0x80 | EP_IN);
+	TEST_ASSERT(SerialUSB.write(data, USB_EP_SIZE * 7) == (USB_EP_SIZE * 7));
+	while (hostIn.packets < 8) pollHostIn(NULL); /* 7 packets and ZLP */
+	TEST_ASSERT(hostIn.size == (USB_EP_SIZE * 7));
+	mockIdle();
+	TEST_ASSERT(mockUsbTransferCount(0x80 | EP_IN) == (transfers + 2));
+	/* the run ends at the end of the FIFO memory */
+	transfers = mockUsbTransferCount(0x80 | EP_IN);
+	TEST_ASSERT(SerialUSB.write(data + (USB_EP_SIZE * 7), USB_EP_SIZE * 4) == (USB_EP_SIZE * 4));
+	while (hostIn.packets < 13) {
+		pollHostIn(NULL);
+		mockIdle();
+	}
+	TEST_ASSERT(hostIn.size == sizeof(data));
+	TEST_ASSERT(memcmp(hostIn.data, data, sizeof(data)) == 0);
+	TEST_ASSERT(mockUsbTransferCount(0x80 | EP_IN) == (transfers + 3));
+}
+} /* anonymous namespace */
+
+
+int main() {
+	USBDevice.init();
+	TEST_ASSERT(USBDevice.attach());
+	SerialUSB.begin(115200);
+	TEST_RUN(testEnumerate);
+	TEST_RUN(testPmaLayout);
+	TEST_RUN(testReceive);
+	TEST_RUN(testReceiveFlowControl);
+	TEST_RUN(testReceiveBulk);
+	TEST_RUN(testReceiveDirect);
+	TEST_RUN(testTransmit);
+	TEST_RUN(testTransmitReserve);
+	TEST_RUN(testTransmitMultiBlock);
+	return EXIT_SUCCESS;
+}
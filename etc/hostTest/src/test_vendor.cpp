@@ -0,0 +1,206 @@
+/**
+ * @file test_vendor.cpp
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ *
+ * Unit tests for the vendor specific USB class using the simulated USB FS device.
+ * The build script defines VENDOR_WINUSB to cover the Microsoft OS 2.0 descriptors.
+ */
+#include "hosttest.h"
+#include "Arduino.h"
+#include "Vendor.h"
+
+
+namespace {
+/** Plugged during static initialization like in an application. */
+Vendor_ & vendor = Vendor();
+
+
+/** Vendor interface number and endpoint numbers as found in the configuration descriptor. */
+uint8_t vendorInterface = 0xFF;
+uint8_t epOut = 0xFF;
+uint8_t epIn = 0xFF;
+
+
+/**
+ * Returns the test pattern byte at the given stream position.
+ *
+ * @param[in] pos - stream position
+ * @return pattern byte
+ */
+uint8_t pattern(const size_t pos) {
+	return uint8_t((pos * 7) ^ (pos >> 8));
+}
+
+
+void testEnumerate() {
+	uint8_t desc[256];
+	TEST_ASSERT(mockUsbEnumerate() == 0);
+	TEST_ASSERT(USBDevice.configured());
+	TEST_ASSERT( vendor );
+	/* the BOS descriptor is only requested for USB 2.1 and newer */
+	TEST_ASSERT(mockUsbControl(0x80, GET_DESCRIPTOR, USB_DEVICE_DESCRIPTOR_TYPE << 8, 0, 18, desc) == 18);
+	TEST_ASSERT((desc[2] | (desc[3] << 8)) == 0x210);
+	TEST_ASSERT(mockUsbControl(0x80, GET_DESCRIPTOR, USB_CONFIGURATION_DESCRIPTOR_TYPE << 8, 0, 9, desc) == 9);
+	const int total = int(desc[2] | (desc[3] << 8));
+	TEST_ASSERT(mockUsbControl(0x80, GET_DESCRIPTOR, USB_CONFIGURATION_DESCRIPTOR_TYPE << 8, 0, uint16_t(total), desc) == total);
+	/* find the vendor interface with its bulk endpoints */
+	int vendorEndpoints = 0;
+	for (int i = 0; i < total; i += desc[i]) {
+		TEST_ASSERT(desc[i] > 0);
+		if (desc[i + 1] == USB_INTERFACE_DESCRIPTOR_TYPE) {
+			if (desc[i + 5] != USB_DEVICE_CLASS_VENDOR_SPECIFIC) {
+				vendorEndpoints = 0;
+				continue;
+			}
+			vendorInterface = desc[i + 2];
+			vendorEndpoints = desc[i + 4];
+			TEST_ASSERT(vendorEndpoints == 2);
+		} else if (vendorEndpoints > 0 && desc[i + 1] == USB_ENDPOINT_DESCRIPTOR_TYPE) {
+			vendorEndpoints--;
+			TEST_ASSERT(desc[i + 3] == USB_ENDPOINT_TYPE_BULK);
+			TEST_ASSERT((desc[i + 4] | (desc[i + 5] << 8)) == USB_EP_SIZE);
+			if ((desc[i + 2] & 0x80) != 0) {
+				epIn = uint8_t(desc[i + 2] & 0x7F);
+			} else {
+				epOut = desc[i + 2];
+			}
+		}
+	}
+	TEST_ASSERT(vendorInterface != 0xFF);
+	TEST_ASSERT(epOut != 0xFF && epIn != 0xFF);
+}
+
+
+void testBosDescriptor() {
+	uint8_t desc[64];
+	/* the host reads the header first to get the total length */
+	TEST_ASSERT(mockUsbControl(0x80, GET_DESCRIPTOR, USB_BOS_DESCRIPTOR_TYPE << 8, 0, 5, desc) == 5);
+	TEST_ASSERT(desc[0] == 5 && desc[1] == USB_BOS_DESCRIPTOR_TYPE);
+	const int total = int(desc[2] | (desc[3] << 8));
+	TEST_ASSERT(total == int(sizeof(VendorBOSDescriptor)));
+	TEST_ASSERT(desc[4] == 2);
+	TEST_ASSERT(mockUsbControl(0x80, GET_DESCRIPTOR, USB_BOS_DESCRIPTOR_TYPE << 8, 0, uint16_t(total), desc) == total);
+	/* USB 2.0 extension */
+	TEST_ASSERT(desc[5] == 7 && desc[6] == USB_DEVICE_CAPABILITY_DESCRIPTOR_TYPE && desc[7] == USB_DEVICE_CAPABILITY_USB20_EXTENSION);
+	/* Microsoft OS 2.0 platform capability */
+	const uint8_t * platform = desc + 12;
+	static const uint8_t uuid[16] = {0xDF, 0x60, 0xDD, 0xD8, 0x89, 0x45, 0xC7, 0x4C, 0x9C, 0xD2, 0x65, 0x9D, 0x9E, 0x64, 0x8A, 0x9F};
+	TEST_ASSERT(platform[0] == 28 && platform[2] == USB_DEVICE_CAPABILITY_PLATFORM);
+	TEST_ASSERT(memcmp(platform + 4, uuid, sizeof(uuid)) == 0);
+	TEST_ASSERT((platform[20] | (platform[21] << 8) | (platform[22] << 16) | (platform[23] << 24)) == MS_OS_20_WINDOWS_VERSION);
+	TEST_ASSERT((platform[24] | (platform[25] << 8)) == int(sizeof(VendorMSOS20Descriptor)));
+	TEST_ASSERT(platform[26] == VENDOR_MS_OS_20_VENDOR_CODE);
+}
+
+
+void testMsOs20Descriptor() {
+	VendorMSOS20Descriptor desc;
+	const int total = int(sizeof(desc));
+	TEST_ASSERT(mockUsbControl(0xC0, VENDOR_MS_OS_20_VENDOR_CODE, 0, VENDOR_MS_OS_20_DESCRIPTOR_INDEX, uint16_t(total), reinterpret_cast<uint8_t *>(&desc)) == total);
+	TEST_ASSERT(desc.header.len == 10 && desc.header.dtype == MS_OS_20_SET_HEADER_DESCRIPTOR);
+	TEST_ASSERT(desc.header.totalLength == total);
+	TEST_ASSERT(desc.configuration.dtype == MS_OS_20_SUBSET_HEADER_CONFIGURATION);
+	TEST_ASSERT(desc.configuration.totalLength == (total - 10));
+	TEST_ASSERT(desc.function.dtype == MS_OS_20_SUBSET_HEADER_FUNCTION);
+	TEST_ASSERT(desc.function.firstInterface == vendorInterface);
+	TEST_ASSERT(desc.function.subsetLength == (total - 18));
+	TEST_ASSERT(desc.compatibleId.len == 20);
+	TEST_ASSERT(memcmp(desc.compatibleId.compatibleId, "WINUSB\0\0", 8) == 0);
+	TEST_ASSERT(desc.interfaceGuids.len == 132);
+	TEST_ASSERT(desc.interfaceGuids.propertyDataType == MS_OS_20_REG_MULTI_SZ);
+	TEST_ASSERT(desc.interfaceGuids.propertyNameLength == 42);
+	TEST_ASSERT(desc.interfaceGuids.propertyName[0] == 'D' && desc.interfaceGuids.propertyName[1] == 0);
+	TEST_ASSERT(desc.interfaceGuids.propertyName[40] == 0 && desc.interfaceGuids.propertyName[41] == 0);
+	TEST_ASSERT(desc.interfaceGuids.propertyDataLength == 80);
+	for (size_t i = 0; i < 38; i++) {
+		TEST_ASSERT(desc.interfaceGuids.propertyData[2 * i] == uint8_t(VENDOR_INTERFACE_GUID[i]));
+		TEST_ASSERT(desc.interfaceGuids.propertyData[(2 * i) + 1] == 0);
+	}
+	for (size_t i = 76; i < 80; i++) TEST_ASSERT(desc.interfaceGuids.propertyData[i] == 0);
+	/* other vendor requests are not handled */
+	uint8_t val;
+	TEST_ASSERT(mockUsbControl(0xC0, VENDOR_MS_OS_20_VENDOR_CODE, 0, 8, 1, &val) < 0);
+	TEST_ASSERT(mockUsbControl(0xC0, uint8_t(VENDOR_MS_OS_20_VENDOR_CODE + 1), 0, VENDOR_MS_OS_20_DESCRIPTOR_INDEX, 1, &val) < 0);
+}
+
+
+void testPeekConsume() {
+	enum { TOTAL = USB_EP_SIZE * 8, CHUNK = 17 };
+	uint8_t packet[USB_EP_SIZE];
+	size_t sent = 0;
+	size_t received = 0;
+	size_t len;
+	TEST_ASSERT(vendor.peek(len) == NULL && len == 0);
+	for (size_t rounds = 0; received < TOTAL; rounds++) {
+		TEST_ASSERT(rounds < 10000);
+		/* the host sends as long as the device accepts the packets */
+		while (sent < TOTAL) {
+			for (size_t i = 0; i < sizeof(packet); i++) packet[i] = pattern(sent + i);
+			const int res = mockUsbHostOut(epOut, packet, sizeof(packet));
+			if (res < 0) break;
+			TEST_ASSERT(res == int(sizeof(packet)));
+			sent += sizeof(packet);
+		}
+		/* process the received data in place in odd chunks to cover partial consumption */
+		const uint8_t * ptr = vendor.peek(len);
+		if (ptr == NULL) continue;
+		TEST_ASSERT(len > 0);
+		if (len > CHUNK) len = CHUNK;
+		for (size_t i = 0; i < len; i++) TEST_ASSERT(ptr[i] == pattern(received + i));
+		vendor.consume(len);
+		received += len;
+	}
+	TEST_ASSERT(sent == TOTAL);
+	TEST_ASSERT(vendor.available() == 0);
+	TEST_ASSERT(vendor.peek(len) == NULL);
+	/* buffered reads still work afterwards */
+	for (size_t i = 0; i < sizeof(packet); i++) packet[i] = pattern(i);
+	TEST_ASSERT(mockUsbHostOut(epOut, packet, 10) == 10);
+	TEST_ASSERT(vendor.available() == 10);
+	uint8_t buf[10];
+	TEST_ASSERT(vendor.read(buf, sizeof(buf)) == sizeof(buf));
+	TEST_ASSERT(memcmp(buf, packet, sizeof(buf)) == 0);
+}
+
+
+void testReserveCommit() {
+	enum { TOTAL = USB_EP_SIZE * 8, CHUNK = 24 };
+	uint8_t packet[USB_EP_SIZE];
+	size_t written = 0;
+	size_t received = 0;
+	for (size_t rounds = 0; received < TOTAL; rounds++) {
+		TEST_ASSERT(rounds < 10000);
+		/* write in place without waiting */
+		if (written < TOTAL && vendor.availableForWrite() > 0) {
+			const size_t want = ((TOTAL - written) < size_t(CHUNK)) ? (TOTAL - written) : size_t(CHUNK);
+			size_t len;
+			uint8_t * ptr = vendor.reserve(want, len);
+			TEST_ASSERT(ptr != NULL && len > 0 && len <= want);
+			for (size_t i = 0; i < len; i++) ptr[i] = pattern(written + i);
+			TEST_ASSERT(vendor.commit(len) == len);
+			written += len;
+		}
+		const int res = mockUsbHostIn(epIn, packet, sizeof(packet));
+		if (res <= 0) continue;
+		for (size_t i = 0; i < size_t(res); i++) TEST_ASSERT(packet[i] == pattern(received + i));
+		received += size_t(res);
+	}
+	TEST_ASSERT(written == TOTAL);
+	TEST_ASSERT(received == TOTAL);
+}
+} /* anonymous namespace */
+
+
+int main() {
+	USBDevice.init();
+	TEST_ASSERT(USBDevice.attach());
+	TEST_RUN(testEnumerate);
+	TEST_RUN(testBosDescriptor);
+	TEST_RUN(testMsOs20Descriptor);
+	TEST_RUN(testPeekConsume);
+	TEST_RUN(testReserveCommit);
+	return EXIT_SUCCESS;
+}
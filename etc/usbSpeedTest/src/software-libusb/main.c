@@ -0,0 +1,271 @@
+/**
+ * @file main.c
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ *
+ * Measures the raw bulk throughput of the vendor specific USB class (see `Vendor_`) via libusb.
+ * The matching firmware can be found in examples/BlackPill/UsbVendor.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <libusb-1.0/libusb.h>
+
+#define SIZE_IN_MB 16
+#define TRANSFER_SIZE 16384 /* multiple of the maximum bulk packet size */
+#define TRANSFER_COUNT 8 /* transfers in flight per direction */
+#define TIMEOUT_MS 2000
+
+
+/**
+ * Describes one data stream in a single direction.
+ */
+typedef struct {
+	size_t total; /**< bytes to transfer */
+	size_t submitted; /**< bytes submitted to libusb */
+	size_t done; /**< bytes completed */
+	int pending; /**< transfers in flight */
+	int failed; /**< set if a transfer failed or the received data did not match */
+} tStream;
+
+
+/**
+ * Returns the test pattern byte at the given stream position.
+ * This needs to match the firmware.
+ *
+ * @param[in] pos - stream position
+ * @return pattern byte
+ */
+static uint8_t pattern(const size_t pos) {
+	return (uint8_t)pos;
+}
+
+
+/**
+ * Returns the current time in milliseconds.
+ *
+ * @return monotonic time in milliseconds
+ */
+static double getTimeMs(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((double)ts.tv_sec * 1000.0) + ((double)ts.tv_nsec / 1000000.0);
+}
+
+
+/**
+ * Submits the next chunk of the stream with the given transfer.
+ *
+ * @param[in,out] xfer - transfer to submit
+ * @param[in,out] s - associated stream
+ * @return 1 if submitted, else 0
+ */
+static int submitNext(struct libusb_transfer * xfer, tStream * s) {
+	if (s->failed || s->submitted >= s->total) return 0;
+	const size_t left = s->total - s->submitted;
+	const int len = (int)((left < TRANSFER_SIZE) ? left : TRANSFER_SIZE);
+	if ((xfer->endpoint & LIBUSB_ENDPOINT_IN) == 0) {
+		for (int i = 0; i < len; i++) xfer->buffer[i] = pattern(s->submitted + (size_t)i);
+	}
+	xfer->length = len;
+	if (libusb_submit_transfer(xfer) != 0) {
+		s->failed = 1;
+		return 0;
+	}
+	s->submitted += (size_t)len;
+	s->pending++;
+	return 1;
+}
+
+
+/**
+ * Called by libusb once a transfer completed. Verifies the received data and re-submits the
+ * transfer with the next chunk of the stream.
+ *
+ * @param[in,out] xfer - completed transfer
+ */
+static void LIBUSB_CALL onTransfer(struct libusb_transfer * xfer) {
+	tStream * s = (tStream *)xfer->user_data;
+	s->pending--;
+	if (xfer->status != LIBUSB_TRANSFER_COMPLETED) {
+		s->failed = 1;
+		return;
+	}
+	if ((xfer->endpoint & LIBUSB_ENDPOINT_IN) != 0) {
+		/* transfers complete in submission order */
+		for (int i = 0; i < xfer->actual_length; i++) {
+			if (xfer->buffer[i] != pattern(s->done + (size_t)i)) {
+				s->failed = 1;
+				return;
+			}
+		}
+	}
+	s->done += (size_t)xfer->actual_length;
+	submitNext(xfer, s);
+}
+
+
+/**
+ * Transfers the given number of bytes on the given bulk endpoint with multiple transfers in
+ * flight to keep the bus busy.
+ *
+ * @param[in,out] ctx - libusb context
+ * @param[in,out] handle - device handle
+ * @param[in] ep - endpoint address
+ * @param[in] size - number of bytes to transfer
+ * @return elapsed time in milliseconds or a negative value on error
+ */
+static double runStream(libusb_context * ctx, libusb_device_handle * handle, const uint8_t ep, const size_t size) {
+	struct libusb_transfer * xfer[TRANSFER_COUNT] = {NULL};
+	tStream s;
+	memset(&s, 0, sizeof(s));
+	s.total = size;
+	double res = -1.0;
+	for (int i = 0; i < TRANSFER_COUNT; i++) {
+		xfer[i] = libusb_alloc_transfer(0);
+		if (xfer[i] == NULL) goto onError;
+		uint8_t * buffer = (uint8_t *)malloc(TRANSFER_SIZE);
+		if (buffer == NULL) goto onError;
+		libusb_fill_bulk_transfer(xfer[i], handle, ep, buffer, TRANSFER_SIZE, onTransfer, &s, TIMEOUT_MS);
+		xfer[i]->flags = LIBUSB_TRANSFER_FREE_BUFFER;
+	}
+	const double start = getTimeMs();
+	for (int i = 0; i < TRANSFER_COUNT; i++) submitNext(xfer[i], &s);
+	while (s.pending > 0) {
+		if (libusb_handle_events(ctx) != 0) {
+			s.failed = 1;
+			for (int i = 0; i < TRANSFER_COUNT; i++) libusb_cancel_transfer(xfer[i]);
+		}
+	}
+	const double end = getTimeMs();
+	if ( ! s.failed && s.done == s.total ) res = end - start;
+onError:
+	for (int i = 0; i < TRANSFER_COUNT; i++) {
+		if (xfer[i] != NULL) libusb_free_transfer(xfer[i]);
+	}
+	return res;
+}
+
+
+/**
+ * Finds the vendor specific interface and its bulk endpoints.
+ *
+ * @param[in] dev - USB device
+ * @param[out] iface - interface number
+ * @param[out] epOut - bulk OUT endpoint address
+ * @param[out] epIn - bulk IN endpoint address
+ * @return 1 on success, else 0
+ */
+static int findVendorInterface(libusb_device * dev, int * iface, uint8_t * epOut, uint8_t * epIn) {
+	struct libusb_config_descriptor * config = NULL;
+	int res = 0;
+	if (libusb_get_active_config_descriptor(dev, &config) != 0) return 0;
+	for (int i = 0; i < (int)config->bNumInterfaces && res == 0; i++) {
+		if (config->interface[i].num_altsetting < 1) continue;
+		const struct libusb_interface_descriptor * desc = &(config->interface[i].altsetting[0]);
+		if (desc->bInterfaceClass != LIBUSB_CLASS_VENDOR_SPEC || desc->bNumEndpoints != 2) continue;
+		*iface = desc->bInterfaceNumber;
+		for (int j = 0; j < 2; j++) {
+			const uint8_t addr = desc->endpoint[j].bEndpointAddress;
+			if ((addr & LIBUSB_ENDPOINT_IN) != 0) {
+				*epIn = addr;
+			} else {
+				*epOut = addr;
+			}
+		}
+		res = 1;
+	}
+	libusb_free_config_descriptor(config);
+	return res;
+}
+
+
+/**
+ * Prints the measured throughput.
+ *
+ * @param[in] label - direction label
+ * @param[in] ms - elapsed time in milliseconds
+ */
+static void printResult(const char * label, const double ms) {
+	printf("%s: %.0f ms for %i MiB, %.1f KiB/s\n", label, ms, SIZE_IN_MB, (double)(SIZE_IN_MB * 1024) / (ms / 1000.0));
+}
+
+
+/**
+ * Main entry point.
+ * Expects the USB vendor and product ID as single argument in the format VID:PID (hexadecimal).
+ *
+ * @param[in] argc - argument count
+ * @param[in] args - argument list
+ */
+int main(int argc, char ** args) {
+	int ec = EXIT_FAILURE;
+	unsigned int vid, pid;
+	if (argc <= 1 || sscanf(args[1], "%x:%x", &vid, &pid) != 2) {
+		fprintf(stderr, "Usage: %s VID:PID\n", args[0]);
+		return ec;
+	}
+	libusb_context * ctx = NULL;
+	libusb_device_handle * handle = NULL;
+	int iface = -1;
+	uint8_t epOut = 0, epIn = 0;
+	if (libusb_init(&ctx) != 0) {
+		fprintf(stderr, "Error: Failed to initialize libusb.\n");
+		return ec;
+	}
+	handle = libusb_open_device_with_vid_pid(ctx, (uint16_t)vid, (uint16_t)pid);
+	if (handle == NULL) {
+		fprintf(stderr, "Error: Failed to open USB device %04X:%04X.\n", vid, pid);
+		goto onError;
+	}
+	if ( ! findVendorInterface(libusb_get_device(handle), &iface, &epOut, &epIn) ) {
+		fprintf(stderr, "Error: No vendor specific interface found.\n");
+		goto onError;
+	}
+	if (libusb_claim_interface(handle, iface) != 0) {
+		fprintf(stderr, "Error: Failed to claim interface %i.\n", iface);
+		iface = -1;
+		goto onError;
+	}
+
+	/* request: upload size and download size as little-endian 32-bit values */
+	{
+		const uint32_t size = SIZE_IN_MB * 1048576;
+		uint8_t header[8];
+		int sent = 0;
+		for (int i = 0; i < 4; i++) {
+			header[i] = (uint8_t)(size >> (8 * i));
+			header[i + 4] = (uint8_t)(size >> (8 * i));
+		}
+		if (libusb_bulk_transfer(handle, epOut, header, (int)sizeof(header), &sent, TIMEOUT_MS) != 0 || sent != (int)sizeof(header)) {
+			fprintf(stderr, "Error: Failed to send the request.\n");
+			goto onError;
+		}
+	}
+
+	/* transmission speed */
+	const double tT = runStream(ctx, handle, epOut, SIZE_IN_MB * 1048576);
+	if (tT < 0.0) {
+		fprintf(stderr, "Error: Failed to send data.\n");
+		goto onError;
+	}
+
+	/* reception speed */
+	const double rT = runStream(ctx, handle, epIn, SIZE_IN_MB * 1048576);
+	if (rT < 0.0) {
+		fprintf(stderr, "Error: Failed to receive data or data mismatch.\n");
+		goto onError;
+	}
+
+	printResult("PC -> MCU", tT);
+	printResult("MCU -> PC", rT);
+	ec = EXIT_SUCCESS;
+onError:
+	if (iface >= 0) libusb_release_interface(handle, iface);
+	if (handle != NULL) libusb_close(handle);
+	libusb_exit(ctx);
+	return ec;
+}
@@ -0,0 +1,47 @@
+/**
+ * @file board.cpp
+ * @author Daniel Starke
+ * @copyright Copyright 2022 Daniel Starke
+ * @date 2022-03-17
+ * @version 2022-03-17
+ */
+#include <Arduino.h>
+#include <wiring_irq.h>
+
+
+/* exported variables */
+HardwareSerial Serial1(USART1, getIrqNumFor(USART1), PB_7, PB_6, GPIO_AF7_USART1, GPIO_AF7_USART1);
+
+
+/**
+ * Initializes this board by configuring the system clock base.
+ */
+void initVariant() {
+	RCC_OscInitTypeDef RCC_OscInitStruct = {0};
+	RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
+
+	/* Configure the main internal regulator output voltage. */
+	__HAL_RCC_PWR_CLK_ENABLE();
+	__HAL_PWR_VOLTAGESCALING_CONFIG(PWR_REGULATOR_VOLTAGE_SCALE2);
+	/* Initializes the RCC Oscillators according to the specified parameters in the RCC_OscInitTypeDef structure. */
+	RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSE;
+	RCC_OscInitStruct.HSEState = RCC_HSE_ON;
+	RCC_OscInitStruct.PLL.PLLState = RCC_PLL_ON;
+	RCC_OscInitStruct.PLL.PLLSource = RCC_PLLSOURCE_HSE;
+	RCC_OscInitStruct.PLL.PLLM = 25;
+	RCC_OscInitStruct.PLL.PLLN = 336;
+	RCC_OscInitStruct.PLL.PLLP = RCC_PLLP_DIV4;
+	RCC_OscInitStruct.PLL.PLLQ = 7;
+	if (HAL_RCC_OscConfig(&RCC_OscInitStruct) != HAL_OK) {
+		systemErrorHandler();
+	}
+	/* Initializes the CPU, AHB and APB buses clocks. */
+	RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_HCLK|RCC_CLOCKTYPE_SYSCLK|RCC_CLOCKTYPE_PCLK1|RCC_CLOCKTYPE_PCLK2;
+	RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
+	RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV1;
+	RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV2;
+	RCC_ClkInitStruct.APB2CLKDivider = RCC_HCLK_DIV1;
+	if (HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_2) != HAL_OK) {
+		systemErrorHandler();
+	}
+}
@@ -0,0 +1,120 @@
+/**
+ * @file main.cpp
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ *
+ * Counterpart of etc/usbSpeedTest/src/software-libusb to measure the raw bulk throughput of the
+ * vendor specific USB class. The host sends the upload and download size as little-endian 32-bit
+ * values followed by the upload data. The firmware discards the upload data in place and sends
+ * the requested number of pattern bytes back afterwards.
+ */
+#include <Arduino.h>
+#include <Vendor.h>
+
+
+namespace {
+/** Plugged during static initialization before the USB device gets enumerated. */
+Vendor_ & vendor = Vendor();
+
+
+enum State {
+	RECV_HEADER,
+	RECV_DATA,
+	SEND_DATA
+};
+
+
+State state = RECV_HEADER;
+uint8_t header[8];
+size_t headerLen = 0;
+uint32_t uploadLeft = 0;
+uint32_t downloadLeft = 0;
+uint32_t downloadPos = 0;
+
+
+/**
+ * Reads a little-endian 32-bit value.
+ *
+ * @param[in] ptr - source
+ * @return value
+ */
+uint32_t readLe32(const uint8_t * ptr) {
+	return uint32_t(ptr[0]) | (uint32_t(ptr[1]) << 8) | (uint32_t(ptr[2]) << 16) | (uint32_t(ptr[3]) << 24);
+}
+
+
+/**
+ * Receives the request header.
+ */
+void recvHeader() {
+	size_t len;
+	const uint8_t * ptr = vendor.peek(len);
+	if (ptr == NULL) return;
+	const size_t missing = sizeof(header) - headerLen;
+	if (len > missing) len = missing;
+	memcpy(header + headerLen, ptr, len);
+	vendor.consume(len);
+	headerLen += len;
+	if (headerLen < sizeof(header)) return;
+	headerLen = 0;
+	uploadLeft = readLe32(header);
+	downloadLeft = readLe32(header + 4);
+	downloadPos = 0;
+	state = RECV_DATA;
+}
+
+
+/**
+ * Discards the received upload data without copying it.
+ */
+void recvData() {
+	size_t len;
+	const uint8_t * ptr;
+	while (uploadLeft > 0 && (ptr = vendor.peek(len)) != NULL) {
+		if (len > uploadLeft) len = uploadLeft;
+		vendor.consume(len);
+		uploadLeft -= uint32_t(len);
+	}
+	if (uploadLeft == 0) state = SEND_DATA;
+}
+
+
+/**
+ * Writes the download data in place into the transmission queue.
+ */
+void sendData() {
+	while (downloadLeft > 0) {
+		size_t len;
+		uint8_t * ptr = vendor.reserve(downloadLeft, len);
+		if (ptr == NULL) return;
+		for (size_t i = 0; i < len; i++) ptr[i] = uint8_t(downloadPos + i);
+		vendor.commit(len);
+		downloadPos += uint32_t(len);
+		downloadLeft -= uint32_t(len);
+	}
+	vendor.flush();
+	state = RECV_HEADER;
+}
+} /* anonymous namespace */
+
+
+void setup() {
+	pinMode(LED_BUILTIN, OUTPUT);
+}
+
+
+void loop() {
+	if ( ! vendor ) {
+		state = RECV_HEADER;
+		headerLen = 0;
+		return;
+	}
+	digitalWrite(LED_BUILTIN, uint32_t(state == RECV_HEADER));
+	switch (state) {
+	case RECV_HEADER: recvHeader(); break;
+	case RECV_DATA:   recvData(); break;
+	case SEND_DATA:   sendData(); break;
+	}
+}
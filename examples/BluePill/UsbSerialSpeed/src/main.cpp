@@ -0,0 +1,68 @@
+/**
+ * @file main.cpp
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ * 
+ * STM32 counterpart of the firmware in etc/usbSpeedTest/src/firmware to be used with the host
+ * software in etc/usbSpeedTest/src/software. The upload is received block wise via
+ * `Serial.read(buffer, size)`, which receives directly into the passed buffer on the USB FS
+ * device peripheral of the STM32F103. Build the environment `bluepill-per-byte` to compare it
+ * with the reception via `Serial.read()`.
+ */
+#include <Arduino.h>
+
+#define SIZE_IN_MB 1
+
+static char buf[1024];
+
+void setup() {
+	Serial.begin(9600);
+	while ( ! Serial );
+	memset(buf, '\r', sizeof(buf));
+	
+	long tT = millis();
+	while (Serial.read() < 0) tT = millis();
+#ifdef READ_PER_BYTE
+	for (size_t received = 1; received < (SIZE_IN_MB * 1048576);) {
+		if (Serial.read() >= 0) received++;
+	}
+#else /* not READ_PER_BYTE */
+	for (size_t received = 1; received < (SIZE_IN_MB * 1048576);) {
+		const size_t left = (SIZE_IN_MB * 1048576) - received;
+		const int len = Serial.read(reinterpret_cast<uint8_t *>(buf), min(sizeof(buf), left));
+		if (len > 0) received += size_t(len);
+	}
+#endif /* not READ_PER_BYTE */
+	tT = millis() - tT;
+	
+	long rT = millis();
+	for (size_t written = 0; written < (SIZE_IN_MB * 1048576);) {
+		const size_t left = (SIZE_IN_MB * 1048576) - written;
+		const size_t writable = min(min(sizeof(buf), left), size_t(Serial.availableForWrite()));
+		written += Serial.write(reinterpret_cast<const uint8_t *>(buf), writable);
+	}
+	Serial.flush();
+	rT = millis() - rT;
+	
+	Serial.print("\r\nPC -> MCU: ");
+	Serial.print(tT);
+	Serial.print(" ms for ");
+	Serial.print(SIZE_IN_MB);
+	Serial.print(" MiB, ");
+	Serial.print(float(SIZE_IN_MB * 1024) / (float(tT) / 1000.0f), 1);
+	Serial.print(" KiB/s\r\n");
+	
+	Serial.print("MCU -> PC: ");
+	Serial.print(rT);
+	Serial.print(" ms for ");
+	Serial.print(SIZE_IN_MB);
+	Serial.print(" MiB, ");
+	Serial.print(float(SIZE_IN_MB * 1024) / (float(rT) / 1000.0f), 1);
+	Serial.print(" KiB/s\r\n");
+	Serial.print("done\r\n");
+}
+
+void loop() {
+}
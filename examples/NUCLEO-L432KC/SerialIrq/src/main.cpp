@@ -0,0 +1,115 @@
+/**
+ * @file main.cpp
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ *
+ * Measures the cycles spent per byte in the UART interrupt handler with the STM32 HAL API
+ * handler and the register level handler (see `HardwareSerial::setFastIrq()`).
+ * Connect PB6 (TX) with PB7 (RX) for a loopback of Serial1. The results are printed via Serial2.
+ */
+#include <Arduino.h>
+
+
+extern "C" void STM32CubeDuinoIrqHandlerForUSART1(void);
+
+
+namespace {
+enum {
+	ROUNDS = 1000,
+	BURST = 32
+};
+
+
+/**
+ * Calls the UART interrupt handler and returns the number of cycles spent in it.
+ *
+ * @return cycles
+ */
+uint32_t measureIrq() {
+	const uint32_t start = DWT->CYCCNT;
+	STM32CubeDuinoIrqHandlerForUSART1();
+	return DWT->CYCCNT - start;
+}
+
+
+/**
+ * Measures the interrupt handler for the reception of single bytes. The interrupts are
+ * disabled to call the handler directly once a byte was received.
+ *
+ * @return cycles per byte
+ */
+uint32_t benchRx() {
+	uint32_t cycles = 0;
+	noInterrupts();
+	for (uint32_t i = 0; i < ROUNDS; i++) {
+		USART1->TDR = uint8_t(i);
+		while ((USART1->ISR & USART_ISR_RXNE) == 0);
+		cycles += measureIrq();
+		Serial1.read();
+	}
+	interrupts();
+	return cycles / ROUNDS;
+}
+
+
+/**
+ * Measures the interrupt handler for the transmission of bursts of bytes. The handler is called
+ * each time the UART shifted out a byte, including the final transmission complete interrupt.
+ * The receiver is disabled to exclude the loopback data.
+ *
+ * @return cycles per byte
+ */
+uint32_t benchTx() {
+	uint8_t buf[BURST];
+	memset(buf, 0x55, sizeof(buf));
+	uint32_t cycles = 0;
+	CLEAR_BIT(USART1->CR1, USART_CR1_RE);
+	noInterrupts();
+	for (uint32_t i = 0; i < (ROUNDS / BURST); i++) {
+		Serial1.write(buf, sizeof(buf));
+		while ((USART1->CR1 & (USART_CR1_TXEIE | USART_CR1_TCIE)) != 0) {
+			const uint32_t flag = ((USART1->CR1 & USART_CR1_TXEIE) != 0) ? USART_ISR_TXE : USART_ISR_TC;
+			while ((USART1->ISR & flag) == 0);
+			cycles += measureIrq();
+		}
+	}
+	interrupts();
+	SET_BIT(USART1->CR1, USART_CR1_RE);
+	return cycles / ((ROUNDS / BURST) * BURST);
+}
+
+
+/**
+ * Runs the benchmarks with the given interrupt handler and prints the results.
+ *
+ * @param[in] name - interrupt handler name
+ * @param[in] fastIrq - true to use the register level interrupt handler
+ */
+void bench(const char * name, const bool fastIrq) {
+	Serial1.end();
+	Serial1.setFastIrq(fastIrq);
+	Serial1.begin(2000000);
+	Serial2.print(name);
+	Serial2.print(" RX: ");
+	Serial2.print(benchRx());
+	Serial2.print(" cycles/byte, TX: ");
+	Serial2.print(benchTx());
+	Serial2.println(" cycles/byte");
+}
+} /* anonymous namespace */
+
+
+void setup() {
+	Serial2.begin(115200);
+	delay(100);
+	Serial2.println("begin");
+}
+
+
+void loop() {
+	bench("HAL_UART_IRQHandler", false);
+	bench("HardwareSerial::fastIrqHandler", true);
+	delay(1000);
+}
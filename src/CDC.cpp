@@ -1,9 +1,9 @@
 /**
  * @file CDC.cpp
  * @author Daniel Starke
- * @copyright Copyright 2020-2022 Daniel Starke
+ * @copyright Copyright 2020-2026 Daniel Starke
  * @date 2020-05-21
- * @version 2022-10-06
+ * @version 2026-10-17
  * 
  * @see https://www.silabs.com/documents/public/application-notes/AN758.pdf
  */
@@ -167,6 +167,38 @@ int Serial_::read(void) {
 }
 
 
+/**
+ * Removes up to the given number of bytes from the receive buffer. The data is copied
+ * block wise. Large reads without buffered data receive directly into the passed buffer.
+ * This waits while the host keeps sending and up to 2 ms without new data (see
+ * `USBDeviceClass::recv()`).
+ * 
+ * @param[out] buffer - output buffer
+ * @param[in] size - maximum number of bytes to read
+ * @return number of bytes read
+ */
+int Serial_::read(uint8_t * buffer, size_t size) {
+	if (buffer == NULL || size < 1) return 0;
+	size_t res = 0;
+	if (_serialPeek >= 0) {
+		*buffer++ = uint8_t(_serialPeek);
+		_serialPeek = -1;
+		size--;
+		res++;
+	}
+	while (size > 0) {
+		const uint32_t received = USBDevice.recv(CDC_RX, buffer, uint32_t(size));
+		if (received == uint32_t(-1) || received == 0) break;
+		const bool drained = (received < size);
+		buffer += received;
+		size -= received;
+		res += received;
+		if ( drained ) break; /* avoid waiting for more data in USBDeviceClass::recv() */
+	}
+	return int(res);
+}
+
+
 /**
  * Waits until all data in transmission queue is sent.
  */
@@ -213,6 +245,44 @@ size_t Serial_::write(const uint8_t * buffer, size_t size) {
 }
 
 
+/**
+ * Returns a pointer into the transmission queue to write up to the given number of bytes in
+ * place. Pass the number of bytes written to `commit()` afterwards to send them. This avoids
+ * the copy from an intermediate buffer for high data rates.
+ * 
+ * @param[in] size - number of bytes needed
+ * @param[out] outLen - set to the number of bytes which can be written (at most size)
+ * @return start of the writable region or NULL if no space is available
+ * @remarks The returned region is at most one USB packet in size. Call `reserve()` and
+ * `commit()` repeatedly to send more data.
+ * @remarks Each successful call needs to be followed by a call to `commit()`.
+ */
+uint8_t * Serial_::reserve(const size_t size, size_t & outLen) {
+	outLen = 0;
+	/* send only if the OS signaled that the connection is open by setting DTR on */
+#ifdef STM32CUBEDUINO_LEGACY_API
+	if (hostLineState == 0) return NULL;
+#else /* not STM32CUBEDUINO_LEGACY_API */
+	if ( ! this->dtr() ) return NULL;
+#endif /* not STM32CUBEDUINO_LEGACY_API */
+	uint32_t len;
+	uint8_t * ptr = USBDevice.reserve(CDC_TX, uint32_t(size), len);
+	outLen = size_t(len);
+	return ptr;
+}
+
+
+/**
+ * Sends the given number of bytes previously written to the region returned by `reserve()`.
+ * 
+ * @param[in] size - number of bytes written; 0 to discard the reservation
+ * @return number of bytes added to the transmission queue
+ */
+size_t Serial_::commit(const size_t size) {
+	return size_t(USBDevice.commit(CDC_TX, uint32_t(size)));
+}
+
+
 /**
  * Returns the connection status.
  * 
@@ -317,7 +387,9 @@ int Serial_::getDescriptor(USBSetup & /* setup */) {
  * @return bytes sent
  */
 int Serial_::getInterface(uint8_t * interfaceCount) {
-	static const CDCDescriptor cdcInterface = {
+	/* endpoint sizes and intervals depend on the USB speed */
+	const uint16_t bulkSize = USBDevice.bulkPacketSize();
+	const CDCDescriptor cdcInterface = {
 		D_IAD(0, 2, CDC_COMMUNICATION_INTERFACE_CLASS, CDC_ABSTRACT_CONTROL_MODEL, 0),
 		/*	CDC communication interface */
 		D_INTERFACE(CDC_ACM_INTERFACE, 1, CDC_COMMUNICATION_INTERFACE_CLASS, CDC_ABSTRACT_CONTROL_MODEL, 0),
@@ -325,11 +397,11 @@ int Serial_::getInterface(uint8_t * interfaceCount) {
 		D_CDCCS(CDC_CALL_MANAGEMENT, 1, 1),                        /* device handles call management (not) */
 		D_CDCCS4(CDC_ABSTRACT_CONTROL_MANAGEMENT, 6),              /* SET_LINE_CODING, GET_LINE_CODING, SET_CONTROL_LINE_STATE supported */
 		D_CDCCS(CDC_UNION, CDC_ACM_INTERFACE, CDC_DATA_INTERFACE), /* communication interface is master, data interface is slave 0 */
-		D_ENDPOINT(USB_ENDPOINT_IN(CDC_ENDPOINT_ACM), USB_ENDPOINT_TYPE_INTERRUPT, 0x10, 0x40),
+		D_ENDPOINT(USB_ENDPOINT_IN(CDC_ENDPOINT_ACM), USB_ENDPOINT_TYPE_INTERRUPT, 0x10, USBDevice.pollInterval(0x40)),
 		/*	CDC data interface */
 		D_INTERFACE(CDC_DATA_INTERFACE, 2, CDC_DATA_INTERFACE_CLASS, 0, 0),
-		D_ENDPOINT(USB_ENDPOINT_OUT(CDC_ENDPOINT_OUT), USB_ENDPOINT_TYPE_BULK, USB_EP_SIZE, 0),
-		D_ENDPOINT(USB_ENDPOINT_IN(CDC_ENDPOINT_IN), USB_ENDPOINT_TYPE_BULK, USB_EP_SIZE, 0)
+		D_ENDPOINT(USB_ENDPOINT_OUT(CDC_ENDPOINT_OUT), USB_ENDPOINT_TYPE_BULK, bulkSize, 0),
+		D_ENDPOINT(USB_ENDPOINT_IN(CDC_ENDPOINT_IN), USB_ENDPOINT_TYPE_BULK, bulkSize, 0)
 	};
 	(*interfaceCount) = uint8_t((*interfaceCount) + 2); /* uses 2 */
 	return USBDevice.sendControl(&cdcInterface, sizeof(cdcInterface));
@@ -1,9 +1,9 @@
 /**
  * @file CDC.h
  * @author Daniel Starke
- * @copyright Copyright 2020-2022 Daniel Starke
+ * @copyright Copyright 2020-2026 Daniel Starke
  * @date 2020-05-21
- * @version 2022-10-16
+ * @version 2026-10-17
  */
 #ifndef __CDC_H__
 #define __CDC_H__
@@ -62,9 +62,12 @@ public:
 	virtual int availableForWrite(void);
 	virtual int peek(void);
 	virtual int read(void);
+	virtual int read(uint8_t * buffer, size_t size);
 	virtual void flush(void);
 	virtual size_t write(const uint8_t val);
 	virtual size_t write(const uint8_t * buffer, size_t size);
+	uint8_t * reserve(const size_t size, size_t & outLen); /* STM32 specific */
+	size_t commit(const size_t size); /* STM32 specific */
 
 	int32_t readBreak();
 	uint32_t baud();
@@ -0,0 +1,378 @@
+/**
+ * @file HID.cpp
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ * 
+ * @see https://www.usb.org/sites/default/files/hid1_11.pdf
+ */
+#include "Arduino.h"
+#include "HID.h"
+
+
+#if !defined(STM32CUBEDUINO_DISABLE_USB_HID) && defined(PLUGGABLE_USB_ENABLED) && defined(USBCON)
+#define HID_INTERFACE   uint8_t(this->pluggedInterface)
+#define HID_ENDPOINT_IN uint8_t(this->pluggedEndpoint)
+
+
+/* Timeout while waiting for free space in the report queue. */
+#define HID_TIMEOUT_MS 100
+
+
+/** Keyboard with modifiers, 6 keys and LED output report. */
+const uint8_t HID_KEYBOARD_REPORT_DESCRIPTOR[] = {
+	0x05, 0x01,                   /* USAGE_PAGE (Generic Desktop) */
+	0x09, 0x06,                   /* USAGE (Keyboard) */
+	0xA1, 0x01,                   /* COLLECTION (Application) */
+	0x85, HID_REPORT_ID_KEYBOARD, /*   REPORT_ID */
+	0x05, 0x07,                   /*   USAGE_PAGE (Keyboard) */
+	0x19, 0xE0,                   /*   USAGE_MINIMUM (Keyboard LeftControl) */
+	0x29, 0xE7,                   /*   USAGE_MAXIMUM (Keyboard Right GUI) */
+	0x15, 0x00,                   /*   LOGICAL_MINIMUM (0) */
+	0x25, 0x01,                   /*   LOGICAL_MAXIMUM (1) */
+	0x75, 0x01,                   /*   REPORT_SIZE (1) */
+	0x95, 0x08,                   /*   REPORT_COUNT (8) */
+	0x81, 0x02,                   /*   INPUT (Data,Var,Abs) */
+	0x95, 0x01,                   /*   REPORT_COUNT (1) */
+	0x75, 0x08,                   /*   REPORT_SIZE (8) */
+	0x81, 0x03,                   /*   INPUT (Cnst,Var,Abs) */
+	0x95, 0x05,                   /*   REPORT_COUNT (5) */
+	0x75, 0x01,                   /*   REPORT_SIZE (1) */
+	0x05, 0x08,                   /*   USAGE_PAGE (LEDs) */
+	0x19, 0x01,                   /*   USAGE_MINIMUM (Num Lock) */
+	0x29, 0x05,                   /*   USAGE_MAXIMUM (Kana) */
+	0x91, 0x02,                   /*   OUTPUT (Data,Var,Abs) */
+	0x95, 0x01,                   /*   REPORT_COUNT (1) */
+	0x75, 0x03,                   /*   REPORT_SIZE (3) */
+	0x91, 0x03,                   /*   OUTPUT (Cnst,Var,Abs) */
+	0x95, 0x06,                   /*   REPORT_COUNT (6) */
+	0x75, 0x08,                   /*   REPORT_SIZE (8) */
+	0x15, 0x00,                   /*   LOGICAL_MINIMUM (0) */
+	0x25, 0x73,                   /*   LOGICAL_MAXIMUM (115) */
+	0x05, 0x07,                   /*   USAGE_PAGE (Keyboard) */
+	0x19, 0x00,                   /*   USAGE_MINIMUM (Reserved (no event indicated)) */
+	0x29, 0x73,                   /*   USAGE_MAXIMUM (Keyboard Application) */
+	0x81, 0x00,                   /*   INPUT (Data,Ary,Abs) */
+	0xC0                          /* END_COLLECTION */
+};
+const uint16_t HID_KEYBOARD_REPORT_DESCRIPTOR_SIZE = uint16_t(sizeof(HID_KEYBOARD_REPORT_DESCRIPTOR));
+
+
+/** Mouse with 3 buttons, X/Y axis and wheel. */
+const uint8_t HID_MOUSE_REPORT_DESCRIPTOR[] = {
+	0x05, 0x01,                   /* USAGE_PAGE (Generic Desktop) */
+	0x09, 0x02,                   /* USAGE (Mouse) */
+	0xA1, 0x01,                   /* COLLECTION (Application) */
+	0x09, 0x01,                   /*   USAGE (Pointer) */
+	0xA1, 0x00,                   /*   COLLECTION (Physical) */
+	0x85, HID_REPORT_ID_MOUSE,    /*     REPORT_ID */
+	0x05, 0x09,                   /*     USAGE_PAGE (Button) */
+	0x19, 0x01,                   /*     USAGE_MINIMUM (Button 1) */
+	0x29, 0x03,                   /*     USAGE_MAXIMUM (Button 3) */
+	0x15, 0x00,                   /*     LOGICAL_MINIMUM (0) */
+	0x25, 0x01,                   /*     LOGICAL_MAXIMUM (1) */
+	0x95, 0x03,                   /*     REPORT_COUNT (3) */
+	0x75, 0x01,                   /*     REPORT_SIZE (1) */
+	0x81, 0x02,                   /*     INPUT (Data,Var,Abs) */
+	0x95, 0x01,                   /*     REPORT_COUNT (1) */
+	0x75, 0x05,                   /*     REPORT_SIZE (5) */
+	0x81, 0x03,                   /*     INPUT (Cnst,Var,Abs) */
+	0x05, 0x01,                   /*     USAGE_PAGE (Generic Desktop) */
+	0x09, 0x30,                   /*     USAGE (X) */
+	0x09, 0x31,                   /*     USAGE (Y) */
+	0x09, 0x38,                   /*     USAGE (Wheel) */
+	0x15, 0x81,                   /*     LOGICAL_MINIMUM (-127) */
+	0x25, 0x7F,                   /*     LOGICAL_MAXIMUM (127) */
+	0x75, 0x08,                   /*     REPORT_SIZE (8) */
+	0x95, 0x03,                   /*     REPORT_COUNT (3) */
+	0x81, 0x06,                   /*     INPUT (Data,Var,Rel) */
+	0xC0,                         /*   END_COLLECTION */
+	0xC0                          /* END_COLLECTION */
+};
+const uint16_t HID_MOUSE_REPORT_DESCRIPTOR_SIZE = uint16_t(sizeof(HID_MOUSE_REPORT_DESCRIPTOR));
+
+
+/** Vendor defined input and output report with HID_GENERIC_REPORT_SIZE bytes each. */
+const uint8_t HID_GENERIC_REPORT_DESCRIPTOR[] = {
+	0x06, 0x00, 0xFF,             /* USAGE_PAGE (Vendor Defined Page 1) */
+	0x09, 0x01,                   /* USAGE (Vendor Usage 1) */
+	0xA1, 0x01,                   /* COLLECTION (Application) */
+	0x85, HID_REPORT_ID_GENERIC,  /*   REPORT_ID */
+	0x15, 0x00,                   /*   LOGICAL_MINIMUM (0) */
+	0x26, 0xFF, 0x00,             /*   LOGICAL_MAXIMUM (255) */
+	0x75, 0x08,                   /*   REPORT_SIZE (8) */
+	0x95, HID_GENERIC_REPORT_SIZE, /*  REPORT_COUNT */
+	0x09, 0x01,                   /*   USAGE (Vendor Usage 1) */
+	0x81, 0x02,                   /*   INPUT (Data,Var,Abs) */
+	0x95, HID_GENERIC_REPORT_SIZE, /*  REPORT_COUNT */
+	0x09, 0x01,                   /*   USAGE (Vendor Usage 1) */
+	0x91, 0x02,                   /*   OUTPUT (Data,Var,Abs) */
+	0xC0                          /* END_COLLECTION */
+};
+const uint16_t HID_GENERIC_REPORT_DESCRIPTOR_SIZE = uint16_t(sizeof(HID_GENERIC_REPORT_DESCRIPTOR));
+
+
+namespace {
+/**
+ * Checks whether the caller may wait for queued reports to be sent. This is only the case
+ * outside of interrupts with interrupts enabled.
+ * 
+ * @return true if waiting is possible, else false
+ */
+inline bool hidCanWait() {
+	return (__get_PRIMASK() & 0x1) == 0 && (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) == 0;
+}
+} /* anonymous namespace */
+
+
+/**
+ * Replacement for global singleton to prevent static initialization issues.
+ * This needs to be called before the USB device gets enumerated, i.e. during
+ * static initialization.
+ * 
+ * @return Global HID_ instance.
+ */
+HID_ & HID() {
+	static HID_ obj;
+	return obj;
+}
+
+
+/**
+ * Constructor.
+ */
+HID_::HID_(void):
+	PluggableUSBModule(1, 1, epType),
+	rootNode(NULL),
+	descriptorSize(0),
+	protocol(HID_REPORT_PROTOCOL),
+	idle(1),
+	outReportCallback(NULL),
+	head(0),
+	tail(0),
+	sending(false)
+{
+	this->epType[0] = USB_ENDPOINT_TYPE_INTERRUPT | USB_ENDPOINT_IN(0);
+	this->handlesSof = true;
+	PluggableUSB().plug(this);
+}
+
+
+/**
+ * Starts the HID interface. This is a NOP and only provided for compatibility.
+ * 
+ * @return 0
+ */
+int HID_::begin(void) {
+	return 0;
+}
+
+
+/**
+ * Queues the given report for transmission on the next USB frame. The function waits for free
+ * space in the queue unless called from an interrupt or with disabled interrupts.
+ * 
+ * @param[in] id - report ID; 0 to send the report without report ID (STM32 specific)
+ * @param[in] data - report data
+ * @param[in] len - report data length
+ * @return number of bytes queued including the report ID or -1 on error
+ */
+int HID_::SendReport(uint8_t id, const void * data, int len) {
+	const size_t size = size_t(len) + ((id != 0) ? 1 : 0);
+	if (len < 0 || size > HID_REPORT_SIZE || ! USBDevice.configured()) return -1;
+	const uint32_t startTime = millis();
+	for (;;) {
+		/* multiple producers are possible -> lock */
+		const uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		const uint8_t curHead = this->head;
+		const uint8_t nextHead = uint8_t((curHead + 1) % (HID_REPORT_QUEUE + 1));
+		if (nextHead != this->tail) {
+			Report & report = this->queue[curHead];
+			uint8_t * ptr = report.data;
+			if (id != 0) *ptr++ = id;
+			if (len > 0) memcpy(ptr, data, size_t(len));
+			report.size = uint8_t(size);
+			this->head = nextHead;
+			__set_PRIMASK(primask);
+			return int(size);
+		}
+		__set_PRIMASK(primask);
+		if ( ! hidCanWait() || uint32_t(millis() - startTime) >= HID_TIMEOUT_MS ) return -1;
+		__WFI();
+	}
+}
+
+
+/**
+ * Adds the given report descriptor. All descriptors need to be added before the USB device gets
+ * enumerated.
+ * 
+ * @param[in] node - report descriptor to add
+ */
+void HID_::AppendDescriptor(HIDSubDescriptor * node) {
+	if (this->rootNode == NULL) {
+		this->rootNode = node;
+	} else {
+		HIDSubDescriptor * current = this->rootNode;
+		while (current->next != NULL) current = current->next;
+		current->next = node;
+	}
+	this->descriptorSize = uint16_t(this->descriptorSize + node->length);
+}
+
+
+/**
+ * Sets the callback for output reports received from the host.
+ * 
+ * @param[in] callback - callback function or NULL to disable
+ * @see HIDOutReportCallback
+ */
+void HID_::setOutReportCallback(HIDOutReportCallback callback) {
+	this->outReportCallback = callback;
+}
+
+
+/**
+ * Returns the number of reports which can be queued without waiting.
+ * 
+ * @return number of free report queue entries
+ */
+int HID_::availableForWrite() {
+	const uint32_t used = uint32_t(this->head + (HID_REPORT_QUEUE + 1) - this->tail) % (HID_REPORT_QUEUE + 1);
+	return int(HID_REPORT_QUEUE - used);
+}
+
+
+/**
+ * Sends the USB interface description to the host.
+ * 
+ * @param[in,out] interfaceCount - index of this interface
+ * @return bytes sent
+ */
+int HID_::getInterface(uint8_t * interfaceCount) {
+	const HIDDescriptor hidInterface = {
+		D_INTERFACE(HID_INTERFACE, 1, USB_DEVICE_CLASS_HUMAN_INTERFACE, HID_SUBCLASS_NONE, HID_PROTOCOL_NONE),
+		D_HIDREPORT(this->descriptorSize),
+		D_ENDPOINT(USB_ENDPOINT_IN(HID_ENDPOINT_IN), USB_ENDPOINT_TYPE_INTERRUPT, USB_EP0_SIZE, USBDevice.pollInterval(HID_INTERVAL))
+	};
+	(*interfaceCount) = uint8_t((*interfaceCount) + 1); /* uses 1 */
+	return int(USBDevice.sendControl(&hidInterface, sizeof(hidInterface)));
+}
+
+
+/**
+ * Sends the report descriptors to the host.
+ * 
+ * @param[in] setup - USB setup message
+ * @return bytes sent, 0 if not handled or -1 on error
+ */
+int HID_::getDescriptor(USBSetup & setup) {
+	if (setup.bmRequestType != REQUEST_DEVICETOHOST_STANDARD_INTERFACE) return 0;
+	if (setup.wValueH != HID_REPORT_DESCRIPTOR_TYPE) return 0;
+	if (setup.wIndex != HID_INTERFACE) return 0;
+	/* send all report descriptors within a single transfer */
+	uint32_t total = 0;
+	USBDevice.packMessages(true);
+	for (HIDSubDescriptor * node = this->rootNode; node != NULL; node = node->next) {
+		const uint32_t res = USBDevice.sendControl(node->data, node->length);
+		if (res != node->length) {
+			USBDevice.packMessages(false);
+			return -1;
+		}
+		total += res;
+	}
+	USBDevice.packMessages(false);
+	/* the host selected the report protocol by requesting the report descriptor */
+	this->protocol = HID_REPORT_PROTOCOL;
+	return int(total);
+}
+
+
+/**
+ * USB setup handler.
+ * 
+ * @param[in] setup - USB setup message
+ * @return true if handled, else false
+ */
+bool HID_::setup(USBSetup & setup) {
+	if (setup.wIndex != HID_INTERFACE) return false;
+	switch (setup.bmRequestType) {
+	case REQUEST_DEVICETOHOST_CLASS_INTERFACE:
+		switch (setup.bRequest) {
+		case HID_GET_PROTOCOL:
+			USBDevice.sendControl(&(this->protocol), 1);
+			return true;
+		case HID_GET_IDLE:
+			USBDevice.sendControl(&(this->idle), 1);
+			return true;
+		default:
+			break;
+		}
+		break;
+	case REQUEST_HOSTTODEVICE_CLASS_INTERFACE:
+		switch (setup.bRequest) {
+		case HID_SET_PROTOCOL:
+			this->protocol = setup.wValueL;
+			return true;
+		case HID_SET_IDLE:
+			this->idle = setup.wValueH;
+			return true;
+		case HID_SET_REPORT:
+			{
+				uint8_t report[HID_REPORT_SIZE];
+				const uint32_t len = USBDevice.recvControl(report, sizeof(report));
+				const HIDOutReportCallback callback = this->outReportCallback;
+				if (setup.wValueH == HID_REPORT_TYPE_OUTPUT && callback != NULL) {
+					const uint8_t id = setup.wValueL;
+					/* the report ID is part of the data if used */
+					const size_t offset = (id != 0 && len > 0 && report[0] == id) ? 1 : 0;
+					callback(id, report + offset, size_t(len - offset));
+				}
+			}
+			return true;
+		default:
+			break;
+		}
+		break;
+	default:
+		break;
+	}
+	return false;
+}
+
+
+/**
+ * Returns the USB device serial number.
+ * 
+ * @param[out] name - copy serial number to this buffer
+ * @return number of bytes copied
+ */
+uint8_t HID_::getShortName(char * name) {
+	name[0] = ' ';
+	name[1] = 'H';
+	name[2] = 'I';
+	name[3] = 'D';
+	return 4;
+}
+
+
+/**
+ * Sends the next queued report. This is called from the USB interrupt on each start of frame.
+ * The transmitted report is removed from the queue once the endpoint is ready again.
+ */
+void HID_::sof() {
+	if ( this->sending ) {
+		if (USBDevice.available(USB_ENDPOINT_IN(HID_ENDPOINT_IN)) == 0) return; /* still sending */
+		this->tail = uint8_t((this->tail + 1) % (HID_REPORT_QUEUE + 1));
+		this->sending = false;
+	}
+	const uint8_t curTail = this->tail;
+	if (curTail == this->head) return; /* empty */
+	const Report & report = this->queue[curTail];
+	if ( USBDevice.sendPacket(HID_ENDPOINT_IN, report.data, report.size) ) this->sending = true;
+}
+
+
+#endif /* not STM32CUBEDUINO_DISABLE_USB_HID and PLUGGABLE_USB_ENABLED and USBCON */
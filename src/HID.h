@@ -0,0 +1,191 @@
+/**
+ * @file HID.h
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ */
+#ifndef __HID_H__
+#define __HID_H__
+
+#include <stdint.h>
+#include "USBAPI.h"
+
+
+#if !defined(STM32CUBEDUINO_DISABLE_USB_HID) && defined(PLUGGABLE_USB_ENABLED) && defined(USBCON)
+#include "PluggableUSB.h"
+
+
+#define _USING_HID
+
+
+#ifndef HID_INTERVAL
+/** Defines the interrupt IN endpoint polling interval in milliseconds. */
+#define HID_INTERVAL 1
+#endif /* HID_INTERVAL */
+
+
+#ifndef HID_REPORT_QUEUE
+/** Defines the number of reports which can be queued for transmission. */
+#define HID_REPORT_QUEUE 4
+#endif /* HID_REPORT_QUEUE */
+#if HID_REPORT_QUEUE < 1 || HID_REPORT_QUEUE > 254
+#error HID_REPORT_QUEUE needs to be in the range 1 to 254.
+#endif
+
+
+/** Maximum size of a single report including its report ID. */
+#define HID_REPORT_SIZE USB_EP0_SIZE
+
+
+/* HID requests */
+#define HID_GET_REPORT                0x01
+#define HID_GET_IDLE                  0x02
+#define HID_GET_PROTOCOL              0x03
+#define HID_SET_REPORT                0x09
+#define HID_SET_IDLE                  0x0A
+#define HID_SET_PROTOCOL              0x0B
+
+/* HID descriptor types */
+#define HID_HID_DESCRIPTOR_TYPE       0x21
+#define HID_REPORT_DESCRIPTOR_TYPE    0x22
+#define HID_PHYSICAL_DESCRIPTOR_TYPE  0x23
+
+/* HID interface sub-classes and protocols */
+#define HID_SUBCLASS_NONE             0
+#define HID_SUBCLASS_BOOT_INTERFACE   1
+#define HID_PROTOCOL_NONE             0
+#define HID_PROTOCOL_KEYBOARD         1
+#define HID_PROTOCOL_MOUSE            2
+
+/* HID protocol values for SET_PROTOCOL and GET_PROTOCOL */
+#define HID_BOOT_PROTOCOL             0
+#define HID_REPORT_PROTOCOL           1
+
+/* HID report types (upper byte of wValue) */
+#define HID_REPORT_TYPE_INPUT         1
+#define HID_REPORT_TYPE_OUTPUT        2
+#define HID_REPORT_TYPE_FEATURE       3
+
+/* report IDs used by the predefined report descriptors */
+#define HID_REPORT_ID_KEYBOARD        1
+#define HID_REPORT_ID_MOUSE           2
+#define HID_REPORT_ID_GENERIC         3
+
+/** Size of the input and output reports of the predefined generic report descriptor without report ID. */
+#define HID_GENERIC_REPORT_SIZE       (HID_REPORT_SIZE - 1)
+
+
+struct HIDDescDescriptor {
+	uint8_t len; /* 9 */
+	uint8_t dtype; /* 0x21 */
+	uint8_t addr;
+	uint8_t versionL; /* 0x101 */
+	uint8_t versionH; /* 0x101 */
+	uint8_t country;
+	uint8_t desctype; /* 0x22 report */
+	uint8_t descLenL;
+	uint8_t descLenH;
+} __attribute__((packed));
+
+
+struct HIDDescriptor {
+	InterfaceDescriptor hid;
+	HIDDescDescriptor desc;
+	EndpointDescriptor in;
+} __attribute__((packed));
+
+
+/** Input report of the predefined keyboard report descriptor without report ID. */
+struct HIDKeyboardReport {
+	uint8_t modifiers;
+	uint8_t reserved;
+	uint8_t keys[6];
+} __attribute__((packed));
+
+
+/** Input report of the predefined mouse report descriptor without report ID. */
+struct HIDMouseReport {
+	uint8_t buttons;
+	int8_t x;
+	int8_t y;
+	int8_t wheel;
+} __attribute__((packed));
+
+
+#define D_HIDREPORT(length) {9, 0x21, 0x01, 0x01, 0, 1, 0x22, lowByte(length), highByte(length)}
+
+
+/* predefined report descriptors (STM32 specific) */
+extern const uint8_t HID_KEYBOARD_REPORT_DESCRIPTOR[];
+extern const uint16_t HID_KEYBOARD_REPORT_DESCRIPTOR_SIZE;
+extern const uint8_t HID_MOUSE_REPORT_DESCRIPTOR[];
+extern const uint16_t HID_MOUSE_REPORT_DESCRIPTOR_SIZE;
+extern const uint8_t HID_GENERIC_REPORT_DESCRIPTOR[];
+extern const uint16_t HID_GENERIC_REPORT_DESCRIPTOR_SIZE;
+
+
+class HIDSubDescriptor {
+public:
+	HIDSubDescriptor * next = NULL;
+	HIDSubDescriptor(const void * d, const uint16_t l):
+		data(d),
+		length(l)
+	{}
+
+	const void * data;
+	const uint16_t length;
+};
+
+
+/**
+ * Callback for output reports received from the host.
+ * This is called from the USB interrupt.
+ * 
+ * @param[in] id - report ID or 0 if report IDs are not used
+ * @param[in] data - report data without report ID
+ * @param[in] len - report data length
+ */
+typedef void (*HIDOutReportCallback)(const uint8_t id, const uint8_t * data, const size_t len);
+
+
+class HID_ : public PluggableUSBModule {
+private:
+	/** Queued report. */
+	struct Report {
+		uint8_t data[HID_REPORT_SIZE] __attribute__((aligned(4))); /* word aligned for DMA transfers */
+		uint8_t size;
+	};
+	uint8_t epType[1];
+	HIDSubDescriptor * rootNode;
+	uint16_t descriptorSize;
+	uint8_t protocol;
+	uint8_t idle;
+	volatile HIDOutReportCallback outReportCallback;
+	Report queue[HID_REPORT_QUEUE + 1]; /**< Reports to send. One slot remains free to distinguish between full and empty. */
+	volatile uint8_t head; /**< Next report to write. */
+	volatile uint8_t tail; /**< Next report to send. */
+	volatile bool sending; /**< True while the report at tail is being sent. */
+public:
+	HID_(void);
+	int begin(void);
+	int SendReport(uint8_t id, const void * data, int len);
+	void AppendDescriptor(HIDSubDescriptor * node);
+	void setOutReportCallback(HIDOutReportCallback callback); /* STM32 specific */
+	uint8_t getProtocol() const { return this->protocol; } /* STM32 specific */
+	int availableForWrite(); /* STM32 specific */
+protected:
+	int getInterface(uint8_t * interfaceCount);
+	int getDescriptor(USBSetup & setup);
+	bool setup(USBSetup & setup);
+	uint8_t getShortName(char * name);
+	void sof();
+};
+
+
+/* Replacement for global singleton to prevent static initialization issues. */
+HID_ & HID();
+
+
+#endif /* not STM32CUBEDUINO_DISABLE_USB_HID and PLUGGABLE_USB_ENABLED and USBCON */
+#endif /* __HID_H__ */
@@ -1,9 +1,9 @@
 /**
  * @file HardwareSerial.cpp
  * @author Daniel Starke
- * @copyright Copyright 2020-2022 Daniel Starke
+ * @copyright Copyright 2020-2026 Daniel Starke
  * @date 2020-05-12
- * @version 2022-10-06
+ * @version 2026-10-17
  */
 #include "Arduino.h"
 #include "wiring_irq.h"
@@ -18,12 +18,44 @@
 #ifndef UART_IRQ_SUBPRIO
 #error Please define UART_IRQ_SUBPRIO in board.hpp.
 #endif
+static_assert(SERIAL_RX_BUFFER_SIZE == 0 || (SERIAL_RX_BUFFER_SIZE >= 2 && SERIAL_RX_BUFFER_SIZE <= 0xFFFF), "SERIAL_RX_BUFFER_SIZE needs to be 0 or in the range of 2 to 65535.");
+static_assert(SERIAL_TX_BUFFER_SIZE == 0 || (SERIAL_TX_BUFFER_SIZE >= 2 && SERIAL_TX_BUFFER_SIZE <= 0xFFFF), "SERIAL_TX_BUFFER_SIZE needs to be 0 or in the range of 2 to 65535.");
 
 
 /** Local definition of the RX circular buffer queue within HardwareSerial. */
-#define RX_QUEUE this->rxBuffer, SERIAL_RX_BUFFER_SIZE, this->rxHead, this->rxTail
+#define RX_QUEUE this->rxBuffer, this->rxSize, this->rxHead, this->rxTail
 /** Local definition of the TX circular buffer queue within HardwareSerial. */
-#define TX_QUEUE this->txBuffer, SERIAL_TX_BUFFER_SIZE, this->txHead, this->txTail
+#define TX_QUEUE this->txBuffer, this->txSize, this->txHead, this->txTail
+/** Embedded receive buffer or NULL if removed via `SERIAL_RX_BUFFER_SIZE`. */
+#if SERIAL_RX_BUFFER_SIZE > 0
+#define RX_DEFAULT this->rxDefault
+#else /* not SERIAL_RX_BUFFER_SIZE > 0 */
+#define RX_DEFAULT NULL
+#endif /* not SERIAL_RX_BUFFER_SIZE > 0 */
+/** Embedded transmission buffer or NULL if removed via `SERIAL_TX_BUFFER_SIZE`. */
+#if SERIAL_TX_BUFFER_SIZE > 0
+#define TX_DEFAULT this->txDefault
+#else /* not SERIAL_TX_BUFFER_SIZE > 0 */
+#define TX_DEFAULT NULL
+#endif /* not SERIAL_TX_BUFFER_SIZE > 0 */
+
+
+/* UART register access for the register level interrupt handler (see `setFastIrq()`) */
+#ifdef USART_ISR_PE
+#define HWSERIAL_SR(x)  ((x)->ISR)
+#define HWSERIAL_RDR(x) ((x)->RDR)
+#define HWSERIAL_TDR(x) ((x)->TDR)
+#else /* not USART_ISR_PE */
+#define HWSERIAL_SR(x)  ((x)->SR)
+#define HWSERIAL_RDR(x) ((x)->DR)
+#define HWSERIAL_TDR(x) ((x)->DR)
+#endif /* not USART_ISR_PE */
+#if !defined(USART_CR1_RXNEIE) && defined(USART_CR1_RXNEIE_RXFNEIE)
+#define USART_CR1_RXNEIE USART_CR1_RXNEIE_RXFNEIE
+#endif /* !USART_CR1_RXNEIE and USART_CR1_RXNEIE_RXFNEIE */
+#if !defined(USART_CR1_TXEIE) && defined(USART_CR1_TXEIE_TXFNFIE)
+#define USART_CR1_TXEIE USART_CR1_TXEIE_TXFNFIE
+#endif /* !USART_CR1_TXEIE and USART_CR1_TXEIE_TXFNFIE */
 
 
 namespace {
@@ -147,16 +179,105 @@ UART_HandleTypeDef ** getHandlePtrFromId(USART_TypeDef * hUart) {
 	}
 	return res;
 }
+
+
+/**
+ * Returns the circular buffer size for the given buffer size in bytes. The size is limited by the
+ * buffer index type and the maximum DMA transfer size.
+ * 
+ * @param[in] size - buffer size in bytes
+ * @return circular buffer size or 0 if too small
+ */
+inline uint16_t getFifoSize(const size_t size) {
+	if (size < 2) return 0; /* one element is always kept free */
+	return uint16_t(min(size, size_t(0xFFFF)));
+}
+
+
+#ifdef HAVE_HWSERIAL_DMA
+/**
+ * Sets the DMA request of the given DMA handle.
+ * 
+ * @param[in,out] hDma - DMA handle
+ * @param[in] request - DMA request or channel number, depending on the target platform
+ */
+inline void setDmaRequest(DMA_HandleTypeDef * hDma, const uint32_t request) {
+#if defined(DMA_REQUEST_0) || defined(DMA_REQUEST_MEM2MEM)
+	hDma->Init.Request = request;
+#elif defined(DMA_CHANNEL_0)
+	hDma->Init.Channel = request;
+#else /* no DMA request multiplexer */
+	(void)hDma;
+	(void)request;
+#endif /* no DMA request multiplexer */
+}
+
+
+/**
+ * Enables the DMA clock and initializes the given DMA handle for byte wise transfers between
+ * UART and memory. The DMA instance and request need to be set already.
+ * 
+ * @param[in,out] hDma - DMA handle
+ * @param[in] direction - DMA transfer direction
+ * @param[in] mode - DMA mode (e.g. DMA_CIRCULAR)
+ * @return true on success, else false
+ */
+bool initDma(DMA_HandleTypeDef * hDma, const uint32_t direction, const uint32_t mode) {
+	/* enable DMA clock */
+	const uintptr_t dmaBase = reinterpret_cast<uintptr_t>(hDma->Instance) & ~uintptr_t(0x3FF);
+#ifdef DMA1
+	if (dmaBase == DMA1_BASE) __HAL_RCC_DMA1_CLK_ENABLE();
+#endif /* DMA1 */
+#ifdef DMA2
+	if (dmaBase == DMA2_BASE) __HAL_RCC_DMA2_CLK_ENABLE();
+#endif /* DMA2 */
+	(void)dmaBase;
+#ifdef __HAL_RCC_DMAMUX1_CLK_ENABLE
+	__HAL_RCC_DMAMUX1_CLK_ENABLE();
+#endif /* __HAL_RCC_DMAMUX1_CLK_ENABLE */
+	hDma->Init.Direction = direction;
+	hDma->Init.PeriphInc = DMA_PINC_DISABLE;
+	hDma->Init.MemInc = DMA_MINC_ENABLE;
+	hDma->Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+	hDma->Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+	hDma->Init.Mode = mode;
+	hDma->Init.Priority = DMA_PRIORITY_HIGH;
+#ifdef DMA_FIFOMODE_DISABLE
+	hDma->Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+#endif /* DMA_FIFOMODE_DISABLE */
+	return HAL_DMA_Init(hDma) == HAL_OK;
+}
+#endif /* HAVE_HWSERIAL_DMA */
 } /* namespace anonymous */
 
 
+/**
+ * Common UART interrupt handler. This calls the register level interrupt handler of the
+ * associated HardwareSerial instance if enabled or the STM32 HAL API handler otherwise.
+ * Frame boundaries are detected around these if requested via `HardwareSerial::onFrame()`.
+ * 
+ * @param[in,out] hUart - pointer to UART handle
+ * @see HardwareSerial::setFastIrq()
+ */
+void hardwareSerialIrqHandler(UART_HandleTypeDef * hUart) {
+	HardwareSerial * obj = getObjFromMemberPtr(hUart, &HardwareSerial::handle);
+	if (obj->onFrameCallback != NULL) {
+		obj->frameIrqHandler();
+	} else if ( obj->fastIrqActive ) {
+		obj->fastIrqHandler();
+	} else {
+		HAL_UART_IRQHandler(hUart);
+	}
+}
+
+
 /* UART/USART IRQ handlers */
 extern "C" {
 /* USARTs */
 #define DEF_IRQ_HANDLER(x) \
 	/** IRQ handler for USARTx interrupt. */ \
 	void STM32CubeDuinoIrqHandlerForUSART##x(void) { \
-		if (uart##x##Handle != NULL) HAL_UART_IRQHandler(uart##x##Handle); \
+		if (uart##x##Handle != NULL) hardwareSerialIrqHandler(uart##x##Handle); \
 	}
 
 #ifdef USART1
@@ -201,7 +322,7 @@ DEF_IRQ_HANDLER(10)
 #define DEF_IRQ_HANDLER(x) \
 	/** IRQ handler for UARTx interrupt. */ \
 	void STM32CubeDuinoIrqHandlerForUART##x(void) { \
-		if (uart##x##Handle != NULL) HAL_UART_IRQHandler(uart##x##Handle); \
+		if (uart##x##Handle != NULL) hardwareSerialIrqHandler(uart##x##Handle); \
 	}
 
 #ifdef UART4
@@ -234,7 +355,7 @@ DEF_IRQ_HANDLER(10)
 #define DEF_IRQ_HANDLER(x) \
 	/** IRQ handler for LPUARTx interrupt. */ \
 	void STM32CubeDuinoIrqHandlerForLPUART##x(void) { \
-		if (lpuart##x##Handle != NULL) HAL_UART_IRQHandler(lpuart##x##Handle); \
+		if (lpuart##x##Handle != NULL) hardwareSerialIrqHandler(lpuart##x##Handle); \
 	}
 
 #ifdef LPUART1
@@ -289,8 +410,34 @@ void HAL_UART_ErrorCallback(UART_HandleTypeDef * hUart) {
 	/* resume data reception */
 	HardwareSerial * obj = getObjFromMemberPtr(hUart, &HardwareSerial::handle);
 	if (obj == NULL) return;
-	HAL_UART_Receive_IT(hUart, obj->recv, 1);
+	obj->countErrors(hUart->ErrorCode);
+#ifdef HAVE_HWSERIAL_DMA
+	if (obj->rxDma->Instance != NULL) {
+		/* the DMA transfer was aborted; continue at the last reported position */
+		obj->startRxDma(obj->rxHead);
+		return;
+	}
+#endif /* HAVE_HWSERIAL_DMA */
+	obj->startRx();
+}
+
+
+#ifdef HAVE_HWSERIAL_DMA
+/**
+ * Overwrites the STM32 HAL API handler for UART reception events.
+ * These are raised on half and full DMA transfer and on idle line detection during DMA based
+ * reception. This maps the UART instance to a call within the associated HardwareSerial instance.
+ * 
+ * @param[in,out] hUart - pointer to UART handle
+ * @param[in] size - number of bytes received since the start of the DMA transfer
+ * @see HardwareSerial::rxEventHandler()
+ */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef * hUart, uint16_t size) {
+	HardwareSerial * obj = getObjFromMemberPtr(hUart, &HardwareSerial::handle);
+	if (obj == NULL) return;
+	obj->rxEventHandler(size);
 }
+#endif /* HAVE_HWSERIAL_DMA */
 
 
 #ifdef USART_ISR_WUF
@@ -308,7 +455,9 @@ void HAL_UARTEx_WakeupCallback(UART_HandleTypeDef * hUart) {
 
 
 /**
- * Constructor.
+ * Constructor. The embedded buffers with the sizes `SERIAL_RX_BUFFER_SIZE` and `SERIAL_TX_BUFFER_SIZE`
+ * are used. Set the buffer sizes via `setRxBufferSize()` and `setTxBufferSize()` before `begin()`
+ * if these are 0.
  * 
  * @param[in,out] instance - UART instance as defined by STM32 HAL API
  * @param[in] irqNum - associated IRQ for the UART as defined by STM32 HAL API
@@ -318,15 +467,70 @@ void HAL_UARTEx_WakeupCallback(UART_HandleTypeDef * hUart) {
  * @param[in] txAltFn - alternate function number of the TX pin (see `pinMode()`)
  */
 HardwareSerial::HardwareSerial(USART_TypeDef * instance, const IRQn_Type irqNum, const PinName rxPin, const PinName txPin, const uint8_t rxAltFn, const uint8_t txAltFn):
+	HardwareSerial(instance, irqNum, rxPin, txPin, rxAltFn, txAltFn, NULL, 0, NULL, 0)
+{}
+
+
+/**
+ * Constructor with user provided buffers. This allows to set the buffer sizes for each instance.
+ * The embedded buffer is used if NULL was passed. Its size is fixed to `SERIAL_RX_BUFFER_SIZE` or
+ * `SERIAL_TX_BUFFER_SIZE`, respectively.
+ * 
+ * @param[in,out] instance - UART instance as defined by STM32 HAL API
+ * @param[in] irqNum - associated IRQ for the UART as defined by STM32 HAL API
+ * @param[in] rxPin - PinName of the RX pin
+ * @param[in] txPin - PinName of the TX pin
+ * @param[in] rxAltFn - alternate function number of the RX pin (see `pinMode()`)
+ * @param[in] txAltFn - alternate function number of the TX pin (see `pinMode()`)
+ * @param[in,out] rxStorage - receive buffer or NULL
+ * @param[in] rxStorageSize - receive buffer size in bytes (2 to 65535)
+ * @param[in,out] txStorage - transmission buffer or NULL
+ * @param[in] txStorageSize - transmission buffer size in bytes (2 to 65535)
+ * @remarks The buffers can hold up to one byte less than their size.
+ * @remarks The buffers need to remain valid for the lifetime of this object.
+ * @remarks The embedded buffers still occupy RAM. Define `SERIAL_RX_BUFFER_SIZE` and
+ * `SERIAL_TX_BUFFER_SIZE` as 0 to remove them if all instances use user provided buffers.
+ */
+HardwareSerial::HardwareSerial(USART_TypeDef * instance, const IRQn_Type irqNum, const PinName rxPin, const PinName txPin, const uint8_t rxAltFn, const uint8_t txAltFn, uint8_t * rxStorage, const size_t rxStorageSize, uint8_t * txStorage, const size_t txStorageSize):
 	irq(irqNum),
 	pins{uint8_t(rxPin), uint8_t(txPin)},
 	afns(uint8_t((rxAltFn << 4) | txAltFn)),
-	txNextTail(0)
+	flowPins{uint8_t(NC), uint8_t(NC)},
+	flowAfns(0),
+#ifdef HAVE_HWSERIAL_DE
+	dePin(uint8_t(NC)),
+	deAfn(0),
+	deTimes{0, 0},
+#endif /* HAVE_HWSERIAL_DE */
+	rxMask(0xFF),
+	fastIrq(false),
+	fastIrqActive(false),
+#ifdef HAVE_HWSERIAL_DMA
+	rxDmaIrq(irqNum),
+	rxDmaStart(0),
+	txDmaIrq(irqNum),
+#endif /* HAVE_HWSERIAL_DMA */
+	rxThrottled(false),
+	txNextTail(0),
+	rxSize(getFifoSize((rxStorage != NULL) ? rxStorageSize : SERIAL_RX_BUFFER_SIZE)),
+	txSize(getFifoSize((txStorage != NULL) ? txStorageSize : SERIAL_TX_BUFFER_SIZE)),
+	ownBuffers(0),
+	rxBuffer((rxStorage != NULL) ? rxStorage : RX_DEFAULT),
+	txBuffer((txStorage != NULL) ? txStorage : TX_DEFAULT)
 {
 	memset(this->handle, 0, sizeof(*(this->handle)));
+	memset(&(this->stats), 0, sizeof(this->stats));
+	this->onFrameCallback = NULL;
+	this->frameDelimiter = -1;
+	this->frameStart = 0;
+#ifdef HAVE_HWSERIAL_DMA
+	memset(this->rxDma, 0, sizeof(*(this->rxDma)));
+	memset(this->txDma, 0, sizeof(*(this->txDma)));
+#endif /* HAVE_HWSERIAL_DMA */
 	this->handle->Instance = instance;
 	UART_HandleTypeDef ** handlePtr = getHandlePtrFromId(instance);
-	if (handlePtr == NULL || (*handlePtr != NULL && (*handlePtr)->Instance != NULL)) {
+	/* a missing buffer needs to be set before `begin()` */
+	if (handlePtr == NULL || (*handlePtr != NULL && (*handlePtr)->Instance != NULL) || (this->rxSize == 0 && this->rxBuffer != NULL) || (this->txSize == 0 && this->txBuffer != NULL)) {
 		systemErrorHandler();
 		return;
 	}
@@ -340,6 +544,8 @@ HardwareSerial::HardwareSerial(USART_TypeDef * instance, const IRQn_Type irqNum,
  * Destructor.
  */
 HardwareSerial::~HardwareSerial() {
+	if ((this->ownBuffers & OWN_RX_BUFFER) != 0) free(this->rxBuffer);
+	if ((this->ownBuffers & OWN_TX_BUFFER) != 0) free(this->txBuffer);
 	UART_HandleTypeDef ** handlePtr = getHandlePtrFromId(this->handle->Instance);
 	if (handlePtr == NULL) return;
 	*handlePtr = NULL;
@@ -359,6 +565,13 @@ HardwareSerial::~HardwareSerial() {
  * driver initialization. This is needed, for example, to switch RX and TX.
  */
 void HardwareSerial::begin(const unsigned long baudrate, const uint8_t mode, HAL_StatusTypeDef (& initFn)(UART_HandleTypeDef * hUart)) {
+	if (this->rxBuffer == NULL || this->txBuffer == NULL) {
+		/* no embedded buffer and none was set via `setRxBufferSize()` or `setTxBufferSize()` */
+		systemErrorHandler();
+		return;
+	}
+	memset(&(this->stats), 0, sizeof(this->stats));
+	this->frameStart = 0;
 	uint32_t databits = 0;
 	uint32_t stopbits = 0;
 	uint32_t parity = 0;
@@ -369,6 +582,7 @@ void HardwareSerial::begin(const unsigned long baudrate, const uint8_t mode, HAL
 	case 0x06: databits = 8; break;
 	default:   databits = 0; break;
 	}
+	this->rxMask = uint8_t(0xFF >> (8 - databits));
 	/* parity */
 	if ((mode & 0x30) == 0x30) {
 		parity = UART_PARITY_ODD;
@@ -521,13 +735,33 @@ void HardwareSerial::begin(const unsigned long baudrate, const uint8_t mode, HAL
 	pinModeEx(this->pins[0], ALTERNATE_FUNCTION, this->afns >> 4);
 #endif /* not STM32F1 */
 	pinModeEx(this->pins[1], ALTERNATE_FUNCTION, this->afns & 0xF);
+	uint32_t hwFlowCtl = UART_HWCONTROL_NONE;
+#ifdef HAVE_HWSERIAL_DE
+	if (this->dePin != uint8_t(NC)) {
+		/* DE replaces the RTS output */
+		pinModeEx(this->dePin, ALTERNATE_FUNCTION, this->deAfn);
+	} else if (this->flowPins[0] != uint8_t(NC)) {
+#else /* not HAVE_HWSERIAL_DE */
+	if (this->flowPins[0] != uint8_t(NC)) {
+#endif /* not HAVE_HWSERIAL_DE */
+		pinModeEx(this->flowPins[0], ALTERNATE_FUNCTION, this->flowAfns >> 4);
+		hwFlowCtl |= UART_HWCONTROL_RTS;
+	}
+	if (this->flowPins[1] != uint8_t(NC)) {
+#ifdef STM32F1
+		pinModeEx(this->flowPins[1], INPUT, this->flowAfns & 0xF);
+#else /* not STM32F1 */
+		pinModeEx(this->flowPins[1], ALTERNATE_FUNCTION, this->flowAfns & 0xF);
+#endif /* not STM32F1 */
+		hwFlowCtl |= UART_HWCONTROL_CTS;
+	}
 	/* initialize */
 	this->handle->Init.BaudRate = uint32_t(baudrate);
 	this->handle->Init.WordLength = databits;
 	this->handle->Init.StopBits = stopbits;
 	this->handle->Init.Parity = parity;
 	this->handle->Init.Mode = UART_MODE_TX_RX;
-	this->handle->Init.HwFlowCtl = UART_HWCONTROL_NONE;
+	this->handle->Init.HwFlowCtl = hwFlowCtl;
 	this->handle->Init.OverSampling = UART_OVERSAMPLING_16;
 #ifdef UART_ONE_BIT_SAMPLE_DISABLE
 	this->handle->Init.OneBitSampling = UART_ONE_BIT_SAMPLE_DISABLE;
@@ -538,10 +772,63 @@ void HardwareSerial::begin(const unsigned long baudrate, const uint8_t mode, HAL
 	if (initFn(this->handle) != HAL_OK) {
 		systemErrorHandler();
 	}
+#ifdef HAVE_HWSERIAL_DE
+	if (this->dePin != uint8_t(NC)) {
+		/* same as HAL_RS485Ex_Init() with active high DE but independent of the passed function */
+		__HAL_UART_DISABLE(this->handle);
+		SET_BIT(this->handle->Instance->CR3, USART_CR3_DEM);
+		CLEAR_BIT(this->handle->Instance->CR3, USART_CR3_DEP);
+		MODIFY_REG(
+			this->handle->Instance->CR1,
+			USART_CR1_DEAT | USART_CR1_DEDT,
+			(uint32_t(this->deTimes[0]) << USART_CR1_DEAT_Pos) | (uint32_t(this->deTimes[1]) << USART_CR1_DEDT_Pos)
+		);
+		__HAL_UART_ENABLE(this->handle);
+	}
+#endif /* HAVE_HWSERIAL_DE */
+#ifdef USART_CR1_CMIE
+	if (this->frameDelimiter >= 0) {
+		/* the character match address can only be changed while the UART is disabled */
+		__HAL_UART_DISABLE(this->handle);
+		MODIFY_REG(this->handle->Instance->CR2, USART_CR2_ADD, uint32_t(this->frameDelimiter) << USART_CR2_ADD_Pos);
+		__HAL_UART_ENABLE(this->handle);
+	}
+#endif /* USART_CR1_CMIE */
 	/* must disable interrupt to prevent handle lock contention */
 	HAL_NVIC_DisableIRQ(this->irq);
 	__DMB(); __DSB(); __ISB(); /* data and instruction barrier */
-	HAL_UART_Receive_IT(this->handle, this->recv, 1); /* receive single bytes for minimal latency */
+#ifdef HAVE_HWSERIAL_DMA
+	this->fastIrqActive = this->fastIrq && this->rxDma->Instance == NULL && this->txDma->Instance == NULL;
+#else /* not HAVE_HWSERIAL_DMA */
+	this->fastIrqActive = this->fastIrq;
+#endif /* not HAVE_HWSERIAL_DMA */
+	this->txNextTail = this->txTail; /* no block in transmission */
+#ifdef HAVE_HWSERIAL_DMA
+	if (this->rxDma->Instance != NULL) {
+		/* the DMA instance and request were set via setRxDma() */
+		__HAL_LINKDMA(this->handle, hdmarx, *(this->rxDma));
+		if ( ! initDma(this->rxDma, DMA_PERIPH_TO_MEMORY, DMA_CIRCULAR) ) {
+			systemErrorHandler();
+		}
+		HAL_NVIC_SetPriority(this->rxDmaIrq, UART_IRQ_PRIO, UART_IRQ_SUBPRIO);
+		HAL_NVIC_EnableIRQ(this->rxDmaIrq);
+		this->startRxDma(0); /* stream into the receive buffer; interrupts only on idle line, half and full buffer */
+	} else {
+		this->startRx(); /* receive single bytes for minimal latency */
+	}
+	if (this->txDma->Instance != NULL) {
+		/* the DMA instance and request were set via setTxDma() */
+		__HAL_LINKDMA(this->handle, hdmatx, *(this->txDma));
+		if ( ! initDma(this->txDma, DMA_MEMORY_TO_PERIPH, DMA_NORMAL) ) {
+			systemErrorHandler();
+		}
+		HAL_NVIC_SetPriority(this->txDmaIrq, UART_IRQ_PRIO, UART_IRQ_SUBPRIO);
+		HAL_NVIC_EnableIRQ(this->txDmaIrq);
+	}
+#else /* not HAVE_HWSERIAL_DMA */
+	this->startRx(); /* receive single bytes for minimal latency */
+#endif /* not HAVE_HWSERIAL_DMA */
+	this->updateFrameIrqs();
 	/* enable interrupt */
 	HAL_NVIC_SetPriority(this->irq, UART_IRQ_PRIO, UART_IRQ_SUBPRIO);
 	HAL_NVIC_EnableIRQ(this->irq);
@@ -663,17 +950,269 @@ void HardwareSerial::end() {
 		systemErrorHandler();
 		break;
 	}
+#ifdef HAVE_HWSERIAL_DMA
+	if (this->rxDma->Instance != NULL) {
+		HAL_NVIC_DisableIRQ(this->rxDmaIrq);
+		HAL_UART_AbortReceive(this->handle);
+		HAL_DMA_DeInit(this->rxDma);
+		this->rxDmaStart = 0;
+	}
+	if (this->txDma->Instance != NULL) {
+		HAL_NVIC_DisableIRQ(this->txDmaIrq);
+		HAL_DMA_DeInit(this->txDma);
+	}
+#endif /* HAVE_HWSERIAL_DMA */
 	HAL_UART_DeInit(this->handle);
+	this->fastIrqActive = false;
 	_FIFOX_CLEAR(RX_QUEUE);
+	this->rxThrottled = false;
 }
 
 
+/**
+ * Changes the receive buffer size. A buffer with the new size is allocated on the heap unless
+ * the size equals `SERIAL_RX_BUFFER_SIZE`, which selects the embedded buffer again. A previously
+ * allocated buffer is released. A user provided buffer is not used anymore. This is required
+ * before `begin()` if `SERIAL_RX_BUFFER_SIZE` is 0 and no user provided buffer was passed.
+ * 
+ * @param[in] size - new buffer size in bytes (2 to 65535)
+ * @return new buffer size or 0 on error
+ * @remarks Needs to be called before `begin()` or after `end()`.
+ * @remarks The previous buffer remains in use if the allocation failed.
+ * @remarks The buffer can hold up to one byte less than its size.
+ */
+size_t HardwareSerial::setRxBufferSize(const size_t size) {
+	const uint16_t fifoSize = getFifoSize(size);
+	if (fifoSize == 0 || this->handle->gState != HAL_UART_STATE_RESET) return 0;
+	uint8_t * buffer = RX_DEFAULT;
+	if (buffer == NULL || fifoSize != SERIAL_RX_BUFFER_SIZE) {
+		buffer = static_cast<uint8_t *>(malloc(fifoSize));
+		if (buffer == NULL) return 0;
+	}
+	if ((this->ownBuffers & OWN_RX_BUFFER) != 0) free(this->rxBuffer);
+	if (buffer != RX_DEFAULT) {
+		this->ownBuffers = uint8_t(this->ownBuffers | OWN_RX_BUFFER);
+	} else {
+		this->ownBuffers = uint8_t(this->ownBuffers & ~OWN_RX_BUFFER);
+	}
+	this->rxBuffer = buffer;
+	this->rxSize = fifoSize;
+	_FIFOX_INIT(RX_QUEUE);
+	return fifoSize;
+}
+
+
+/**
+ * Changes the transmission buffer size. A buffer with the new size is allocated on the heap
+ * unless the size equals `SERIAL_TX_BUFFER_SIZE`, which selects the embedded buffer again. A
+ * previously allocated buffer is released. A user provided buffer is not used anymore. This is
+ * required before `begin()` if `SERIAL_TX_BUFFER_SIZE` is 0 and no user provided buffer was passed.
+ * 
+ * @param[in] size - new buffer size in bytes (2 to 65535)
+ * @return new buffer size or 0 on error
+ * @remarks Needs to be called before `begin()` or after `end()`.
+ * @remarks The previous buffer remains in use if the allocation failed.
+ * @remarks The buffer can hold up to one byte less than its size.
+ */
+size_t HardwareSerial::setTxBufferSize(const size_t size) {
+	const uint16_t fifoSize = getFifoSize(size);
+	if (fifoSize == 0 || this->handle->gState != HAL_UART_STATE_RESET) return 0;
+	uint8_t * buffer = TX_DEFAULT;
+	if (buffer == NULL || fifoSize != SERIAL_TX_BUFFER_SIZE) {
+		buffer = static_cast<uint8_t *>(malloc(fifoSize));
+		if (buffer == NULL) return 0;
+	}
+	if ((this->ownBuffers & OWN_TX_BUFFER) != 0) free(this->txBuffer);
+	if (buffer != TX_DEFAULT) {
+		this->ownBuffers = uint8_t(this->ownBuffers | OWN_TX_BUFFER);
+	} else {
+		this->ownBuffers = uint8_t(this->ownBuffers & ~OWN_TX_BUFFER);
+	}
+	this->txBuffer = buffer;
+	this->txSize = fifoSize;
+	_FIFOX_INIT(TX_QUEUE);
+	return fifoSize;
+}
+
+
+/**
+ * Enables the hardware flow control via RTS and CTS. The UART deasserts RTS while the received
+ * data is not read. The reception is paused once the receive buffer is full, which leaves the
+ * next byte in the UART and deasserts RTS. The reception resumes once a quarter of the receive
+ * buffer was read. This makes the reception lossless if the remote side respects RTS.
+ * The transmission pauses while CTS is deasserted by the remote side.
+ * 
+ * @param[in] rtsPin - PinName of the RTS pin or NC to disable
+ * @param[in] ctsPin - PinName of the CTS pin or NC to disable
+ * @param[in] rtsAltFn - alternate function number of the RTS pin (see `pinMode()`)
+ * @param[in] ctsAltFn - alternate function number of the CTS pin (see `pinMode()`)
+ * @remarks Needs to be called before `begin()`.
+ */
+void HardwareSerial::setFlowControl(const PinName rtsPin, const PinName ctsPin, const uint8_t rtsAltFn, const uint8_t ctsAltFn) {
+	this->flowPins[0] = uint8_t(rtsPin);
+	this->flowPins[1] = uint8_t(ctsPin);
+	this->flowAfns = uint8_t((rtsAltFn << 4) | ctsAltFn);
+}
+
+
+#ifdef HAVE_HWSERIAL_DE
+/**
+ * Enables the hardware driver enable output for RS-485 transceivers. The UART asserts DE
+ * before the start bit of the first byte and deasserts it after the stop bit of the last byte.
+ * This turns the bus around at the exact end of the transmission without software involvement.
+ * The times are given in sample time units, i.e. 1/16 bit time with the used oversampling.
+ * 
+ * @param[in] driverEnablePin - PinName of the DE pin (same as RTS) or NC to disable
+ * @param[in] assertionTime - time between DE assertion and the start bit (0 to 31)
+ * @param[in] deassertionTime - time between the stop bit and DE deassertion (0 to 31)
+ * @param[in] deAltFn - alternate function number of the DE pin (see `pinMode()`)
+ * @remarks Needs to be called before `begin()`.
+ * @remarks The RTS output of `setFlowControl()` is not used while DE is enabled.
+ */
+void HardwareSerial::setDriverEnable(const PinName driverEnablePin, const uint8_t assertionTime, const uint8_t deassertionTime, const uint8_t deAltFn) {
+	this->dePin = uint8_t(driverEnablePin);
+	this->deAfn = deAltFn;
+	this->deTimes[0] = uint8_t(min(assertionTime, uint8_t(31)));
+	this->deTimes[1] = uint8_t(min(deassertionTime, uint8_t(31)));
+}
+#endif /* HAVE_HWSERIAL_DE */
+
+
+/**
+ * Enables the register level interrupt handler. It serves the receive, transmit and error flags
+ * directly from the UART registers instead of passing each byte through the STM32 HAL API
+ * state machine and callbacks. This reduces the interrupt load per received byte considerably.
+ * The transmission is served per byte from contiguous blocks of the transmission buffer like the
+ * block based STM32 HAL API transmission and costs about the same.
+ * 
+ * @param[in] enable - true to enable, false to use the STM32 HAL API interrupt handler
+ * @remarks Needs to be called before `begin()`.
+ * @remarks Has no effect if DMA based reception or transmission is enabled.
+ * @remarks Received bytes with parity, framing or noise error are dropped.
+ */
+void HardwareSerial::setFastIrq(const bool enable) {
+	this->fastIrq = enable;
+}
+
+
+/**
+ * Sets the function which is called from the interrupt handler once a frame was received.
+ * A frame ends if the line becomes idle for one character time or with the byte set via
+ * `setFrameDelimiter()`. The function receives the number of bytes which were added to the
+ * receive buffer since the previous frame. This allows to process complete messages of packet
+ * protocols (e.g. Modbus RTU, SLIP or NMEA) at once instead of polling for each byte.
+ * 
+ * @param[in] function - callback function or NULL to disable
+ * @remarks The callback is called from the UART or DMA interrupt context.
+ * @remarks Bytes which did not fit into the receive buffer are not counted.
+ */
+void HardwareSerial::onFrame(void (* function)(size_t)) {
+	if (this->handle->gState == HAL_UART_STATE_RESET) {
+		this->onFrameCallback = function;
+		return;
+	}
+	/* must disable interrupt to change the enabled interrupt sources */
+	HAL_NVIC_DisableIRQ(this->irq);
+	__DMB(); __DSB(); __ISB(); /* data and instruction barrier */
+	this->onFrameCallback = function;
+	this->frameStart = this->stats.rxBytes; /* the first frame starts now */
+	this->updateFrameIrqs();
+	/* enable interrupt */
+	HAL_NVIC_SetPriority(this->irq, UART_IRQ_PRIO, UART_IRQ_SUBPRIO);
+	HAL_NVIC_EnableIRQ(this->irq);
+}
+
+
+/**
+ * Sets the byte value which ends a frame in addition to the idle line (see `onFrame()`).
+ * 
+ * @param[in] delimiter - byte value (e.g. '\n') or -1 to disable
+ * @remarks Needs to be called before `begin()`.
+ * @remarks DMA based reception requires the character match feature of the UART (e.g. STM32L4).
+ * The delimiter is ignored otherwise.
+ */
+void HardwareSerial::setFrameDelimiter(const int delimiter) {
+	this->frameDelimiter = int16_t((delimiter >= 0 && delimiter <= 0xFF) ? delimiter : -1);
+}
+
+
+/**
+ * Returns the reception and transmission statistics since `begin()` or the last call to
+ * `resetStats()`. These help to find the cause of data loss, i.e. the line (parity, framing and
+ * noise errors), the interrupt latency (overrun errors) or the application (dropped bytes).
+ * 
+ * @return statistics
+ */
+HardwareSerial::Stats HardwareSerial::getStats() {
+	/* consistent copy of the values updated by the interrupt handler */
+	const uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	const Stats res = this->stats;
+	__set_PRIMASK(primask);
+	return res;
+}
+
+
+/**
+ * Resets the reception and transmission statistics.
+ */
+void HardwareSerial::resetStats() {
+	const uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	memset(&(this->stats), 0, sizeof(this->stats));
+	this->frameStart = 0;
+	__set_PRIMASK(primask);
+}
+
+
+#ifdef HAVE_HWSERIAL_DMA
+/**
+ * Enables DMA based reception. The UART streams the received data via circular DMA directly
+ * into the receive buffer. Interrupts are only raised on idle line, half and full buffer
+ * instead of for each byte. This reduces the CPU load at high baud rates considerably.
+ * 
+ * @param[in,out] instance - DMA channel/stream instance as defined by STM32 HAL API (e.g. `DMA1_Channel6`) or NULL to disable
+ * @param[in] request - DMA request or channel number for the UART RX line (e.g. `DMA_REQUEST_2`), depending on the target platform
+ * @param[in] irqNum - associated IRQ for the DMA channel/stream as defined by STM32 HAL API
+ * @remarks Needs to be called before `begin()`.
+ * @remarks The user needs to call `rxDmaIrqHandler()` from the IRQ handler of the given DMA channel/stream.
+ * @remarks Unread data is overwritten if more than the receive buffer size minus one bytes are pending.
+ * @remarks The receive buffer must not be cached by the data cache (if any).
+ */
+void HardwareSerial::setRxDma(DmaInstance instance, const uint32_t request, const IRQn_Type irqNum) {
+	this->rxDma->Instance = instance;
+	setDmaRequest(this->rxDma, request);
+	this->rxDmaIrq = irqNum;
+}
+
+
+/**
+ * Enables DMA based transmission. The contiguous part of the transmission buffer is sent
+ * via DMA at once instead of one interrupt per byte.
+ * 
+ * @param[in,out] instance - DMA channel/stream instance as defined by STM32 HAL API (e.g. `DMA1_Channel7`) or NULL to disable
+ * @param[in] request - DMA request or channel number for the UART TX line (e.g. `DMA_REQUEST_2`), depending on the target platform
+ * @param[in] irqNum - associated IRQ for the DMA channel/stream as defined by STM32 HAL API
+ * @remarks Needs to be called before `begin()`.
+ * @remarks The user needs to call `txDmaIrqHandler()` from the IRQ handler of the given DMA channel/stream.
+ * @remarks The transmission buffer must not be cached by the data cache (if any).
+ */
+void HardwareSerial::setTxDma(DmaInstance instance, const uint32_t request, const IRQn_Type irqNum) {
+	this->txDma->Instance = instance;
+	setDmaRequest(this->txDma, request);
+	this->txDmaIrq = irqNum;
+}
+#endif /* HAVE_HWSERIAL_DMA */
+
+
 /**
  * Returns the number of available bytes in the receive buffer.
  * 
  * @return number of bytes available for read
  */
 int HardwareSerial::available(void) {
+	/* the interrupt handler may have paused the reception while data was read */
+	if ( this->rxThrottled ) this->resumeRx();
 	return int(_FIFOX_SIZE(RX_QUEUE));
 }
 
@@ -686,7 +1225,7 @@ int HardwareSerial::available(void) {
 int HardwareSerial::availableForWrite(void) {
 	/* we are being pessimistic here in case of concurrent interrupts */
 	const tx_buffer_index_t tail = this->txTail;
-	return int(_FIFO_AVAILABLE(this->txBuffer, SERIAL_TX_BUFFER_SIZE, this->txHead, tail));
+	return int(_FIFO_AVAILABLE(this->txBuffer, this->txSize, this->txHead, tail));
 }
 
 
@@ -706,7 +1245,36 @@ int HardwareSerial::peek(void) {
  * @return first received byte in buffer if any, else -1
  */
 int HardwareSerial::read(void) {
-	return _FIFOX_POP(RX_QUEUE);
+	const int res = _FIFOX_POP(RX_QUEUE);
+	if ( this->rxThrottled ) this->resumeRx();
+	return res;
+}
+
+
+/**
+ * Removes up to the given number of bytes from the receive buffer. The data is copied
+ * block wise.
+ * 
+ * @param[out] buffer - output buffer
+ * @param[in] size - maximum number of bytes to read
+ * @return number of bytes read
+ */
+int HardwareSerial::read(uint8_t * buffer, size_t size) {
+	if (buffer == NULL) return 0;
+	size_t res = 0;
+	while (res < size) {
+		/* contiguous received data; the interrupt handler only advances rxHead */
+		const rx_buffer_index_t head = this->rxHead;
+		const rx_buffer_index_t tail = this->rxTail;
+		size_t len = _FIFO_BSIZE(this->rxBuffer, this->rxSize, head, tail);
+		if (len == 0) break;
+		if (len > (size - res)) len = size - res;
+		memcpy(buffer + res, this->rxBuffer + tail, len);
+		this->rxTail = rx_buffer_index_t(_FIFO_WRAP(tail + len, this->rxSize));
+		res += len;
+	}
+	if ( this->rxThrottled ) this->resumeRx();
+	return int(res);
 }
 
 
@@ -715,7 +1283,7 @@ int HardwareSerial::read(void) {
  */
 void HardwareSerial::flush(void) {
 	/* wait until the interrupt handler wrote out all data */
-	while ( ! _FIFOX_EMPTY(TX_QUEUE) );
+	while ( ! _FIFOX_EMPTY(TX_QUEUE) || this->txBusy() );
 }
 
 
@@ -726,38 +1294,53 @@ void HardwareSerial::flush(void) {
  * @return number of bytes written to the transmission queue
  */
 size_t HardwareSerial::write(const uint8_t val) {
-	bool canWait = false;
-	const bool interruptsEnabled = ((__get_PRIMASK() & 0x1) == 0);
-	if ( interruptsEnabled ) {
-		const uint32_t irqExecutionNumber = SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk;
-		if (irqExecutionNumber == 0 || NVIC_GetPriority(IRQn_Type(irqExecutionNumber - 16)) > UART_IRQ_PRIO) {
-			/* UART interrupt is enabled and we were not called from an interrupt with higher priority */
-			canWait = true;
-		}
-	}
-	if ( canWait ) {
+	if ( this->canWaitForTx() ) {
 		/* wait until space is available and add to queue */
 		_FIFOX_WPUSH(TX_QUEUE, val);
 	} else {
 		/* add to queue or fail if no space is available, because there is currently no chance to get data out */
 		if ( ! _FIFOX_PUSH(TX_QUEUE, val) ) return 0;
 	}
-	if ( this->txBusy() ) return 1;
-	/* must disable interrupt to prevent handle lock contention */
-	HAL_NVIC_DisableIRQ(this->irq);
-	__DMB(); __DSB(); __ISB(); /* data and instruction barrier */
-	const size_t blockSize = _FIFOX_BSIZE(TX_QUEUE);
-	/* ensure that we have enough space for user requests before the IRQ returns by using double buffering */
-	const tx_buffer_index_t trimmedBlockSize = tx_buffer_index_t(max(1, min(blockSize, (SERIAL_TX_BUFFER_SIZE / 2))));
-	this->txNextTail = _FIFOX_INDEX(TX_QUEUE, trimmedBlockSize);
-	HAL_UART_Transmit_IT(this->handle, this->txBuffer + this->txTail, trimmedBlockSize);
-	/* enable interrupt */
-	HAL_NVIC_SetPriority(this->irq, UART_IRQ_PRIO, UART_IRQ_SUBPRIO);
-	HAL_NVIC_EnableIRQ(this->irq);
+	this->updateTxStats();
+	this->startTx();
 	return 1;
 }
 
 
+/**
+ * Sends the given bytes. The data is copied block wise into the transmission queue.
+ * 
+ * @param[in] buffer - bytes to send
+ * @param[in] size - number of bytes to send
+ * @return number of bytes written to the transmission queue
+ */
+size_t HardwareSerial::write(const uint8_t * buffer, size_t size) {
+	if (buffer == NULL) return 0;
+	const bool canWait = this->canWaitForTx();
+	size_t res = 0;
+	while (res < size) {
+		/* contiguous free space; the interrupt handler only advances txTail */
+		const tx_buffer_index_t head = this->txHead;
+		const tx_buffer_index_t tail = this->txTail;
+		size_t len = (head >= tail) ? size_t(this->txSize - head - ((tail == 0) ? 1 : 0)) : size_t(tail - head - 1);
+		if (len == 0) {
+			/* wait until space is available or fail, because there is currently no chance to get data out */
+			if ( ! canWait ) break;
+			__WFI();
+			continue;
+		}
+		if (len > (size - res)) len = size - res;
+		memcpy(this->txBuffer + head, buffer + res, len);
+		__DMB(); /* data needs to be in memory before it is added to the queue */
+		this->txHead = tx_buffer_index_t(_FIFO_WRAP(head + len, this->txSize));
+		res += len;
+		this->updateTxStats();
+		this->startTx();
+	}
+	return res;
+}
+
+
 /**
  * Returns whether the UART is in BUSY reception state or not.
  * 
@@ -774,33 +1357,387 @@ bool HardwareSerial::rxBusy() {
  * @return true if busy, else false
  */
 bool HardwareSerial::txBusy() {
+	if ( this->fastIrqActive ) return (this->handle->Instance->CR1 & (USART_CR1_TXEIE | USART_CR1_TCIE)) != 0;
 	return ((HAL_UART_GetState(this->handle) & HAL_UART_STATE_BUSY_TX) == HAL_UART_STATE_BUSY_TX);
 }
 
 
+/**
+ * Returns whether a blocking write can wait for free space in the transmission queue. This is
+ * not possible if the UART interrupt cannot preempt the current context.
+ * 
+ * @return true if waiting is possible, else false
+ */
+bool HardwareSerial::canWaitForTx() {
+	const bool interruptsEnabled = ((__get_PRIMASK() & 0x1) == 0);
+	if ( ! interruptsEnabled ) return false;
+	const uint32_t irqExecutionNumber = SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk;
+	/* UART interrupt is enabled and we were not called from an interrupt with higher priority */
+	return irqExecutionNumber == 0 || NVIC_GetPriority(IRQn_Type(irqExecutionNumber - 16)) > UART_IRQ_PRIO;
+}
+
+
+/**
+ * Starts the interrupt based reception of the next byte. The reception is paused instead if RTS
+ * is enabled and the receive buffer is full. The UART keeps the next byte and deasserts RTS then.
+ */
+void HardwareSerial::startRx() {
+	if ((this->handle->Init.HwFlowCtl & UART_HWCONTROL_RTS) != 0 && _FIFOX_FULL(RX_QUEUE)) {
+		this->rxThrottled = true;
+		return;
+	}
+	if ( this->fastIrqActive ) {
+		/* the received bytes are pushed by `fastIrqHandler()` */
+		SET_BIT(this->handle->Instance->CR3, USART_CR3_EIE);
+		SET_BIT(this->handle->Instance->CR1, USART_CR1_RXNEIE | USART_CR1_PEIE);
+		return;
+	}
+	HAL_UART_Receive_IT(this->handle, this->recv, 1);
+}
+
+
+/**
+ * Resumes the reception paused by the hardware flow control once a quarter of the receive buffer
+ * is free. The hysteresis avoids an interrupt per read byte.
+ */
+void HardwareSerial::resumeRx() {
+	if (_FIFOX_AVAILABLE(RX_QUEUE) < max(size_t(1), size_t(this->rxSize / 4))) return;
+	/* must disable interrupt to prevent handle lock contention */
+	HAL_NVIC_DisableIRQ(this->irq);
+	__DMB(); __DSB(); __ISB(); /* data and instruction barrier */
+	this->rxThrottled = false;
+#ifdef HAVE_HWSERIAL_DMA
+	if (this->rxDma->Instance != NULL) {
+		this->startRxDma(this->rxHead);
+	} else {
+		this->startRx();
+	}
+#else /* not HAVE_HWSERIAL_DMA */
+	this->startRx();
+#endif /* not HAVE_HWSERIAL_DMA */
+	/* enable interrupt */
+	HAL_NVIC_SetPriority(this->irq, UART_IRQ_PRIO, UART_IRQ_SUBPRIO);
+	HAL_NVIC_EnableIRQ(this->irq);
+}
+
+
+/**
+ * Starts the transmission of the queued data unless a transmission is already ongoing.
+ * The transmission complete interrupt handler continues with the remaining data.
+ */
+void HardwareSerial::startTx() {
+	if ( this->txBusy() ) return;
+	/* must disable interrupt to prevent handle lock contention */
+	HAL_NVIC_DisableIRQ(this->irq);
+	__DMB(); __DSB(); __ISB(); /* data and instruction barrier */
+	/* the interrupt handler may have started the transmission in the meantime */
+	if ( ! this->txBusy() ) this->startTxBlock();
+	/* enable interrupt */
+	HAL_NVIC_SetPriority(this->irq, UART_IRQ_PRIO, UART_IRQ_SUBPRIO);
+	HAL_NVIC_EnableIRQ(this->irq);
+}
+
+
+/**
+ * Enables or disables the interrupt sources needed to detect the frame boundaries (see
+ * `onFrame()`).
+ */
+void HardwareSerial::updateFrameIrqs() {
+	const bool enable = (this->onFrameCallback != NULL);
+#ifdef HAVE_HWSERIAL_DMA
+	if (this->rxDma->Instance != NULL) {
+		/* idle line events are already part of the DMA based reception */
+#ifdef USART_CR1_CMIE
+		if (enable && this->frameDelimiter >= 0) {
+			SET_BIT(this->handle->Instance->CR1, USART_CR1_CMIE);
+		} else {
+			CLEAR_BIT(this->handle->Instance->CR1, USART_CR1_CMIE);
+		}
+#endif /* USART_CR1_CMIE */
+		return;
+	}
+#endif /* HAVE_HWSERIAL_DMA */
+	if ( enable ) {
+		SET_BIT(this->handle->Instance->CR1, USART_CR1_IDLEIE);
+	} else {
+		CLEAR_BIT(this->handle->Instance->CR1, USART_CR1_IDLEIE);
+	}
+}
+
+
+/**
+ * Counts the given reception errors.
+ * 
+ * @param[in] errorCode - STM32 HAL API UART error code (e.g. `HAL_UART_ERROR_PE`)
+ */
+void HardwareSerial::countErrors(const uint32_t errorCode) {
+	if ((errorCode & HAL_UART_ERROR_PE) != 0) this->stats.parityErrors++;
+	if ((errorCode & HAL_UART_ERROR_FE) != 0) this->stats.framingErrors++;
+	if ((errorCode & HAL_UART_ERROR_NE) != 0) this->stats.noiseErrors++;
+	if ((errorCode & HAL_UART_ERROR_ORE) != 0) this->stats.overrunErrors++;
+}
+
+
+/**
+ * Updates the reception statistics after bytes were added to the receive buffer.
+ * 
+ * @param[in] count - number of bytes added
+ */
+void HardwareSerial::updateRxStats(const uint32_t count) {
+	const rx_buffer_index_t size = rx_buffer_index_t(_FIFOX_SIZE(RX_QUEUE));
+	this->stats.rxBytes += count;
+	if (size > this->stats.rxHighWater) this->stats.rxHighWater = size;
+}
+
+
+/**
+ * Updates the transmission statistics after bytes were added to the transmission buffer.
+ */
+void HardwareSerial::updateTxStats() {
+	const tx_buffer_index_t size = tx_buffer_index_t(_FIFOX_SIZE(TX_QUEUE));
+	if (size > this->stats.txHighWater) this->stats.txHighWater = size;
+}
+
+
+/**
+ * Transmits the next contiguous block from the transmission queue.
+ */
+void HardwareSerial::startTxBlock() {
+	if ( this->fastIrqActive ) {
+		/* the queued bytes are popped by `fastIrqHandler()` */
+		if ( ! _FIFOX_EMPTY(TX_QUEUE) ) SET_BIT(this->handle->Instance->CR1, USART_CR1_TXEIE);
+		return;
+	}
+	const size_t blockSize = _FIFOX_BSIZE(TX_QUEUE);
+	if (blockSize <= 0) return;
+	/* ensure that we have enough space for user requests before the IRQ returns by using double buffering */
+	const tx_buffer_index_t trimmedBlockSize = tx_buffer_index_t(max(size_t(1), min(blockSize, size_t(this->txSize / 2))));
+	this->txNextTail = _FIFOX_INDEX(TX_QUEUE, trimmedBlockSize);
+#ifdef HAVE_HWSERIAL_DMA
+	if (this->txDma->Instance != NULL) {
+		HAL_UART_Transmit_DMA(this->handle, this->txBuffer + this->txTail, trimmedBlockSize);
+		return;
+	}
+#endif /* HAVE_HWSERIAL_DMA */
+	HAL_UART_Transmit_IT(this->handle, this->txBuffer + this->txTail, trimmedBlockSize);
+}
+
+
+/**
+ * Interrupt handler which detects the frame boundaries around the actual interrupt handler
+ * (see `onFrame()`).
+ */
+void HardwareSerial::frameIrqHandler() {
+	USART_TypeDef * regs = this->handle->Instance;
+	const uint32_t sr = HWSERIAL_SR(regs);
+	const uint32_t cr1 = regs->CR1;
+	/* the line became idle after the received data */
+	const bool idle = (sr & UART_FLAG_IDLE) != 0 && (cr1 & USART_CR1_IDLEIE) != 0;
+#if defined(HAVE_HWSERIAL_DMA) && defined(USART_CR1_CMIE)
+	if ((sr & UART_FLAG_CMF) != 0 && (cr1 & USART_CR1_CMIE) != 0) {
+		/* the frame delimiter was received and transferred via DMA */
+		__HAL_UART_CLEAR_FLAG(this->handle, UART_CLEAR_CMF);
+		this->rxEventHandler(uint16_t(this->handle->RxXferSize - __HAL_DMA_GET_COUNTER(this->rxDma)));
+		this->frameHandler();
+	}
+#endif /* HAVE_HWSERIAL_DMA and USART_CR1_CMIE */
+	if ( this->fastIrqActive ) {
+		this->fastIrqHandler();
+	} else {
+		HAL_UART_IRQHandler(this->handle);
+	}
+#ifndef USART_ISR_PE
+	if ((sr & UART_FLAG_RXNE) != 0 && (cr1 & USART_CR1_RXNEIE) != 0 && (cr1 & USART_CR1_IDLEIE) == 0) {
+		/* the data register was read which cleared IDLE; resume the idle line detection paused below */
+		SET_BIT(regs->CR1, USART_CR1_IDLEIE);
+	}
+#endif /* not USART_ISR_PE */
+	if ( ! idle ) return;
+	/* already cleared by the STM32 HAL API for DMA based reception */
+	if ((HWSERIAL_SR(regs) & UART_FLAG_IDLE) != 0) {
+#ifdef USART_ISR_PE
+		__HAL_UART_CLEAR_IDLEFLAG(this->handle);
+#else /* not USART_ISR_PE */
+		/* reading DR to clear IDLE would drop the byte kept while RTS pauses the reception or one received in the meantime */
+		/* the idle line interrupt is paused instead until the next byte was read */
+		if ((regs->CR3 & USART_CR3_DMAR) == 0) CLEAR_BIT(regs->CR1, USART_CR1_IDLEIE);
+#endif /* not USART_ISR_PE */
+	}
+	this->frameHandler();
+}
+
+
+/**
+ * Register level interrupt handler for interrupt based reception and transmission (see
+ * `setFastIrq()`). Each byte is transferred directly between the UART data register and the
+ * circular buffer. The transmission complete interrupt is only used after the last byte.
+ */
+void HardwareSerial::fastIrqHandler() {
+	USART_TypeDef * regs = this->handle->Instance;
+	const uint32_t sr = HWSERIAL_SR(regs);
+	const uint32_t cr1 = regs->CR1;
+	uint32_t errors = sr & (UART_FLAG_PE | UART_FLAG_FE | UART_FLAG_NE | UART_FLAG_ORE);
+	if ((sr & UART_FLAG_RXNE) != 0 && (cr1 & USART_CR1_RXNEIE) != 0) {
+		/* reading the data register clears RXNE */
+		const uint8_t val = uint8_t(HWSERIAL_RDR(regs) & this->rxMask);
+		/* drop corrupted data; on overrun the data register still holds valid data */
+		if ((errors & (UART_FLAG_PE | UART_FLAG_FE | UART_FLAG_NE)) == 0) {
+			if ( _FIFOX_PUSH(RX_QUEUE, val) ) {
+				this->updateRxStats(1);
+				if (int(val) == this->frameDelimiter) this->frameHandler();
+			} else {
+				this->stats.rxDropped++;
+			}
+		}
+		if ((this->handle->Init.HwFlowCtl & UART_HWCONTROL_RTS) != 0 && _FIFOX_FULL(RX_QUEUE)) {
+			/* pause; the UART keeps the next byte and deasserts RTS (see `resumeRx()`) */
+			CLEAR_BIT(regs->CR1, USART_CR1_RXNEIE | USART_CR1_PEIE);
+			this->rxThrottled = true;
+		}
+	}
+#ifndef USART_ISR_PE
+	else {
+		/* the flags belong to the byte kept by the UART; they are counted once it was read */
+		errors = 0;
+	}
+#endif /* not USART_ISR_PE */
+	if (errors != 0) {
+		this->countErrors(
+			((errors & UART_FLAG_PE) ? HAL_UART_ERROR_PE : 0)
+			| ((errors & UART_FLAG_FE) ? HAL_UART_ERROR_FE : 0)
+			| ((errors & UART_FLAG_NE) ? HAL_UART_ERROR_NE : 0)
+			| ((errors & UART_FLAG_ORE) ? HAL_UART_ERROR_ORE : 0)
+		);
+#ifdef USART_ISR_PE
+		/* a single write to the interrupt flag clear register; does not touch the received data */
+		__HAL_UART_CLEAR_FLAG(this->handle, UART_CLEAR_PEF | UART_CLEAR_FEF | UART_CLEAR_NEF | UART_CLEAR_OREF);
+#else /* not USART_ISR_PE */
+		/* already cleared by reading the status register followed by the data register */
+#endif /* not USART_ISR_PE */
+	}
+	if ((sr & UART_FLAG_TXE) != 0 && (cr1 & USART_CR1_TXEIE) != 0) {
+		tx_buffer_index_t tail = this->txTail;
+		tx_buffer_index_t blockEnd = this->txNextTail;
+		if (tail == blockEnd) {
+			/* continue with the next contiguous block; counted once per block instead of per byte */
+			const size_t len = _FIFO_BSIZE(this->txBuffer, this->txSize, this->txHead, tail);
+			this->stats.txBytes += uint32_t(len);
+			blockEnd = tx_buffer_index_t(tail + len);
+			this->txNextTail = blockEnd;
+		}
+		if (tail != blockEnd) {
+			/* writing the data register clears TXE */
+			HWSERIAL_TDR(regs) = this->txBuffer[tail];
+			tail++;
+			if (tail >= this->txSize) {
+				/* blocks end at the buffer end */
+				tail = 0;
+				this->txNextTail = 0;
+			}
+			this->txTail = tail;
+		} else {
+			/* wait until the last byte was shifted out (see `flush()`) */
+			CLEAR_BIT(regs->CR1, USART_CR1_TXEIE);
+			SET_BIT(regs->CR1, USART_CR1_TCIE);
+		}
+	}
+	if ((sr & UART_FLAG_TC) != 0 && (regs->CR1 & USART_CR1_TCIE) != 0) {
+		CLEAR_BIT(regs->CR1, USART_CR1_TCIE);
+		/* continue with the data queued in the meantime */
+		if ( ! _FIFOX_EMPTY(TX_QUEUE) ) SET_BIT(regs->CR1, USART_CR1_TXEIE);
+	}
+}
+
+
+/**
+ * Reports the frame received since the previous frame boundary, if any (see `onFrame()`).
+ */
+void HardwareSerial::frameHandler() {
+	const uint32_t length = this->stats.rxBytes - this->frameStart;
+	if (length == 0 || this->onFrameCallback == NULL) return;
+	this->frameStart = this->stats.rxBytes;
+	this->onFrameCallback(size_t(length));
+}
+
+
 /**
  * Reception complete interrupt handler.
  */
 void HardwareSerial::rxCompleteHandler() {
 	if ( this->rxBusy() ) return; /* transaction ongoing */
 	/* no parity error */
-	_FIFOX_PUSH(RX_QUEUE, *(this->recv));
+	if ( _FIFOX_PUSH(RX_QUEUE, *(this->recv)) ) {
+		this->updateRxStats(1);
+		if (int(*(this->recv)) == this->frameDelimiter) this->frameHandler();
+	} else {
+		this->stats.rxDropped++;
+	}
 	/* receive next byte */
-	HAL_UART_Receive_IT(this->handle, this->recv, 1);
+	this->startRx();
 }
 
 
+#ifdef HAVE_HWSERIAL_DMA
+/**
+ * Starts the DMA based reception at the given receive buffer position. The DMA runs in circular
+ * mode over the whole buffer if started at position 0. Otherwise, a single transfer until the
+ * end of the buffer is started first to keep the DMA position in sync with `rxHead`. This is
+ * needed to resume reception after it was aborted (e.g. due to a reception error).
+ * With RTS enabled, single transfers are used which cover only the free space. The reception is
+ * paused if there is none. The UART keeps the next byte and deasserts RTS then.
+ * 
+ * @param[in] pos - receive buffer position
+ */
+void HardwareSerial::startRxDma(const rx_buffer_index_t pos) {
+	uint32_t mode = (pos == 0) ? DMA_CIRCULAR : DMA_NORMAL;
+	uint16_t size = uint16_t(this->rxSize - pos);
+	if ((this->handle->Init.HwFlowCtl & UART_HWCONTROL_RTS) != 0) {
+		const rx_buffer_index_t tail = this->rxTail;
+		mode = DMA_NORMAL;
+		size = uint16_t((pos >= tail) ? (this->rxSize - pos - ((tail == 0) ? 1 : 0)) : (tail - pos - 1));
+		if (size == 0) {
+			this->rxThrottled = true;
+			return;
+		}
+	}
+	if (this->rxDma->Init.Mode != mode) {
+		HAL_DMA_DeInit(this->rxDma);
+		this->rxDma->Init.Mode = mode;
+		HAL_DMA_Init(this->rxDma);
+	}
+	this->rxDmaStart = pos;
+	HAL_UARTEx_ReceiveToIdle_DMA(this->handle, this->rxBuffer + pos, size);
+}
+
+
+/**
+ * Reception event interrupt handler for DMA based reception.
+ * The data is already in the receive buffer. Only the head index needs to be advanced.
+ * 
+ * @param[in] size - number of bytes received since the start of the DMA transfer
+ */
+void HardwareSerial::rxEventHandler(const uint16_t size) {
+	const uint32_t pos = uint32_t(this->rxDmaStart) + size;
+	const rx_buffer_index_t head = rx_buffer_index_t((pos < this->rxSize) ? pos : 0);
+	const uint32_t count = uint32_t(_FIFO_WRAP(head + this->rxSize - this->rxHead, this->rxSize));
+	const uint32_t available = uint32_t(_FIFOX_AVAILABLE(RX_QUEUE));
+	/* the DMA overwrote unread data */
+	if (count > available) this->stats.rxDropped += count - available;
+	this->rxHead = head;
+	this->updateRxStats(count);
+	/* non-circular transfers end at the buffer end or idle line */
+	if ( ! this->rxBusy() ) this->startRxDma(this->rxHead);
+}
+#endif /* HAVE_HWSERIAL_DMA */
+
+
 /**
  * Transmission complete interrupt handler.
  */
 void HardwareSerial::txCompleteHandler() {
+	this->stats.txBytes += uint32_t(_FIFO_WRAP(this->txNextTail + this->txSize - this->txTail, this->txSize));
 	this->txTail = this->txNextTail;
-	const size_t blockSize = _FIFOX_BSIZE(TX_QUEUE);
-	if (blockSize <= 0) return;
-	/* ensure that we have enough space for user requests before the IRQ returns by using double buffering */
-	const tx_buffer_index_t trimmedBlockSize = tx_buffer_index_t(max(1, min(blockSize, (SERIAL_TX_BUFFER_SIZE / 2))));
-	this->txNextTail = _FIFOX_INDEX(TX_QUEUE, trimmedBlockSize);
-	HAL_UART_Transmit_IT(this->handle, this->txBuffer + this->txTail, trimmedBlockSize);
+	this->startTxBlock();
 }
 
 
@@ -1,9 +1,9 @@
 /**
  * @file HardwareSerial.h
  * @author Daniel Starke
- * @copyright Copyright 2020-2022 Daniel Starke
+ * @copyright Copyright 2020-2026 Daniel Starke
  * @date 2020-05-12
- * @version 2022-10-06
+ * @version 2026-10-17
  */
 #ifndef __HARDWARESERIAL_H__
 #define __HARDWARESERIAL_H__
@@ -41,57 +41,158 @@
 #ifndef SERIAL_TX_BUFFER_SIZE
 #define SERIAL_TX_BUFFER_SIZE 64
 #endif
-typedef typename _FifoIndexTypeFor<SERIAL_RX_BUFFER_SIZE>::type rx_buffer_index_t;
-typedef typename _FifoIndexTypeFor<SERIAL_TX_BUFFER_SIZE>::type tx_buffer_index_t;
+/* buffer sizes can be set per instance at runtime (see `setRxBufferSize()` and `setTxBufferSize()`) */
+/* a size of 0 removes the embedded buffers; each instance needs user storage or a set buffer size then */
+typedef uint16_t rx_buffer_index_t;
+typedef uint16_t tx_buffer_index_t;
 
 
 #define HAVE_HWSERIAL0
+#if defined(IS_DMA_MODE) && defined(HAL_UART_RECEPTION_TOIDLE) /* STM32 HAL DMA header was included and UART supports reception till idle */
+#define HAVE_HWSERIAL_DMA
+#endif /* IS_DMA_MODE and HAL_UART_RECEPTION_TOIDLE */
+#ifdef USART_CR3_DEM /* UART supports driver enable output for RS-485 */
+#define HAVE_HWSERIAL_DE
+#endif /* USART_CR3_DEM */
 
 
 class HardwareSerial : public Stream {
 private:
+	friend void hardwareSerialIrqHandler(UART_HandleTypeDef *);
 	friend void HAL_UART_RxCpltCallback(UART_HandleTypeDef *);
 	friend void HAL_UART_TxCpltCallback(UART_HandleTypeDef *);
 	friend void HAL_UART_ErrorCallback(UART_HandleTypeDef *);
+#ifdef HAVE_HWSERIAL_DMA
+	friend void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *, uint16_t);
+#endif /* HAVE_HWSERIAL_DMA */
+public:
+	/** Reception and transmission statistics (see `getStats()`). */
+	struct Stats {
+		uint32_t rxBytes; /**< bytes added to the receive buffer */
+		uint32_t txBytes; /**< bytes passed from the transmission buffer to the UART */
+		uint32_t parityErrors;
+		uint32_t framingErrors;
+		uint32_t noiseErrors;
+		uint32_t overrunErrors; /**< bytes lost in the UART due to interrupt latency */
+		uint32_t rxDropped; /**< bytes lost due to a full receive buffer */
+		uint16_t rxHighWater; /**< maximum number of bytes in the receive buffer */
+		uint16_t txHighWater; /**< maximum number of bytes in the transmission buffer */
+	};
 protected:
 	/** @remarks UART is a subset of USART. Only UART functionality is needed here and only used as such to simplify design. */
 	UART_HandleTypeDef handle[1];
 	IRQn_Type irq;
 	uint8_t pins[2];
 	uint8_t afns;
+	uint8_t flowPins[2]; /**< RTS and CTS pin */
+	uint8_t flowAfns;
+#ifdef HAVE_HWSERIAL_DE
+	uint8_t dePin; /**< RS-485 driver enable pin */
+	uint8_t deAfn;
+	uint8_t deTimes[2]; /**< assertion and deassertion time in sample time units */
+#endif /* HAVE_HWSERIAL_DE */
+	uint8_t rxMask; /**< data bits of a received byte */
+	bool fastIrq; /**< register level interrupt handler requested (see `setFastIrq()`) */
+	bool fastIrqActive; /**< register level interrupt handler in use */
 	uint8_t recv[1];
+#ifdef HAVE_HWSERIAL_DMA
+	DMA_HandleTypeDef rxDma[1];
+	IRQn_Type rxDmaIrq;
+	rx_buffer_index_t rxDmaStart; /**< receive buffer position of the current DMA transfer */
+	DMA_HandleTypeDef txDma[1];
+	IRQn_Type txDmaIrq;
+#endif /* HAVE_HWSERIAL_DMA */
 	rx_buffer_index_t rxTail;
 	volatile rx_buffer_index_t rxHead;
+	volatile bool rxThrottled; /**< reception paused by the hardware flow control */
 	volatile tx_buffer_index_t txNextTail;
 	volatile tx_buffer_index_t txTail;
 	tx_buffer_index_t txHead;
-	uint8_t rxBuffer[SERIAL_RX_BUFFER_SIZE];
-	uint8_t txBuffer[SERIAL_TX_BUFFER_SIZE];
+	rx_buffer_index_t rxSize;
+	tx_buffer_index_t txSize;
+	uint8_t ownBuffers; /**< buffers allocated by this instance (see `OWN_RX_BUFFER` and `OWN_TX_BUFFER`) */
+	uint8_t * rxBuffer;
+	uint8_t * txBuffer;
+#if SERIAL_RX_BUFFER_SIZE > 0
+	uint8_t rxDefault[SERIAL_RX_BUFFER_SIZE]; /**< used unless user storage or another size was set */
+#endif /* SERIAL_RX_BUFFER_SIZE > 0 */
+#if SERIAL_TX_BUFFER_SIZE > 0
+	uint8_t txDefault[SERIAL_TX_BUFFER_SIZE]; /**< used unless user storage or another size was set */
+#endif /* SERIAL_TX_BUFFER_SIZE > 0 */
+	Stats stats;
+	void (* onFrameCallback)(size_t);
+	int16_t frameDelimiter; /**< byte value which ends a frame or -1 */
+	uint32_t frameStart; /**< value of `stats.rxBytes` at the start of the current frame */
 public:
+#ifdef HAVE_HWSERIAL_DMA
+	typedef decltype(DMA_HandleTypeDef::Instance) DmaInstance;
+#endif /* HAVE_HWSERIAL_DMA */
+	
 	HardwareSerial(USART_TypeDef * instance, const IRQn_Type irqNum, const PinName rxPin, const PinName txPin, const uint8_t rxAltFn = 0, const uint8_t txAltFn = 0);
+	HardwareSerial(USART_TypeDef * instance, const IRQn_Type irqNum, const PinName rxPin, const PinName txPin, const uint8_t rxAltFn, const uint8_t txAltFn, uint8_t * rxStorage, const size_t rxStorageSize, uint8_t * txStorage, const size_t txStorageSize); /* STM32 specific */
 	virtual ~HardwareSerial();
 	
 	void begin(const unsigned long baudrate) { this->begin(baudrate, SERIAL_8N1); }
 	void begin(const unsigned long baudrate, const uint8_t mode) { this->begin(baudrate, mode, HAL_UART_Init); }
 	void begin(const unsigned long baudrate, const uint8_t mode, HAL_StatusTypeDef (& initFn)(UART_HandleTypeDef * hUart)); /* STM32 specific */
 	void end();
+	size_t setRxBufferSize(const size_t size);
+	size_t setTxBufferSize(const size_t size);
+	void setFlowControl(const PinName rtsPin, const PinName ctsPin, const uint8_t rtsAltFn = 0, const uint8_t ctsAltFn = 0); /* STM32 specific */
+#ifdef HAVE_HWSERIAL_DE
+	void setDriverEnable(const PinName driverEnablePin, const uint8_t assertionTime = 0, const uint8_t deassertionTime = 0, const uint8_t deAltFn = 0); /* STM32 specific */
+#endif /* HAVE_HWSERIAL_DE */
+	void setFastIrq(const bool enable); /* STM32 specific */
+	void onFrame(void (* function)(size_t)); /* STM32 specific */
+	void setFrameDelimiter(const int delimiter); /* STM32 specific */
+	Stats getStats(); /* STM32 specific */
+	void resetStats(); /* STM32 specific */
+#ifdef HAVE_HWSERIAL_DMA
+	void setRxDma(DmaInstance instance, const uint32_t request, const IRQn_Type irqNum); /* STM32 specific */
+	void rxDmaIrqHandler() { HAL_DMA_IRQHandler(this->rxDma); } /* STM32 specific */
+	void setTxDma(DmaInstance instance, const uint32_t request, const IRQn_Type irqNum); /* STM32 specific */
+	void txDmaIrqHandler() { HAL_DMA_IRQHandler(this->txDma); } /* STM32 specific */
+#endif /* HAVE_HWSERIAL_DMA */
 	
 	virtual int available(void);
 	virtual int availableForWrite(void);
 	virtual int peek(void);
 	virtual int read(void);
+	virtual int read(uint8_t * buffer, size_t size);
 	virtual void flush(void);
 	virtual size_t write(const uint8_t val);
+	virtual size_t write(const uint8_t * buffer, size_t size);
 	
 	operator bool() { return true; }
 	
 	using Print::write;
 private:
+	enum {
+		OWN_RX_BUFFER = 0x01,
+		OWN_TX_BUFFER = 0x02
+	};
+	
 	bool rxBusy();
 	bool txBusy();
+	bool canWaitForTx();
+	void startRx();
+	void resumeRx();
+	void startTx();
+	void startTxBlock();
+	void countErrors(const uint32_t errorCode);
+	void updateRxStats(const uint32_t count);
+	void updateTxStats();
+	void updateFrameIrqs();
 	/* interrupt handlers */
+	void frameIrqHandler();
+	void fastIrqHandler();
+	void frameHandler();
 	void rxCompleteHandler();
 	void txCompleteHandler();
+#ifdef HAVE_HWSERIAL_DMA
+	void startRxDma(const rx_buffer_index_t pos);
+	void rxEventHandler(const uint16_t size);
+#endif /* HAVE_HWSERIAL_DMA */
 };
 
 
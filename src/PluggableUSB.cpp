@@ -1,9 +1,9 @@
 /**
  * @file PluggableUSB.cpp
  * @author Daniel Starke
- * @copyright Copyright 2020-2022 Daniel Starke
+ * @copyright Copyright 2020-2026 Daniel Starke
  * @date 2020-05-21
- * @version 2022-03-22
+ * @version 2026-10-17
  */
 #include "Arduino.h"
 #include "PluggableUSB.h"
@@ -35,7 +35,18 @@ PluggableUSB_::PluggableUSB_():
  */
 bool PluggableUSB_::plug(PluggableUSBModule * node) {
 	/* maximum number of endpoints or dedicated USB memory reached? */
+#ifdef USB_HS
+	if ((this->lastEp + node->numEndpoints) > USB_ENDPOINTS) return false;
+	/* the USB OTG HS FIFO memory is partitioned statically with one TX FIFO per IN endpoint (see USB_TX_FIFO_SIZE) */
+	uint32_t fifoSize = uint32_t(USB_RX_FIFO_SIZE + USB_TX_FIFO_SIZE(0));
+	for (uint8_t i = 1; i < (this->lastEp + node->numEndpoints); i++) {
+		const uint8_t config = (i < this->lastEp) ? _usbEndpoints[i] : node->endpointType[i - this->lastEp];
+		if ((config & USB_ENDPOINT_DIRECTION_MASK) == USB_ENDPOINT_IN(0)) fifoSize += USB_TX_FIFO_SIZE(i);
+	}
+	if (fifoSize > USB_FIFO_MEM_SIZE) return false;
+#else /* not USB_HS */
 	if ((this->lastEp + node->numEndpoints) > USB_ENDPOINTS || (((this->lastEp + node->numEndpoints) * USB_EP_SIZE) + 64) > USB_PMASIZE) return false;
+#endif /* not USB_HS */
 
 	/* get last node */
 	if (this->rootNode == NULL) {
@@ -119,6 +130,29 @@ uint8_t PluggableUSB_::getShortName(char * iSerialNum) {
 }
 
 
+/**
+ * Checks whether any plugged node needs to be called on each start of frame.
+ * 
+ * @return true if start of frame events are needed, else false
+ */
+bool PluggableUSB_::handlesSof() {
+	for (PluggableUSBModule * node = this->rootNode; node != NULL; node = node->next) {
+		if ( node->handlesSof ) return true;
+	}
+	return false;
+}
+
+
+/**
+ * Calls the start of frame handler of each plugged node which requested it.
+ */
+void PluggableUSB_::sof() {
+	for (PluggableUSBModule * node = this->rootNode; node != NULL; node = node->next) {
+		if ( node->handlesSof ) node->sof();
+	}
+}
+
+
 /**
  * Replacement for global singleton to prevent static initialization issues.
  * 
@@ -1,9 +1,9 @@
 /**
  * @file PluggableUSB.h
  * @author Daniel Starke
- * @copyright Copyright 2020 Daniel Starke
+ * @copyright Copyright 2020-2026 Daniel Starke
  * @date 2020-05-21
- * @version 2020-06-21
+ * @version 2026-10-17
  */
 #ifndef __PLUGGABLEUSB_H__
 #define __PLUGGABLEUSB_H__
@@ -26,6 +26,7 @@ protected:
 	const uint8_t numInterfaces;
 	const uint8_t * endpointType; /**< @warning Pointer type is compatible to AVR Arduino, not SAMD Arduino. */
 	PluggableUSBModule * next = NULL;
+	bool handlesSof = false; /**< STM32 specific: set to true to get sof() called */
 public:
 	PluggableUSBModule(const uint8_t numEps, const uint8_t numIfs, const uint8_t * epType):
 		numEndpoints(numEps),
@@ -41,6 +42,8 @@ protected:
 		name[0] = char('A' + this->pluggedInterface);
 		return 1;
 	}
+	/* STM32 specific: called from the USB interrupt on each start of frame if handlesSof is set */
+	virtual void sof() {}
 };
 
 
@@ -57,6 +60,8 @@ public:
 	int getDescriptor(USBSetup & setup);
 	bool setup(USBSetup & setup);
 	uint8_t getShortName(char * iSerialNum);
+	bool handlesSof(); /* STM32 specific */
+	void sof(); /* STM32 specific */
 };
 
 
@@ -1,9 +1,9 @@
 /**
  * @file Stream.cpp
  * @author Daniel Starke
- * @copyright Copyright 2019-2022 Daniel Starke
+ * @copyright Copyright 2019-2026 Daniel Starke
  * @date 2019-03-10
- * @version 2022-04-17
+ * @version 2026-10-17
  */
 #include "Arduino.h"
 #include "Stream.h"
@@ -168,29 +168,56 @@ float Stream::parseFloat(LookaheadMode lookahead, char ignore) {
 }
 
 
-size_t Stream::readBytes(char * buffer, size_t length) {
+int Stream::read(uint8_t * buffer, size_t size) {
 	size_t count = 0;
-	for (; count < length; count++) {
-		const int c = this->timedRead();
+	for (; count < size; count++) {
+		const int c = this->read();
 		if (c < 0) break;
-		*buffer++ = static_cast<char>(c);
+		buffer[count] = static_cast<uint8_t>(c);
 	}
-	return count;
+	return static_cast<int>(count);
+}
+
+
+size_t Stream::readBytes(char * buffer, size_t length) {
+	return this->readBytes(reinterpret_cast<uint8_t *>(buffer), length);
 }
 
 
 size_t Stream::readBytes(uint8_t * buffer, size_t length) {
-	return this->readBytes(reinterpret_cast<char *>(buffer), length);
+	/* the timeout applies between received bytes like in `timedRead()` */
+	size_t count = 0;
+	this->_startMillis = millis();
+	while (count < length) {
+		const int len = this->read(buffer + count, length - count);
+		if (len > 0) {
+			count += static_cast<size_t>(len);
+			this->_startMillis = millis();
+		} else if ((millis() - this->_startMillis) >= this->_timeout) {
+			break;
+		}
+	}
+	return count;
 }
 
 
 size_t Stream::readBytesUntil(char terminator, char * buffer, size_t length) {
-	if (length < 1) return 0;
+	/* Read byte by byte to leave the data after the terminator in the stream.
+	 * The timeout start is only updated once no more data is available. */
 	size_t index = 0;
-	for (; index < length; index++) {
-		const int c = this->timedRead();
-		if (c < 0 || c == terminator) break;
-		*buffer++ = static_cast<char>(c);
+	size_t lastIndex = 0;
+	this->_startMillis = millis();
+	while (index < length) {
+		const int c = this->read();
+		if (c >= 0) {
+			if (c == static_cast<uint8_t>(terminator)) break;
+			buffer[index++] = static_cast<char>(c);
+		} else if (index != lastIndex) {
+			lastIndex = index;
+			this->_startMillis = millis();
+		} else if ((millis() - this->_startMillis) >= this->_timeout) {
+			break;
+		}
 	}
 	return index;
 }
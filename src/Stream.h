@@ -1,9 +1,9 @@
 /**
  * @file Stream.h
  * @author Daniel Starke
- * @copyright Copyright 2019-2022 Daniel Starke
+ * @copyright Copyright 2019-2026 Daniel Starke
  * @date 2019-03-10
- * @version 2022-04-17
+ * @version 2026-10-17
  */
 #ifndef __STREAM_H__
 #define __STREAM_H__
@@ -36,6 +36,7 @@ public:
 
 	virtual int available(void) = 0;
 	virtual int read(void) = 0;
+	virtual int read(uint8_t * buffer, size_t size);
 	virtual int peek(void) = 0;
 
 	void setTimeout(unsigned long timeout);
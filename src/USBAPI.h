@@ -1,9 +1,9 @@
 /**
  * @file USBAPI.h
  * @author Daniel Starke
- * @copyright Copyright 2020 Daniel Starke
+ * @copyright Copyright 2020-2026 Daniel Starke
  * @date 2020-05-21
- * @version 2022-09-17
+ * @version 2026-10-17
  */
 #ifndef __USBAPI_H__
 #define __USBAPI_H__
@@ -11,7 +11,9 @@
 
 #ifndef USB_EP_SIZE
 /** Defines the endpoint size. */
-#if (defined(STM32L1) || defined(STM32F1) || defined(STM32F3))
+#if defined(USB_HS)
+#define USB_EP_SIZE 512
+#elif (defined(STM32L1) || defined(STM32F1) || defined(STM32F3))
 #define USB_EP_SIZE 32
 #else
 #define USB_EP_SIZE 64
@@ -20,9 +22,15 @@
 #if (USB_EP_SIZE & 0x0F) != 0
 #error USB_EP_SIZE needs to be a multiple of 16.
 #endif
-#if USB_EP_SIZE >= 256
+#ifdef USB_HS
+#if USB_EP_SIZE > 512
+#error USB_EP_SIZE is too large.
+#endif
+#elif USB_EP_SIZE >= 256
 #error USB_EP_SIZE is too large.
 #endif
+/** Defines the control endpoint size. Bulk endpoints are limited to this size in full speed mode. */
+#define USB_EP0_SIZE ((USB_EP_SIZE > 64) ? 64 : USB_EP_SIZE)
 #if (defined(STM32L1) || defined(STM32F1) || defined(STM32F3))
 #if USB_EP_SIZE > 48
 #ifndef STM32CUBEDUINO_DISABLE_USB_CDC
@@ -102,6 +110,9 @@ public:
 	bool sendStringDescriptor(const uint8_t * string, uint32_t maxLen);
 	uint8_t SendInterfaces(uint32_t * total);
 	void packMessages(bool val);
+	bool isHighSpeed(); /* STM32 specific */
+	uint16_t bulkPacketSize(); /* STM32 specific */
+	uint8_t pollInterval(uint8_t ms); /* STM32 specific */
 
 	/* generic endpoint API */
 	void initEndpoints(void);
@@ -109,8 +120,13 @@ public:
 
 	uint32_t send(uint32_t ep, const void * data, uint32_t len);
 	void sendZlp(uint32_t ep);
+	bool sendPacket(uint32_t ep, const void * data, uint32_t len); /* STM32 specific */
+	uint8_t * reserve(uint32_t ep, uint32_t len, uint32_t & outLen); /* STM32 specific */
+	uint32_t commit(uint32_t ep, uint32_t len); /* STM32 specific */
 	uint32_t recv(uint32_t ep, void * data, uint32_t len);
 	int recv(uint32_t ep);
+	const uint8_t * peek(uint32_t ep, uint32_t & outLen); /* STM32 specific */
+	void consume(uint32_t ep, uint32_t len); /* STM32 specific */
 	uint32_t available(uint32_t ep);
 	void flush(uint32_t ep);
 	void clear(uint32_t ep);
@@ -1,9 +1,9 @@
 /**
  * @file USBCore.cpp
  * @author Daniel Starke
- * @copyright Copyright 2020-2022 Daniel Starke
+ * @copyright Copyright 2020-2026 Daniel Starke
  * @date 2020-05-21
- * @version 2023-09-25
+ * @version 2026-10-17
  * 
  * Control Endpoint:
  * @verbatim
@@ -46,18 +46,29 @@
  * That means that both transmit exactly one USB data packet at a time and need to be called again for the next one. The size may be less than
  * USB_EP_SIZE for HAL_PCD_EP_Transmit() but not for HAL_PCD_EP_Receive(). Providing a buffer less than USB_EP_SIZE for HAL_PCD_EP_Receive() may
  * result in a buffer overrun. I.e. data after the buffer will be overwritten. Hence, the reception procedure requires 3 buffer: the device internal
- * dedicated reception buffer, the internal packet reception buffer and the FIFO to the upper Arduino API layer.
+ * dedicated reception buffer, the internal packet reception buffer and the FIFO to the upper Arduino API layer. The packet reception buffer
+ * is skipped if the FIFO provides enough contiguous space for a full packet (see _FifoClass::reserve()). Both are skipped if the application
+ * requests at least USB_EP_SIZE bytes while the FIFO is empty. The reception is then redirected to the buffer of the application
+ * (see USBDeviceClass::recv()).
  * @remarks PMA memory is 32 bit aligned in general and 32 byte aligned for the packet buffers. Each 32 bit contain 16 bit of data. Each endpoint is
  * handled using four 16 bit values. That means 16 byte of data (32 byte in memory) are necessary for each endpoint (including IN and OUT). Hence, for
  * an MCU with 512 byte PMA memory (e.g. STM32F103, see UM0424) the highest endpoint number is 4 using 64 byte buffer per endpoint. USB CDC + HID is
  * not possible in this configuration.
+ * @remarks Bulk endpoints get a second packet buffer in the PMA if USB_DBL_BUF is defined. The host can then transfer the next packet while the
+ * other one is processed. The second buffers are placed behind the single buffers of all endpoints (see usbDblBufPmaAddr()). The endpoint falls
+ * back to a single buffer if the PMA size (USB_PMASIZE) is insufficient.
  * @remarks HAL PCD handles endpoint transmission states in internal structures for IN and OUT that all contain the fields xfer_count, xfer_buff and
  * xfer_len. Handling of these fields is not consistent between the various STM32 series and HAL versions which makes it impossible to rely on those
  * to save some memory. The internal variables bytesPendingEp and bufferPtrEp are introduces instead.
  * @see https://higaski.at/custom-class-for-stm32-usb-device-library/
  * @see https://www.st.com/resource/en/user_manual/dm00108129-stm32cube-usb-device-library-stmicroelectronics.pdf
  * @remarks Note bug for PMA handling in STM32F1 https://community.st.com/s/question/0D50X00009XkXLz
- * @remarks USB HS is currently not supported.
+ * @remarks The USB OTG HS peripheral can be used in full speed mode with its embedded PHY by defining USB_USE_OTG_HS. USB HS with
+ * 512 byte bulk packets is enabled by additionally defining USB_HS. This requires the internal UTMI PHY or an external ULPI PHY
+ * (USB_HS_ULPI). The bulk endpoints fall back to 64 bytes if the host enumerates the device in full speed mode.
+ * @remarks The internal DMA of the USB OTG HS peripheral is enabled by defining USB_DMA. All packets are then received into the cache line
+ * aligned packet reception buffers. The data cache needs to be disabled via D_CACHE_DISABLED if present, because the USB DMA also writes
+ * the setup packets into the PCD handle of the STM32 HAL.
  */
 #include "Arduino.h"
 #include "PluggableUSB.h"
@@ -135,6 +146,50 @@
 #endif
 
 
+#ifdef USB_HS
+#ifndef USB_USE_OTG_HS
+#error USB_HS requires USB_USE_OTG_HS.
+#endif
+#ifndef USB_TX_TRANSACTIONAL
+#error USB_HS requires an STM32 HAL with multi-packet USB transactions (see USB_TX_TRANSACTIONAL).
+#endif
+#if !defined(USB_HS_ULPI) && !defined(USB_HS_PHYC)
+#error USB_HS requires an external ULPI PHY (USB_HS_ULPI) on this target.
+#endif
+#endif /* USB_HS */
+
+
+#if defined(USB_DMA) && !defined(USB_USE_OTG_HS)
+#error USB_DMA requires USB_USE_OTG_HS, because only the USB OTG HS peripheral provides an internal DMA.
+#endif
+#if defined(USB_DMA) && defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U) && !defined(D_CACHE_DISABLED)
+#error USB_DMA requires D_CACHE_DISABLED, because the USB DMA writes the setup packets into the PCD handle which cannot be cache maintained.
+#endif
+
+
+#if !defined(USB_USE_OTG_HS) && !defined(USB_OTG_FS)
+/* Reception into the application buffer. Only the USB FS device peripheral allows to redirect an armed OUT endpoint. */
+#define USB_RX_DIRECT
+#endif
+
+
+#ifdef USB_DMA
+/* DMA buffers need to be 32 bit aligned; the data cache maintenance works on 32 byte cache lines */
+#define USB_DMA_ALIGN __attribute__((aligned(32)))
+#define USB_DMA_ALIGN_SIZE(x) (((x) + 31) & ~31)
+#else /* not USB_DMA */
+#define USB_DMA_ALIGN
+#define USB_DMA_ALIGN_SIZE(x) (x)
+#endif /* not USB_DMA */
+
+
+#if defined(USB_DBL_BUF) && defined(USE_USB_DOUBLE_BUFFER)
+#if USE_USB_DOUBLE_BUFFER == 0
+#error USB_DBL_BUF requires USE_USB_DOUBLE_BUFFER to be enabled in the STM32 HAL.
+#endif
+#endif
+
+
 /**
  * @macro USB_TX_TRANSACTIONAL
  * USB_TX_TRANSACTIONAL is defined in board.hpp if the used STM32Cube library handles
@@ -143,8 +198,10 @@
  */
 #ifdef USB_TX_TRANSACTIONAL
 #define USB_IO_TX_CHUNK(len) (len)
+#define USB_IO_RX_CHUNK(len) ((len) - ((len) % USB_EP_SIZE))
 #else /* not USB_TX_TRANSACTIONAL */
 #define USB_IO_TX_CHUNK(len) min(USB_EP_SIZE, (len))
+#define USB_IO_RX_CHUNK(len) USB_EP_SIZE
 #endif /* not USB_TX_TRANSACTIONAL */
 
 
@@ -157,6 +214,8 @@
 /* Timeout for sends and receives. */
 #define USB_WFI_TIMEOUT_MS 1000
 #define USB_IO_TIMEOUT_MS 70
+/* Time without new data after which a reception into the application buffer is aborted. */
+#define USB_RX_DIRECT_IDLE_MS 2
 #define PP_CAT(x, y) x##y
 #ifdef __thumb__
 #define INST_TYPE uint16_t
@@ -188,11 +247,17 @@ extern const DeviceDescriptor USB_DeviceDescriptorIAD;
 
 
 const DeviceDescriptor USB_DeviceDescriptorIAD = D_DEVICE(
-	DEVICE_CLASS, DEVICE_SUB_CLASS, DEVICE_PROTOCOL, USB_EP_SIZE,
+	DEVICE_CLASS, DEVICE_SUB_CLASS, DEVICE_PROTOCOL, USB_EP0_SIZE,
 	USB_VID, USB_PID, DEVICE_VERSION,
 	IMANUFACTURER, IPRODUCT, ISERIAL,
 	1
 );
+#ifdef USB_HS
+const DeviceQualifierDescriptor USB_DeviceQualifierIAD = D_QUALIFIER(
+	DEVICE_CLASS, DEVICE_SUB_CLASS, DEVICE_PROTOCOL, USB_EP0_SIZE,
+	1
+);
+#endif /* USB_HS */
 const uint16_t STRING_LANGUAGE[2] = {(3 << 8) | (2 + 2), 0x0409 /* English */};
 const uint8_t STRING_PRODUCT[] = USB_PRODUCT;
 const uint8_t STRING_MANUFACTURER[] = USB_MANUFACTURER;
@@ -207,9 +272,17 @@ uint8_t _usbEndpoints[USB_ENDPOINTS] = {
 
 namespace {
 struct _UsbRxBuffer {
-	enum { PacketSize = USB_EP_SIZE };
-	typedef _FifoClass<USB_RX_SIZE - PacketSize> FifoType;
+	enum {
+		PacketSize = USB_EP_SIZE,
+		FifoSize = USB_RX_SIZE - PacketSize
+	};
+	/* free-running counters allow to buffer a full packet in a power of two sized FIFO */
+	typedef _FifoClass<FifoSize, (FifoSize & (FifoSize - 1)) == 0> FifoType;
+#ifdef USB_DMA
+	uint8_t * packet; /**< packet reception buffers (see _usbDmaPacket) */
+#else /* not USB_DMA */
 	uint8_t packet[PacketSize]; /**< packet reception buffers */
+#endif /* not USB_DMA */
 	FifoType fifo; /**< FIFO to upper layer */
 };
 struct _UsbTxBuffer {
@@ -220,13 +293,17 @@ struct _UsbTxBuffer {
 
 
 void * _usbBuf[USB_ENDPOINTS] = {NULL}; /* index + 1 = endpoint number */
-uint8_t _usbCtrlRecvBuf[64]; /* holds data from the host associated to a class interface setup request */
+uint8_t _usbCtrlRecvBuf[64] USB_DMA_ALIGN; /* holds data from the host associated to a class interface setup request */
+#ifdef USB_DMA
+uint8_t _usbDmaPacket[USB_ENDPOINTS][USB_DMA_ALIGN_SIZE(USB_EP_SIZE)] USB_DMA_ALIGN; /* packet reception buffers; heap memory is not cache line aligned */
+#endif /* USB_DMA */
 bool isRemoteWakeUpEnabled = false;
 bool isEndpointHalt = false;
 uint8_t ctrlStatBuf[2];
 
 volatile uint16_t txPendingEp = 0; /* IN endpoints */
 volatile uint16_t rxPendingEp = 0; /* OUT endpoints */
+volatile uint16_t rxDirectEp = 0; /* OUT endpoints receiving into the application buffer */
 volatile uint32_t bytesPendingEp[USB_ENDPOINTS + 1]; /* for each endpoint; two for control */
 uint8_t * bufferPtrEp[USB_ENDPOINTS + 1]; /* for each endpoint; two for control */
 } /* anonymous namespace */
@@ -237,8 +314,11 @@ volatile uint8_t _usbSetInterface = 0;
 
 bool _dry_run = false;
 bool _pack_message = false;
+#ifdef USB_HS
+bool _other_speed = false; /* true while sending the other speed configuration */
+#endif /* USB_HS */
 uint16_t _pack_size = 0;
-uint8_t _pack_buffer[256];
+uint8_t _pack_buffer[256] USB_DMA_ALIGN;
 PCD_HandleTypeDef hPcdUsb[1];
 
 
@@ -260,6 +340,12 @@ DEF_NO_FN_ARGS_WRAPPER(HAL_StatusTypeDef, HAL_PCDEx_SetRxFiFo_Wrapper, HAL_PCDEx
 template <typename Fn>
 static void usbCallForEachIrqNum(Fn && fn) {
 	#define CALL_FOR_IRQ_NUM(x) CALL_FOR_EXISTING_FIELD(fn, IRQn_Type, x)
+#ifdef USB_USE_OTG_HS
+	CALL_FOR_IRQ_NUM(OTG_HS_EP1_IN_IRQn);
+	CALL_FOR_IRQ_NUM(OTG_HS_EP1_OUT_IRQn);
+	CALL_FOR_IRQ_NUM(OTG_HS_IRQn);
+	CALL_FOR_IRQ_NUM(OTG_HS_WKUP_IRQn);
+#else /* not USB_USE_OTG_HS */
 	CALL_FOR_IRQ_NUM(OTG_FS_EP1_IN_IRQn);
 	CALL_FOR_IRQ_NUM(OTG_FS_EP1_OUT_IRQn);
 	CALL_FOR_IRQ_NUM(OTG_FS_IRQn);
@@ -273,6 +359,7 @@ static void usbCallForEachIrqNum(Fn && fn) {
 	CALL_FOR_IRQ_NUM(USB_LP_CAN1_RX0_IRQn);
 	CALL_FOR_IRQ_NUM(USB_LP_CAN_RX0_IRQn);
 	CALL_FOR_IRQ_NUM(USB_LP_IRQn);
+#endif /* not USB_USE_OTG_HS */
 	#undef CALL_FOR_IRQ_NUM
 }
 
@@ -381,6 +468,81 @@ static uint32_t usbFrameNumber() {
 }
 
 
+/**
+ * Writes the data cache lines of the given buffer back to memory before it is transmitted by the
+ * USB DMA. This is a NOP without USB_DMA or data cache.
+ * 
+ * @param[in] data - data buffer
+ * @param[in] len - data length
+ */
+static inline void usbCleanDCache(const void * data, const uint32_t len) {
+#if defined(USB_DMA) && defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+	if (data == NULL || len == 0 || (SCB->CCR & SCB_CCR_DC_Msk) == 0) return;
+	const uintptr_t start = uintptr_t(data) & ~uintptr_t(31);
+	SCB_CleanDCache_by_Addr(reinterpret_cast<uint32_t *>(start), int32_t(uintptr_t(data) + len - start));
+#else
+	(void)data;
+	(void)len;
+#endif
+}
+
+
+/**
+ * Discards the data cache lines of the given buffer after it was written by the USB DMA.
+ * The buffer needs to be cache line aligned. This is a NOP without USB_DMA or data cache.
+ * 
+ * @param[in] data - data buffer
+ * @param[in] len - data length
+ */
+static inline void usbInvalidateDCache(const void * data, const uint32_t len) {
+#if defined(USB_DMA) && defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+	if (data == NULL || len == 0 || (SCB->CCR & SCB_CCR_DC_Msk) == 0) return;
+	SCB_InvalidateDCache_by_Addr(reinterpret_cast<uint32_t *>(const_cast<void *>(data)), int32_t(USB_DMA_ALIGN_SIZE(len)));
+#else
+	(void)data;
+	(void)len;
+#endif
+}
+
+
+#if defined(USB_DBL_BUF) && defined(PCD_DBL_BUF)
+/**
+ * Returns the PMA address of the second packet buffer for the given endpoint. Only bulk
+ * endpoints are double-buffered. The second buffers follow the single buffers of all
+ * endpoints in the order of the endpoint numbers.
+ * 
+ * @param[in] ep - endpoint number
+ * @param[in] config - endpoint configuration
+ * @return PMA address or 0 if the endpoint shall be single-buffered
+ */
+static uint32_t usbDblBufPmaAddr(const uint32_t ep, const uint32_t config) {
+	if (ep == 0 || (config & USB_ENDPOINT_TYPE_MASK) != USB_ENDPOINT_TYPE_BULK) return 0;
+	uint32_t slot = USB_ENDPOINTS + 1;
+	for (uint32_t i = 1; i < ep; i++) {
+		if ((_usbEndpoints[i] & USB_ENDPOINT_TYPE_MASK) == USB_ENDPOINT_TYPE_BULK) slot++;
+	}
+	const uint32_t addr = (slot * USB_EP_SIZE) + (16 * USB_ENDPOINTS);
+	if ((addr + USB_EP_SIZE) > USB_PMASIZE) return 0; /* insufficient PMA memory */
+	return addr;
+}
+#endif /* USB_DBL_BUF and PCD_DBL_BUF */
+
+
+/**
+ * Checks whether the caller may wait for the completion of USB transfers. This is not the case
+ * if the interrupts are disabled or the caller runs in an interrupt with equal or higher
+ * priority than the USB interrupt.
+ * 
+ * @return true if waiting is possible, else false
+ */
+static bool usbCanWait() {
+	if ((__get_PRIMASK() & 0x1) != 0) return false;
+	const uint32_t irqExecutionNumber = SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk;
+	/* USB interrupt is enabled and we were not called from an interrupt with higher priority */
+	return irqExecutionNumber == 0 || NVIC_GetPriority(IRQn_Type(irqExecutionNumber - 16)) > usbNvicGetLowestPriority();
+}
+
+
 /**
  * Sends data on the given endpoint. The operation blocks if there is still
  * a previous data transmission ongoing. Else returns immediately if blocking is false.
@@ -408,6 +570,7 @@ static bool sendOrBlock(const uint8_t ep, const void * data, const uint32_t len,
 	txPendingEp |= epMask; /* mark as pending */
 	bufferPtrEp[epIdx] = const_cast<uint8_t *>(static_cast<const uint8_t *>(data));
 	bytesPendingEp[epIdx] = len;
+	usbCleanDCache(data, len);
 	HAL_PCD_EP_Transmit(hPcdUsb, ep, bufferPtrEp[epIdx], USB_IO_TX_CHUNK(len));
 	if ( blocking ) {
 		/* wait until the transmission completed */
@@ -421,6 +584,32 @@ static bool sendOrBlock(const uint8_t ep, const void * data, const uint32_t len,
 }
 
 
+/**
+ * Returns the number of bytes of the longest contiguous run of committed blocks starting with
+ * the next block to send. All but the last block of the run are full. The run ends at the wrap
+ * around of the FIFO memory. This allows to send multiple blocks with a single transfer if the
+ * STM32 HAL handles multi-packet transactions.
+ * 
+ * @param[in] buf - output buffers
+ * @param[in] blockSize - size of the next block to send
+ * @return number of bytes in the run
+ */
+static uint32_t usbTxRunLength(const _UsbTxBuffer & buf, uint32_t blockSize) {
+#if USB_TX_SIZE >= (USB_EP_SIZE * 4) && defined(USB_TX_TRANSACTIONAL)
+	const _UsbTxBuffer::FifoType::IndexType curHead = buf.fifo.head;
+	uint32_t len = blockSize;
+	for (uint32_t i = uint32_t(buf.fifo.tail + 1); blockSize >= USB_EP_SIZE && i < _UsbTxBuffer::FifoType::Count && i != curHead; i++) {
+		blockSize = buf.fifo.size[i];
+		len += blockSize;
+	}
+	return len;
+#else /* single block per transfer */
+	(void)buf;
+	return blockSize;
+#endif
+}
+
+
 /**
  * Triggers the transmission of a non-control endpoint by pushing the buffered
  * data from its FIFO to the send routine. The function shall only be called if
@@ -437,15 +626,9 @@ static void usbTriggerSend(_UsbTxBuffer & buf, const uint8_t epNum, const bool a
 	/* must disable interrupt to prevent handle lock contention */
 	usbNvicDisable();
 	__DMB(); __DSB(); __ISB(); /* data and instruction barrier */
-#if USB_TX_SIZE >= (USB_EP_SIZE * 4) && defined(USB_TX_TRANSACTIONAL)
-	const _UsbTxBuffer::FifoType::IndexType nextTail = _UsbTxBuffer::FifoType::IndexType(buf.fifo.tail + 1);
-	if (blockSize >= USB_EP_SIZE && nextTail < _UsbTxBuffer::FifoType::Count && nextTail != buf.fifo.head) {
-		/* queue two blocks at once */
-		sendOrBlock(USB_ENDPOINT_IN(epNum), blockPtr, blockSize + buf.fifo.size[nextTail]);
-	} else
-#endif
 	if (blockSize > 0) {
-		sendOrBlock(USB_ENDPOINT_IN(epNum), blockPtr, blockSize);
+		/* queue all contiguous blocks at once */
+		sendOrBlock(USB_ENDPOINT_IN(epNum), blockPtr, usbTxRunLength(buf, blockSize));
 	} else if ( allowEmpty ) {
 		sendOrBlock(USB_ENDPOINT_IN(epNum), NULL, 0);
 	}
@@ -473,42 +656,42 @@ static uint32_t sendHelper(const uint8_t flags, const uint32_t ep, const void *
 		if ( ! sendOrBlock(USB_ENDPOINT_IN(ep), data, len, true) ) return 0;
 	} else {
 		_UsbTxBuffer & buf = *usbTxBuffer(epNum);
-		bool canWait = false;
+		const bool canWait = usbCanWait();
 		const bool zlp = (len == 0);
-		const bool interruptsEnabled = ((__get_PRIMASK() & 0x1) == 0);
 		const uint16_t epMask = uint16_t(1 << uint16_t(epNum));
-		if ( interruptsEnabled ) {
-			const uint32_t irqExecutionNumber = SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk;
-			if (irqExecutionNumber == 0 || NVIC_GetPriority(IRQn_Type(irqExecutionNumber - 16)) > usbNvicGetLowestPriority()) {
-				/* USB interrupt is enabled and we were not called from an interrupt with higher priority */
-				canWait = true;
-			}
-		}
 		/* write data to queue */
 		buf.commitLock = true;
 		if ( canWait ) {
 			/* wait until space is available and add to queue */
 			__DMB(); __DSB(); __ISB(); /* data and instruction barrier */
 			const uint8_t * dataBuf = reinterpret_cast<const uint8_t *>(data);
-			for (uint32_t i = 0; i < len; dataBuf++, i++) {
-				const uint32_t startTime = millis();
-				while ( ! buf.fifo.push(((flags & TRANSFER_ZERO) == 0) ? *dataBuf : 0) ) {
-					if ((txPendingEp & epMask) == 0) {
-						/* trigger send in case something clogged up */
-						usbTriggerSend(buf, epNum, false);
-						break;
-					}
-					__WFI();
-					if (uint32_t(millis() - startTime) >= USB_WFI_TIMEOUT_MS) {
-						/* interface got stuck -> reattach it */
-						USBDevice.detach();
-						USBDevice.attach();
-						return i;
-					}
+			uint32_t startTime = millis();
+			for (uint32_t i = 0; i < len; ) {
+				uint32_t written;
+				if ((flags & TRANSFER_ZERO) == 0) {
+					written = buf.fifo.write(dataBuf + i, uint32_t(len - i));
+				} else {
+					for (written = 0; (i + written) < len && buf.fifo.push(0); written++);
+				}
+				if (written > 0) {
+					i += written;
+					startTime = millis();
+					continue;
+				}
+				if ((txPendingEp & epMask) == 0) {
+					/* trigger send in case something clogged up; retry the remaining data afterwards */
+					usbTriggerSend(buf, epNum, false);
+				}
+				__WFI();
+				if (uint32_t(millis() - startTime) >= USB_WFI_TIMEOUT_MS) {
+					/* interface got stuck -> reattach it */
+					USBDevice.detach();
+					USBDevice.attach();
+					return i;
 				}
 			}
 			if ((flags & TRANSFER_RELEASE) != 0) {
-				const uint32_t startTime = millis();
+				startTime = millis();
 				while ( ! buf.fifo.commitBlock() ) {
 					if ((txPendingEp & epMask) == 0) {
 						/* trigger send in case something clogged up */
@@ -590,7 +773,8 @@ static bool recvOrFail(const uint8_t ep, void * data, const uint32_t len, const
 	}
 	rxPendingEp |= epMask; /* mark as pending */
 	bytesPendingEp[epIdx] = len;
-	HAL_PCD_EP_Receive(hPcdUsb, ep, reinterpret_cast<uint8_t *>(data), len);
+	bufferPtrEp[epIdx] = reinterpret_cast<uint8_t *>(data);
+	HAL_PCD_EP_Receive(hPcdUsb, ep, bufferPtrEp[epIdx], len);
 	if ( blocking ) {
 		/* wait until the reception completed */
 		const uint32_t startTime = millis();
@@ -603,22 +787,132 @@ static bool recvOrFail(const uint8_t ep, void * data, const uint32_t len, const
 }
 
 
+/**
+ * Starts the reception of the next packet on the given buffered OUT endpoint. The packet is
+ * received directly into the FIFO if it provides enough contiguous space for a full packet.
+ * The packet reception buffer is used otherwise.
+ * 
+ * @param[in,out] buf - endpoint reception buffer
+ * @param[in] ep - endpoint
+ * @remarks bufferPtrEp holds the reception target to distinguish both cases on completion.
+ */
+static void recvPacket(_UsbRxBuffer & buf, const uint8_t ep) {
+	const uint8_t epNum = uint8_t(ep & 0xF);
+	const uint8_t epIdx = uint8_t(epNum + 1);
+#ifdef USB_DMA
+	/* the FIFO is not cache line aligned */
+	uint8_t * recvBuf = buf.packet;
+#else /* not USB_DMA */
+	uint32_t len;
+	uint8_t * recvBuf = buf.fifo.reserve(_UsbRxBuffer::PacketSize, len);
+	if (recvBuf == NULL || len < _UsbRxBuffer::PacketSize) recvBuf = buf.packet;
+#endif /* not USB_DMA */
+	/* receive single packets; the packet size may be below PacketSize in full speed mode */
+	const uint32_t packetSize = hPcdUsb->OUT_ep[epNum].maxpacket;
+	rxPendingEp |= uint16_t(1 << uint16_t(epNum)); /* mark as pending */
+	bytesPendingEp[epIdx] = packetSize;
+	bufferPtrEp[epIdx] = recvBuf;
+	HAL_PCD_EP_Receive(hPcdUsb, ep, recvBuf, packetSize);
+}
+
+
+#ifdef USB_RX_DIRECT
+/**
+ * Receives data on the given buffered OUT endpoint directly into the passed buffer. This is only
+ * possible if the FIFO is empty and the packet reception armed by recvPacket() did not receive
+ * any data yet. The reception is redirected to the passed buffer in this case and the function
+ * waits until the transfer completed or no more data was received for USB_RX_DIRECT_IDLE_MS.
+ * The packet reception into the FIFO is re-armed afterwards.
+ * 
+ * @param[in,out] buf - endpoint reception buffer
+ * @param[in] ep - endpoint
+ * @param[out] data - data buffer
+ * @param[in] len - buffer size (at least USB_EP_SIZE)
+ * @return number of bytes received into the passed buffer
+ */
+static uint32_t recvDirect(_UsbRxBuffer & buf, const uint8_t ep, uint8_t * data, const uint32_t len) {
+	const uint8_t epNum = uint8_t(ep & 0xF);
+	const uint8_t epIdx = uint8_t(epNum + 1);
+	const uint16_t epMask = uint16_t(1 << uint16_t(epNum));
+	if ( ! usbCanWait() ) return 0;
+	/* must disable interrupt to safely redirect the armed packet reception */
+	usbNvicDisable();
+	__DMB(); __DSB(); __ISB(); /* data and instruction barrier */
+	if ((rxPendingEp & epMask) == 0 || HAL_PCD_EP_GetRxCount(hPcdUsb, ep) != 0 || buf.fifo.availableForRead() != 0) {
+		/* data was received in the meantime -> use FIFO */
+		usbNvicSetPriority();
+		usbNvicEnable();
+		return 0;
+	}
+	rxDirectEp |= epMask;
+	bytesPendingEp[epIdx] = 0;
+	bufferPtrEp[epIdx] = data;
+	HAL_PCD_EP_Receive(hPcdUsb, ep, data, USB_IO_RX_CHUNK(len));
+	usbNvicSetPriority();
+	usbNvicEnable();
+	/* wait until the reception completed */
+	uint32_t progress = 0;
+	uint32_t startTime = millis();
+	while ((rxPendingEp & epMask) != 0) {
+		__WFI();
+		const uint32_t count = HAL_PCD_EP_GetRxCount(hPcdUsb, ep);
+		if (count != progress) {
+			progress = count;
+			startTime = millis();
+		} else if (uint32_t(millis() - startTime) >= USB_RX_DIRECT_IDLE_MS) {
+			break;
+		}
+	}
+	usbNvicDisable();
+	__DMB(); __DSB(); __ISB(); /* data and instruction barrier */
+	uint32_t received = 0;
+	if ((rxDirectEp & epMask) != 0) {
+		/* the data of an aborted reception remains in the passed buffer */
+		received = ((rxPendingEp & epMask) != 0) ? HAL_PCD_EP_GetRxCount(hPcdUsb, ep) : bytesPendingEp[epIdx];
+		rxDirectEp &= uint16_t(~epMask); /* clear bit */
+		recvPacket(buf, ep);
+	} /* else the endpoint was reset in the meantime */
+	usbNvicSetPriority();
+	usbNvicEnable();
+	return received;
+}
+#endif /* USB_RX_DIRECT */
+
+
 /**
  * Initializes the USB peripheral device.
  * 
- * @remarks Enabling DMA transfer is currently not supported.
+ * @remarks DMA transfers are enabled with USB_DMA for the USB OTG HS peripheral.
  */
 void USBDeviceClass::init() {
 	/* initialize the USB device */
 	hPcdUsb->pData = this;
-#ifdef USB_OTG_FS
+#ifdef USB_USE_OTG_HS
+	hPcdUsb->Instance = USB_OTG_HS;
+#elif defined(USB_OTG_FS)
 	hPcdUsb->Instance = USB_OTG_FS;
 #else
 	hPcdUsb->Instance = USB;
 #endif
+#ifdef USB_DMA
+	hPcdUsb->Init.dma_enable = ENABLE;
+#endif /* USB_DMA */
+#ifdef PLUGGABLE_USB_ENABLED
+	/* start of frame interrupts are only enabled if needed by a plugged module */
+	hPcdUsb->Init.Sof_enable = PluggableUSB().handlesSof() ? ENABLE : DISABLE;
+#endif /* PLUGGABLE_USB_ENABLED */
 	hPcdUsb->Init.dev_endpoints = USB_ENDPOINTS; /* see USBDesc.h */
+#if defined(USB_HS)
+	hPcdUsb->Init.speed = PCD_SPEED_HIGH;
+#ifdef USB_HS_ULPI
+	hPcdUsb->Init.phy_itface = PCD_PHY_ULPI;
+#else /* not USB_HS_ULPI */
+	hPcdUsb->Init.phy_itface = PCD_PHY_UTMI;
+#endif /* not USB_HS_ULPI */
+#else /* not USB_HS */
 	hPcdUsb->Init.speed = PCD_SPEED_FULL;
 	hPcdUsb->Init.phy_itface = PCD_PHY_EMBEDDED;
+#endif /* not USB_HS */
 	hPcdUsb->Init.low_power_enable = DISABLE;
 	hPcdUsb->Init.lpm_enable = DISABLE; /* Link Power Management */
 	hPcdUsb->Init.battery_charging_enable = DISABLE;
@@ -851,6 +1145,15 @@ bool USBDeviceClass::sendDescriptor(USBSetup & setup) {
 	if (setup.wValueH == USB_CONFIGURATION_DESCRIPTOR_TYPE) {
 		return USBDevice.sendConfiguration(setup.wLength);
 	}
+#ifdef USB_HS
+	if (setup.wValueH == USB_OTHER_SPEED_CONFIGURATION_DESCRIPTOR_TYPE) {
+		/* endpoint descriptors are created for the speed not currently in use */
+		_other_speed = true;
+		const bool res = USBDevice.sendConfiguration(setup.wLength);
+		_other_speed = false;
+		return res;
+	}
+#endif /* USB_HS */
 
 #ifdef PLUGGABLE_USB_ENABLED
 	const int res = PluggableUSB().getDescriptor(setup);
@@ -865,6 +1168,13 @@ bool USBDeviceClass::sendDescriptor(USBSetup & setup) {
 		descLength = *descAddr;
 		/* sent at the end of the function */
 		break;
+#ifdef USB_HS
+	case USB_DEVICE_QUALIFIER_DESCRIPTOR_TYPE:
+		descAddr = reinterpret_cast<const uint8_t *>(&USB_DeviceQualifierIAD);
+		descLength = *descAddr;
+		/* sent at the end of the function */
+		break;
+#endif /* USB_HS */
 	case USB_STRING_DESCRIPTOR_TYPE:
 		switch (setup.wValueL) {
 		case 0:
@@ -918,10 +1228,19 @@ bool USBDeviceClass::sendDescriptor(USBSetup & setup) {
 uint32_t USBDeviceClass::sendControl(const void * data, uint32_t len) {
 	if ( _dry_run ) return len;
 	if ( _pack_message ) {
+		if ((_pack_size + len) > sizeof(_pack_buffer)) return 0; /* does not fit */
 		memcpy(_pack_buffer + _pack_size, data, len);
 		_pack_size = uint16_t(_pack_size + len);
 		return len;
 	}
+#ifdef USB_DMA
+	if (data != _pack_buffer) {
+		/* descriptors may be unaligned or located in flash memory */
+		if (len > sizeof(_pack_buffer)) len = sizeof(_pack_buffer);
+		memcpy(_pack_buffer, data, len);
+		data = _pack_buffer;
+	}
+#endif /* USB_DMA */
 	sendOrBlock(USB_ENDPOINT_IN(0), data, len);
 	return len;
 }
@@ -956,8 +1275,11 @@ bool USBDeviceClass::sendConfiguration(uint32_t maxLen) {
 	_dry_run = true;
 	uint32_t total = 0;
 	const uint8_t interfaces = this->SendInterfaces(&total);
-	const ConfigDescriptor config = D_CONFIG(uint16_t(sizeof(ConfigDescriptor) + total), interfaces);
+	ConfigDescriptor config = D_CONFIG(uint16_t(sizeof(ConfigDescriptor) + total), interfaces);
 	_dry_run = false;
+#ifdef USB_HS
+	if ( _other_speed ) config.dtype = USB_OTHER_SPEED_CONFIGURATION_DESCRIPTOR_TYPE;
+#endif /* USB_HS */
 
 	/* send the actual configuration */
 	if (maxLen == sizeof(ConfigDescriptor)) {
@@ -1032,6 +1354,54 @@ void USBDeviceClass::packMessages(bool val) {
 }
 
 
+/**
+ * Checks whether descriptors and endpoints are currently set up for USB HS.
+ * This refers to the other speed while the other speed configuration is sent.
+ * 
+ * @return true for high speed, else false
+ */
+bool USBDeviceClass::isHighSpeed() {
+#ifdef USB_HS
+	const bool highSpeed = (hPcdUsb->Init.speed == PCD_SPEED_HIGH);
+	return _other_speed ? ( ! highSpeed ) : highSpeed;
+#else /* not USB_HS */
+	return false;
+#endif /* not USB_HS */
+}
+
+
+/**
+ * Returns the maximum packet size of bulk endpoints for the current speed.
+ * 
+ * @return bulk endpoint size in bytes
+ * @see isHighSpeed()
+ */
+uint16_t USBDeviceClass::bulkPacketSize() {
+#ifdef USB_HS
+	/* USB FS bulk endpoints are limited to 64 bytes */
+	if ( ! this->isHighSpeed() ) return uint16_t(USB_EP0_SIZE);
+#endif /* USB_HS */
+	return uint16_t(USB_EP_SIZE);
+}
+
+
+/**
+ * Converts the given polling interval into the bInterval field value of
+ * an interrupt endpoint descriptor for the current speed.
+ * 
+ * @param[in] ms - polling interval in milliseconds
+ * @return bInterval value
+ * @see isHighSpeed()
+ */
+uint8_t USBDeviceClass::pollInterval(uint8_t ms) {
+	if ( ! this->isHighSpeed() ) return ms;
+	/* USB HS uses 2^(bInterval - 1) micro frames of 125us */
+	uint8_t res = 4; /* 1ms */
+	for (uint32_t frames = 2; res < 16 && frames <= ms; frames <<= 1) res++;
+	return res;
+}
+
+
 /**
  * Initializes and starts all non-control endpoints with their associated configuration.
  */
@@ -1066,24 +1436,37 @@ void USBDeviceClass::initEP(uint32_t ep, uint32_t config) {
 	const uint8_t epIdx = (ep == 0 && (config & USB_ENDPOINT_DIRECTION_MASK) == USB_ENDPOINT_OUT(0)) ? 0 : uint8_t(ep + 1);
 	/* we need space for the BTABLE at the beginning of the PMA memory (16 byte per endpoint number with IN/OUT); EP buffer needs to be 32 byte aligned */
 	/* note that HAL internally calculates the PMA address as USB_PMAADDR + (offset * 2) */
-	HAL_PCDEx_PMAConfig_Wrapper(hPcdUsb, epId, PCD_SNG_BUF, (epIdx * USB_EP_SIZE) + (16 * USB_ENDPOINTS));
+	const uint32_t pmaAddr = (epIdx * USB_EP_SIZE) + (16 * USB_ENDPOINTS);
+#if defined(USB_DBL_BUF) && defined(PCD_DBL_BUF)
+	const uint32_t pmaAddr1 = usbDblBufPmaAddr(ep, config);
+	if (pmaAddr1 != 0) {
+		/* the HAL expects the address of the second buffer in the upper 16 bits */
+		HAL_PCDEx_PMAConfig_Wrapper(hPcdUsb, epId, PCD_DBL_BUF, (pmaAddr1 << 16) | pmaAddr);
+	} else
+#endif /* USB_DBL_BUF and PCD_DBL_BUF */
+	HAL_PCDEx_PMAConfig_Wrapper(hPcdUsb, epId, PCD_SNG_BUF, pmaAddr);
 #endif /* PCD_SNG_BUF */
 	if ((config & USB_ENDPOINT_DIRECTION_MASK) == USB_ENDPOINT_IN(0)) {
-		/* ED TX FIFO size needs to be at least 64 bytes and to be a multiple of 4 */
-		HAL_PCDEx_SetTxFiFo_Wrapper(hPcdUsb, uint8_t(ep), uint16_t((USB_EP_SIZE < 64) ? 64 : (uint16_t((USB_EP_SIZE + 3) / 4) * 4)));
+		HAL_PCDEx_SetTxFiFo_Wrapper(hPcdUsb, uint8_t(ep), USB_TX_FIFO_SIZE(ep));
 	}
-	HAL_PCD_EP_Open(hPcdUsb, epId, uint16_t(USB_EP_SIZE), epType);
+	/* control and interrupt endpoints are limited to USB_EP0_SIZE */
+	const uint16_t packetSize = (epType == PCD_EP_TYPE_CTRL || epType == PCD_EP_TYPE_INTR) ? uint16_t(USB_EP0_SIZE) : this->bulkPacketSize();
+	HAL_PCD_EP_Open(hPcdUsb, epId, packetSize, epType);
 	if (ep > 0) {
 		const uint16_t epMask = uint16_t(1 << uint16_t(ep));
 		if ((config & USB_ENDPOINT_DIRECTION_MASK) == USB_ENDPOINT_OUT(0)) {
 			_UsbRxBuffer * & buf = reinterpret_cast<_UsbRxBuffer **>(_usbBuf)[ep - 1];
 			if (buf == NULL) {
 				buf = new _UsbRxBuffer;
+#ifdef USB_DMA
+				buf->packet = _usbDmaPacket[ep - 1];
+#endif /* USB_DMA */
 			} else {
 				buf->fifo.clear();
 			}
 			rxPendingEp &= uint16_t(~epMask); /* clear bit */
-			recvOrFail(uint8_t(ep), buf->packet, _UsbRxBuffer::PacketSize);
+			rxDirectEp &= uint16_t(~epMask); /* clear bit */
+			recvPacket(*buf, uint8_t(ep));
 		} else {
 			_UsbTxBuffer * & buf = reinterpret_cast<_UsbTxBuffer **>(_usbBuf)[ep - 1];
 			if (buf == NULL) {
@@ -1123,13 +1506,104 @@ void USBDeviceClass::sendZlp(uint32_t ep) {
 
 
 /**
- * Non-blocking receive.
+ * Starts the transmission of the given data as a single transfer on the given endpoint. The
+ * transmission buffer of the endpoint is bypassed. This is useful to send reports on interrupt
+ * endpoints, which may not be merged with other data.
+ * 
+ * @param[in] ep - endpoint number
+ * @param[in] data - data buffer
+ * @param[in] len - data length
+ * @return true on success, else false if not configured or a transmission is still ongoing
+ * @remarks The passed buffer needs to be valid until `available()` reports the endpoint ready again.
+ * @remarks Call this only from the USB interrupt (e.g. `PluggableUSBModule::sof()`) to avoid races.
+ */
+bool USBDeviceClass::sendPacket(uint32_t ep, const void * data, uint32_t len) {
+	if ( ! _usbConfiguration ) return false;
+	return sendOrBlock(USB_ENDPOINT_IN(ep), data, len);
+}
+
+
+/**
+ * Returns the free space of the current transmission block of the given endpoint. The data can
+ * be written there in place and passed to `commit()` for transmission afterwards. This avoids
+ * the copy from an intermediate buffer. The function waits for free space unless called from an
+ * interrupt with higher priority than the USB interrupt or with disabled interrupts.
+ * 
+ * @param[in] ep - endpoint number
+ * @param[in] len - number of bytes needed
+ * @param[out] outLen - set to the number of bytes available at the returned pointer (at most len)
+ * @return start of the writable region or NULL on timeout or if unavailable
+ * @remarks The region is at most USB_EP_SIZE bytes in size.
+ * @remarks Each successful call needs to be followed by a call to `commit()`. The current block
+ * is not sent in the meantime.
+ */
+uint8_t * USBDeviceClass::reserve(uint32_t ep, uint32_t len, uint32_t & outLen) {
+	outLen = 0;
+	if ( ! _usbConfiguration || len == 0) return NULL;
+	const uint8_t epNum = uint8_t(ep & 0xF);
+	if (usbTxBuffer(epNum) == NULL) return NULL;
+	_UsbTxBuffer & buf = *usbTxBuffer(epNum);
+	const uint16_t epMask = uint16_t(1 << uint16_t(epNum));
+	buf.commitLock = true;
+	__DMB(); __DSB(); __ISB(); /* data and instruction barrier */
+	uint8_t * ptr = buf.fifo.reserve(len, outLen);
+	if (ptr == NULL && usbCanWait()) {
+		/* wait until space is available */
+		const uint32_t startTime = millis();
+		while ((ptr = buf.fifo.reserve(len, outLen)) == NULL) {
+			if ((txPendingEp & epMask) == 0) {
+				/* trigger send in case something clogged up */
+				usbTriggerSend(buf, epNum, false);
+			}
+			__WFI();
+			if (uint32_t(millis() - startTime) >= USB_WFI_TIMEOUT_MS) break;
+		}
+	}
+	if (ptr == NULL) buf.commitLock = false;
+	return ptr;
+}
+
+
+/**
+ * Adds the given number of bytes written to the region returned by `reserve()` to the
+ * transmission queue of the given endpoint and starts the transmission if the endpoint is idle.
+ * Otherwise, the data is sent once the ongoing transmission completed.
+ * 
+ * @param[in] ep - endpoint number
+ * @param[in] len - number of bytes to add; 0 to discard the reservation
+ * @return number of bytes added
+ */
+uint32_t USBDeviceClass::commit(uint32_t ep, uint32_t len) {
+	const uint8_t epNum = uint8_t(ep & 0xF);
+	if (usbTxBuffer(epNum) == NULL) return 0;
+	_UsbTxBuffer & buf = *usbTxBuffer(epNum);
+	const uint16_t epMask = uint16_t(1 << uint16_t(epNum));
+	if (len > 0) buf.fifo.commit(len);
+	buf.commitLock = false;
+	/* the interrupt routine may send out the queued data at this point */
+	__DMB(); __DSB(); __ISB(); /* data and instruction barrier */
+	if ((txPendingEp & epMask) == 0 && _usbConfiguration) {
+		/* start endpoint transmission from idle state */
+		buf.fifo.commitBlock();
+		usbTriggerSend(buf, epNum, false);
+	}
+	return len;
+}
+
+
+/**
+ * Receives the buffered data. Does not block unless the data is received directly into the passed
+ * buffer.
  * 
  * @param[in] ep - endpoint number
  * @param[out] data - data buffer
  * @param[in] len - buffer size
  * @return Number of bytes copied to the passed data buffer.
  * @remarks uint32_t(-1) is returned if no USB device is connected for compatibility reasons.
+ * @remarks The data is received directly into the passed buffer if no data was buffered and
+ * the buffer can hold at least USB_EP_SIZE bytes. The function waits while the host keeps sending
+ * data in this case and returns after USB_RX_DIRECT_IDLE_MS (2 ms) without new data. This is only
+ * done for the USB FS device peripheral, not for the USB OTG peripherals.
  */
 uint32_t USBDeviceClass::recv(uint32_t ep, void * data, uint32_t len) {
 	if ( ! _usbConfiguration ) return uint32_t(-1);
@@ -1143,24 +1617,32 @@ uint32_t USBDeviceClass::recv(uint32_t ep, void * data, uint32_t len) {
 		/* copy data from FIFO to output buffer */
 		uint32_t copied = buf.fifo.read(static_cast<uint8_t *>(data), len);
 		const uint16_t epMask = uint16_t(1 << uint16_t(epNum));
-		if ((rxPendingEp & epMask) != 0) return copied; /* no more data is available, yet */
+		if ((rxPendingEp & epMask) != 0) {
+			/* no more data is available, yet */
+#ifdef USB_RX_DIRECT
+			if (copied == 0 && len >= USB_EP_SIZE) {
+				/* skip packet buffer and FIFO for large receptions */
+				return recvDirect(buf, uint8_t(ep), static_cast<uint8_t *>(data), len);
+			}
+#endif /* USB_RX_DIRECT */
+			return copied;
+		}
 		/* copy data from received packet to output buffer */
 		const uint8_t epIdx = (epNum == 0) ? 0 : uint8_t(epNum + 1);
 		uint8_t * recvBuf = bufferPtrEp[epIdx];
 		uint32_t received = bytesPendingEp[epIdx];
-		uint8_t * outBuf = static_cast<uint8_t *>(data) + copied;
-		while (received > 0 && copied < len) {
-			*outBuf = *recvBuf;
-			outBuf++;
-			copied++;
-			recvBuf++;
-			received--;
+		const uint32_t direct = (received < (len - copied)) ? received : uint32_t(len - copied);
+		if (direct > 0) {
+			memcpy(static_cast<uint8_t *>(data) + copied, recvBuf, direct);
+			copied += direct;
+			recvBuf += direct;
+			received -= direct;
 		}
 		/* copy data from received packet to FIFO */
 		const uint32_t written = buf.fifo.write(recvBuf, received);
 		/* request next packet */
 		if (written >= received) {
-			recvOrFail(uint8_t(ep), buf.packet, _UsbRxBuffer::PacketSize);
+			recvPacket(buf, uint8_t(ep));
 		} else {
 			bufferPtrEp[epIdx] = recvBuf + written;
 			bytesPendingEp[epIdx] = uint32_t(received - written);
@@ -1183,6 +1665,79 @@ int USBDeviceClass::recv(uint32_t ep) {
 }
 
 
+/**
+ * Returns the received data of the given endpoint without copying it. Pass the number of
+ * processed bytes to `consume()` afterwards to remove them. This avoids the copy to an
+ * intermediate buffer.
+ * 
+ * @param[in] ep - endpoint number
+ * @param[out] outLen - set to the number of bytes readable at the returned pointer
+ * @return start of the received data or NULL if no data is available
+ * @remarks The returned region is contiguous and may be shorter than `available()`. Call `peek()`
+ * and `consume()` repeatedly to process all data.
+ * @remarks The region remains valid until `consume()` is called.
+ */
+const uint8_t * USBDeviceClass::peek(uint32_t ep, uint32_t & outLen) {
+	outLen = 0;
+	if ( ! _usbConfiguration ) return NULL;
+	const uint8_t epNum = uint8_t(ep & 0xF);
+	if (epNum == 0 || usbRxBuffer(epNum) == NULL) return NULL;
+	_UsbRxBuffer & buf = *usbRxBuffer(epNum);
+	_FifoSpan span[2];
+	if (buf.fifo.peek(span) > 0) {
+		outLen = span[0].len;
+		return span[0].ptr;
+	}
+	const uint16_t epMask = uint16_t(1 << uint16_t(epNum));
+	if ((rxPendingEp & epMask) != 0) return NULL; /* no more data is available, yet */
+	/* return the remaining data of the received packet which did not fit into the FIFO */
+	const uint8_t epIdx = uint8_t(epNum + 1);
+	outLen = bytesPendingEp[epIdx];
+	return (outLen > 0) ? bufferPtrEp[epIdx] : NULL;
+}
+
+
+/**
+ * Removes the given number of bytes previously returned by `peek()` from the reception buffer of
+ * the given endpoint. The next packet is requested from the host if enough space got available.
+ * 
+ * @param[in] ep - endpoint number
+ * @param[in] len - number of bytes to remove; needs to be less or equal to the peeked number of bytes
+ */
+void USBDeviceClass::consume(uint32_t ep, uint32_t len) {
+	if ( ! _usbConfiguration ) return;
+	const uint8_t epNum = uint8_t(ep & 0xF);
+	if (epNum == 0 || usbRxBuffer(epNum) == NULL) return;
+	_UsbRxBuffer & buf = *usbRxBuffer(epNum);
+	const uint8_t epIdx = uint8_t(epNum + 1);
+	const uint16_t epMask = uint16_t(1 << uint16_t(epNum));
+	if ( ! buf.fifo.empty() ) {
+		/* the FIFO only grows while peeked data is processed */
+		buf.fifo.consume(len);
+		if ((rxPendingEp & epMask) != 0) return;
+	} else if ((rxPendingEp & epMask) == 0) {
+		/* data was taken from the received packet */
+		const uint32_t received = bytesPendingEp[epIdx];
+		if (len > received) len = received;
+		bufferPtrEp[epIdx] += len;
+		bytesPendingEp[epIdx] = uint32_t(received - len);
+	} else {
+		return;
+	}
+	/* copy the remaining data of the received packet to the FIFO */
+	uint8_t * recvBuf = bufferPtrEp[epIdx];
+	const uint32_t received = bytesPendingEp[epIdx];
+	const uint32_t written = buf.fifo.write(recvBuf, received);
+	/* request next packet */
+	if (written >= received) {
+		recvPacket(buf, uint8_t(ep));
+	} else {
+		bufferPtrEp[epIdx] = recvBuf + written;
+		bytesPendingEp[epIdx] = uint32_t(received - written);
+	}
+}
+
+
 /**
  * Returns how many bytes have been received on the given endpoint.
  * 
@@ -1191,8 +1746,12 @@ int USBDeviceClass::recv(uint32_t ep) {
  */
 uint32_t USBDeviceClass::available(uint32_t ep) {
 	const uint8_t epNum = uint8_t(ep & 0xF);
+	if (ep == USB_ENDPOINT_OUT(0)) {
+		/* control endpoint data received with the last setup request */
+		return uint32_t(bufferPtrEp[0] - _usbCtrlRecvBuf);
+	}
 	if ((_usbEndpoints[epNum] & USB_ENDPOINT_DIRECTION_MASK) == USB_ENDPOINT_OUT(0)) {
-		if (ep == 0 || usbRxBuffer(epNum) == NULL) {
+		if (usbRxBuffer(epNum) == NULL) {
 			return uint32_t(bufferPtrEp[0] - _usbCtrlRecvBuf);
 		}
 		const _UsbRxBuffer & buf = *usbRxBuffer(epNum);
@@ -1220,16 +1779,7 @@ void USBDeviceClass::flush(uint32_t ep) {
 		bytesPendingEp[0] = 0;
 		bytesPendingEp[1] = 0;
 	} else {
-		bool canWait = false;
-		const bool interruptsEnabled = ((__get_PRIMASK() & 0x1) == 0);
-		if ( interruptsEnabled ) {
-			const uint32_t irqExecutionNumber = SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk;
-			if (irqExecutionNumber == 0 || NVIC_GetPriority(IRQn_Type(irqExecutionNumber - 16)) > usbNvicGetLowestPriority()) {
-				/* USB interrupt is enabled and we were not called from an interrupt with higher priority */
-				canWait = true;
-			}
-		}
-		if ( ! canWait ) return;
+		if ( ! usbCanWait() ) return;
 		const uint16_t epMask = uint16_t(1 << uint16_t(ep & 0xF));
 		if ((_usbEndpoints[ep] & USB_ENDPOINT_DIRECTION_MASK) == USB_ENDPOINT_IN(0)) {
 			const uint8_t epNum = uint8_t(ep & 0xF);
@@ -1448,6 +1998,12 @@ void STM32CubeDuinoIrqHandlerForUSB(void) {
 	HAL_PCD_IRQHandler(hPcdUsb);
 }
 
+#ifdef USB_USE_OTG_HS
+void STM32CubeDuinoIrqHandlerForUSB_OTG_HS(void) {
+	HAL_PCD_IRQHandler(hPcdUsb);
+}
+#endif /* USB_USE_OTG_HS */
+
 
 /* implementation of STM32 HAL related callback hooks */
 /**
@@ -1461,8 +2017,13 @@ void HAL_PCD_MspInit(PCD_HandleTypeDef * /* hPcd */) {
 	/* possible implementation to force a USB enumeration, e.g. by pulling down D+ */
 	{ ACTIVATE_USB_PORT(); }
 #endif /* ACTIVATE_USB_PORT */
-	/* USB FS is always on PA_11 (D-) and PA_12 (D+) */
-#if defined(GPIO_AF10_OTG1_FS) || defined(GPIO_AF10_OTG2_FS) || defined(GPIO_AF10_OTG_FS) || defined(GPIO_AF10_USB_FS)
+#if defined(USB_USE_OTG_HS) && !defined(USB_HS) && defined(GPIO_AF12_OTG_HS_FS)
+	/* USB OTG HS with embedded full speed PHY is on PB_14 (D-) and PB_15 (D+) */
+	pinModeEx(PB_14, ALTERNATE_FUNCTION, 12);
+	pinModeEx(PB_15, ALTERNATE_FUNCTION, 12);
+#elif defined(USB_USE_OTG_HS)
+	/* ULPI pin configuration is left to ACTIVATE_USB_PORT */
+#elif defined(GPIO_AF10_OTG1_FS) || defined(GPIO_AF10_OTG2_FS) || defined(GPIO_AF10_OTG_FS) || defined(GPIO_AF10_USB_FS)
 	pinModeEx(PA_11, ALTERNATE_FUNCTION, 10);
 	pinModeEx(PA_12, ALTERNATE_FUNCTION, 10);
 #elif defined(GPIO_AF14_USB)
@@ -1476,7 +2037,18 @@ void HAL_PCD_MspInit(PCD_HandleTypeDef * /* hPcd */) {
 	/* remap pins to use USB */
 	{ __HAL_REMAP_PIN_ENABLE(HAL_REMAP_PA11_PA12); }
 #endif /* HAL_REMAP_PA11_PA12 */
-#ifdef __HAL_RCC_USB_OTG_FS_CLK_ENABLE
+#ifdef USB_USE_OTG_HS
+	{ __HAL_RCC_USB_OTG_HS_CLK_ENABLE(); }
+#if defined(USB_HS) && defined(USB_HS_ULPI)
+	{ __HAL_RCC_USB_OTG_HS_ULPI_CLK_ENABLE(); }
+#elif defined(USB_HS)
+	/* internal UTMI PHY */
+	{ __HAL_RCC_OTGPHYC_CLK_ENABLE(); }
+#elif defined(__HAL_RCC_USB_OTG_HS_ULPI_CLK_SLEEP_DISABLE)
+	/* the embedded PHY does not work if the ULPI clock is enabled in sleep mode */
+	{ __HAL_RCC_USB_OTG_HS_ULPI_CLK_SLEEP_DISABLE(); }
+#endif /* __HAL_RCC_USB_OTG_HS_ULPI_CLK_SLEEP_DISABLE */
+#elif defined(__HAL_RCC_USB_OTG_FS_CLK_ENABLE)
 	{ __HAL_RCC_USB_OTG_FS_CLK_ENABLE(); }
 #elif defined(__HAL_RCC_USB_CLK_ENABLE)
 	{ __HAL_RCC_USB_CLK_ENABLE(); }
@@ -1494,7 +2066,14 @@ void HAL_PCD_MspInit(PCD_HandleTypeDef * /* hPcd */) {
  */
 void HAL_PCD_MspDeInit(PCD_HandleTypeDef * /* hPcd */) {
 	/* disable clock */
-#ifdef __HAL_RCC_USB_OTG_FS_CLK_DISABLE
+#ifdef USB_USE_OTG_HS
+	__HAL_RCC_USB_OTG_HS_CLK_DISABLE();
+#if defined(USB_HS) && defined(USB_HS_ULPI)
+	__HAL_RCC_USB_OTG_HS_ULPI_CLK_DISABLE();
+#elif defined(USB_HS)
+	__HAL_RCC_OTGPHYC_CLK_DISABLE();
+#endif /* USB_HS */
+#elif defined(__HAL_RCC_USB_OTG_FS_CLK_DISABLE)
 	__HAL_RCC_USB_OTG_FS_CLK_DISABLE();
 #elif defined(__HAL_RCC_USB_CLK_DISABLE)
 	__HAL_RCC_USB_CLK_DISABLE();
@@ -1574,6 +2153,7 @@ void HAL_PCD_DataOutStageCallback(PCD_HandleTypeDef * /* hPcd */, uint8_t ep) {
 	const uint32_t received = HAL_PCD_EP_GetRxCount(hPcdUsb, ep);
 	uint8_t * recvBuf = bufferPtrEp[epIdx];
 	bool callSetup = false;
+	usbInvalidateDCache(recvBuf, received);
 	if (epNum == 0) {
 		if (bytesPendingEp[0] > received) {
 			/* reception incomplete -> receive next packet */
@@ -1583,20 +2163,30 @@ void HAL_PCD_DataOutStageCallback(PCD_HandleTypeDef * /* hPcd */, uint8_t ep) {
 			return;
 		} else if (received > 0) {
 			/* reception complete -> signal the host that we are ready to send again */
+			bufferPtrEp[0] = recvBuf + received; /* received data length for USBDeviceClass::available() */
 			callSetup = true;
 		}
 		bytesPendingEp[epIdx] = 0;
-	} else if (received > 0) {
-		if (epNum != 0 && usbRxBuffer(epNum) != NULL) {
+	} else if (usbRxBuffer(epNum) != NULL || received > 0) {
+		if (usbRxBuffer(epNum) != NULL) {
 			_UsbRxBuffer & buf = *usbRxBuffer(epNum);
-			recvBuf = buf.packet; /* revert pointer */
+			if ((rxDirectEp & uint16_t(1 << uint16_t(epNum))) != 0) {
+				/* packets were received directly into the application buffer -> signal completion */
+				/* @see recvDirect() */
+				bytesPendingEp[epIdx] = received;
+				rxPendingEp &= uint16_t(~(1 << uint16_t(epNum))); /* clear bit */
+				return;
+			} else if (recvBuf != buf.packet) {
+				/* packet was received directly into the upper layer FIFO */
+				buf.fifo.commit(received);
+				recvPacket(buf, ep);
+				return;
+			}
 			/* transfer packet data to upper layer FIFO */
 			const uint32_t written = buf.fifo.write(recvBuf, received);
 			/* re-queue read operation if the packet was completely transfered to the FIFO */
 			if (written >= received) {
-				bufferPtrEp[epIdx] = buf.packet;
-				bytesPendingEp[epIdx] = _UsbRxBuffer::PacketSize;
-				HAL_PCD_EP_Receive(hPcdUsb, ep, buf.packet, _UsbRxBuffer::PacketSize);
+				recvPacket(buf, ep);
 				return;
 			} else {
 				bufferPtrEp[epIdx] = recvBuf + written;
@@ -1625,21 +2215,12 @@ static bool sendNextPacket(_UsbTxBuffer & buf, const uint8_t ep, const uint8_t e
 	uint32_t blockSize = 0;
 	const uint8_t * blockPtr = buf.fifo.peek(blockSize);
 	if (blockPtr != NULL) {
-		/* send out complete block */
-#if USB_TX_SIZE >= (USB_EP_SIZE * 4) && defined(USB_TX_TRANSACTIONAL)
-		const _UsbTxBuffer::FifoType::IndexType nextTail = _UsbTxBuffer::FifoType::IndexType(buf.fifo.tail + 1);
-		if (blockSize >= USB_EP_SIZE && nextTail < _UsbTxBuffer::FifoType::Count && nextTail != buf.fifo.head) {
-			/* queue two blocks at once */
-			const uint32_t blockSize2 = blockSize + buf.fifo.size[nextTail];
-			bufferPtrEp[epIdx] = const_cast<uint8_t *>(blockPtr);
-			bytesPendingEp[epIdx] = blockSize2;
-			HAL_PCD_EP_Transmit(hPcdUsb, ep, bufferPtrEp[epIdx], USB_IO_TX_CHUNK(blockSize2));
-			return true;
-		}
-#endif
+		/* send out all contiguous complete blocks */
+		const uint32_t runSize = usbTxRunLength(buf, blockSize);
 		bufferPtrEp[epIdx] = const_cast<uint8_t *>(blockPtr);
-		bytesPendingEp[epIdx] = blockSize;
-		HAL_PCD_EP_Transmit(hPcdUsb, ep, bufferPtrEp[epIdx], USB_IO_TX_CHUNK(blockSize));
+		bytesPendingEp[epIdx] = runSize;
+		usbCleanDCache(blockPtr, runSize);
+		HAL_PCD_EP_Transmit(hPcdUsb, ep, bufferPtrEp[epIdx], USB_IO_TX_CHUNK(runSize));
 		return true;
 	} else if ( ! (buf.commitLock || buf.fifo.totallyEmpty()) ) {
 		/* send out partial complete current block */
@@ -1654,6 +2235,7 @@ static bool sendNextPacket(_UsbTxBuffer & buf, const uint8_t ep, const uint8_t e
 		blockPtr = buf.fifo.peek(blockSize);
 		bufferPtrEp[epIdx] = const_cast<uint8_t *>(blockPtr);
 		bytesPendingEp[epIdx] = blockSize;
+		usbCleanDCache(blockPtr, blockSize);
 		HAL_PCD_EP_Transmit(hPcdUsb, ep, bufferPtrEp[epIdx], USB_IO_TX_CHUNK(blockSize));
 		return true;
 	}
@@ -1689,17 +2271,14 @@ void HAL_PCD_DataInStageCallback(PCD_HandleTypeDef * /* hPcd */, uint8_t ep) {
 		if (usbTxBuffer(epNum) != NULL) {
 			/* process TX queue */
 			_UsbTxBuffer & buf = *usbTxBuffer(epNum);
-#if USB_TX_SIZE >= (USB_EP_SIZE * 4) && defined(USB_TX_TRANSACTIONAL)
-			const uint8_t * blockEndPtr = buf.fifo.block[buf.fifo.tail + 1];
-			/* free up both transmitted blocks */
-			if (bufferPtrEp[epIdx] > blockEndPtr) buf.fifo.pop();
-#endif
-			buf.fifo.pop();
+			/* free up all transmitted blocks; all but the last one are full */
+			for (uint32_t n = (transmitted + USB_EP_SIZE - 1) / USB_EP_SIZE; n > 0; n--) buf.fifo.pop();
 			if ( sendNextPacket(buf, ep, epIdx) ) return;
 		}
 		bytesPendingEp[epIdx] = 0;
-		if ((transmitted % USB_EP_SIZE) == 0) {
+		if ((transmitted % hPcdUsb->IN_ep[epNum].maxpacket) == 0 && hPcdUsb->IN_ep[epNum].type != PCD_EP_TYPE_INTR) {
 			/* no more data to send; last packet had max endpoint size -> send ZLP to signal end of transaction */
+			/* interrupt endpoints transfer single reports instead */
 			HAL_PCD_EP_Transmit(hPcdUsb, ep, NULL, 0);
 			return;
 		}
@@ -1724,9 +2303,13 @@ void HAL_PCD_DataInStageCallback(PCD_HandleTypeDef * /* hPcd */, uint8_t ep) {
  * 
  * @param[in,out] hPcd - pointer to PCD handle
  * @remarks Output of the SOF signal needs to be explicitly enabled at USB HAL initialization.
+ * This is done in USBDeviceClass::init() if a plugged module handles start of frame events.
  */
 void HAL_PCD_SOFCallback(PCD_HandleTypeDef * /* hPcd */) {
 	//uint32_t frameNumber = usbFrameNumber();
+#ifdef PLUGGABLE_USB_ENABLED
+	if ( _usbConfiguration ) PluggableUSB().sof();
+#endif /* PLUGGABLE_USB_ENABLED */
 }
 
 
@@ -1739,8 +2322,9 @@ void HAL_PCD_ResetCallback(PCD_HandleTypeDef * /* hPcd */) {
 	/* end of reset -> initialize control endpoints */
 	txPendingEp = 0;
 	rxPendingEp = 0;
+	rxDirectEp = 0;
 	/* RX FIFO needs to be defined before TX FIFO because HAL calculates the TX FIFO offset from the RX FIFO size */
-	HAL_PCDEx_SetRxFiFo_Wrapper(hPcdUsb, uint16_t(((USB_EP_SIZE < 64) ? 64 : (uint16_t((USB_EP_SIZE + 3) / 4) * 4)) * 2));
+	HAL_PCDEx_SetRxFiFo_Wrapper(hPcdUsb, USB_RX_FIFO_SIZE);
 	USBDevice.initEP(0, USB_ENDPOINT_TYPE_CONTROL | USB_ENDPOINT_OUT(0)); /* initialize OUT first! */
 	USBDevice.initEP(0, USB_ENDPOINT_TYPE_CONTROL | USB_ENDPOINT_IN(0));
 	isRemoteWakeUpEnabled = false;
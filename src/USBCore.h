@@ -1,9 +1,9 @@
 /**
  * @file USBCore.h
  * @author Daniel Starke
- * @copyright Copyright 2020 Daniel Starke
+ * @copyright Copyright 2020-2026 Daniel Starke
  * @date 2020-05-21
- * @version 2020-05-21
+ * @version 2026-10-17
  */
 #ifndef __USBCORE_H__
 #define __USBCORE_H__
@@ -66,6 +66,10 @@
 #define USB_STRING_DESCRIPTOR_TYPE             3
 #define USB_INTERFACE_DESCRIPTOR_TYPE          4
 #define USB_ENDPOINT_DESCRIPTOR_TYPE           5
+#define USB_DEVICE_QUALIFIER_DESCRIPTOR_TYPE   6
+#define USB_OTHER_SPEED_CONFIGURATION_DESCRIPTOR_TYPE 7
+#define USB_BOS_DESCRIPTOR_TYPE                15
+#define USB_DEVICE_CAPABILITY_DESCRIPTOR_TYPE  16
 
 
 /* usb_20.pdf Table 9.6 Standard Feature Selectors */
@@ -127,8 +131,12 @@
 #define MSC_PROTOCOL_BULK_ONLY                 0x50
 
 #ifndef USB_VERSION
+#if defined(VENDOR_WINUSB) && !defined(STM32CUBEDUINO_DISABLE_USB_VENDOR)
+#define USB_VERSION                            0x210 /* hosts request the BOS descriptor (see Vendor.cpp) */
+#else
 #define USB_VERSION                            0x200
 #endif
+#endif
 
 
 struct DeviceDescriptor {
@@ -149,6 +157,19 @@ struct DeviceDescriptor {
 } __attribute__((packed));
 
 
+struct DeviceQualifierDescriptor {
+	uint8_t len; /* 10 */
+	uint8_t dtype; /* 6 USB_DEVICE_QUALIFIER_DESCRIPTOR_TYPE */
+	uint16_t usbVersion; /* 0x200 */
+	uint8_t deviceClass;
+	uint8_t deviceSubClass;
+	uint8_t deviceProtocol;
+	uint8_t packetSize0; /* packet 0 for the other speed */
+	uint8_t bNumConfigurations;
+	uint8_t bReserved;
+} __attribute__((packed));
+
+
 struct ConfigDescriptor {
 	uint8_t len; /* 9 */
 	uint8_t dtype; /* 2 */
@@ -242,6 +263,9 @@ struct MSCDescriptor {
 #define D_DEVICE(_class ,_subClass, _proto, _packetSize0, _vid, _pid, _version, _im, _ip, _is, _configs) \
 	{18, 1, USB_VERSION, _class, _subClass, _proto, _packetSize0, _vid, _pid, _version, _im, _ip, _is, _configs}
 
+#define D_QUALIFIER(_class ,_subClass, _proto, _packetSize0, _configs) \
+	{10, 6, USB_VERSION, _class, _subClass, _proto, _packetSize0, _configs, 0}
+
 #define D_CONFIG(_totalLength, _interfaces) \
 	{9, 2, _totalLength, _interfaces, 1, 0, USB_CONFIG_BUS_POWERED | USB_CONFIG_REMOTE_WAKEUP, USB_CONFIG_POWER_MA(USB_CONFIG_POWER)}
 
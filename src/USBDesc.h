@@ -1,9 +1,9 @@
 /**
  * @file USBDesc.h
  * @author Daniel Starke
- * @copyright Copyright 2020-2022 Daniel Starke
+ * @copyright Copyright 2020-2026 Daniel Starke
  * @date 2020-05-21
- * @version 2022-03-21
+ * @version 2026-10-17
  */
 #ifndef __USBDESC_H__
 #define __USBDESC_H__
@@ -68,4 +68,16 @@
 #endif /* USB_PMASIZE */
 
 
+#ifdef USB_HS
+/* FIFO sizes in 32 bit words within the 4 KiB FIFO memory of the USB OTG HS peripheral */
+#define USB_FIFO_MEM_SIZE 1024
+#define USB_RX_FIFO_SIZE uint16_t(0x180)
+#define USB_TX_FIFO_SIZE(ep) uint16_t(((ep) == 0) ? 0x20 : 0x80)
+#else /* not USB_HS */
+/* ED TX FIFO size needs to be at least 64 bytes and to be a multiple of 4 */
+#define USB_RX_FIFO_SIZE uint16_t(((USB_EP_SIZE < 64) ? 64 : (uint16_t((USB_EP_SIZE + 3) / 4) * 4)) * 2)
+#define USB_TX_FIFO_SIZE(ep) uint16_t((USB_EP_SIZE < 64) ? 64 : (uint16_t((USB_EP_SIZE + 3) / 4) * 4))
+#endif /* not USB_HS */
+
+
 #endif /* __USBDESC_H__ */
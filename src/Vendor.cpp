@@ -0,0 +1,314 @@
+/**
+ * @file Vendor.cpp
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ * 
+ * @see https://learn.microsoft.com/en-us/windows-hardware/drivers/usbcon/microsoft-os-2-0-descriptors-specification
+ */
+#include "Arduino.h"
+#include "Vendor.h"
+
+
+#if !defined(STM32CUBEDUINO_DISABLE_USB_VENDOR) && defined(PLUGGABLE_USB_ENABLED) && defined(USBCON)
+#define VENDOR_INTERFACE    uint8_t(this->pluggedInterface)
+#define VENDOR_ENDPOINT_OUT uint8_t(this->pluggedEndpoint)
+#define VENDOR_ENDPOINT_IN  uint8_t(this->pluggedEndpoint + 1)
+
+#define VENDOR_RX VENDOR_ENDPOINT_OUT
+#define VENDOR_TX VENDOR_ENDPOINT_IN
+
+
+#ifdef VENDOR_WINUSB
+static_assert(sizeof(VENDOR_INTERFACE_GUID) == 39, "VENDOR_INTERFACE_GUID needs to be of the form {XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}.");
+
+
+/** BOS descriptor with the Microsoft OS 2.0 platform capability. */
+static const VendorBOSDescriptor vendorBosDescriptor = {
+	{5, USB_BOS_DESCRIPTOR_TYPE, uint16_t(sizeof(VendorBOSDescriptor)), 2},
+	{7, USB_DEVICE_CAPABILITY_DESCRIPTOR_TYPE, USB_DEVICE_CAPABILITY_USB20_EXTENSION, 0 /* no LPM */},
+	{
+		28, USB_DEVICE_CAPABILITY_DESCRIPTOR_TYPE, USB_DEVICE_CAPABILITY_PLATFORM, 0,
+		/* {D8DD60DF-4589-4CC7-9CD2-659D9E648A9F} */
+		{0xDF, 0x60, 0xDD, 0xD8, 0x89, 0x45, 0xC7, 0x4C, 0x9C, 0xD2, 0x65, 0x9D, 0x9E, 0x64, 0x8A, 0x9F},
+		MS_OS_20_WINDOWS_VERSION, uint16_t(sizeof(VendorMSOS20Descriptor)), VENDOR_MS_OS_20_VENDOR_CODE, 0
+	}
+};
+
+
+/**
+ * Copies the given ASCII string as UTF-16LE string.
+ * 
+ * @param[out] out - output string
+ * @param[in] in - input string
+ * @param[in] len - number of characters to copy
+ */
+static void copyUtf16(uint8_t * out, const char * in, const size_t len) {
+	for (size_t i = 0; i < len; i++) {
+		*out++ = uint8_t(in[i]);
+		*out++ = 0;
+	}
+}
+#endif /* VENDOR_WINUSB */
+
+
+/**
+ * Replacement for global singleton to prevent static initialization issues.
+ * This needs to be called before the USB device gets enumerated, i.e. during
+ * static initialization.
+ * 
+ * @return Global Vendor_ instance.
+ */
+Vendor_ & Vendor() {
+	static Vendor_ obj;
+	return obj;
+}
+
+
+/**
+ * Constructor.
+ */
+Vendor_::Vendor_(void):
+	PluggableUSBModule(2, 1, epType)
+{
+	/* same order as VENDOR_ENDPOINT_XXX */
+	this->epType[0] = USB_ENDPOINT_TYPE_BULK | USB_ENDPOINT_OUT(0);
+	this->epType[1] = USB_ENDPOINT_TYPE_BULK | USB_ENDPOINT_IN(0);
+	PluggableUSB().plug(this);
+}
+
+
+/**
+ * Returns the connection status.
+ * 
+ * @return true if the USB device has been configured by the host, else false
+ */
+Vendor_::operator bool() {
+	return USBDevice.configured();
+}
+
+
+/**
+ * Returns the number of available bytes in the receive buffer.
+ * 
+ * @return number of bytes available for read
+ */
+int Vendor_::available(void) {
+	if ( ! USBDevice.configured() ) return 0;
+	return int(USBDevice.available(VENDOR_RX));
+}
+
+
+/**
+ * Returns the number of bytes which can be written without blocking.
+ * 
+ * @return number of bytes available for write
+ */
+int Vendor_::availableForWrite(void) {
+	if ( ! USBDevice.configured() ) return 0;
+	return int(USBDevice.available(VENDOR_TX));
+}
+
+
+/**
+ * Removes up to the given number of bytes from the receive buffer. Large reads without buffered
+ * data receive directly into the passed buffer on the USB FS device peripheral. This waits while
+ * the host keeps sending and up to 2 ms without new data (see `USBDeviceClass::recv()`).
+ * 
+ * @param[out] buffer - output buffer
+ * @param[in] size - maximum number of bytes to read
+ * @return number of bytes read
+ */
+size_t Vendor_::read(uint8_t * buffer, size_t size) {
+	if (buffer == NULL || size < 1) return 0;
+	size_t res = 0;
+	while (size > 0) {
+		const uint32_t received = USBDevice.recv(VENDOR_RX, buffer, uint32_t(size));
+		if (received == uint32_t(-1) || received == 0) break;
+		const bool drained = (received < size);
+		buffer += received;
+		size -= received;
+		res += received;
+		if ( drained ) break; /* avoid waiting for more data in USBDeviceClass::recv() */
+	}
+	return res;
+}
+
+
+/**
+ * Sends the requested number of bytes from the given buffer.
+ * 
+ * @param[in] buffer - data to send
+ * @param[in] size - size of the data in the buffer
+ * @return number of bytes written to the transmission queue
+ */
+size_t Vendor_::write(const uint8_t * buffer, size_t size) {
+	if ( ! USBDevice.configured() ) return 0;
+	const int res = int(USBDevice.send(VENDOR_TX, buffer, uint32_t(size)));
+	return (res > 0) ? size_t(res) : 0;
+}
+
+
+/**
+ * Waits until all data in transmission queue is sent.
+ */
+void Vendor_::flush(void) {
+	USBDevice.flush(VENDOR_TX);
+}
+
+
+/**
+ * Returns the received data without copying it. Pass the number of processed bytes to
+ * `consume()` afterwards to remove them from the receive buffer.
+ * 
+ * @param[out] outLen - set to the number of bytes readable at the returned pointer
+ * @return start of the received data or NULL if no data is available
+ * @remarks The returned region is contiguous and may be shorter than `available()`.
+ */
+const uint8_t * Vendor_::peek(size_t & outLen) {
+	uint32_t len;
+	const uint8_t * ptr = USBDevice.peek(VENDOR_RX, len);
+	outLen = size_t(len);
+	return ptr;
+}
+
+
+/**
+ * Removes the given number of bytes previously returned by `peek()` from the receive buffer.
+ * 
+ * @param[in] size - number of bytes processed
+ */
+void Vendor_::consume(const size_t size) {
+	USBDevice.consume(VENDOR_RX, uint32_t(size));
+}
+
+
+/**
+ * Returns a pointer into the transmission queue to write up to the given number of bytes in
+ * place. Pass the number of bytes written to `commit()` afterwards to send them.
+ * 
+ * @param[in] size - number of bytes needed
+ * @param[out] outLen - set to the number of bytes which can be written (at most size)
+ * @return start of the writable region or NULL if no space is available
+ * @remarks The returned region is at most one USB packet in size.
+ * @remarks Each successful call needs to be followed by a call to `commit()`.
+ */
+uint8_t * Vendor_::reserve(const size_t size, size_t & outLen) {
+	uint32_t len;
+	uint8_t * ptr = USBDevice.reserve(VENDOR_TX, uint32_t(size), len);
+	outLen = size_t(len);
+	return ptr;
+}
+
+
+/**
+ * Sends the given number of bytes previously written to the region returned by `reserve()`.
+ * 
+ * @param[in] size - number of bytes written; 0 to discard the reservation
+ * @return number of bytes added to the transmission queue
+ */
+size_t Vendor_::commit(const size_t size) {
+	return size_t(USBDevice.commit(VENDOR_TX, uint32_t(size)));
+}
+
+
+/**
+ * Sends the USB interface description to the host.
+ * 
+ * @param[in,out] interfaceCount - index of this interface
+ * @return bytes sent
+ */
+int Vendor_::getInterface(uint8_t * interfaceCount) {
+	const uint16_t bulkSize = USBDevice.bulkPacketSize();
+	const VendorDescriptor vendorInterface = {
+		D_INTERFACE(VENDOR_INTERFACE, 2, USB_DEVICE_CLASS_VENDOR_SPECIFIC, 0, 0),
+		D_ENDPOINT(USB_ENDPOINT_OUT(VENDOR_ENDPOINT_OUT), USB_ENDPOINT_TYPE_BULK, bulkSize, 0),
+		D_ENDPOINT(USB_ENDPOINT_IN(VENDOR_ENDPOINT_IN), USB_ENDPOINT_TYPE_BULK, bulkSize, 0)
+	};
+	(*interfaceCount) = uint8_t((*interfaceCount) + 1); /* uses 1 */
+	return int(USBDevice.sendControl(&vendorInterface, sizeof(vendorInterface)));
+}
+
+
+/**
+ * Sends the BOS descriptor to the host if `VENDOR_WINUSB` is defined.
+ * 
+ * @param[in] setup - USB setup message
+ * @return bytes sent or 0 if not handled
+ */
+int Vendor_::getDescriptor(USBSetup & setup) {
+#ifdef VENDOR_WINUSB
+	if (setup.bmRequestType != REQUEST_DEVICETOHOST) return 0;
+	if (setup.wValueH != USB_BOS_DESCRIPTOR_TYPE) return 0;
+	return int(USBDevice.sendControl(&vendorBosDescriptor, min(uint32_t(sizeof(vendorBosDescriptor)), uint32_t(setup.wLength))));
+#else /* not VENDOR_WINUSB */
+	(void)setup;
+	return 0;
+#endif /* not VENDOR_WINUSB */
+}
+
+
+/**
+ * USB setup handler. Sends the Microsoft OS 2.0 descriptor set to the host if `VENDOR_WINUSB` is
+ * defined. This makes Windows bind the WinUSB driver to the vendor interface.
+ * 
+ * @param[in] setup - USB setup message
+ * @return true if handled, else false
+ */
+bool Vendor_::setup(USBSetup & setup) {
+#ifdef VENDOR_WINUSB
+	if (setup.bmRequestType != (REQUEST_DEVICETOHOST | REQUEST_VENDOR | REQUEST_DEVICE)) return false;
+	if (setup.bRequest != VENDOR_MS_OS_20_VENDOR_CODE || setup.wIndex != VENDOR_MS_OS_20_DESCRIPTOR_INDEX) return false;
+	/* the function subset refers to the plugged interface number */
+	VendorMSOS20Descriptor desc;
+	memset(&desc, 0, sizeof(desc));
+	desc.header.len = uint16_t(sizeof(desc.header));
+	desc.header.dtype = MS_OS_20_SET_HEADER_DESCRIPTOR;
+	desc.header.windowsVersion = MS_OS_20_WINDOWS_VERSION;
+	desc.header.totalLength = uint16_t(sizeof(desc));
+	desc.configuration.len = uint16_t(sizeof(desc.configuration));
+	desc.configuration.dtype = MS_OS_20_SUBSET_HEADER_CONFIGURATION;
+	desc.configuration.totalLength = uint16_t(sizeof(desc) - sizeof(desc.header));
+	desc.function.len = uint16_t(sizeof(desc.function));
+	desc.function.dtype = MS_OS_20_SUBSET_HEADER_FUNCTION;
+	desc.function.firstInterface = VENDOR_INTERFACE;
+	desc.function.subsetLength = uint16_t(sizeof(desc) - sizeof(desc.header) - sizeof(desc.configuration));
+	desc.compatibleId.len = uint16_t(sizeof(desc.compatibleId));
+	desc.compatibleId.dtype = MS_OS_20_FEATURE_COMPATIBLE_ID;
+	memcpy(desc.compatibleId.compatibleId, "WINUSB", 6);
+	desc.interfaceGuids.len = uint16_t(sizeof(desc.interfaceGuids));
+	desc.interfaceGuids.dtype = MS_OS_20_FEATURE_REG_PROPERTY;
+	desc.interfaceGuids.propertyDataType = MS_OS_20_REG_MULTI_SZ;
+	desc.interfaceGuids.propertyNameLength = uint16_t(sizeof(desc.interfaceGuids.propertyName));
+	copyUtf16(desc.interfaceGuids.propertyName, "DeviceInterfaceGUIDs", sizeof("DeviceInterfaceGUIDs"));
+	desc.interfaceGuids.propertyDataLength = uint16_t(sizeof(desc.interfaceGuids.propertyData));
+	copyUtf16(desc.interfaceGuids.propertyData, VENDOR_INTERFACE_GUID, sizeof(VENDOR_INTERFACE_GUID));
+	/* the descriptor set needs to remain valid until sent -> copy it to the packet buffer */
+	USBDevice.packMessages(true);
+	USBDevice.sendControl(&desc, min(uint32_t(sizeof(desc)), uint32_t(setup.wLength)));
+	USBDevice.packMessages(false);
+	return true;
+#else /* not VENDOR_WINUSB */
+	(void)setup;
+	return false;
+#endif /* not VENDOR_WINUSB */
+}
+
+
+/**
+ * Returns the USB device serial number.
+ * 
+ * @param[out] name - copy serial number to this buffer
+ * @return number of bytes copied
+ */
+uint8_t Vendor_::getShortName(char * name) {
+	name[0] = ' ';
+	name[1] = 'V';
+	name[2] = 'N';
+	name[3] = 'D';
+	return 4;
+}
+
+
+#endif /* not STM32CUBEDUINO_DISABLE_USB_VENDOR and PLUGGABLE_USB_ENABLED and USBCON */
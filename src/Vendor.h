@@ -0,0 +1,169 @@
+/**
+ * @file Vendor.h
+ * @author Daniel Starke
+ * @copyright Copyright 2026 Daniel Starke
+ * @date 2026-10-17
+ * @version 2026-10-17
+ */
+#ifndef __VENDOR_H__
+#define __VENDOR_H__
+
+#include <stdint.h>
+#include "USBAPI.h"
+
+
+#if !defined(STM32CUBEDUINO_DISABLE_USB_VENDOR) && defined(PLUGGABLE_USB_ENABLED) && defined(USBCON)
+#include "PluggableUSB.h"
+
+
+#ifndef VENDOR_INTERFACE_GUID
+/** Defines the device interface GUID announced via the Microsoft OS 2.0 descriptors (see `VENDOR_WINUSB`). */
+#define VENDOR_INTERFACE_GUID "{385F3412-8A5D-46B0-A306-6F9FE148A6E6}"
+#endif /* VENDOR_INTERFACE_GUID */
+
+
+/* vendor request to retrieve the Microsoft OS 2.0 descriptor set */
+#define VENDOR_MS_OS_20_VENDOR_CODE           0x01
+#define VENDOR_MS_OS_20_DESCRIPTOR_INDEX      0x07
+
+/* Microsoft OS 2.0 descriptor types */
+#define MS_OS_20_SET_HEADER_DESCRIPTOR        0x00
+#define MS_OS_20_SUBSET_HEADER_CONFIGURATION  0x01
+#define MS_OS_20_SUBSET_HEADER_FUNCTION       0x02
+#define MS_OS_20_FEATURE_COMPATIBLE_ID        0x03
+#define MS_OS_20_FEATURE_REG_PROPERTY         0x04
+
+#define MS_OS_20_WINDOWS_VERSION              0x06030000 /* Windows 8.1 */
+#define MS_OS_20_REG_MULTI_SZ                 7
+
+/* device capability types of the BOS descriptor */
+#define USB_DEVICE_CAPABILITY_USB20_EXTENSION 0x02
+#define USB_DEVICE_CAPABILITY_PLATFORM        0x05
+
+
+struct VendorDescriptor {
+	InterfaceDescriptor vif;
+	EndpointDescriptor out;
+	EndpointDescriptor in;
+} __attribute__((packed));
+
+
+struct BOSDescriptor {
+	uint8_t len; /* 5 */
+	uint8_t dtype; /* 15 USB_BOS_DESCRIPTOR_TYPE */
+	uint16_t totalLength;
+	uint8_t numDeviceCaps;
+} __attribute__((packed));
+
+
+struct USB20ExtensionDescriptor {
+	uint8_t len; /* 7 */
+	uint8_t dtype; /* 16 USB_DEVICE_CAPABILITY_DESCRIPTOR_TYPE */
+	uint8_t capabilityType; /* 2 USB_DEVICE_CAPABILITY_USB20_EXTENSION */
+	uint32_t attributes;
+} __attribute__((packed));
+
+
+struct MSOS20PlatformDescriptor {
+	uint8_t len; /* 28 */
+	uint8_t dtype; /* 16 USB_DEVICE_CAPABILITY_DESCRIPTOR_TYPE */
+	uint8_t capabilityType; /* 5 USB_DEVICE_CAPABILITY_PLATFORM */
+	uint8_t reserved;
+	uint8_t platformCapabilityUuid[16];
+	uint32_t windowsVersion;
+	uint16_t descriptorSetTotalLength;
+	uint8_t vendorCode;
+	uint8_t altEnumCode;
+} __attribute__((packed));
+
+
+struct VendorBOSDescriptor {
+	BOSDescriptor bos;
+	USB20ExtensionDescriptor usb20;
+	MSOS20PlatformDescriptor msos20;
+} __attribute__((packed));
+
+
+struct MSOS20SetHeaderDescriptor {
+	uint16_t len; /* 10 */
+	uint16_t dtype; /* MS_OS_20_SET_HEADER_DESCRIPTOR */
+	uint32_t windowsVersion;
+	uint16_t totalLength;
+} __attribute__((packed));
+
+
+struct MSOS20SubsetHeaderConfiguration {
+	uint16_t len; /* 8 */
+	uint16_t dtype; /* MS_OS_20_SUBSET_HEADER_CONFIGURATION */
+	uint8_t configurationIndex;
+	uint8_t reserved;
+	uint16_t totalLength;
+} __attribute__((packed));
+
+
+struct MSOS20SubsetHeaderFunction {
+	uint16_t len; /* 8 */
+	uint16_t dtype; /* MS_OS_20_SUBSET_HEADER_FUNCTION */
+	uint8_t firstInterface;
+	uint8_t reserved;
+	uint16_t subsetLength;
+} __attribute__((packed));
+
+
+struct MSOS20CompatibleIdDescriptor {
+	uint16_t len; /* 20 */
+	uint16_t dtype; /* MS_OS_20_FEATURE_COMPATIBLE_ID */
+	uint8_t compatibleId[8];
+	uint8_t subCompatibleId[8];
+} __attribute__((packed));
+
+
+struct MSOS20RegistryPropertyDescriptor {
+	uint16_t len; /* 132 */
+	uint16_t dtype; /* MS_OS_20_FEATURE_REG_PROPERTY */
+	uint16_t propertyDataType; /* MS_OS_20_REG_MULTI_SZ */
+	uint16_t propertyNameLength;
+	uint8_t propertyName[42]; /* "DeviceInterfaceGUIDs" UTF-16LE with null terminator */
+	uint16_t propertyDataLength;
+	uint8_t propertyData[80]; /* VENDOR_INTERFACE_GUID UTF-16LE with two null terminators */
+} __attribute__((packed));
+
+
+struct VendorMSOS20Descriptor {
+	MSOS20SetHeaderDescriptor header;
+	MSOS20SubsetHeaderConfiguration configuration;
+	MSOS20SubsetHeaderFunction function;
+	MSOS20CompatibleIdDescriptor compatibleId;
+	MSOS20RegistryPropertyDescriptor interfaceGuids;
+} __attribute__((packed));
+
+
+class Vendor_ : public PluggableUSBModule {
+private:
+	uint8_t epType[2];
+public:
+	Vendor_(void);
+	operator bool();
+	int available(void);
+	int availableForWrite(void);
+	size_t read(uint8_t * buffer, size_t size);
+	size_t write(const uint8_t * buffer, size_t size);
+	void flush(void);
+	const uint8_t * peek(size_t & outLen);
+	void consume(const size_t size);
+	uint8_t * reserve(const size_t size, size_t & outLen);
+	size_t commit(const size_t size);
+protected:
+	int getInterface(uint8_t * interfaceCount);
+	int getDescriptor(USBSetup & setup);
+	bool setup(USBSetup & setup);
+	uint8_t getShortName(char * name);
+};
+
+
+/* Replacement for global singleton to prevent static initialization issues. */
+Vendor_ & Vendor();
+
+
+#endif /* not STM32CUBEDUINO_DISABLE_USB_VENDOR and PLUGGABLE_USB_ENABLED and USBCON */
+#endif /* __VENDOR_H__ */
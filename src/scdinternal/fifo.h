@@ -1,9 +1,9 @@
 /**
  * @file fifo.h
  * @author Daniel Starke
- * @copyright Copyright 2020-2022 Daniel Starke
+ * @copyright Copyright 2020-2026 Daniel Starke
  * @date 2020-05-14
- * @version 2022-02-08
+ * @version 2026-10-17
  * 
  * @warning This file is for internal use only. The content is subject to change at any time.
  * @internal Macros to handle embedded FIFOs via circular buffers. Define a macro with
@@ -13,6 +13,8 @@
  * @remarks Here head is the next write position, whereas tail marks the next read position.
  * This approach limits the usable buffer capacity to (size - 1) but ensures proper states
  * in concurrent situations as write and read functions only access disjoint variables.
+ * @remarks `_FifoClass` can use free-running counters instead for power of two sizes to
+ * make the full size usable.
  */
 #ifndef __SCDINTERNAL_FIFO_H__
 #define __SCDINTERNAL_FIFO_H__
@@ -36,6 +38,56 @@ __attribute__((always_inline)) static inline R _FIFO_CAST(const T val) {
 }
 
 
+/**
+ * Helper function which wraps the given index at the given FIFO size. A binary
+ * AND is used instead of the modulo operation if the size is a power of two. This
+ * is resolved at compile-time for constant sizes and avoids a software division on
+ * cores without hardware divider (e.g. Cortex-M0/M0+).
+ * 
+ * @param[in] val - index value to wrap
+ * @param[in] size - FIFO size
+ * @return wrapped index value
+ * @tparam T - input type
+ */
+template <typename T>
+__attribute__((always_inline)) static inline uint32_t _FIFO_WRAP(const T val, const uint32_t size) {
+	return ((size & (size - 1)) == 0) ? (uint32_t(val) & (size - 1)) : (uint32_t(val) % size);
+}
+
+
+/**
+ * Helper function which atomically replaces the value at the given address if it
+ * equals the expected value. Compiles to LDREX/STREX on ARMv7-M and ARMv8-M and
+ * to the native instructions on other hosts. ARMv6-M (Cortex-M0/M0+) provides no
+ * exclusive access instructions and masks interrupts for the few instructions of
+ * the comparison instead.
+ * 
+ * @param[in,out] ptr - address of the value to modify
+ * @param[in,out] expected - expected value; set to the current value on failure
+ * @param[in] desired - new value
+ * @return true on success, else false
+ * @tparam T - value type
+ */
+template <typename T>
+__attribute__((always_inline)) static inline bool _FIFO_CAS(volatile T * ptr, T & expected, const T desired) {
+#if defined(__ARM_ARCH_6M__)
+	const uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	const T cur = *ptr;
+	const bool res = (cur == expected);
+	if ( res ) {
+		*ptr = desired;
+	} else {
+		expected = cur;
+	}
+	__set_PRIMASK(primask);
+	return res;
+#else /* not ARMv6-M */
+	return __atomic_compare_exchange_n(ptr, &expected, desired, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif /* not ARMv6-M */
+}
+
+
 /* helper macro to expand the passed argument list */
 #define _FIFOX_CALL(fn, ...)      fn(__VA_ARGS__)
 /* initializes the index variables head and tail */
@@ -74,7 +126,7 @@ __attribute__((always_inline)) static inline R _FIFO_CAST(const T val) {
 #define _FIFO_CLEAR(buf, size, head, tail) _FIFO_INIT((buf), (size), (head), (tail))
 
 #define _FIFO_PUSH(buf, size, head, tail, val) [&]() -> bool { \
-		const __typeof__((head)) __fifo_next = _FIFO_CAST<__typeof__((head))>(((head) + 1) % (size)); \
+		const __typeof__((head)) __fifo_next = _FIFO_CAST<__typeof__((head))>(_FIFO_WRAP((head) + 1, (size))); \
 		if (__fifo_next == (tail)) return false; \
 		(buf)[(head)] = val; \
 		(head) = __fifo_next; \
@@ -82,7 +134,7 @@ __attribute__((always_inline)) static inline R _FIFO_CAST(const T val) {
 	}()
 
 #define _FIFO_WPUSH(buf, size, head, tail, val) do { \
-		const __typeof__((head)) __fifo_next = _FIFO_CAST<__typeof__((head))>(((head) + 1) % (size)); \
+		const __typeof__((head)) __fifo_next = _FIFO_CAST<__typeof__((head))>(_FIFO_WRAP((head) + 1, (size))); \
 		while (__fifo_next == (tail)) __WFI(); \
 		(buf)[(head)] = val; \
 		(head) = __fifo_next; \
@@ -96,7 +148,7 @@ __attribute__((always_inline)) static inline R _FIFO_CAST(const T val) {
 #define _FIFO_POP(buf, size, head, tail) [&]() -> int { \
 		if ((head) == (tail)) return -1; \
 		const int __fifo_res = (buf)[(tail)]; \
-		tail = _FIFO_CAST<__typeof__((tail))>(((tail) + 1) % (size)); \
+		(tail) = _FIFO_CAST<__typeof__((tail))>(_FIFO_WRAP((tail) + 1, (size))); \
 		return __fifo_res; \
 	}()
 
@@ -104,7 +156,7 @@ __attribute__((always_inline)) static inline R _FIFO_CAST(const T val) {
 	((head) == (tail))
 
 #define _FIFO_FULL(buf, size, head, tail) \
-	((((head) + 1) % (size)) == (tail))
+	(_FIFO_WRAP((head) + 1, (size)) == (tail))
 
 #define _FIFO_CAPACITY(buf, size, head, tail) ((size) - 1)
 
@@ -122,7 +174,7 @@ __attribute__((always_inline)) static inline R _FIFO_CAST(const T val) {
 	size_t(((head) < (tail)) ? (size) - (tail) : (head) - (tail))
 
 #define _FIFO_INDEX(buf, size, head, tail, idx) \
-	_FIFO_CAST<__typeof__((tail))>(((tail) + (idx)) % (size))
+	_FIFO_CAST<__typeof__((tail))>(_FIFO_WRAP((tail) + (idx), (size)))
 
 
 /** Same as std::conditional. */
@@ -145,38 +197,90 @@ struct _FifoIndexTypeFor {
 };
 
 
+/** Gives the signed integer type with the same size as the given unsigned index type. */
+template <typename T> struct _FifoSignedFor;
+template <> struct _FifoSignedFor<uint8_t> { typedef int8_t type; };
+template <> struct _FifoSignedFor<uint16_t> { typedef int16_t type; };
+template <> struct _FifoSignedFor<uint32_t> { typedef int32_t type; };
+
+
+/** Contiguous readable memory region of a FIFO. */
+struct _FifoSpan {
+	const uint8_t * ptr; /**< Start of the region. */
+	uint32_t len; /**< Length of the region in bytes. */
+};
+
+
 /**
  * Implements a FIFO of the given size. The FIFO is made up of uint8_t elements.
  * No data is overwritten. The corresponding functions will fail if the maximum
  * capacity was reached.
  * 
  * @tparam TSize - FIFO size in bytes
+ * @tparam TFreeRunning - set to true to use free-running head and tail counters which makes the
+ * full FIFO size usable; requires TSize to be a power of two
  * @remarks This class is optimized for speed and little RAM usage in contrast to
  * other implementations that minimize flash usage.
+ * @remarks Buffer indices are computed via binary AND instead of modulo if TSize is a power of two.
  * @remarks Designed for single producer, single consumer.
  */
-template <uint32_t TSize>
+template <uint32_t TSize, bool TFreeRunning = false>
 struct _FifoClass {
-	/** Index type. */
-	typedef typename _FifoIndexTypeFor<TSize>::type SizeType;
-#define _FIFO_HANDLE this->buffer, Size, this->head, this->tail
+	/** Index type. Free-running counters need to wrap at a multiple of TSize. */
+	typedef typename _FifoIndexTypeFor<TFreeRunning ? ((TSize * 2) - 1) : TSize>::type SizeType;
 	enum {
 		/** FIFO size in memory. */
 		Size = TSize,
 		/** Half of the FIFO size in memory clamped at lower boundary to 1. */
 		HalfSize = ((TSize / 2) > 0) ? (TSize / 2) : 1,
 		/** FIFO capacity, e.i. the number of bytes the FIFO can hold at maximum. */
-		Capacity = _FIFOX_CAPACITY(_FIFO_HANDLE)
+		Capacity = TFreeRunning ? TSize : (TSize - 1)
 	};
-	volatile SizeType head; /**< Next write position within buffer. */
-	volatile SizeType tail; /**< Next read position within buffer. */
+	volatile SizeType head; /**< Next write position (counter if free-running). */
+	volatile SizeType tail; /**< Next read position (counter if free-running). */
 	uint8_t buffer[TSize]; /**< Circular buffer of the FIFO. */
 	
 	/** Constructor. */
 	explicit _FifoClass():
 		head(0),
 		tail(0)
-	{}
+	{
+		static_assert( ! TFreeRunning || (TSize & (TSize - 1)) == 0, "Free-running counters require a power of two FIFO size.");
+		static_assert(TSize >= 2, "At least 2 elements are required.");
+	}
+	
+	/**
+	 * Returns the buffer index of the given head or tail value.
+	 * 
+	 * @param[in] pos - head or tail value
+	 * @return corresponding index in buffer
+	 */
+	static SizeType indexOf(const uint32_t pos) {
+		return TFreeRunning ? SizeType(pos & (Size - 1)) : SizeType(pos);
+	}
+	
+	/**
+	 * Advances the given head or tail value by the given number of elements.
+	 * 
+	 * @param[in] pos - head or tail value
+	 * @param[in] len - number of elements to advance; needs to be less or equal to Size
+	 * @return new head or tail value
+	 */
+	static SizeType advance(const uint32_t pos, const uint32_t len) {
+		return TFreeRunning ? SizeType(pos + len) : SizeType(_FIFO_WRAP(pos + len, Size));
+	}
+	
+	/**
+	 * Returns the number of used elements for the given head and tail values.
+	 * 
+	 * @param[in] curHead - head value
+	 * @param[in] curTail - tail value
+	 * @return number of used elements
+	 */
+	static uint32_t used(const SizeType curHead, const SizeType curTail) {
+		if ( TFreeRunning ) return uint32_t(SizeType(curHead - curTail));
+		return (curHead >= curTail) ? uint32_t(curHead - curTail) : uint32_t(Size + curHead - curTail);
+	}
 	
 	/**
 	 * Returns whether the FIFO is empty.
@@ -184,7 +288,7 @@ struct _FifoClass {
 	 * @return true if empty, else false
 	 */
 	bool empty() const {
-		return _FIFOX_EMPTY(_FIFO_HANDLE);
+		return this->head == this->tail;
 	}
 	
 	/**
@@ -193,14 +297,17 @@ struct _FifoClass {
 	 * @return true if full, else false
 	 */
 	bool full() const {
-		return _FIFOX_FULL(_FIFO_HANDLE);
+		const SizeType curHead = this->head;
+		if ( TFreeRunning ) return this->used(curHead, this->tail) >= uint32_t(Capacity);
+		return this->advance(curHead, 1) == this->tail;
 	}
 	
 	/**
 	 * Clears the FIFO by resetting the index variables.
 	 */
 	void clear() {
-		_FIFOX_CLEAR(_FIFO_HANDLE);
+		this->head = 0;
+		this->tail = 0;
 	}
 	
 	/**
@@ -211,7 +318,7 @@ struct _FifoClass {
 	 * @return corresponding index in buffer
 	 */
 	uint32_t index(const uint32_t pos) const {
-		return _FIFOX_INDEX(_FIFO_HANDLE, pos);
+		return TFreeRunning ? uint32_t((this->tail + pos) & (Size - 1)) : _FIFO_WRAP(this->tail + pos, Size);
 	}
 	
 	/**
@@ -221,7 +328,11 @@ struct _FifoClass {
 	 * @return true on success, else false
 	 */
 	bool push(const uint8_t val) {
-		return _FIFOX_PUSH(_FIFO_HANDLE, val);
+		if ( this->full() ) return false;
+		const SizeType curHead = this->head;
+		this->buffer[this->indexOf(curHead)] = val;
+		this->head = this->advance(curHead, 1);
+		return true;
 	}
 	
 	/**
@@ -230,7 +341,10 @@ struct _FifoClass {
 	 * @param[in] val - value to add
 	 */
 	void blockingPush(const uint8_t val) {
-		_FIFOX_WPUSH(_FIFO_HANDLE, val);
+		while ( this->full() ) __WFI();
+		const SizeType curHead = this->head;
+		this->buffer[this->indexOf(curHead)] = val;
+		this->head = this->advance(curHead, 1);
 	}
 	
 	/**
@@ -240,7 +354,11 @@ struct _FifoClass {
 	 * @return value if available, else -1
 	 */
 	int pop() {
-		return _FIFOX_POP(_FIFO_HANDLE);
+		const SizeType curTail = this->tail;
+		if (this->head == curTail) return -1;
+		const int res = this->buffer[this->indexOf(curTail)];
+		this->tail = this->advance(curTail, 1);
+		return res;
 	}
 	
 	/**
@@ -250,7 +368,9 @@ struct _FifoClass {
 	 * @return value if available, else -1
 	 */
 	int peek() {
-		return _FIFOX_PEEK(_FIFO_HANDLE);
+		const SizeType curTail = this->tail;
+		if (this->head == curTail) return -1;
+		return this->buffer[this->indexOf(curTail)];
 	}
 	
 	/**
@@ -265,30 +385,16 @@ struct _FifoClass {
 #ifdef STM32CUBEDUINO_SMALL_FLASH
 		for (; res < len && this->push(*buf); buf++, res++);
 #else
-		const SizeType curTail = this->tail;
-		SizeType curHead = this->head;
-		SizeType nextHead;
+		const SizeType curHead = this->head;
+		const uint32_t freeLen = uint32_t(Capacity) - this->used(curHead, this->tail);
+		res = (len < freeLen) ? len : freeLen;
+		const uint32_t headIdx = this->indexOf(curHead);
+		const uint32_t endLen = uint32_t(Size) - headIdx;
 		/* copy until buffer end */
-		if (curTail <= curHead) {
-			const SizeType maxSize = SizeType((curTail == 0) ? Size - 1 : Size);
-			const SizeType endHead = SizeType(maxSize > (curHead + len) ? curHead + len : maxSize);
-			const SizeType cpyLen = SizeType(endHead - curHead);
-			memcpy(this->buffer + curHead, buf, cpyLen);
-			buf += cpyLen;
-			res = uint32_t(res + cpyLen);
-			curHead = SizeType(curHead + cpyLen) % Size;
-			this->head = curHead;
-			nextHead = SizeType((curHead + 1) % Size);
-			if (res >= len || nextHead == curTail) return res;
-		} else {
-			nextHead = SizeType((curHead + 1) % Size);
-		}
-		/* copy until full */
-		const SizeType endNextHead = SizeType(((nextHead + len - res) >= curTail) ? curTail : nextHead + len - res);
-		const SizeType cpyLen = SizeType(endNextHead - nextHead);
-		memcpy(this->buffer + curHead, buf, cpyLen);
-		this->head = SizeType(curHead + cpyLen);
-		res = uint32_t(res + cpyLen);
+		memcpy(this->buffer + headIdx, buf, (res < endLen) ? res : endLen);
+		/* copy remaining from buffer start */
+		if (res > endLen) memcpy(this->buffer, buf + endLen, res - endLen);
+		this->head = this->advance(curHead, res);
 #endif
 		return res;
 	}
@@ -312,7 +418,7 @@ struct _FifoClass {
 	uint32_t dummyWrite(const uint32_t len) {
 		const uint32_t available = this->availableForWrite();
 		const uint32_t skipping = (len <= available) ? len : available;
-		this->head = static_cast<SizeType>((this->head + skipping) % TSize);
+		this->head = this->advance(this->head, skipping);
 		return skipping;
 	}
 	
@@ -326,12 +432,98 @@ struct _FifoClass {
 	 */
 	uint32_t read(uint8_t * buf, const uint32_t len) {
 		uint32_t res = 0;
+#ifdef STM32CUBEDUINO_SMALL_FLASH
 		for (int val; res < len && (val = this->pop()) >= 0; buf++, res++) {
 			*buf = uint8_t(val);
 		}
+#else
+		const SizeType curTail = this->tail;
+		const uint32_t usedLen = this->used(this->head, curTail);
+		if (len == 1) {
+			/* avoid memcpy() overhead for single bytes */
+			if (usedLen == 0) return 0;
+			*buf = this->buffer[this->indexOf(curTail)];
+			this->tail = this->advance(curTail, 1);
+			return 1;
+		}
+		res = (len < usedLen) ? len : usedLen;
+		const uint32_t tailIdx = this->indexOf(curTail);
+		const uint32_t endLen = uint32_t(Size) - tailIdx;
+		/* copy until buffer end */
+		memcpy(buf, this->buffer + tailIdx, (res < endLen) ? res : endLen);
+		/* copy remaining from buffer start */
+		if (res > endLen) memcpy(buf + endLen, this->buffer, res - endLen);
+		this->tail = this->advance(curTail, res);
+#endif
 		return res;
 	}
 	
+	/**
+	 * Returns the readable data of the FIFO without copying it. The data is given
+	 * as up to two spans as it may wrap around at the end of the buffer. Call
+	 * `consume()` to remove the processed bytes from the FIFO afterwards.
+	 * 
+	 * @param[out] span - readable regions in order; the second span has a length of 0 if unused
+	 * @return total number of readable bytes
+	 * @remarks The spans remain valid until the consumer removes the data.
+	 */
+	uint32_t peek(_FifoSpan (& span)[2]) const {
+		const SizeType curTail = this->tail;
+		const uint32_t usedLen = this->used(this->head, curTail);
+		const uint32_t tailIdx = this->indexOf(curTail);
+		const uint32_t endLen = uint32_t(Size) - tailIdx;
+		span[0].ptr = this->buffer + tailIdx;
+		span[1].ptr = this->buffer;
+		if (usedLen > endLen) {
+			span[0].len = endLen;
+			span[1].len = usedLen - endLen;
+		} else {
+			span[0].len = usedLen;
+			span[1].len = 0;
+		}
+		return usedLen;
+	}
+	
+	/**
+	 * Removes the given number of bytes previously returned by `peek(span)` from the FIFO.
+	 * 
+	 * @param[in] len - number of bytes to remove; needs to be less or equal to the peeked number of bytes
+	 * @remarks Unlike `skip()`, the number of bytes is not checked against the current FIFO size.
+	 */
+	void consume(const uint32_t len) {
+		this->tail = this->advance(this->tail, len);
+	}
+	
+	/**
+	 * Returns the contiguous writable region at the write position without adding
+	 * anything to the FIFO. Call `commit()` to add the written bytes afterwards.
+	 * This allows DMA engines and peripherals to write to the FIFO directly.
+	 * 
+	 * @param[in] maxLen - maximum number of bytes needed
+	 * @param[out] outLen - set to the length of the returned region
+	 * @return start of the writable region or NULL if the FIFO is full
+	 * @remarks The region remains valid until the producer commits data.
+	 */
+	uint8_t * reserve(const uint32_t maxLen, uint32_t & outLen) {
+		const SizeType curHead = this->head;
+		const uint32_t freeLen = uint32_t(Capacity) - this->used(curHead, this->tail);
+		const uint32_t headIdx = this->indexOf(curHead);
+		const uint32_t endLen = uint32_t(Size) - headIdx;
+		uint32_t len = (freeLen < endLen) ? freeLen : endLen;
+		if (maxLen < len) len = maxLen;
+		outLen = len;
+		return (len > 0) ? this->buffer + headIdx : NULL;
+	}
+	
+	/**
+	 * Adds the given number of bytes previously written to the region returned by `reserve()`.
+	 * 
+	 * @param[in] len - number of bytes to add; needs to be less or equal to the reserved length
+	 */
+	void commit(const uint32_t len) {
+		this->head = this->advance(this->head, len);
+	}
+	
 	/**
 	 * Discards the given number of bytes stored in the FIFO.
 	 * 
@@ -341,7 +533,7 @@ struct _FifoClass {
 	uint32_t skip(const uint32_t len) {
 		const uint32_t available = this->availableForRead();
 		const uint32_t skipping = (len <= available) ? len : available;
-		this->tail = _FIFOX_INDEX(_FIFO_HANDLE, skipping);
+		this->tail = this->advance(this->tail, skipping);
 		return skipping;
 	}
 	
@@ -351,18 +543,21 @@ struct _FifoClass {
 	 * @return number of bytes that can be instantly read
 	 */
 	uint32_t availableForRead() const {
-		return uint32_t(_FIFOX_SIZE(_FIFO_HANDLE));
+		return this->used(this->head, this->tail);
 	}
 	
 	/**
 	 * Number of bytes available for instant block read.
 	 * This is convenient for function that do not support circular buffers
-	 * but only regular buffers. Use tail as start position within buffer.
+	 * but only regular buffers. Use `index(0)` as start position within buffer.
 	 * 
 	 * @return number of bytes that can be instantly read as block
 	 */
 	uint32_t availableForBlockRead() const {
-		return uint32_t(_FIFOX_BSIZE(_FIFO_HANDLE));
+		const SizeType curTail = this->tail;
+		const uint32_t usedLen = this->used(this->head, curTail);
+		const uint32_t endLen = uint32_t(Size) - this->indexOf(curTail);
+		return (usedLen < endLen) ? usedLen : endLen;
 	}
 	
 	/**
@@ -371,12 +566,408 @@ struct _FifoClass {
 	 * @return number of bytes that can be instantly written
 	 */
 	uint32_t availableForWrite() const {
-		return uint32_t(_FIFOX_AVAILABLE(_FIFO_HANDLE));
+		return uint32_t(Capacity) - this->used(this->head, this->tail);
+	}
+};
+
+
+/**
+ * Implements a FIFO of the given number of elements of the given type. No data is
+ * overwritten. The corresponding functions will fail if the maximum capacity was
+ * reached. Elements are stored with their natural alignment and moved as a whole.
+ * 
+ * @tparam T - element type; needs to be copy assignable
+ * @tparam N - FIFO size in elements
+ * @remarks Buffer indices are computed via binary AND instead of modulo if N is a power of two.
+ * @remarks Designed for single producer, single consumer.
+ */
+template <typename T, uint32_t N>
+struct _TypedFifo {
+	/** Element type. */
+	typedef T ValueType;
+	/** Index type. */
+	typedef typename _FifoIndexTypeFor<N>::type SizeType;
+	/** Contiguous readable memory region of the FIFO. */
+	struct Span {
+		const T * ptr; /**< Start of the region. */
+		uint32_t len; /**< Length of the region in elements. */
+	};
+	enum {
+		/** FIFO size in elements. */
+		Size = N,
+		/** FIFO capacity, e.i. the number of elements the FIFO can hold at maximum. */
+		Capacity = N - 1
+	};
+	volatile SizeType head; /**< Next write position within buffer. */
+	volatile SizeType tail; /**< Next read position within buffer. */
+	T buffer[N]; /**< Circular buffer of the FIFO. */
+	
+	/** Constructor. */
+	explicit _TypedFifo():
+		head(0),
+		tail(0)
+	{
+		static_assert(N >= 2, "At least 2 elements are required.");
+	}
+	
+	/**
+	 * Returns the number of used elements for the given head and tail values.
+	 * 
+	 * @param[in] curHead - head value
+	 * @param[in] curTail - tail value
+	 * @return number of used elements
+	 */
+	static uint32_t used(const SizeType curHead, const SizeType curTail) {
+		return (curHead >= curTail) ? uint32_t(curHead - curTail) : uint32_t(Size + curHead - curTail);
+	}
+	
+	/**
+	 * Returns whether the FIFO is empty.
+	 * 
+	 * @return true if empty, else false
+	 */
+	bool empty() const {
+		return this->head == this->tail;
+	}
+	
+	/**
+	 * Returns whether the FIFO is full.
+	 * 
+	 * @return true if full, else false
+	 */
+	bool full() const {
+		return _FIFO_WRAP(this->head + 1, Size) == this->tail;
+	}
+	
+	/**
+	 * Clears the FIFO by resetting the index variables.
+	 */
+	void clear() {
+		this->head = 0;
+		this->tail = 0;
+	}
+	
+	/**
+	 * Adds a new element to the FIFO.
+	 * 
+	 * @param[in] val - value to add
+	 * @return true on success, else false
+	 */
+	bool push(const T & val) {
+		const SizeType curHead = this->head;
+		const SizeType nextHead = SizeType(_FIFO_WRAP(curHead + 1, Size));
+		if (nextHead == this->tail) return false;
+		this->buffer[curHead] = val;
+		this->head = nextHead;
+		return true;
+	}
+	
+	/**
+	 * Returns the next element from the FIFO
+	 * and removes it from there.
+	 * 
+	 * @param[out] val - set to the next element on success
+	 * @return true on success, else false
+	 */
+	bool pop(T & val) {
+		const SizeType curTail = this->tail;
+		if (this->head == curTail) return false;
+		val = this->buffer[curTail];
+		this->tail = SizeType(_FIFO_WRAP(curTail + 1, Size));
+		return true;
+	}
+	
+	/**
+	 * Returns the next element from the FIFO.
+	 * The value remains in the FIFO.
+	 * 
+	 * @param[out] val - set to the next element on success
+	 * @return true on success, else false
+	 */
+	bool peek(T & val) const {
+		const SizeType curTail = this->tail;
+		if (this->head == curTail) return false;
+		val = this->buffer[curTail];
+		return true;
+	}
+	
+	/**
+	 * Writes the given elements to the FIFO.
+	 * 
+	 * @param[in] buf - input elements
+	 * @param[in] len - number of elements
+	 * @return number of elements written
+	 */
+	uint32_t write(const T * buf, const uint32_t len) {
+		const SizeType curHead = this->head;
+		const uint32_t freeLen = uint32_t(Capacity) - this->used(curHead, this->tail);
+		const uint32_t res = (len < freeLen) ? len : freeLen;
+		const uint32_t endLen = uint32_t(Size - curHead);
+		const uint32_t firstLen = (res < endLen) ? res : endLen;
+		/* copy until buffer end, then from buffer start */
+		for (uint32_t i = 0; i < firstLen; i++) this->buffer[curHead + i] = buf[i];
+		for (uint32_t i = firstLen; i < res; i++) this->buffer[i - firstLen] = buf[i];
+		this->head = SizeType(_FIFO_WRAP(curHead + res, Size));
+		return res;
+	}
+	
+	/**
+	 * Reads elements from the FIFO
+	 * and removes them from it.
+	 * 
+	 * @param[out] buf - output elements
+	 * @param[in] len - maximum number of elements
+	 * @return number of elements copied
+	 */
+	uint32_t read(T * buf, const uint32_t len) {
+		const SizeType curTail = this->tail;
+		const uint32_t usedLen = this->used(this->head, curTail);
+		const uint32_t res = (len < usedLen) ? len : usedLen;
+		const uint32_t endLen = uint32_t(Size - curTail);
+		const uint32_t firstLen = (res < endLen) ? res : endLen;
+		/* copy until buffer end, then from buffer start */
+		for (uint32_t i = 0; i < firstLen; i++) buf[i] = this->buffer[curTail + i];
+		for (uint32_t i = firstLen; i < res; i++) buf[i] = this->buffer[i - firstLen];
+		this->tail = SizeType(_FIFO_WRAP(curTail + res, Size));
+		return res;
+	}
+	
+	/**
+	 * Returns the readable elements of the FIFO without copying them. The elements
+	 * are given as up to two spans as they may wrap around at the end of the buffer.
+	 * Call `consume()` to remove the processed elements from the FIFO afterwards.
+	 * 
+	 * @param[out] span - readable regions in order; the second span has a length of 0 if unused
+	 * @return total number of readable elements
+	 * @remarks The spans remain valid until the consumer removes the elements.
+	 */
+	uint32_t peek(Span (& span)[2]) const {
+		const SizeType curHead = this->head;
+		const SizeType curTail = this->tail;
+		span[0].ptr = this->buffer + curTail;
+		span[1].ptr = this->buffer;
+		if (curHead < curTail) {
+			span[0].len = uint32_t(Size - curTail);
+			span[1].len = uint32_t(curHead);
+		} else {
+			span[0].len = uint32_t(curHead - curTail);
+			span[1].len = 0;
+		}
+		return uint32_t(span[0].len + span[1].len);
+	}
+	
+	/**
+	 * Removes the given number of elements previously returned by `peek(span)` from the FIFO.
+	 * 
+	 * @param[in] len - number of elements to remove; needs to be less or equal to the peeked number of elements
+	 */
+	void consume(const uint32_t len) {
+		this->tail = SizeType(_FIFO_WRAP(this->tail + len, Size));
+	}
+	
+	/**
+	 * Number of elements available for instant reading.
+	 * 
+	 * @return number of elements that can be instantly read
+	 */
+	uint32_t availableForRead() const {
+		return this->used(this->head, this->tail);
+	}
+	
+	/**
+	 * Number of elements available for instant writing.
+	 * 
+	 * @return number of elements that can be instantly written
+	 */
+	uint32_t availableForWrite() const {
+		return uint32_t(Capacity) - this->used(this->head, this->tail);
+	}
+};
+
+
+/**
+ * Implements a ring buffer of the given number of elements of the given type which
+ * overwrites the oldest elements if full. The producer never fails and never waits.
+ * The consumer detects overwritten elements and counts them as overruns.
+ * 
+ * @tparam T - element type; needs to be copy assignable
+ * @tparam N - ring buffer size in elements; needs to be a power of two
+ * @remarks The consumer validates copied elements against the producer position
+ * afterwards, like a sequence lock. Hence, it never returns an element which was
+ * overwritten while being copied.
+ * @remarks Designed for single producer, single consumer.
+ */
+template <typename T, uint32_t N>
+struct _OverwriteFifo {
+	/** Element type. */
+	typedef T ValueType;
+	enum {
+		/** Ring buffer size in elements. */
+		Size = N,
+		/** Number of elements which can be read safely. The element at head may be in progress of being overwritten. */
+		Capacity = N - 1
+	};
+	volatile uint32_t head; /**< Total number of elements written. Written by the producer only. */
+	uint32_t tail; /**< Total number of elements read or overrun. Written by the consumer only. */
+	uint32_t overruns; /**< Number of elements overwritten before being read. Written by the consumer only. */
+	T buffer[N]; /**< Circular buffer. */
+	
+	/** Constructor. */
+	explicit _OverwriteFifo():
+		head(0),
+		tail(0),
+		overruns(0)
+	{
+		static_assert((N & (N - 1)) == 0, "Ring buffer size needs to be a power of two.");
+		static_assert(N >= 2, "At least 2 elements are required.");
+	}
+	
+	/**
+	 * Returns the oldest position which is still valid for the given head value.
+	 * 
+	 * @param[in] curHead - head value
+	 * @param[in] pos - requested position
+	 * @return pos or the oldest valid position if pos was overwritten
+	 */
+	static uint32_t validFrom(const uint32_t curHead, const uint32_t pos) {
+		return (uint32_t(curHead - pos) > uint32_t(Capacity)) ? uint32_t(curHead - Capacity) : pos;
+	}
+	
+	/**
+	 * Returns whether no unread element is available.
+	 * 
+	 * @return true if empty, else false
+	 */
+	bool empty() const {
+		return this->head == this->tail;
+	}
+	
+	/**
+	 * Discards all unread elements. Called by the consumer.
+	 */
+	void clear() {
+		this->tail = __atomic_load_n(&(this->head), __ATOMIC_ACQUIRE);
+	}
+	
+	/**
+	 * Adds a new element and overwrites the oldest one if full.
+	 * 
+	 * @param[in] val - value to add
+	 */
+	void push(const T & val) {
+		const uint32_t curHead = this->head;
+		this->buffer[curHead & (Size - 1)] = val;
+		__atomic_store_n(&(this->head), uint32_t(curHead + 1), __ATOMIC_RELEASE);
+	}
+	
+	/**
+	 * Adds the given elements and overwrites the oldest ones if full.
+	 * 
+	 * @param[in] buf - input elements
+	 * @param[in] len - number of elements
+	 */
+	void write(const T * buf, const uint32_t len) {
+		for (uint32_t i = 0; i < len; i++) this->push(buf[i]);
+	}
+	
+	/**
+	 * Returns the next unread element and removes it.
+	 * 
+	 * @param[out] val - set to the next element on success
+	 * @return true on success, else false
+	 */
+	bool pop(T & val) {
+		for (;;) {
+			const uint32_t curHead = __atomic_load_n(&(this->head), __ATOMIC_ACQUIRE);
+			if (curHead == this->tail) return false;
+			const uint32_t curTail = this->validFrom(curHead, this->tail);
+			this->overruns += uint32_t(curTail - this->tail);
+			this->tail = curTail;
+			val = this->buffer[curTail & (Size - 1)];
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if (this->validFrom(__atomic_load_n(&(this->head), __ATOMIC_ACQUIRE), curTail) == curTail) {
+				this->tail = uint32_t(curTail + 1);
+				return true;
+			}
+			/* overwritten while copying -> retry */
+		}
+	}
+	
+	/**
+	 * Reads unread elements and removes them.
+	 * 
+	 * @param[out] buf - output elements
+	 * @param[in] len - maximum number of elements
+	 * @return number of elements copied
+	 */
+	uint32_t read(T * buf, const uint32_t len) {
+		const uint32_t curHead = __atomic_load_n(&(this->head), __ATOMIC_ACQUIRE);
+		const uint32_t curTail = this->validFrom(curHead, this->tail);
+		this->overruns += uint32_t(curTail - this->tail);
+		const uint32_t available = uint32_t(curHead - curTail);
+		const uint32_t res = (len < available) ? len : available;
+		this->tail = uint32_t(curTail + res);
+		uint32_t dropped;
+		const uint32_t copied = this->copyValid(buf, curTail, res, dropped);
+		this->overruns += dropped;
+		return copied;
+	}
+	
+	/**
+	 * Copies the most recently written elements without removing them. This includes
+	 * elements which were already read.
+	 * 
+	 * @param[out] buf - output elements; oldest first
+	 * @param[in] len - maximum number of elements
+	 * @return number of elements copied
+	 * @remarks The number of written elements is derived from the free-running head counter.
+	 * Hence, fewer elements are returned directly after it wrapped around at 2^32.
+	 */
+	uint32_t readLatest(T * buf, const uint32_t len) const {
+		const uint32_t curHead = __atomic_load_n(&(this->head), __ATOMIC_ACQUIRE);
+		const uint32_t available = (curHead < uint32_t(Capacity)) ? curHead : uint32_t(Capacity);
+		const uint32_t res = (len < available) ? len : available;
+		uint32_t dropped;
+		return this->copyValid(buf, uint32_t(curHead - res), res, dropped);
+	}
+	
+	/**
+	 * Number of unread elements including those which will be counted as overruns.
+	 * 
+	 * @return number of unread elements
+	 */
+	uint32_t availableForRead() const {
+		const uint32_t available = uint32_t(this->head - this->tail);
+		return (available < uint32_t(Capacity)) ? available : uint32_t(Capacity);
+	}
+	
+	/**
+	 * Copies the given range and drops the elements which were overwritten
+	 * while copying.
+	 * 
+	 * @param[out] buf - output elements
+	 * @param[in] pos - position of the first element
+	 * @param[in] len - number of elements
+	 * @param[out] dropped - set to the number of dropped elements
+	 * @return number of valid elements moved to the start of buf
+	 */
+	uint32_t copyValid(T * buf, const uint32_t pos, const uint32_t len, uint32_t & dropped) const {
+		for (uint32_t i = 0; i < len; i++) buf[i] = this->buffer[(pos + i) & (Size - 1)];
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		const uint32_t validPos = this->validFrom(__atomic_load_n(&(this->head), __ATOMIC_ACQUIRE), pos);
+		dropped = (uint32_t(validPos - pos) < len) ? uint32_t(validPos - pos) : len;
+		if (dropped == 0) return len;
+		for (uint32_t i = dropped; i < len; i++) buf[i - dropped] = buf[i];
+		return uint32_t(len - dropped);
 	}
-#undef _FIFO_HANDLE
 };
 
 
+/** Overwriting ring buffer of the given number of bytes. */
+template <uint32_t N>
+using _OverwriteByteFifo = _OverwriteFifo<uint8_t, N>;
+
+
 /**
  * Implements a FIFO of any size. The FIFO is made up of uint8_t elements.
  * No data is overwritten. The corresponding functions will fail if the maximum
@@ -514,7 +1105,7 @@ struct _DynFifoBase {
 	uint32_t dummyWrite(const uint32_t len) {
 		const uint32_t available = this->availableForWrite();
 		const uint32_t skipping = (len <= available) ? len : available;
-		this->head = static_cast<SizeType>((this->head + skipping) % this->size);
+		this->head = static_cast<SizeType>(_FIFO_WRAP(this->head + skipping, this->size));
 		return skipping;
 	}
 	
@@ -650,8 +1241,10 @@ struct _BlockFifoClass {
 #define _FIFO_HANDLE this->size, Count, this->head, this->tail
 	volatile IndexType head; /**< Next write block within block. Written after isFull and size. */
 	volatile IndexType tail; /**< Next read block within block. */
+	volatile uint32_t committedBytes; /**< Total number of committed bytes. Written by the producer only. */
+	volatile uint32_t poppedBytes; /**< Total number of removed bytes. Written by the consumer only. */
 	SizeType size[Count]; /**< Block lengths. */
-	uint8_t block[Count][BlockSize]; /**< Circular buffer of the FIFO. */
+	uint8_t block[Count][BlockSize] __attribute__((aligned(4))); /**< Circular buffer of the FIFO. Word aligned for DMA transfers. */
 	
 	/** Constructor. */
 	explicit _BlockFifoClass() {
@@ -695,6 +1288,8 @@ struct _BlockFifoClass {
 	 */
 	void clear() {
 		_FIFOX_CLEAR(_FIFO_HANDLE);
+		this->committedBytes = 0;
+		this->poppedBytes = 0;
 		for (IndexType i = 0; i < Count; i++) this->size[i] = 0;
 	}
 	
@@ -717,13 +1312,14 @@ struct _BlockFifoClass {
 	 */
 	bool push(const uint8_t val) {
 		const IndexType curHead = this->head;
-		const IndexType nextHead = IndexType((curHead + 1) % Count);
+		const IndexType nextHead = IndexType(_FIFO_WRAP(curHead + 1, Count));
 		const SizeType bSize = this->size[curHead];
 		const SizeType bSizeNext = SizeType(bSize + 1);
 		if (nextHead == this->tail && bSizeNext >= BlockSize) return false; /* full */
 		this->block[curHead][bSize] = val;
 		this->size[curHead] = bSizeNext;
 		if (bSizeNext >= BlockSize) {
+			this->committedBytes += BlockSize;
 			this->head = nextHead;
 		}
 		return true;
@@ -736,7 +1332,7 @@ struct _BlockFifoClass {
 	 */
 	void blockingPush(const uint8_t val) {
 		const IndexType curHead = this->head;
-		const IndexType nextHead = IndexType((curHead + 1) % Count);
+		const IndexType nextHead = IndexType(_FIFO_WRAP(curHead + 1, Count));
 		const SizeType cbSize = this->size[curHead];
 		if (nextHead == this->tail && (cbSize + 1) >= BlockSize) {
 			/* wait until write space is available */
@@ -747,6 +1343,7 @@ struct _BlockFifoClass {
 		this->block[curHead][bSize] = val;
 		this->size[curHead] = bSizeNext;
 		if (bSizeNext >= BlockSize) {
+			this->committedBytes += BlockSize;
 			this->head = nextHead;
 		}
 	}
@@ -759,7 +1356,8 @@ struct _BlockFifoClass {
 	bool pop() {
 		const IndexType curTail = this->tail;
 		if (this->head == curTail) return false; /* empty */
-		const IndexType nextTail = IndexType((curTail + 1) % Count);
+		const IndexType nextTail = IndexType(_FIFO_WRAP(curTail + 1, Count));
+		this->poppedBytes += this->size[curTail];
 		this->size[curTail] = 0;
 		this->tail = nextTail;
 		return true;
@@ -780,7 +1378,8 @@ struct _BlockFifoClass {
 	}
 	
 	/**
-	 * Writes some data to the FIFO.
+	 * Writes some data to the FIFO. Full blocks are committed
+	 * automatically.
 	 * 
 	 * @param[in] buf - input data buffer
 	 * @param[in] len - length of the data
@@ -788,10 +1387,58 @@ struct _BlockFifoClass {
 	 */
 	uint32_t write(const uint8_t * buf, const uint32_t len) {
 		uint32_t res = 0;
+#ifdef STM32CUBEDUINO_SMALL_FLASH
 		for (; res < len && this->push(*buf); buf++, res++);
+#else
+		while (res < len) {
+			uint32_t cpyLen;
+			uint8_t * ptr = this->reserve(len - res, cpyLen);
+			if (ptr == NULL) break; /* full */
+			memcpy(ptr, buf + res, cpyLen);
+			this->commit(cpyLen);
+			res += cpyLen;
+		}
+#endif
 		return res;
 	}
 	
+	/**
+	 * Returns the contiguous writable region of the current block without adding
+	 * anything to the FIFO. Call `commit()` to add the written bytes afterwards.
+	 * This allows DMA engines and peripherals to write to the FIFO directly.
+	 * 
+	 * @param[in] maxLen - maximum number of bytes needed
+	 * @param[out] outLen - set to the length of the returned region
+	 * @return start of the writable region or NULL if the FIFO is full
+	 * @remarks The region remains valid until the producer commits data.
+	 */
+	uint8_t * reserve(const uint32_t maxLen, uint32_t & outLen) {
+		const IndexType curHead = this->head;
+		const IndexType nextHead = IndexType(_FIFO_WRAP(curHead + 1, Count));
+		const SizeType bSize = this->size[curHead];
+		/* the last free block can only be filled up to BlockSize - 1 (see push()) */
+		uint32_t len = uint32_t(BlockSize - bSize) - ((nextHead == this->tail) ? 1 : 0);
+		if (maxLen < len) len = maxLen;
+		outLen = len;
+		return (len > 0) ? this->block[curHead] + bSize : NULL;
+	}
+	
+	/**
+	 * Adds the given number of bytes previously written to the region returned by `reserve()`.
+	 * The current block is committed automatically once it is full.
+	 * 
+	 * @param[in] len - number of bytes to add; needs to be less or equal to the reserved length
+	 */
+	void commit(const uint32_t len) {
+		const IndexType curHead = this->head;
+		const SizeType bSizeNext = SizeType(this->size[curHead] + len);
+		this->size[curHead] = bSizeNext;
+		if (bSizeNext >= BlockSize) {
+			this->committedBytes += BlockSize;
+			this->head = IndexType(_FIFO_WRAP(curHead + 1, Count));
+		}
+	}
+	
 	/**
 	 * Blocking writes some data to the FIFO.
 	 * 
@@ -810,16 +1457,19 @@ struct _BlockFifoClass {
 	 */
 	bool commitBlock() {
 		const IndexType curHead = this->head;
-		const IndexType nextHead = IndexType((curHead + 1) % Count);
+		const IndexType nextHead = IndexType(_FIFO_WRAP(curHead + 1, Count));
 		if (nextHead == this->tail) return false; /* no free block available */
-		if (this->size[curHead] == 0) return false; /* empty block */
+		const SizeType bSize = this->size[curHead];
+		if (bSize == 0) return false; /* empty block */
+		this->committedBytes += bSize;
 		this->head = nextHead;
 		return true;
 	}
 	
 	/**
 	 * Reads some data from the FIFO
-	 * and removes the data from it.
+	 * and removes the data from it. Only complete
+	 * committed blocks are read.
 	 * 
 	 * @param[out] buf - output data buffer 
 	 * @param[in] len - length of the data buffer
@@ -830,10 +1480,8 @@ struct _BlockFifoClass {
 		uint32_t res = 0;
 		uint32_t blockSize;
 		const uint8_t * blockPtr;
-		while ((blockPtr = this->peek(blockSize)) != NULL && (res + blockSize) < len) {
-			for (uint32_t i = 0; i < blockSize; i++, buf++, blockPtr++) {
-				*buf = *blockPtr;
-			}
+		while ((blockPtr = this->peek(blockSize)) != NULL && (res + blockSize) <= len) {
+			memcpy(buf + res, blockPtr, blockSize);
 			res += blockSize;
 			this->pop();
 		}
@@ -842,16 +1490,13 @@ struct _BlockFifoClass {
 	
 	/**
 	 * Number of bytes available for instant reading.
+	 * This includes only committed blocks.
 	 * 
 	 * @return number of bytes that can be instantly read
 	 */
 	uint32_t availableForRead() const {
-		const IndexType curHead = this->head;
-		uint32_t res = 0;
-		for (IndexType i = this->tail; i != curHead; i = IndexType((i + 1) % Count)) {
-			res += this->size[i];
-		}
-		return res;
+		const uint32_t curPopped = this->poppedBytes; /* read first to never exceed committedBytes */
+		return uint32_t(this->committedBytes - curPopped);
 	}
 	
 	/**
@@ -870,236 +1515,175 @@ struct _BlockFifoClass {
 };
 
 
-/* unit tests:
--------------------------------------------------------------------------------
-#include <stdio.h>
-#include <stdlib.h>
-#define __WFI()
-#include "fifo.h"
-
-#define BUF_SIZE 8
-
-enum State { ADD, DEL, CLR, STATES };
-
-State rndState() {
-	return State(rand() % STATES);
-}
-
-#define assert(exp) \
-	if (!(exp)) { \
-		fprintf(stderr, "%s:%i: failed assertion: %s\n", __FILE__, int(__LINE__), #exp); \
-		fprintf(stderr, "exp: %u\n", unsigned(exp)); \
-		fprintf(stderr, "head: %u\n", unsigned(head)); \
-		fprintf(stderr, "tail: %u\n", unsigned(tail)); \
-		fprintf(stderr, "size: %u\n", unsigned(size)); \
-		exit(1); \
+/**
+ * Implements a FIFO of the given size which accepts data from multiple producers at once,
+ * e.g. several interrupt handlers and the main loop. The FIFO is made up of uint8_t
+ * elements. No data is overwritten. The corresponding functions will fail if the maximum
+ * capacity was reached.
+ * 
+ * @tparam TSize - FIFO size in bytes; needs to be a power of two
+ * @remarks Producers reserve elements with a compare-and-swap on the head counter and
+ * publish each element via its own sequence number. Producers never wait for each other.
+ * A producer interrupted between reservation and publishing only delays the consumer.
+ * @remarks The sequence numbers wrap after 32 laps. A producer must not be preempted for
+ * longer than that between reading head and reserving its elements.
+ * @remarks Designed for multiple producers, single consumer.
+ */
+template <uint32_t TSize>
+struct _MpscFifoClass {
+	/** Index and sequence number type. */
+	typedef typename _FifoIndexTypeFor<(TSize * 32) - 1>::type SizeType;
+	/** Signed variant of the index type. */
+	typedef typename _FifoSignedFor<SizeType>::type DiffType;
+	enum {
+		/** FIFO size in memory. */
+		Size = TSize,
+		/** FIFO capacity, e.i. the number of bytes the FIFO can hold at maximum. */
+		Capacity = TSize
+	};
+	volatile SizeType head; /**< Next position to reserve. Written by all producers. */
+	volatile SizeType tail; /**< Next read position. Written by the consumer only. */
+	volatile SizeType seq[TSize]; /**< Element sequence numbers. The position if free, position + 1 if published. */
+	uint8_t buffer[TSize]; /**< Circular buffer of the FIFO. */
+	
+	/** Constructor. */
+	explicit _MpscFifoClass() {
+		static_assert((TSize & (TSize - 1)) == 0, "FIFO size needs to be a power of two.");
+		static_assert(TSize >= 2 && TSize <= (uint32_t(1) << 26), "FIFO size is out of range.");
+		this->clear();
 	}
-
-int main() {
-	size_t head, tail;
-	char buf[BUF_SIZE];
-	#define HANDLE buf, BUF_SIZE, head, tail
-	size_t size = 0;
-	_FIFOX_INIT(HANDLE);
-	assert(_FIFOX_EMPTY(HANDLE));
-	assert(_FIFOX_SIZE(HANDLE) == 0);
-	assert(_FIFOX_AVAILABLE(HANDLE) == (BUF_SIZE - 1));
-	assert(_FIFOX_CAPACITY(HANDLE) == (BUF_SIZE - 1));
-	assert(_FIFOX_BSIZE(HANDLE) == 0);
-	for (size_t i = 0; i < 1000000; i++) {
-		switch (rndState()) {
-		case ADD:
-			if ((size + 1) < BUF_SIZE) {
-				_FIFOX_PUSH(HANDLE, char(head));
-				size++;
-			}
-			break;
-		case DEL:
-			if (size > 0) {
-				const char expVal = char(tail);
-				const char peekVal = char(_FIFOX_PEEK(HANDLE));
-				const char popVal = char(_FIFOX_POP(HANDLE));
-				assert(peekVal == popVal);
-				assert(expVal == popVal);
-				size--;
+	
+	/**
+	 * Returns whether the FIFO holds no published element at the read position.
+	 * 
+	 * @return true if empty, else false
+	 */
+	bool empty() const {
+		const SizeType curTail = this->tail;
+		return __atomic_load_n(this->seq + (curTail & (Size - 1)), __ATOMIC_ACQUIRE) != SizeType(curTail + 1);
+	}
+	
+	/**
+	 * Clears the FIFO by resetting the index variables and sequence numbers.
+	 * 
+	 * @remarks Not safe against concurrent producers.
+	 */
+	void clear() {
+		this->head = 0;
+		this->tail = 0;
+		for (uint32_t i = 0; i < Size; i++) this->seq[i] = SizeType(i);
+	}
+	
+	/**
+	 * Adds a new element to the FIFO. Safe to be called from multiple
+	 * producers concurrently.
+	 * 
+	 * @param[in] val - value to add
+	 * @return true on success, else false
+	 */
+	bool push(const uint8_t val) {
+		return this->write(&val, 1) == 1;
+	}
+	
+	/**
+	 * Writes a block of data to the FIFO. The block is either written completely
+	 * or not at all. Blocks of concurrent producers are not interleaved. Safe to
+	 * be called from multiple producers concurrently.
+	 * 
+	 * @param[in] buf - input data buffer
+	 * @param[in] len - length of the data
+	 * @return number of bytes written, i.e. 0 or len
+	 */
+	uint32_t write(const uint8_t * buf, const uint32_t len) {
+		if (len == 0 || len > Size) return 0;
+		SizeType pos = __atomic_load_n(&(this->head), __ATOMIC_RELAXED);
+		for (;;) {
+			/* the last element is only free if all previous ones are */
+			const SizeType lastPos = SizeType(pos + len - 1);
+			const SizeType lastSeq = __atomic_load_n(this->seq + (lastPos & (Size - 1)), __ATOMIC_ACQUIRE);
+			const DiffType diff = DiffType(SizeType(lastSeq - lastPos));
+			if (diff == 0) {
+				if ( _FIFO_CAS(&(this->head), pos, SizeType(pos + len)) ) break; /* reserved */
+			} else if (diff < 0) {
+				return 0; /* full */
 			} else {
-				assert(_FIFOX_PEEK(HANDLE) == -1);
-				assert(_FIFOX_POP(HANDLE) == -1);
+				pos = __atomic_load_n(&(this->head), __ATOMIC_RELAXED); /* reserved by another producer */
 			}
-			break;
-		case CLR:
-			_FIFOX_CLEAR(HANDLE);
-			size = 0;
-			break;
-		case STATES:
-			break;
-		}
-		assert(_FIFOX_SIZE(HANDLE) == size);
-		assert(_FIFOX_AVAILABLE(HANDLE) == size_t(BUF_SIZE - size - 1));
-		assert(_FIFOX_INDEX(HANDLE, size) == head);
-		assert(_FIFOX_BSIZE(HANDLE) <= _FIFOX_SIZE(HANDLE));
-		const size_t blockEnd = _FIFOX_INDEX(HANDLE, _FIFOX_BSIZE(HANDLE));
-		assert(blockEnd == 0 || blockEnd == head);
-		if (size == 0) {
-			assert(_FIFOX_EMPTY(HANDLE));
-			assert(_FIFOX_SIZE(HANDLE) == 0);
-			assert(_FIFOX_AVAILABLE(HANDLE) == (BUF_SIZE - 1));
-		} else {
-			assert(!_FIFOX_EMPTY(HANDLE));
 		}
-		if ((size + 1) >= BUF_SIZE) {
-			assert(_FIFOX_FULL(HANDLE));
-			assert(_FIFOX_SIZE(HANDLE) == (BUF_SIZE - 1));
-			assert(_FIFOX_AVAILABLE(HANDLE) == 0);
-		} else {
-			assert(!_FIFOX_FULL(HANDLE));
+		for (uint32_t i = 0; i < len; i++) {
+			const SizeType curPos = SizeType(pos + i);
+			this->buffer[curPos & (Size - 1)] = buf[i];
+			__atomic_store_n(this->seq + (curPos & (Size - 1)), SizeType(curPos + 1), __ATOMIC_RELEASE);
 		}
+		return len;
 	}
-	return 0;
-}
--------------------------------------------------------------------------------
-#include <stdio.h>
-#include <stdlib.h>
-#define __WFI()
-#include "fifo.h"
-
-#define TOTAL_SIZE 8
-#define BLOCK_SIZE 4
-#define BLOCK_COUNT ((TOTAL_SIZE) / (BLOCK_SIZE))
-
-typedef _BlockFifoClass<TOTAL_SIZE, BLOCK_SIZE> Fifo;
-
-enum State { ADD, COM, DEL, CLR, STATES };
-
-State rndState() {
-	return State(rand() % STATES);
-}
-
-#define assert(exp) \
-	if (!(exp)) { \
-		fprintf(stderr, "%s:%i: failed assertion: %s\n", __FILE__, int(__LINE__), #exp); \
-		fprintf(stderr, "exp: %u\n", unsigned(exp)); \
-		fprintf(stderr, "size: %u\n", unsigned(size)); \
-		fprintf(stderr, "blockSize: %u\n", unsigned(blockSize)); \
-		fprintf(stderr, "blocks: %u\n", unsigned(blocks)); \
-		fprintf(stderr, "head: %u\n", unsigned(fifo.head)); \
-		fprintf(stderr, "tail: %u\n", unsigned(fifo.tail)); \
-		fprintf(stderr, "sizes: ["); \
-		for (size_t _n = 0; _n < BLOCK_COUNT; _n++) { \
-			if (_n != 0) fprintf(stderr, ", "); \
-			fprintf(stderr, "%u", unsigned(fifo.size[_n])); \
-		} \
-		fprintf(stderr, "]\n"); \
-		fprintf(stderr, "data: ["); \
-		for (size_t _n = 0; _n < BLOCK_COUNT; _n++) { \
-			if (_n != 0) fprintf(stderr, ", "); \
-			fprintf(stderr, "["); \
-			for (size_t _m = 0; _m < BLOCK_SIZE; _m++) { \
-				if (_m != 0) fprintf(stderr, ", "); \
-				fprintf(stderr, "%u", unsigned(fifo.block[_n][_m])); \
-			} \
-			fprintf(stderr, "]"); \
-		} \
-		fprintf(stderr, "]\n"); \
-		exit(1); \
+	
+	/**
+	 * Returns the next element from the FIFO
+	 * and removes it from there.
+	 * 
+	 * @return value if available, else -1
+	 */
+	int pop() {
+		const SizeType curTail = this->tail;
+		const SizeType idx = SizeType(curTail & (Size - 1));
+		if (__atomic_load_n(this->seq + idx, __ATOMIC_ACQUIRE) != SizeType(curTail + 1)) return -1;
+		const int res = this->buffer[idx];
+		__atomic_store_n(this->seq + idx, SizeType(curTail + Size), __ATOMIC_RELEASE);
+		this->tail = SizeType(curTail + 1);
+		return res;
 	}
-
-int main() {
-	Fifo fifo;
-	size_t size = 0, blockSize = 0, blocks = 0;
-	assert(fifo.empty());
-	assert(fifo.availableForRead() == 0);
-	assert((fifo.availableForWrite() + 1) == TOTAL_SIZE);
-	assert(fifo.TotalSize == TOTAL_SIZE);
-	assert(fifo.BlockSize == BLOCK_SIZE);
-	assert(fifo.Count == BLOCK_COUNT);
-	for (size_t i = 0; i < 1000000; i++) {
-		switch (rndState()) {
-		case ADD:
-			if ((size + 1) < TOTAL_SIZE) {
-				const bool expRes = (blocks + 1) < BLOCK_COUNT || (blockSize + 1) < BLOCK_SIZE;
-				const bool res = fifo.push(char(blockSize));
-				assert(res == expRes);
-				if ( res ) {
-					size++;
-					blockSize++;
-					if (blockSize >= BLOCK_SIZE) {
-						blockSize = 0;
-						blocks++;
-					}
-				}
-			}
-			break;
-		case COM:
-			{
-				const bool expRes = (blocks + 1) < BLOCK_COUNT && blockSize > 0;
-				const bool res = fifo.commitBlock();
-				assert(res == expRes);
-				if ( res ) {
-					blockSize = 0;
-					blocks++;
-				}
-			}
-			break;
-		case DEL:
-			{
-				uint32_t aBlockSize;
-				const uint8_t * blockPtr = fifo.peek(aBlockSize);
-				if (blocks > 0) {
-					assert(blockPtr != NULL);
-					assert(aBlockSize > 0);
-					assert(aBlockSize == fifo.size[fifo.tail]);
-					for (uint32_t k = 0; k < aBlockSize; k++) {
-						assert(k == blockPtr[k]);
-					}
-					fifo.pop();
-					size = size_t(size - aBlockSize);
-					blocks--;
-				} else {
-					assert(blockPtr == NULL);
-					assert(aBlockSize == 0);
-				}
-			}
-			break;
-		case CLR:
-			fifo.clear();
-			size = 0;
-			blockSize = 0;
-			blocks = 0;
-			break;
-		case STATES:
-			break;
-		}
-		if (size == 0) {
-			assert(fifo.empty());
-			assert(fifo.totallyEmpty());
-			assert( ! fifo.full() );
-			assert(fifo.availableForRead() == 0);
-			assert((fifo.availableForWrite() + 1) == TOTAL_SIZE);
-		} else if ((size + 1) == TOTAL_SIZE) {
-			assert( ! fifo.empty() );
-			assert( ! fifo.totallyEmpty() );
-			assert(fifo.full());
-			assert((fifo.availableForRead() + blockSize + 1) == TOTAL_SIZE);
-			assert(fifo.availableForWrite() == 0);
-		} else {
-			if (blocks < 1) {
-				assert(fifo.empty());
-			} else {
-				assert( ! fifo.empty() );
-			}
-			assert( ! fifo.totallyEmpty() );
-			if ((blocks + 1) == BLOCK_COUNT) {
-				assert(fifo.full());
-			} else {
-				assert( ! fifo.full() );
-			}
-			assert(fifo.availableForRead() == (size - blockSize));
-			assert(fifo.availableForWrite() == (((BLOCK_COUNT - blocks) * BLOCK_SIZE) - blockSize - 1));
+	
+	/**
+	 * Returns the next element from the FIFO.
+	 * The value remains in the FIFO.
+	 * 
+	 * @return value if available, else -1
+	 */
+	int peek() const {
+		const SizeType curTail = this->tail;
+		const SizeType idx = SizeType(curTail & (Size - 1));
+		if (__atomic_load_n(this->seq + idx, __ATOMIC_ACQUIRE) != SizeType(curTail + 1)) return -1;
+		return this->buffer[idx];
+	}
+	
+	/**
+	 * Reads a block of data from the FIFO
+	 * and removes the data from it.
+	 * 
+	 * @param[out] buf - output data buffer 
+	 * @param[in] len - length of the data buffer
+	 * @return number of bytes copied
+	 */
+	uint32_t read(uint8_t * buf, const uint32_t len) {
+		uint32_t res = 0;
+		for (int val; res < len && (val = this->pop()) >= 0; buf++, res++) {
+			*buf = uint8_t(val);
 		}
+		return res;
 	}
-	return 0;
-}
-*/
+	
+	/**
+	 * Number of bytes reserved by producers. This includes bytes which are
+	 * not published yet. Hence, `read()` may return less.
+	 * 
+	 * @return number of bytes in the FIFO
+	 */
+	uint32_t availableForRead() const {
+		const SizeType curTail = this->tail;
+		return uint32_t(SizeType(__atomic_load_n(&(this->head), __ATOMIC_ACQUIRE) - curTail));
+	}
+	
+	/**
+	 * Number of bytes available for writing. Concurrent producers
+	 * may reduce this value at any time.
+	 * 
+	 * @return number of bytes that can be written
+	 */
+	uint32_t availableForWrite() const {
+		return uint32_t(Capacity) - this->availableForRead();
+	}
+};
+
 
 #endif /* __SCDINTERNAL_FIFO_H__ */